@@ -0,0 +1,517 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaBatch
+
+ *  Function:
+      Plan a night's fields in one call.
+
+ *  Description:
+      Given, for each plate (or night), the field on the plate and an
+      ordered list of the fields to be configured on it, plans every
+      reconfiguration and reports the moves, parks and estimated robot
+      time (see tdFdelRobot.c) of each and in total.
+
+      Each field starts from where the plan of the one before leaves the
+      plate - its fibre positions and crossovers - so the fields of one
+      segment must be planned in order.  The segments are independent and
+      are planned concurrently, a segment at a time per thread, each
+      thread with its own instrument description (see tdFdeltaFpilNew()).
+      Built without TDFDELTA_REENTRANT, the calling thread plans them all.
+
+      The mustMove flags of the first field of a segment are as given.
+      Those of the fields after it are derived from where the plan before
+      leaves the plate (see tdFdeltaBatchChain()), as a fibre can't be
+      known to be in place on a plate not yet configured.
+
+      If a field cannot be planned, the fields after it in the segment
+      cannot be either, as their start is unknown.  These are reported
+      with TDFDELTA__BATCHSKIP.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Add tdFdeltaBatchChain() and tdFdeltaBatchField(),
+                        for tdFdelMatrix.c.
+      19-Oct-2026  AGT  Read and set the cancel flag atomically.
+      19-Oct-2026  AGT  mustMove of each field after the first is derived
+                        from the field before, in tdFdeltaBatchChain().
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelBatch.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelBatch.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef TDFDELTA_REENTRANT
+#   include <pthread.h>
+#endif
+
+/*
+ *  What one field's plan output, from its callbacks.
+ */
+typedef struct {
+    tdFrobot        robot;
+    tdFbatchField   *field;
+    int             done;           /* cfDone called with keep true */
+    } Tally;
+
+/*
+ *  A thread planning segments.
+ */
+typedef struct {
+    tdFbatch        *batch;
+    FpilType        inst;
+#ifdef TDFDELTA_REENTRANT
+    pthread_t       thread;
+#endif
+    } Worker;
+
+
+/*
+ *  Plan callbacks.  Only the first error of a field is kept, the rest
+ *  usually just say which stage failed.
+ */
+static void TallyErsRep(
+        void        *clientData,
+        int         flags,
+        StatusType  *status,
+        const char  *text)
+{
+    tdFbatchField *field = ((Tally *)clientData)->field;
+    if (field->error[0] == '\0') {
+        strncpy(field->error, text, sizeof(field->error)-1);
+        field->error[sizeof(field->error)-1] = '\0';
+    }
+}
+
+static void TallyCfNew(
+        void              *clientData,
+        const char        *name,
+        const tdFinterim  *cur,
+        StatusType        *status)
+{
+    Tally *tally = (Tally *)clientData;
+    tdFdeltaRobotStart(&tally->robot, cur, tally->robot.con);
+}
+
+static void TallyCfLine(
+        void        *clientData,
+        const char  *name,
+        const char  *line,
+        StatusType  *status)
+{
+    tdFdeltaRobotLine(&((Tally *)clientData)->robot, line);
+}
+
+static void TallyCfCount(
+        void        *clientData,
+        const char  *name,
+        long int    value,
+        StatusType  *status)
+{
+    tdFbatchField *field = ((Tally *)clientData)->field;
+    if (strcmp(name, "numMoves") == 0)
+        field->numMoves = (unsigned)value;
+    else if (strcmp(name, "numParks") == 0)
+        field->numParks = (unsigned)value;
+}
+
+static void TallyCfDone(
+        void        *clientData,
+        int         keep,
+        StatusType  *status)
+{
+    ((Tally *)clientData)->done = keep;
+}
+
+
+/*
+ *  Copy a crossover list, keeping its order.
+ */
+static void CopyCrosses(
+        const FibreCross  *from,
+        FibreCross        **to,
+        StatusType        *status)
+{
+    FibreCross **tail = to;
+    for ( ; (from)&&(*status == STATUS__OK) ; from = from->next) {
+        FibreCross *p;
+        if ((p = (FibreCross *)malloc(sizeof(FibreCross))) == NULL) {
+            *status = TDFDELTA__MALLOCERR;
+            return;
+        }
+        p->piv = from->piv;
+        p->next = 0;
+        *tail = p;
+        tail = &p->next;
+    }
+}
+
+/*+        T D F D E L T A B A T C H
+
+ *  Function name:
+      tdFdeltaBatchChain
+
+ *  Function:
+      Create the plan of a field, starting from where another leaves off.
+
+ *  Description:
+      Creates a plan with prev's current field and crossover lists (a
+      deep copy), constants, clearances, offsets, fiducials and flags, and
+      the given target.  Where prev has been planned, its current field
+      and crossovers are where it leaves the plate.
+
+      A target's mustMove flags are only meaningful against the field
+      actually on the plate.  When starting from where another plan
+      leaves the plate, derive should be set, and a fibre must move if
+      its target differs from that field.
+
+ *  Language:
+      C
+
+ *  Call:
+      (tdFdeltaType *) = tdFdeltaBatchChain (prev, target, derive, index,
+                                             status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) prev        (const tdFdeltaType *) The plan to start from.
+      (>) target      (const tdFtarget *)    The target field.
+      (>) derive      (int)                  Derive mustMove from prev's
+                                             current field, rather than
+                                             take it from target.
+      (>) index       (unsigned)             Field index, for the name.
+      (!) status      (StatusType *)         Modified status.
+
+ *  Returned value:
+      The plan, to be released with tdFdeltaDataFree(), or NULL on error.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, was Chain().
+      19-Oct-2026  AGT  Add derive, mustMove from the chained current
+                        field, as was done by tdFdelMatrix.c alone.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL tdFdeltaType  *tdFdeltaBatchChain (
+        const tdFdeltaType  *prev,
+        const tdFtarget     *target,
+        int                 derive,
+        unsigned            index,
+        StatusType          *status)
+{
+    tdFdeltaType *data;
+    unsigned i;
+
+    if ((data = tdFdeltaDataNew(prev->check, status)) == NULL)
+        return NULL;
+    data->current      = prev->current;
+    data->target       = *target;
+    data->constants    = prev->constants;
+    data->butClearG    = prev->butClearG;
+    data->butClearO    = prev->butClearO;
+    data->fibClearG    = prev->fibClearG;
+    data->fibClearO    = prev->fibClearO;
+    data->maxButAngG   = prev->maxButAngG;
+    data->maxButAngO   = prev->maxButAngO;
+    data->maxPivAngG   = prev->maxPivAngG;
+    data->maxPivAngO   = prev->maxPivAngO;
+    data->extSpringOut = prev->extSpringOut;
+    data->offsets_     = prev->offsets_;
+    data->fids         = prev->fids;
+    memcpy(data->failed, prev->failed, sizeof(data->failed));
+    sprintf(data->name, "field%u", index+1);
+    for (i = 0; i < FPIL_MAXPIVOTS ; ++i) {
+        CopyCrosses(prev->crosses.above[i], &data->crosses.above[i], status);
+        CopyCrosses(prev->crosses.below[i], &data->crosses.below[i], status);
+    }
+    if (*status != STATUS__OK) {
+        tdFdeltaDataFree(data);
+        return NULL;
+    }
+    if (derive) {
+        const tdFinterim *cur = &data->current;
+        tdFtarget        *tar = &data->target;
+        for (i = 0; i < FPIL_MAXPIVOTS ; ++i) {
+            tar->mustMove[i] =
+                ((cur->park[i] != tar->park[i])||
+                 ((tar->park[i] != YES)&&
+                  ((cur->xf[i] != tar->xf[i])||
+                   (cur->yf[i] != tar->yf[i])||
+                   (cur->theta[i] != tar->theta[i])))) ? YES : NO;
+        }
+    }
+    return data;
+}
+
+/*+        T D F D E L T A B A T C H
+
+ *  Function name:
+      tdFdeltaBatchField
+
+ *  Function:
+      Plan a field, recording its moves, parks and robot time.
+
+ *  Description:
+      Plans the field with the given instrument, with output callbacks
+      which fill in field rather than build a command file.  The
+      callbacks are cleared again afterwards.  If the plan produces no
+      command file, field's status is TDFDELTA__BATCHSKIP if cancelled,
+      otherwise TDFDELTA__DELTAERR.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaBatchField (data, inst, cancel, field)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan.
+      (>) inst        (FpilType)        Its instrument description, null
+                                        for that of tdFdeltaFpilSet().
+      (>) cancel      (volatile int *)  Set to stop planning.
+      (<) field       (tdFbatchField *) The result.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, extracted from RunSeg().
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaBatchField (
+        tdFdeltaType   *data,
+        FpilType       inst,
+        volatile int   *cancel,
+        tdFbatchField  *field)
+{
+    Tally tally;
+
+    memset(field, 0, sizeof(*field));
+    memset(&tally, 0, sizeof(tally));
+    tally.field = field;
+    tally.robot.con = &data->constants;
+    data->out.clientData = &tally;
+    data->out.ersRep  = TallyErsRep;
+    data->out.cfNew   = TallyCfNew;
+    data->out.cfLine  = TallyCfLine;
+    data->out.cfCount = TallyCfCount;
+    data->out.cfDone  = TallyCfDone;
+    data->inst = inst;
+
+    tdFdeltaPlan(data, cancel, &field->status);
+    if ((field->status == STATUS__OK)&&(!tally.done))
+        field->status = (TDFDELTA_CANCELLED(cancel) ? TDFDELTA__BATCHSKIP
+                                                    : TDFDELTA__DELTAERR);
+    if (field->status == STATUS__OK) {
+        field->robotTime = tally.robot.time;
+        field->error[0] = '\0';
+    }
+
+    /*
+     *  The callbacks refer to our stack.
+     */
+    memset(&data->out, 0, sizeof(data->out));
+}
+
+/*
+ *  Count a field as finished.
+ */
+static void FieldDone(
+        tdFbatch  *batch)
+{
+    tdFdeltaLock();
+    ++batch->fieldsDone;
+    tdFdeltaUnlock();
+}
+
+/*
+ *  Plan the fields of a segment, in order.
+ */
+static void RunSeg(
+        tdFbatch     *batch,
+        tdFbatchSeg  *seg,
+        FpilType     inst)
+{
+    const tdFdeltaType *prev = seg->start;
+    tdFdeltaType *last = 0;
+    StatusType   skip = STATUS__OK;
+    unsigned     i;
+
+    seg->numMoves = seg->numParks = 0;
+    seg->robotTime = 0.0;
+    seg->numPlanned = 0;
+
+    for (i = 0; i < seg->numFields ; ++i) {
+        tdFbatchField *field = &seg->fields[i];
+        tdFdeltaType  *data;
+
+        memset(field, 0, sizeof(*field));
+        if ((skip == STATUS__OK)&&(TDFDELTA_LOAD(&batch->cancel)))
+            skip = TDFDELTA__BATCHSKIP;
+        if (skip != STATUS__OK) {
+            field->status = skip;
+            FieldDone(batch);
+            continue;
+        }
+
+        if ((data = tdFdeltaBatchChain(prev, &seg->targets[i], (i > 0), i,
+                                       &field->status)) != NULL)
+            tdFdeltaBatchField(data, inst, &batch->cancel, field);
+        if (field->status != STATUS__OK) {
+            if (data) tdFdeltaDataFree(data);
+            skip = TDFDELTA__BATCHSKIP;
+            FieldDone(batch);
+            continue;
+        }
+
+        seg->numMoves += field->numMoves;
+        seg->numParks += field->numParks;
+        seg->robotTime += field->robotTime;
+        ++seg->numPlanned;
+
+        /*
+         *  Keep this plan as the start of the next, the one before is
+         *  no longer needed.
+         */
+        if (last) tdFdeltaDataFree(last);
+        prev = last = data;
+        FieldDone(batch);
+    }
+    if (last) tdFdeltaDataFree(last);
+}
+
+/*
+ *  Plan segments until there are none left.
+ */
+static void *WorkerMain(
+        void  *arg)
+{
+    Worker   *worker = (Worker *)arg;
+    tdFbatch *batch = worker->batch;
+
+    for (;;) {
+        unsigned seg;
+        tdFdeltaLock();
+        seg = batch->nextSeg++;
+        tdFdeltaUnlock();
+        if (seg >= batch->numSegs) break;
+        RunSeg(batch, &batch->segs[seg], worker->inst);
+    }
+    return 0;
+}
+
+
+/*+        T D F D E L T A B A T C H
+
+ *  Function name:
+      tdFdeltaBatch
+
+ *  Function:
+      Plan a batch of fields.
+
+ *  Description:
+      Plans each segment of the batch, the fields of a segment in order,
+      each starting from the final state of the one before, and fills
+      in each field's and segment's moves, parks and robot time.  The
+      segments are shared between one thread per instrument given, the
+      calling thread being one of them, and this returns when all are
+      planned.
+
+      Failure to plan a field is not an error of the batch, it is
+      reported in the field's status and error text.  Setting the batch's
+      cancel item stops planning; fields not planned then have status
+      TDFDELTA__BATCHSKIP.  batch->fieldsDone counts the fields finished
+      with, for progress reports from another thread.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaBatch (batch, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) batch       (tdFbatch *)      The batch.  The segments, their
+                                        start plans and targets and the
+                                        instruments are input, the field
+                                        and segment results are output.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaBatch (
+        tdFbatch    *batch,
+        StatusType  *status)
+{
+    Worker   workers[TDFDELTA_BATCH_THREADS];
+    unsigned numWorkers = 1;
+    unsigned i;
+
+    if (*status != STATUS__OK) return;
+
+    batch->nextSeg = 0;
+    batch->fieldsDone = 0;
+
+    workers[0].batch = batch;
+    workers[0].inst = (batch->insts ? batch->insts[0] : 0);
+#ifdef TDFDELTA_REENTRANT
+    if (batch->insts) {
+        numWorkers = batch->numInsts;
+        if (numWorkers > TDFDELTA_BATCH_THREADS)
+            numWorkers = TDFDELTA_BATCH_THREADS;
+        if (numWorkers > batch->numSegs)
+            numWorkers = batch->numSegs;
+        if (numWorkers < 1)
+            numWorkers = 1;
+    }
+    for (i = 1; i < numWorkers ; ++i) {
+        workers[i].batch = batch;
+        workers[i].inst = batch->insts[i];
+        if (pthread_create(&workers[i].thread, 0, WorkerMain,
+                           &workers[i]) != 0) {
+            /*
+             *  Plan with the threads we have.
+             */
+            numWorkers = i;
+            break;
+        }
+    }
+#endif
+    WorkerMain(&workers[0]);
+#ifdef TDFDELTA_REENTRANT
+    for (i = 1; i < numWorkers ; ++i)
+        pthread_join(workers[i].thread, 0);
+#endif
+}
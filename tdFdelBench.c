@@ -0,0 +1,367 @@
+/*+               T D F D E L T A
+
+ *  Module name:
+      tdFbench
+
+ *  Function:
+      Planner scaling benchmark.
+
+ *  Description:
+      Generates random, but valid, current and target fields for the
+      stand-in 2dF-like and 6dF-like instruments (see tdFdelFpilSim.c) and
+      times the field check and both sequencers on them, for a range of
+      numbers of pivots.  The normal sequencer is also timed with a warm
+      start (see tdFdelWarm.c), as if the current field had been set up
+      by the previous plan.  The other engines are timed cold.  One CSV
+      line is written for each field and each of the four, giving the wall clock time, the FPIL
+      collision check call counts (as per DELTA_STATS), the number of
+      pair checks skipped by the warm start, the number of moves and
+      parks in the command file, for the normal sequencer the number of
+      extra parks and the time the robot would take to carry out the
+      command file (see tdFdelRobot.c).
+
+      The fields are generated by tdFdeltaGenField() (see tdFdelGen.c)
+      from a seed, so a run may be repeated exactly.
+
+      Usage:
+
+          tdFbench [options]
+
+      Options:
+
+          -g 2df|6df|both       Geometry, default both.
+          -n first,last,step    Numbers of pivots, default 100,2000,100.
+                                Sizes above FPIL_MAXPIVOTS are skipped.
+          -d density            Fraction of pivots placed, default 0.8.
+          -c crossing           Crossing rate (0 to 1), default 0.5.
+          -m mustMove           Fraction of pivots to move, default 0.7.
+          -t tweak              Target is a tweak of the current field,
+                                moving fibres by up to this many
+                                microns, default 0 (not a tweak).
+          -s seed               First seed, default 1.
+          -r repeats            Fields per size, using seeds seed,
+                                seed+1 ..., default 1.
+          -o file               CSV output file, default stdout.
+          -v                    Output planner messages to stderr.
+
+      The program is linked with the stand-in instrument model, not the
+      FPIL library, and does not use DRAMA.  In a single instrument build
+      (see tdFdeltaCore.h), only that instrument's geometry at its
+      nominal number of pivots may be used, other sizes are skipped.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Field generator moved to tdFdelGen.c.
+      18-Oct-2026  AGT  Add the warm engine, the tweak option and the
+                        warmSkips column.
+      18-Oct-2026  AGT  Add the robotSecs column.
+      18-Oct-2026  AGT  Add the intgeom engine.
+      18-Oct-2026  AGT  Skip instruments which do not suit a single
+                        instrument build.
+      18-Oct-2026  AGT  Tracing is now per plan, so need not be disabled.
+      19-Oct-2026  AGT  Remove the intgeom engine, INT_GEOM is gone.
+      {@change entry@}
+
+ *  @(#) $Id: ACMM:2dFdelta/tdFdelBench.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
+ */
+
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelBench.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"             /* STATUS__OK definition          */
+
+#include "tdFdeltaCore.h"       /* Planning core                  */
+#include "tdFdelta_Err.h"       /* TDFDLETA Errors                */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  The engines we time.
+ */
+#define ENG_CHECK       0
+#define ENG_SEQUENCER   1
+#define ENG_SPECIAL     2
+#define ENG_WARM        3
+#define NUM_ENG         4
+
+static const char * const engName[NUM_ENG] = {
+    "check", "sequencer", "special", "warm" };
+
+/*
+ *  Benchmark parameters.
+ */
+typedef struct {
+    tdFgenParams    gen;
+    unsigned long   seed;
+    int             verbose;
+    } BenchParams;
+
+/*
+ *  Command file counts, from the cfCount callback, and the robot time,
+ *  from the cfLine callback.
+ */
+typedef struct {
+    long     moves;
+    long     parks;
+    int      verbose;
+    tdFrobot robot;
+    } Counts;
+
+/*
+ *  Output callbacks.
+ */
+static void BenchMsgOut(
+        void        *clientData,
+        const char  *text)
+{
+    if (((Counts *)clientData)->verbose)
+        fprintf(stderr, "%s\n", text);
+}
+
+static void BenchErsRep(
+        void        *clientData,
+        int         flags,
+        StatusType  *status,
+        const char  *text)
+{
+    if (((Counts *)clientData)->verbose)
+        fprintf(stderr, "!! %s\n", text);
+}
+
+static void BenchCfCount(
+        void        *clientData,
+        const char  *name,
+        long int    value,
+        StatusType  *status)
+{
+    Counts *counts = (Counts *)clientData;
+    if (strcmp(name, "numMoves") == 0)
+        counts->moves = value;
+    else if (strcmp(name, "numParks") == 0)
+        counts->parks = value;
+}
+
+static void BenchCfLine(
+        void        *clientData,
+        const char  *name,
+        const char  *line,
+        StatusType  *status)
+{
+    tdFdeltaRobotLine(&((Counts *)clientData)->robot, line);
+}
+
+/*
+ *  Time one engine on one field and output the CSV line.
+ */
+static void RunOne(
+        FILE               *csv,
+        unsigned           numPivots,
+        const BenchParams  *params,
+        unsigned long      seed,
+        int                engine)
+{
+    StatusType    status = STATUS__OK;
+    tdFdeltaType  *data;
+    Counts        counts;
+    unsigned      placed = 0;
+    unsigned      moving = 0;
+    unsigned      i;
+    double        tStart;
+    double        ms = 0;
+    int           never = 0;
+
+    if ((data = tdFdeltaGenField(&params->gen, seed, &status)) == NULL) {
+        fprintf(stderr, "tdFbench: failed to generate field, seed %lu\n",
+                seed);
+        return;
+    }
+    for (i = 0; i < numPivots ; ++i) {
+        if (data->target.park[i] != YES) ++placed;
+        if (data->target.mustMove[i] == YES) ++moving;
+    }
+
+    memset(&counts, 0, sizeof(counts));
+    counts.verbose = params->verbose;
+    data->out.clientData = &counts;
+    data->out.msgOut = BenchMsgOut;
+    data->out.ersRep = BenchErsRep;
+    data->out.cfCount = BenchCfCount;
+    data->out.cfLine = BenchCfLine;
+    tdFdeltaRobotStart(&counts.robot, &data->current, &data->constants);
+    tdFdeltaUse(data);
+
+    /*
+     *  For the warm start, the pair matrix is built from the current
+     *  field, as the previous plan would have left it.
+     */
+    tdFdeltaWarmClear();
+    if (engine == ENG_WARM) {
+        tdFdeltaWarmSave(data, &status);
+        tdFdeltaStatsInit(&data->stats);
+    }
+
+    /*
+     *  The sequencers are timed on fields which have passed the check,
+     *  with the check's statistics discarded.
+     */
+    tStart = tdFdeltaClock();
+    if (tdFdeltaFieldCheckRun(data, 0, &status) && (engine != ENG_CHECK)) {
+        tdFdeltaStatsInit(&data->stats);
+        tStart = tdFdeltaClock();
+        if ((engine == ENG_SEQUENCER)||(engine == ENG_WARM))
+            tdFdeltaSequencerRun(data, &never, &status);
+        else
+            tdFdeltaSequencerSpecialRun(data, 0, &status);
+    }
+    ms = (tdFdeltaClock() - tStart)*1.0e3;
+
+    fprintf(csv, "%s,%u,%g,%g,%g,%ld,%lu,%s,%u,%u,%.3f,%lu,%lu,%lu,%lu,"
+                 "%lu,%lu,%ld,%ld,%d,%.1f,%s\n",
+            FpilGetInstName(tdFdeltaFpilInst()), numPivots,
+            params->gen.density, params->gen.crossing, params->gen.mustMove,
+            params->gen.tweak, seed,
+            engName[engine], placed, moving, ms,
+            data->stats.colButBut, data->stats.colButFib,
+            data->stats.colFibFib, data->stats.crossAdds,
+            data->stats.crossDeletes, data->stats.warmSkips,
+            counts.moves, counts.parks,
+            ((engine == ENG_SEQUENCER)||(engine == ENG_WARM) ?
+             (int)data->seq.extraParks : 0),
+            counts.robot.time,
+            (status == STATUS__OK ? "ok" : "bad"));
+    fflush(csv);
+    tdFdeltaDataFree(data);
+}
+
+static void Usage(
+        const char  *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [-g 2df|6df|both] [-n first,last,step] [-d density]\n"
+        "          [-c crossing] [-m mustMove] [-t tweak] [-s seed]\n"
+        "          [-r repeats] [-o file] [-v]\n", prog);
+}
+
+int main(
+        int   argc,
+        char  *argv[])
+{
+    BenchParams  params;
+    FILE         *csv = stdout;
+    unsigned     first = 100;
+    unsigned     last = 2000;
+    unsigned     step = 100;
+    unsigned     repeats = 1;
+    int          geomFirst = 0;
+    int          geomLast = 1;
+    int          sixdf;
+    int          i;
+
+    params.gen.density  = 0.8;
+    params.gen.crossing = 0.5;
+    params.gen.mustMove = 0.7;
+    params.gen.tweak    = 0;
+    params.seed     = 1;
+    params.verbose  = 0;
+
+    for (i = 1; i < argc ; ++i) {
+        const char *opt = argv[i];
+        const char *val = (i+1 < argc ? argv[i+1] : 0);
+        if (strcmp(opt, "-v") == 0) {
+            params.verbose = 1;
+            continue;
+        }
+        if ((opt[0] != '-')||(!val)||(opt[2] != '\0')) {
+            Usage(argv[0]);
+            return 2;
+        }
+        ++i;
+        switch (opt[1]) {
+          case 'g':
+            if (strcmp(val, "2df") == 0)       geomLast = 0;
+            else if (strcmp(val, "6df") == 0) geomFirst = 1;
+            else if (strcmp(val, "both") != 0) { Usage(argv[0]); return 2; }
+            break;
+          case 'n':
+            if ((sscanf(val, "%u,%u,%u", &first, &last, &step) != 3)||
+                (first == 0)||(step == 0)) {
+                Usage(argv[0]);
+                return 2;
+            }
+            break;
+          case 'd': params.gen.density  = atof(val); break;
+          case 'c': params.gen.crossing = atof(val); break;
+          case 'm': params.gen.mustMove = atof(val); break;
+          case 't': params.gen.tweak    = atol(val); break;
+          case 's': params.seed     = strtoul(val, 0, 10); break;
+          case 'r': repeats         = (unsigned)atoi(val); break;
+          case 'o':
+            if ((csv = fopen(val, "w")) == NULL) {
+                fprintf(stderr, "%s: failed to open %s\n", argv[0], val);
+                return 1;
+            }
+            break;
+          default:
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    fprintf(csv, "geometry,pivots,density,crossing,mustMove,tweak,seed,"
+                 "engine,placed,moving,wallMs,colButBut,colButFib,"
+                 "colFibFib,crossAdds,crossDeletes,warmSkips,moves,parks,"
+                 "extraParks,robotSecs,status\n");
+
+    for (sixdf = geomFirst; sixdf <= geomLast ; ++sixdf) {
+        unsigned n;
+        for (n = first; n <= last ; n += step) {
+            StatusType  status = STATUS__OK;
+            FpilType    inst;
+            unsigned    r;
+
+            if (n > FPIL_MAXPIVOTS) {
+                fprintf(stderr,
+                        "%s: %u pivots skipped, FPIL_MAXPIVOTS is %d\n",
+                        argv[0], n, FPIL_MAXPIVOTS);
+                continue;
+            }
+            tdFdeltaFpilSimInit(tdFdeltaFpilSimGeom(sixdf), n, &inst,
+                                &status);
+            if (status != STATUS__OK) {
+                fprintf(stderr, "%s: failed to create instrument\n", argv[0]);
+                return 1;
+            }
+            if (!tdFdeltaFpilFixed(inst)) {
+                fprintf(stderr,
+                        "%s: %s with %u pivots skipped, not this build's "
+                        "instrument\n", argv[0], FpilGetInstName(inst), n);
+                FpilFree(inst);
+                continue;
+            }
+            tdFdeltaFpilSet(inst);
+
+            for (r = 0; r < repeats ; ++r) {
+                int engine;
+                for (engine = 0; engine < NUM_ENG ; ++engine)
+                    RunOne(csv, n, &params, params.seed + r, engine);
+            }
+            FpilFree(inst);
+        }
+    }
+
+    if (csv != stdout) fclose(csv);
+    return 0;
+}
@@ -0,0 +1,853 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaCache
+
+ *  Function:
+      Cache of recent GENERATE results.
+
+ *  Description:
+      Operators often re-issue the same GENERATE after an unrelated abort.
+      Once GENERATE has converted its arguments, tdFdeltaCacheLookup()
+      works out a key from everything the field check and sequencer will
+      use - the target, constants, offsets, fiducials, current field
+      details (including the crossover lists built from the "above"
+      item), the clearances, angles, failed pivots, flags and the
+      instrument.  The command file name, and the flags which only
+      change how the plan is run or output (THREAD, TRACE, SNAPSHOT,
+      PACKED and STREAM), are not part of the key.
+
+      If a cached result has the same key, its command file and
+      statistics are passed straight to the plan's callbacks, under the
+      new command file name, and the plan need not be run.  Otherwise a
+      recording is attached to the plan.  The command file functions
+      (tdFdelCmdFile.c) add each line and count to the recording, and
+      when a complete command file has been output, tdFdeltaPutStats()
+      moves it into the cache along with the statistics.  Plans which
+      fail, are cancelled or output no command file are not cached.
+
+      The key is four independent 32 bit FNV-1a hashes of the inputs,
+      so an exact copy of the inputs need not be held.  The cache holds
+      at most TDFDELTA_CACHE_ENTRIES results and TDFDELTA_CACHE_BYTES
+      bytes, the least recently used result being discarded to make
+      room.  A recording which grows beyond TDFDELTA_CACHE_BYTES is
+      abandoned.
+
+      The cache is cleared when the instrument is changed (see
+      tdFdeltaFpilSet()).  It is shared by all plans, and only used
+      under tdFdeltaLock().  A hit is copied out before it is replayed,
+      so the lock is not held across the plan's callbacks.  Recordings
+      belong to their plans and need no lock until they are cached.
+
+      The cache hits and misses so far and the size of the cache are
+      added to the statistics (see tdFdeltaCacheStats()).
+
+      A result may also be prepared ahead of the GENERATE which needs it
+      (see tdFdeltaCachePrepare() and the PREPARE action).  The prepared
+      plan's recording takes its cache entry straight away, marked as
+      pending, and is not evicted until it completes.  A lookup which
+      finds a pending entry with its key returns TDFDELTA_CACHE_PENDING,
+      and should be retried.  Should the prepared plan fail, its entry is
+      dropped and the retry is a miss.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
+      18-Oct-2026  AGT  The cache is used under tdFdeltaLock(), the
+                        recording selected per thread.
+      18-Oct-2026  AGT  Add tdFdeltaCachePrepare() and pending entries.
+      18-Oct-2026  AGT  Add tdFdeltaCacheRecording().  The PACKED flag is
+                        not part of the key.
+      18-Oct-2026  AGT  Nor is the STREAM flag.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelCache.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelCache.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LANES     4           /* 32 bit hashes in a key          */
+#define FNV_PRIME       16777619UL
+#define FNV_BASIS       2166136261UL
+
+/*
+ *  Recording item types.  Each item in the buffer is the type
+ *  character, then the null terminated name and text.  Counts are
+ *  held as text.
+ */
+#define ITEM_LINE       'L'
+#define ITEM_COUNT      'C'
+
+/*
+ *  A result, either being recorded or in the cache.
+ */
+struct tdFcacheRec {
+    unsigned long   key[CACHE_LANES];
+    char            *buf;           /* Recorded items                  */
+    size_t          len;            /* Bytes used in buf               */
+    size_t          alloc;          /* Bytes allocated to buf          */
+    short           complete;       /* cfDone called with keep true    */
+    short           abandoned;      /* Failed, cancelled or too big    */
+    short           prepared;       /* From tdFdeltaCachePrepare()     */
+    short           pending;        /* In the cache, but not complete.
+                                       Only used under tdFdeltaLock()  */
+    tdFstats        stats;          /* Statistics of the plan          */
+    unsigned long   used;           /* useClock when last used         */
+    tdFcacheRec     **owner;        /* Plan's pointer to the recording */
+    };
+
+static tdFcacheRec  *cache[TDFDELTA_CACHE_ENTRIES];
+static size_t       cacheBytes = 0;
+static unsigned long useClock = 0;
+static unsigned long cacheHits = 0;
+static unsigned long cacheMisses = 0;
+
+/*
+ *  The recording of the plan being run, see tdFdeltaCacheUse().
+ */
+static TDFDELTA_TLS tdFcacheRec  *curRec = 0;
+
+/*
+ *  Add bytes to a key.
+ */
+static void Hash(
+        unsigned long  key[CACHE_LANES],
+        const void     *bytes,
+        size_t         len)
+{
+    const unsigned char *p = (const unsigned char *)bytes;
+    unsigned long h0 = key[0], h1 = key[1], h2 = key[2], h3 = key[3];
+    size_t i;
+    for (i = 0; i < len ; ++i) {
+        h0 = ((h0 ^ p[i]) * FNV_PRIME) & 0xffffffffUL;
+        h1 = ((h1 ^ p[i]) * FNV_PRIME) & 0xffffffffUL;
+        h2 = ((h2 ^ p[i]) * FNV_PRIME) & 0xffffffffUL;
+        h3 = ((h3 ^ p[i]) * FNV_PRIME) & 0xffffffffUL;
+    }
+    key[0] = h0; key[1] = h1; key[2] = h2; key[3] = h3;
+}
+
+/*
+ *  Work out the key for a plan's inputs.
+ */
+static void MakeKey(
+        const tdFdeltaType  *data,
+        unsigned long       key[CACHE_LANES])
+{
+    FpilType    inst = tdFdeltaFpilInst();
+    const char  *instName = FpilGetInstName(inst);
+    unsigned    numPivots = tdFdeltaNumPivots(inst);
+    short       check = data->check & ~(THREAD|TRACE|SNAPSHOT|PACKED|STREAM);
+    int         i;
+
+    for (i = 0; i < CACHE_LANES ; ++i)
+        key[i] = (FNV_BASIS ^ (0x9e3779b9UL*(unsigned long)i)) & 0xffffffffUL;
+
+    Hash(key, instName, strlen(instName));
+    Hash(key, &numPivots, sizeof(numPivots));
+    Hash(key, &data->current, sizeof(data->current));
+    Hash(key, &data->constants, sizeof(data->constants));
+    Hash(key, &data->offsets_, sizeof(data->offsets_));
+    Hash(key, &data->fids, sizeof(data->fids));
+    Hash(key, &data->target, sizeof(data->target));
+    Hash(key, &data->maxButAngG, sizeof(data->maxButAngG));
+    Hash(key, &data->maxButAngO, sizeof(data->maxButAngO));
+    Hash(key, &data->maxPivAngG, sizeof(data->maxPivAngG));
+    Hash(key, &data->maxPivAngO, sizeof(data->maxPivAngO));
+    Hash(key, &data->butClearG, sizeof(data->butClearG));
+    Hash(key, &data->butClearO, sizeof(data->butClearO));
+    Hash(key, &data->fibClearG, sizeof(data->fibClearG));
+    Hash(key, &data->fibClearO, sizeof(data->fibClearO));
+    Hash(key, &data->extSpringOut, sizeof(data->extSpringOut));
+    Hash(key, &check, sizeof(check));
+    Hash(key, data->failed, sizeof(data->failed));
+
+    /*
+     *  The crossover lists, in order, each ended by -1.
+     */
+    for (i = 0; i < FPIL_MAXPIVOTS ; ++i) {
+        static const short end = -1;
+        FibreCross *p;
+        for (p = data->crosses.above[i]; p ; p = p->next)
+            Hash(key, &p->piv, sizeof(p->piv));
+        Hash(key, &end, sizeof(end));
+        for (p = data->crosses.below[i]; p ; p = p->next)
+            Hash(key, &p->piv, sizeof(p->piv));
+        Hash(key, &end, sizeof(end));
+    }
+}
+
+/*
+ *  Size of a result for the cache limits.
+ */
+static size_t RecSize(
+        const tdFcacheRec  *rec)
+{
+    return sizeof(*rec) + rec->alloc;
+}
+
+static void RecFree(
+        tdFcacheRec  *rec)
+{
+    if (!rec) return;
+    free(rec->buf);
+    free(rec);
+}
+
+/*
+ *  Add an item to the recording.
+ */
+static void RecAdd(
+        int         type,
+        const char  *name,
+        const char  *text)
+{
+    size_t nameLen = strlen(name) + 1;
+    size_t textLen = strlen(text) + 1;
+    size_t need = 1 + nameLen + textLen;
+    tdFcacheRec *rec = curRec;
+
+    if ((!rec)||(rec->abandoned)) return;
+    if (rec->len + need > rec->alloc) {
+        size_t alloc = (rec->alloc ? rec->alloc*2 : 4096);
+        char   *buf;
+        while (alloc < rec->len + need) alloc *= 2;
+        if ((alloc + sizeof(*rec) > TDFDELTA_CACHE_BYTES)||
+            ((buf = (char *)realloc(rec->buf, alloc)) == NULL)) {
+            rec->abandoned = YES;
+            return;
+        }
+        rec->buf = buf;
+        rec->alloc = alloc;
+    }
+    rec->buf[rec->len++] = (char)type;
+    memcpy(rec->buf + rec->len, name, nameLen);
+    rec->len += nameLen;
+    memcpy(rec->buf + rec->len, text, textLen);
+    rec->len += textLen;
+}
+
+/*
+ *  Discard the least recently used result, other than those pending.
+ *  Returns false if there is none.  Called under tdFdeltaLock().
+ */
+static int Evict(void)
+{
+    int oldest = -1;
+    int i;
+    for (i = 0; i < TDFDELTA_CACHE_ENTRIES ; ++i) {
+        if ((cache[i])&&(!cache[i]->pending)&&
+            ((oldest < 0)||(cache[i]->used < cache[oldest]->used)))
+            oldest = i;
+    }
+    if (oldest < 0) return NO;
+    cacheBytes -= RecSize(cache[oldest]);
+    RecFree(cache[oldest]);
+    cache[oldest] = 0;
+    return YES;
+}
+
+/*
+ *  Take a pending recording out of the cache, it then belongs to its plan
+ *  alone.  Called under tdFdeltaLock().
+ */
+static void Unlist(
+        tdFcacheRec  *rec)
+{
+    int i;
+    if (!rec->pending) return;
+    for (i = 0; i < TDFDELTA_CACHE_ENTRIES ; ++i) {
+        if (cache[i] == rec) cache[i] = 0;
+    }
+    rec->pending = NO;
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheLookup
+
+ *  Function:
+      Look up a plan's result in the cache.
+
+ *  Description:
+      Works out the key of the plan's inputs.  If a result with the same
+      key is cached, its command file is passed to the plan's cfNew,
+      cfLine, cfCount and cfDone callbacks, under the plan's command file
+      name, followed by its statistics, and true is returned.  The plan
+      should not then be run.
+
+      If the result is still being prepared (see tdFdeltaCachePrepare()),
+      TDFDELTA_CACHE_PENDING is returned and nothing else is done.  The
+      caller should wait a little and look up the result again.
+
+      Otherwise a recording is attached to the plan, so that its result
+      is cached if it completes, and false is returned.  Failure to
+      allocate the recording is not an error, the result just isn't
+      cached.  Likewise, if a hit can't be copied out of the cache, it
+      is treated as a miss.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaCacheLookup (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data, as converted and
+                                        before the field check.  Must
+                                        have been selected with
+                                        tdFdeltaUse().
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      True if the result was found in the cache, TDFDELTA_CACHE_PENDING
+      if it is being prepared.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Replay a copy of the hit, made under the lock.
+      18-Oct-2026  AGT  Return TDFDELTA_CACHE_PENDING for a result being
+                        prepared.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaCacheLookup (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    const tdFdeltaCallbacks *out = tdFdeltaOut();
+    unsigned long  key[CACHE_LANES];
+    tdFcacheRec    *hit = 0;
+    tdFstats       stats;
+    char           *buf = 0;
+    size_t         len = 0;
+    const char     *p;
+    int            prepared = NO;
+    int            i;
+
+    if (*status != STATUS__OK) return NO;
+
+    /*
+     *  Another plan may evict the hit once we unlock, so take a copy.
+     */
+    MakeKey(data, key);
+    tdFdeltaLock();
+    for (i = 0; (i < TDFDELTA_CACHE_ENTRIES)&&(!hit) ; ++i) {
+        if ((cache[i])&&(memcmp(cache[i]->key, key, sizeof(key)) == 0))
+            hit = cache[i];
+    }
+    if ((hit)&&(hit->pending)) {
+        tdFdeltaUnlock();
+        return TDFDELTA_CACHE_PENDING;
+    }
+    if ((hit)&&((buf = (char *)malloc(hit->len + 1)) != NULL)) {
+        memcpy(buf, hit->buf, hit->len);
+        len = hit->len;
+        stats = hit->stats;
+        prepared = hit->prepared;
+        ++cacheHits;
+        hit->used = ++useClock;
+    } else
+        ++cacheMisses;
+    tdFdeltaUnlock();
+
+    if (!buf) {
+        tdFdeltaCacheFree(data->cache);
+        if ((data->cache = (tdFcacheRec *)calloc(1, sizeof(tdFcacheRec)))) {
+            memcpy(data->cache->key, key, sizeof(key));
+            data->cache->owner = &data->cache;
+            tdFdeltaCacheUse(data->cache);
+        }
+        return NO;
+    }
+
+    /*
+     *  Replay the command file.
+     */
+    if (out->cfNew)
+        (*out->cfNew)(out->clientData, data->name, &data->current, status);
+    for (p = buf; (p < buf + len)&&(*status == STATUS__OK) ; ) {
+        int        type = *p++;
+        const char *name = p;
+        const char *text = name + strlen(name) + 1;
+        p = text + strlen(text) + 1;
+        if ((type == ITEM_LINE)&&(out->cfLine))
+            (*out->cfLine)(out->clientData, name, text, status);
+        else if ((type == ITEM_COUNT)&&(out->cfCount))
+            (*out->cfCount)(out->clientData, name, atol(text), status);
+    }
+    free(buf);
+    if (*status != STATUS__OK) {
+        tdFdeltaCFdelete();
+        return YES;
+    }
+    tdFdeltaCFdone(status);
+    tdFdeltaPutProgress(100.0, 0, status);
+    tdFdeltaMsgOut(status, "Command file generated - %s - %s",
+                   data->name, prepared ? "prepared in advance" : "from cache");
+
+    tdFdeltaCacheStats(&stats);
+    if ((*status == STATUS__OK)&&(out->stats))
+        (*out->stats)(out->clientData, &stats, status);
+    return YES;
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCachePrepare
+
+ *  Function:
+      Reserve a cache entry for a plan being prepared in advance.
+
+ *  Description:
+      Works out the key of the plan's inputs, as tdFdeltaCacheLookup()
+      does.  If a result with the same key is already cached or being
+      prepared, false is returned and there is nothing to do.
+
+      Otherwise a recording is attached to the plan and entered in the
+      cache straight away, as pending, making room for it if needed, and
+      true is returned.  The plan should then be run.  Until it
+      completes, a lookup with the same key returns
+      TDFDELTA_CACHE_PENDING.  Once it completes, the result is cached as
+      usual (see tdFdeltaCacheStats()).  If it fails, the entry is
+      dropped when the plan is released or its statistics are reported.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaCachePrepare (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data, as converted and
+                                        before the field check.  Must
+                                        have been selected with
+                                        tdFdeltaUse().
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      True if the plan should be run.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaCachePrepare (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFcacheRec    *rec;
+    int            found = NO;
+    int            slot = -1;
+    int            i;
+
+    if (*status != STATUS__OK) return NO;
+
+    if ((rec = (tdFcacheRec *)calloc(1, sizeof(tdFcacheRec))) == NULL) {
+        *status = TDFDELTA__MALLOCERR;
+        return NO;
+    }
+    MakeKey(data, rec->key);
+    rec->prepared = YES;
+
+    tdFdeltaLock();
+    for (i = 0; i < TDFDELTA_CACHE_ENTRIES ; ++i) {
+        if ((cache[i])&&
+            (memcmp(cache[i]->key, rec->key, sizeof(rec->key)) == 0))
+            found = YES;
+    }
+    while (!found) {
+        for (i = 0; i < TDFDELTA_CACHE_ENTRIES ; ++i) {
+            if (!cache[i]) slot = i;
+        }
+        if ((slot >= 0)||(!Evict())) break;
+    }
+    if (slot >= 0) {
+        rec->pending = YES;
+        rec->used = ++useClock;
+        cache[slot] = rec;
+    }
+    tdFdeltaUnlock();
+
+    if (slot < 0) {
+        RecFree(rec);
+        return NO;
+    }
+    tdFdeltaCacheFree(data->cache);
+    data->cache = rec;
+    rec->owner = &data->cache;
+    tdFdeltaCacheUse(rec);
+    return YES;
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheUse
+
+ *  Function:
+      Select the recording command file output is added to.
+
+ *  Description:
+      Called by tdFdeltaUse() with the plan's recording, which is null
+      if the plan's result is not to be cached.  Applies to the calling
+      thread.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCacheUse (rec)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) rec         (tdFcacheRec *)   The recording, may be null.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCacheUse (
+        tdFcacheRec  *rec)
+{
+    curRec = rec;
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheLine
+
+ *  Function:
+      Record a command file line or count.
+
+ *  Description:
+      Called by the command file functions for each line and count
+      passed to the plan.  Does nothing unless the plan is being
+      recorded.  If value is null, text is a count.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCacheLine (name, line, value)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) name        (const char *)    The item name, e.g. "line1" or
+                                        "numMoves".
+      (>) line        (const char *)    The line, or null for a count.
+      (>) value       (long int)        The count.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCacheLine (
+        const char  *name,
+        const char  *line,
+        long int    value)
+{
+    char text[30];
+    if (!curRec) return;
+    if (line)
+        RecAdd(ITEM_LINE, name, line);
+    else {
+        sprintf(text, "%ld", value);
+        RecAdd(ITEM_COUNT, name, text);
+    }
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheRecording
+
+ *  Function:
+      Is the current plan being recorded.
+
+ *  Description:
+      So the command file functions need only format lines which are
+      wanted, see the cfCmd callback.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaCacheRecording ()
+
+ *  Returned value:
+      True if tdFdeltaCacheLine() would record the lines.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaCacheRecording (
+        void)
+{
+    return (curRec != 0);
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheDone
+
+ *  Function:
+      Note the end of the command file being recorded.
+
+ *  Description:
+      Called with keep true when the command file is complete, or false
+      if it is discarded, in which case the recording is abandoned.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCacheDone (keep)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) keep        (int)             Command file complete.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCacheDone (
+        int         keep)
+{
+    if (!curRec) return;
+    if (keep)
+        curRec->complete = YES;
+    else
+        curRec->abandoned = YES;
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheStats
+
+ *  Function:
+      Cache a completed result and add the cache statistics.
+
+ *  Description:
+      Called by tdFdeltaPutStats() with a copy of the statistics about to
+      be reported.  If the plan's command file was completed, the
+      recording is moved into the cache, with the statistics, making
+      room if needed.  A pending entry (see tdFdeltaCachePrepare()) is
+      replaced by the result, or dropped if there is none.  Then the
+      cache statistics are set in stats -
+
+          cacheHits    - Results found in the cache.
+          cacheMisses  - Results not found.
+          cacheEntries - Results in the cache.
+          cacheBytes   - Memory used by the cache.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCacheStats (stats)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) stats       (tdFstats *)      The statistics.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Under tdFdeltaLock().
+      18-Oct-2026  AGT  Complete or drop a pending entry.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCacheStats (
+        tdFstats    *stats)
+{
+    tdFcacheRec *rec = curRec;
+    unsigned long entries = 0;
+    int i;
+
+    tdFdeltaLock();
+    if (rec)
+        Unlist(rec);
+    if ((rec)&&(rec->complete)&&(!rec->abandoned)) {
+        int slot = -1;
+        /*
+         *  Hand the recording over to the cache, making room for it.
+         */
+        rec->stats = *stats;
+        rec->complete = NO;
+        rec->used = ++useClock;
+        for (;;) {
+            for (i = 0, slot = -1; i < TDFDELTA_CACHE_ENTRIES ; ++i) {
+                if (!cache[i]) slot = i;
+            }
+            if ((slot >= 0)&&
+                (cacheBytes + RecSize(rec) <= TDFDELTA_CACHE_BYTES))
+                break;
+            if (cacheBytes == 0) break;
+            Evict();
+        }
+        if ((slot >= 0)&&(cacheBytes + RecSize(rec) <= TDFDELTA_CACHE_BYTES)) {
+            cache[slot] = rec;
+            cacheBytes += RecSize(rec);
+            *rec->owner = 0;
+            rec->owner = 0;
+            curRec = 0;
+        }
+    }
+
+    for (i = 0; i < TDFDELTA_CACHE_ENTRIES ; ++i) {
+        if (cache[i]) ++entries;
+    }
+    stats->cacheHits    = cacheHits;
+    stats->cacheMisses  = cacheMisses;
+    stats->cacheEntries = entries;
+    stats->cacheBytes   = (unsigned long)cacheBytes;
+    tdFdeltaUnlock();
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheFree
+
+ *  Function:
+      Release a plan's recording.
+
+ *  Description:
+      Called by tdFdeltaDataFree().  Once a result has been moved into
+      the cache, the plan no longer points to it.  A pending entry is
+      dropped from the cache.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCacheFree (rec)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) rec         (tdFcacheRec *)   The recording, may be null.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Drop a pending entry.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCacheFree (
+        tdFcacheRec  *rec)
+{
+    if (!rec) return;
+    if (curRec == rec) curRec = 0;
+    tdFdeltaLock();
+    Unlist(rec);
+    tdFdeltaUnlock();
+    RecFree(rec);
+}
+
+
+/*+        T D F D E L T A C A C H E
+
+ *  Function name:
+      tdFdeltaCacheClear
+
+ *  Function:
+      Discard all cached results.
+
+ *  Description:
+      Called when the instrument is changed.  The hit and miss counts
+      are kept.  Pending entries are dropped, but plans being prepared
+      carry on, their results being cached as usual if they complete.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCacheClear ()
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Under tdFdeltaLock().
+      18-Oct-2026  AGT  Drop pending entries.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCacheClear (void)
+{
+    int i;
+    tdFdeltaLock();
+    for (i = 0; i < TDFDELTA_CACHE_ENTRIES ; ++i) {
+        if ((cache[i])&&(cache[i]->pending))
+            Unlist(cache[i]);
+    }
+    while (Evict())
+        ;
+    tdFdeltaUnlock();
+}
@@ -7,6 +7,14 @@
       Contains functions to enable the creation of 2dF Command Files.
 
  *  Description:
+      The command file is output through the current plan's cfNew,
+      cfLine, cfCount and cfDone callbacks (see tdFdeltaCore.h).  If the
+      plan is being recorded for the result cache, the lines and counts
+      are also added to the recording (see tdFdelCache.c).
+
+      A plan with a cfCmd callback is given each line as its command and
+      parameters instead, and the text of the line is only formatted if
+      it is being recorded.
 
  *  Language:
       C
@@ -17,6 +25,20 @@
 
  *  History:
       01-Jul-1994  JW    Original version
+      18-Oct-2026  AGT   Add tdFdeltaCFgetCmd() to read back a command file.
+      18-Oct-2026  AGT   Output is saved for the main thread when called
+                         from a delta worker thread.  Add tdFdeltaCFdone()
+                         and tdFdeltaCFdelete().
+      18-Oct-2026  AGT   Time command file lines for DELTA_STATS.
+      18-Oct-2026  AGT   Part of the planning core.  The command file is
+                         passed to the plan's callbacks rather than built
+                         as an Sds structure here, so the functions no
+                         longer take a command file id.  The Sds command
+                         file is now built by tdFdelDrama.c, which also
+                         has tdFdeltaCFgetCmd().
+      18-Oct-2026  AGT   Record the command file for the result cache.
+      18-Oct-2026  AGT   Add the cfCmd callback, tdFdeltaCFformat() and
+                         tdFdeltaCFparse().
       {@change entry@}
 
  *  @(#) $Id: ACMM:2dFdelta/tdFdelCmdFile.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $ (mm/dd/yy)
@@ -31,23 +53,9 @@ static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelCmdFile.c,v 3.17 25-Aug-2014 1
 static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
 
 
-#include "DitsTypes.h"       /* Basic dits types            */
-#include "Dits_Err.h"        /* Dits error codes            */
-#include "DitsSys.h"         /* For PutActionHandlers       */
-#include "DitsFix.h"         /* For various Dits routines   */
-#include "DitsMsgOut.h"      /* For MsgOut                  */
-#include "DitsParam.h"       /* For DitsGetParId            */
-#include "DitsUtil.h"        /* For DitsErrorText           */
-#include "arg.h"             /* For ARG_ macros             */
-#include "sds.h"             /* For SDS_ macros             */
-#include "Sdp.h"             /* Sdp routines                */
-#include "mess.h"            /* For MessPutFacility         */
-#include "Git.h"             /* Git routines                */
-#include "Git_Err.h"         /* GIT__ codes                 */
-#include "Ers.h"
 #include "status.h"          /* STATUS__OK definition       */
 
-#include "tdFdelta.h"
+#include "tdFdeltaCore.h"
 #include "tdFdelta_Err.h"
 
 #include <stdio.h>
@@ -59,7 +67,58 @@ static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
 #   include <varargs.h>      /* For old style unix          */
 #endif
 
-
+/*
+ *  Pass a line of the command file to the plan.  The text is only
+ *  formatted if the plan has no cfCmd callback or is being recorded.
+ */
+static void PutCmd(
+    int             lineNo,
+    const tdFcfCmd  *c,
+    StatusType      *status)
+{
+    const tdFdeltaCallbacks *out = tdFdeltaOut();
+    int       wantLine = ((out->cfLine)&&(!out->cfCmd));
+    char      lineName[10],             /* Name for new entry    */
+              cmdLine[CMDLINE_LENGTH];  /* Command line contents */
+    double    tStart;
+    if (*status != STATUS__OK) return;
+    tStart = tdFdeltaClock();
+
+    /*
+     *  Comments must still fit a line.
+     */
+    if ((c->comment)&&(strlen(c->comment)+2 >= CMDLINE_LENGTH)) {
+        *status = TDFDELTA__SPRINTF;
+        return;
+    }
+    if (out->cfCmd)
+        (*out->cfCmd)(out->clientData,lineNo,c,status);
+    if ((wantLine)||(tdFdeltaCacheRecording())) {
+        sprintf(lineName,"line%d",lineNo);
+        tdFdeltaCFformat(c,cmdLine,status);
+        if ((*status == STATUS__OK)&&(wantLine))
+            (*out->cfLine)(out->clientData,lineName,cmdLine,status);
+        tdFdeltaCacheLine(lineName,cmdLine,0);
+    }
+    tdFdeltaStatsPhase(TDF_PHASE_CMDFILE, tStart);
+}
+
+/*
+ *  Pass a count to the plan.
+ */
+static void PutCount(
+    const char  *name,
+    long int    value,
+    StatusType  *status)
+{
+    const tdFdeltaCallbacks *out = tdFdeltaOut();
+    if (*status != STATUS__OK) return;
+    if (out->cfCount)
+        (*out->cfCount)(out->clientData,name,value,status);
+    tdFdeltaCacheLine(name,0,value);
+}
+
+
 /*
  *+           T D F D E L T A C M D F I L E
 
@@ -75,21 +134,18 @@ static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
       to be checked at the time of command file execution to confirm command file
       validity.
 
-      The function returns the SdsIdType for the generated command file.
+      The command file is started with the plan's cfNew callback, which
+      is given the current field details.
 
  *  Language:
       C
 
  *  Call:
-      (SdsIdType) = tdFdeltaCFnew (name,currDetails,status)
+      (void) = tdFdeltaCFnew (name,currDetails,status)
 
  *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
       (>) name         (char *)        Name of the command file to be generated.
       (>) currDetails  (tdFinterim *)  Pointer to current field details.
-      (>) above        (SdsIdType)    The SDS id of the above item from
-                                      the original plate current details
-                                      structure.  This is just copied
-                                      to the output file.
       (!) status       (StatusType *)  Modified status.
 
  *  Prior requirements:
@@ -105,59 +161,26 @@ static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
       20-Oct-2000  TJF   Add the new "above" item to the output so that
                          we can reconstruct the conditions before the
                          delta.
+      18-Oct-2026  AGT   Save details for the main thread if called
+                         from a worker thread.
+      18-Oct-2026  AGT   Now just calls the cfNew callback.  The Sds
+                         structure is created by tdFdeltaCFcreate().
       {@change entry@}
  */
-TDFDELTA_INTERNAL SdsIdType  tdFdeltaCFnew (
-        char        *name,
-        tdFinterim  *currDetails,
-        SdsIdType   *above,
-        StatusType  *status)
+TDFDELTA_INTERNAL void  tdFdeltaCFnew (
+        const char        *name,
+        const tdFinterim  *currDetails,
+        StatusType        *status)
 {
-    SdsIdType          newCmdFile,
-                       xId, yId,
-                       thetaId;
-    unsigned long int  dims = FpilGetNumPivots(tdFdeltaFpilInst());
-
-    if (*status != STATUS__OK) return (0);
-
-    /*
-     *  Create new command file (Sds structure).
-     */
-    SdsNew(0,name,0,NULL,SDS_STRUCT,0,NULL,&newCmdFile,status);
-    SdsNew(newCmdFile,"xf",0,NULL,SDS_INT,1,&dims,&xId,status);
-    SdsNew(newCmdFile,"yf",0,NULL,SDS_INT,1,&dims,&yId,status);
-    SdsNew(newCmdFile,"theta",0,NULL,SDS_DOUBLE,1,&dims,&thetaId,status);
-    /*
-     * If the SDS above structure exists, insert it into the
-     * command file and then free the id and make.
-     */
-    if (*above) {
-        SdsInsert(newCmdFile, *above, status);
-        SdsFreeId(*above, status);
-        *above = 0;
-    }
-
-    /*
-     *  Add x,y,theta for current field.
-     */
-    SdsPut(xId,sizeof(INT32)*dims,0,(void *)currDetails->xf,status);
-    SdsPut(yId,sizeof(INT32)*dims,0,(void *)currDetails->yf,status);
-    SdsPut(thetaId,sizeof(double)*dims,0,(void *)currDetails->theta,status);
+    const tdFdeltaCallbacks *out = tdFdeltaOut();
 
-    /*
-     *  Free sds id's.
-     */
-    SdsFreeId(xId,status);
-    SdsFreeId(yId,status);
-    SdsFreeId(thetaId,status);
+    if (*status != STATUS__OK) return;
 
-    /*
-     *  Return SdsIdType for command file.
-     */
-    return (newCmdFile);
+    if (out->cfNew)
+        (*out->cfNew)(out->clientData,name,currDetails,status);
 }
 
-
+
 /*
  *+           T D F D E L T A C M D F I L E
 
@@ -174,10 +197,9 @@ TDFDELTA_INTERNAL SdsIdType  tdFdeltaCFnew (
       C
 
  *  Call:
-      (void) = tdFdeltaCFaddMoves (cmdFileId,numMoves,numParks,status)
+      (void) = tdFdeltaCFaddMoves (numMoves,numParks,status)
 
  *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
-      (>) cmdFileId    (SdsIdType)     Name of the command file.
       (>) numMoves     (long int)      Number of moves to be performed.
       (>) numParks     (long int)      Number of parks to be performed.
       (!) status       (StatusType *)  Modified status.
@@ -190,10 +212,11 @@ TDFDELTA_INTERNAL SdsIdType  tdFdeltaCFnew (
 
  *  History:
       01-Jul-1994  JW   Original version
+      18-Oct-2026  AGT  Support worker threads.
+      18-Oct-2026  AGT  Use the cfCount callback.
       {@change entry@}
  */
 TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
-        SdsIdType   cmdFileId,
         long int    numMoves,
         long int    numParks,
         StatusType  *status)
@@ -201,8 +224,8 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
     /*
      *  Append the number of moves and parks to the command file.
      */
-    ArgPuti(cmdFileId,"numMoves",numMoves,status);
-    ArgPuti(cmdFileId,"numParks",numParks,status);
+    PutCount("numMoves",numMoves,status);
+    PutCount("numParks",numParks,status);
 }
 
 
@@ -217,17 +240,17 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
 
  *  Description:
       Adds a structure containing the command and appropiate parameters to the
-      command file (the SdsIdType).
+      command file, with the cfLine callback, or the cfCmd callback if
+      the plan has one.
 
  *  Language:
       C
 
  *  Call:
-      (void) = tdFdeltaCFaddCmd (status,cmdFileId,lineNo,cmd,param1,...)
+      (void) = tdFdeltaCFaddCmd (status,lineNo,cmd,param1,...)
 
  *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
       (!) status        (StatusType *)  Modified status.
-      (>) cmdFileId     (SdsIdType)     The Sds Id for the command file.
       (>) lineNo        (int)           The number of the line to be added.
       (>) cmd           (char *)        The command to be added.
       (>) param1,...    (...)           The accompanying parameters (see 
@@ -243,12 +266,15 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
  *  History:
       01-Jul-1994  JW   Original version
       10-Aug-1998  TJF  Drop offsets from output file
+      18-Oct-2026  AGT  Use PutLine() to support worker threads.
+      18-Oct-2026  AGT  Drop cmdFileId argument.
+      18-Oct-2026  AGT  Use the cfCmd callback if set, the line is only
+                        formatted if needed.
       {@change entry@}
  */
 #ifdef DSTDARG_OK
     TDFDELTA_INTERNAL void  tdFdeltaCFaddCmd (
             StatusType   *status,
-            SdsIdType    cmdFileId,
             int          lineNo,
             char         *cmd,
             ...)
@@ -258,34 +284,23 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
 #endif
 {
     va_list    args;                     /* Argument pointer list */
-    double     tarTheta;
-    INT32   tarXf, tarYf;             /* Command parameters    */
-    int        piv;
-    char       lineName[10],             /* Name for new entry    */
-               cmdLine[CMDLINE_LENGTH],  /* Command line contents */
-               *comment;
+    tdFcfCmd   c;                        /* Command and parameters */
 
 #   ifdef DSTDARG_OK
         va_start(args,cmd);
 #   else
         StatusType   *status;
-        SdsIdType    cmdFileId;
         int          lineNo;
         char         *cmd;
 
         va_start(args);
         status    = va_arg(args, StatusType *);
-        cmdFileId = va_arg(args, SdsIdType);
         lineNo    = va_arg(args, int);
         cmd       = va_arg(args, char *);
 #   endif
 
     if (*status != STATUS__OK) return;
-
-    /*
-     *  Name new structure `lineX', where X is the line number.
-     */
-    sprintf(lineName,"line%d",lineNo);
+    memset(&c,0,sizeof(c));
 
     /*
      *  Command is: MOVE FIBRE (MF).
@@ -295,21 +310,11 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
         /*
          *  Get MF args (must be in correct order).
          */
-        piv      = va_arg(args, int);
-        tarXf    = va_arg(args, INT32);
-        tarYf    = va_arg(args, INT32);
-        tarTheta = va_arg(args, double);
-
-        /*
-         *  Add new line to command file containing move details.
-         */
-        if (ErsSPrintf(sizeof(cmdLine),cmdLine,"%s %d %d %d %f",
-                        cmd,piv,tarXf,tarYf,tarTheta) == EOF)
-            *status = TDFDELTA__SPRINTF;
-        else
-            ArgPutString(cmdFileId,lineName,cmdLine,status);
-        va_end(args);
-        return;
+        c.op    = TDF_CF_MF;
+        c.piv   = va_arg(args, int);
+        c.xf    = va_arg(args, INT32);
+        c.yf    = va_arg(args, INT32);
+        c.theta = va_arg(args, double);
     }
 
     /*
@@ -320,59 +325,24 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
         /*
          *  Get PF args.
          */
-        piv  = va_arg(args, int);
-
-        /*
-         *  Add new line to command file containing park details.
-         */
-        if (ErsSPrintf(sizeof(cmdLine),cmdLine,"%s %d",cmd,piv) == EOF)
-            *status = TDFDELTA__SPRINTF;
-        else
-            ArgPutString(cmdFileId,lineName,cmdLine,status);
-        va_end(args);
-        return;
+        c.op    = TDF_CF_PF;
+        c.piv   = va_arg(args, int);
     }
 
     /*
      *  Command is: COMMENT (no echo) (!).
      */
     else if (strcmp("!",cmd) == 0) {
-
-        /*
-         *  Get ! arg.
-         */
-        comment = va_arg(args, char *);
-
-        /*
-         *  Add new line to command file containing comment.
-         */
-        if (ErsSPrintf(sizeof(cmdLine),cmdLine,"%s %s",cmd,comment) == EOF)
-            *status = TDFDELTA__SPRINTF;
-        else
-            ArgPutString(cmdFileId,lineName,cmdLine,status);
-        va_end(args);
-        return;
+        c.op      = TDF_CF_NOTE;
+        c.comment = va_arg(args, char *);
     }
 
     /*
      *  Command is: COMMENT (echo) (*).
      */
     else if (strcmp("*",cmd) == 0) {
-
-        /*
-         *  Get * arg.
-         */
-        comment = va_arg(args, char *);
-
-        /*
-         *  Add new line to command file containing comment.
-         */
-        if (ErsSPrintf(sizeof(cmdLine),cmdLine,"%s %s",cmd,comment) == EOF)
-            *status = TDFDELTA__SPRINTF;
-        else
-            ArgPutString(cmdFileId,lineName,cmdLine,status);
-        va_end(args);
-        return;
+        c.op      = TDF_CF_ECHO;
+        c.comment = va_arg(args, char *);
     }
 
     /*
@@ -383,6 +353,12 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
         va_end(args);
         return;
     }
+    va_end(args);
+
+    /*
+     *  Add new line to command file.
+     */
+    PutCmd(lineNo,&c,status);
 }
 /*
  *+           T D F D E L T A C M D F I L E
@@ -401,11 +377,9 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
       C
 
  *  Call:
-      (void) = tdFdeltaCFaddSpringOutParks (cmdFileId,numSpringOutParks, 
-      status)
+      (void) = tdFdeltaCFaddSpringOutParks (numSpringOutParks, status)
 
  *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
-      (>) cmdFileId    (SdsIdType)     Name of the command file.
       (>) numSpringOutParks (long int)      Number of spring out parks.
       (!) status       (StatusType *)  Modified status.
 
@@ -417,15 +391,228 @@ TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
 
  *  History:
       22-Sep-2002  TJF  Original version
+      18-Oct-2026  AGT  Support worker threads.
+      18-Oct-2026  AGT  Use the cfCount callback.
       {@change entry@}
  */
 TDFDELTA_INTERNAL void  tdFdeltaCFaddSpringOutParks (
-        SdsIdType   cmdFileId,
         long int    numSpringOutParks,
         StatusType  *status)
 {
     /*
      *  Append the number of sprint out parks to the file..
      */
-    ArgPuti(cmdFileId,"springOutParks",numSpringOutParks,status);
+    PutCount("springOutParks",numSpringOutParks,status);
+}
+
+
+/*
+ *+           T D F D E L T A C M D F I L E
+
+ *  Function name:
+      tdFdeltaCFdone
+
+ *  Function:
+      Completes a command file.
+
+ *  Description:
+      Tells the plan, with its cfDone callback, that the command file
+      is complete.  The task returns it as the action's output argument.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCFdone (status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status       (StatusType *)  Modified status.
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Use the cfDone callback.
+      18-Oct-2026  AGT  Tell the result cache.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCFdone (
+        StatusType  *status)
+{
+    const tdFdeltaCallbacks *out = tdFdeltaOut();
+    if (*status != STATUS__OK) return;
+    if (out->cfDone)
+        (*out->cfDone)(out->clientData,1,status);
+    tdFdeltaCacheDone(*status == STATUS__OK);
+}
+
+
+/*
+ *+           T D F D E L T A C M D F I L E
+
+ *  Function name:
+      tdFdeltaCFdelete
+
+ *  Function:
+      Discards a command file.
+
+ *  Description:
+      Used on errors to delete a partially generated command file.  This
+      is done regardless of the current status.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCFdelete ()
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Use the cfDone callback.
+      18-Oct-2026  AGT  Tell the result cache.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCFdelete (void)
+{
+    const tdFdeltaCallbacks *out = tdFdeltaOut();
+    StatusType ignore = STATUS__OK;
+    if (out->cfDone)
+        (*out->cfDone)(out->clientData,0,&ignore);
+    tdFdeltaCacheDone(NO);
+}
+
+
+/*
+ *+           T D F D E L T A C M D F I L E
+
+ *  Function name:
+      tdFdeltaCFparse
+
+ *  Function:
+      Parses a command file line.
+
+ *  Description:
+      The inverse of the formatting of tdFdeltaCFaddCmd(), for consumers
+      with a cfCmd callback given lines as text, e.g. replayed from the
+      result cache.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaCFparse (line,cmd)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) line          (const char *)  The line.
+      (<) cmd           (tdFcfCmd *)    The command.  For comments, the
+                                        comment points into line.
+
+ *  Returned value:
+      1 if the line was parsed, 0 if it is not a valid command.
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaCFparse (
+        const char  *line,
+        tdFcfCmd    *cmd)
+{
+    long xf, yf;
+
+    memset(cmd,0,sizeof(*cmd));
+    if ((line[0] == 'M')&&(line[1] == 'F')&&(line[2] == ' ')) {
+        if (sscanf(line+3,"%d %ld %ld %lf",
+                   &cmd->piv,&xf,&yf,&cmd->theta) != 4)
+            return (0);
+        cmd->op = TDF_CF_MF;
+        cmd->xf = (INT32)xf;
+        cmd->yf = (INT32)yf;
+    }
+    else if ((line[0] == 'P')&&(line[1] == 'F')&&(line[2] == ' ')) {
+        if (sscanf(line+3,"%d",&cmd->piv) != 1)
+            return (0);
+        cmd->op = TDF_CF_PF;
+    }
+    else if (((line[0] == '!')||(line[0] == '*'))&&
+             ((line[1] == ' ')||(line[1] == '\0'))) {
+        cmd->op = (line[0] == '!' ? TDF_CF_NOTE : TDF_CF_ECHO);
+        cmd->comment = (line[1] ? line+2 : line+1);
+    }
+    else
+        return (0);
+    return (1);
+}
+
+
+/*
+ *+           T D F D E L T A C M D F I L E
+
+ *  Function name:
+      tdFdeltaCFformat
+
+ *  Function:
+      Formats a command as a command file line.
+
+ *  Description:
+      The line is as written by tdFdeltaCFaddCmd(), e.g. to give the
+      lines of a packed command file to older readers.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCFformat (cmd,line,status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) cmd           (const tdFcfCmd *) The command.
+      (<) line          (char [CMDLINE_LENGTH]) The line.
+      (!) status        (StatusType *)  Modified status.  Set to
+                                        TDFDELTA__SPRINTF if the line
+                                        is too long.
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCFformat (
+        const tdFcfCmd  *cmd,
+        char            line[CMDLINE_LENGTH],
+        StatusType      *status)
+{
+    int n;
+
+    if (*status != STATUS__OK) return;
+    if (cmd->op == TDF_CF_MF)
+        n = snprintf(line,CMDLINE_LENGTH,"%s %d %d %d %f",
+                     "MF",cmd->piv,cmd->xf,cmd->yf,cmd->theta);
+    else if (cmd->op == TDF_CF_PF)
+        n = snprintf(line,CMDLINE_LENGTH,"%s %d","PF",cmd->piv);
+    else
+        n = snprintf(line,CMDLINE_LENGTH,"%s %s",
+                     (cmd->op == TDF_CF_NOTE ? "!" : "*"),cmd->comment);
+    if (n >= CMDLINE_LENGTH)
+        *status = TDFDELTA__SPRINTF;
 }
@@ -20,6 +20,9 @@
       30-Jun-1994  JW   Original version
       14-Feb-2013  TJF  Change all uses of SdsFind() to ArgFind(), giving us
                           better error reporting.
+      18-Oct-2026  AGT  Add tdFdeltaConvertCrossesToSds().
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
       {@change entry@}
 
  *      @(#) $Id: ACMM:2dFdelta/tdFdelConvert.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $ */
@@ -182,7 +185,7 @@ TDFDELTA_INTERNAL void  tdFdeltaConvertCurToC (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
     /*
      *  Display message if requested.
      */
@@ -310,7 +313,7 @@ TDFDELTA_INTERNAL void  tdFdeltaConvertConToC (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
     /*
      *  Display message if requested.
      */
@@ -431,7 +434,7 @@ TDFDELTA_INTERNAL void  tdFdeltaConvertOffToC (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
 
     /*
      *  Display message if requested.
@@ -604,7 +607,7 @@ TDFDELTA_INTERNAL void  tdFdeltaConvertTarToC (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
 
     /*
      *  Display message if requested.
@@ -648,3 +651,108 @@ TDFDELTA_INTERNAL void  tdFdeltaConvertTarToC (
         ErsRep(0,status,"Error reading or converting target field details - %s",
                DitsErrorText(*status));
 }
+
+
+/*+        T D F D E L T A C O N V E R T
+
+ *  Function name:
+      tdFdeltaConvertCrossesToSds
+
+ *  Function:
+      Converts the crossover lists back to an Sds `above' array.
+
+ *  Description:
+      This is the inverse of tdFdelta___SdsToCrosses().  For each pivot
+      which has fibres crossing above it, the array contains the pivot
+      number followed by the numbers of the fibres crossing above it,
+      terminated by a zero.  If there are no crossovers at all, the
+      array contains a single zero.
+
+      Used where we must describe an interim field, rather then one
+      supplied to us, such as when a REPLAN action writes a new command file.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaConvertCrossesToSds (cur,crosses,aboveID,status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) cur         (tdFinterim *)    Interim field details.
+      (>) crosses     (tdFcrosses *)    Crossover lists for cur.
+      (<) aboveID     (SdsIdType *)     A new Sds item named "above" is
+                                        created and its id written here.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Proir Requirements:
+
+ *  Support: James Wilcox, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaConvertCrossesToSds (
+        const tdFinterim  *cur,
+        const tdFcrosses  *crosses,
+        SdsIdType         *aboveID,
+        StatusType        *status)
+{
+    unsigned long  size = 0;
+    unsigned       numPivots;
+    unsigned       i;
+    short          *above;
+    int            n = 0;
+
+    if (*status != STATUS__OK) return;
+
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+
+    /*
+     *  Work out the size of the array.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        if (cur->nAbove[i] > 0)
+            size += cur->nAbove[i] + 2;
+    }
+    if (size == 0)
+        size = 1;
+
+    if ((above = (short *)malloc(sizeof(short)*size)) == NULL) {
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+
+    /*
+     *  Fill it in.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        const FibreCross *p = crosses->above[i];
+        if (cur->nAbove[i] <= 0) continue;
+        above[n++] = i+1;
+        while (p) {
+            above[n++] = p->piv;
+            p = p->next;
+        }
+        above[n++] = 0;
+    }
+    if (n == 0)
+        above[n++] = 0;
+
+    /*
+     *  The counts and lists should agree, if not we have a bug somewhere.
+     */
+    if ((unsigned long)n != size) {
+        *status = TDFDELTA__CROSSESERR;
+        ErsRep(0,status,"Crossover list counts do not match the lists");
+        free((void *)above);
+        return;
+    }
+
+    size = n;
+    SdsNew(0,"above",0,NULL,SDS_SHORT,1,&size,aboveID,status);
+    SdsPut(*aboveID,sizeof(short)*size,0,(void *)above,status);
+    free((void *)above);
+}
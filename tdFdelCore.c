@@ -0,0 +1,1097 @@
+/*+                T D F D E L T A
+
+ *  Module name:
+      tdFdeltaCore
+
+ *  Function:
+      Entry points and output routing for the planning core.
+
+ *  Description:
+      The planning core (see tdFdeltaCore.h) is the field check, the
+      sequencers, the crossover lists and command file generation.  It does
+      not use DRAMA, all its output goes through the callbacks in the
+      tdFdeltaType being planned.  This module selects those callbacks
+      with tdFdeltaUse() and provides the functions the rest of the core
+      uses to call them, along with the creation and release of the plan
+      data, the instrument description and the timing and progress
+      functions.
+
+      The DRAMA task supplies callbacks which output with MsgOut() and
+      ErsRep(), set parameters and build the Sds command file (see
+      tdFdelDrama.c).  The worker thread supplies callbacks which queue
+      the output for the main thread (see tdFdelThread.c).
+
+      The selected plan is held in thread local variables, so threads
+      may run plans at the same time, and tdFdeltaLock() serialises the
+      use of what the plans share (see TDFDELTA_TLS in tdFdeltaCore.h).
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version.  tdFdeltaMsgOut(),
+                        tdFdeltaErsRep(), tdFdeltaPutProgress() and
+                        tdFdeltaPutStats() moved here from tdFdelThread.c,
+                        tdFdeltaClock(), tdFdeltaProgInit() and
+                        tdFdeltaProgress() from tdFdelUtil.c and
+                        tdFdeltaFpilInst() from tdFdelta.c.
+      18-Oct-2026  AGT  Select, release and clear the result cache
+                        recording.  Add the cache statistics.
+      18-Oct-2026  AGT  Clear the warm start pair matrix with the cache.
+      18-Oct-2026  AGT  Plan data comes from a pool of aligned blocks,
+                        reused across actions.  Add tdFdeltaDataPoolFlush().
+      18-Oct-2026  AGT  Select the collision geometry in tdFdeltaUse().
+      18-Oct-2026  AGT  Add tdFdeltaFpilFixed().
+      18-Oct-2026  AGT  The selected plan is thread local, plans may have
+                        their own instrument.  Add tdFdeltaLock() and
+                        tdFdeltaUnlock(), the pool is used under the lock.
+      19-Oct-2026  AGT  Save the number of pivots in tdFdeltaFpilSet(),
+                        no compile time pivot count.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelCore.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelCore.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#ifdef TDFDELTA_REENTRANT
+#   include <pthread.h>
+#endif
+
+#ifdef DSTDARG_OK
+#   include <stdarg.h>       /* For ANSI C                  */
+#else
+#   include <varargs.h>      /* For old style unix          */
+#endif
+
+/*
+ *  Weight given to each new per pivot cost sample by tdFdeltaProgress().
+ */
+#define PROG_WEIGHT 0.2
+
+/*
+ *  Plan data pool.  Released plan data is kept for reuse by the next
+ *  action, up to POOL_SIZE blocks, so a GENERATE doesn't need a large
+ *  allocation (and the page faults of first touching it).  The blocks
+ *  are aligned to POOL_ALIGN bytes, a cache line, with the address
+ *  returned by malloc() in the pointer before the block.  The pool is
+ *  only used under tdFdeltaLock().
+ */
+#define POOL_SIZE  4
+#define POOL_ALIGN 64
+
+static tdFdeltaType *pool[POOL_SIZE];
+static int poolUsed = 0;
+
+/*
+ *  Instrument description, see tdFdeltaFpilSet().
+ */
+static FpilType tdFdeltaInstrument;
+
+/*
+ *  Its number of pivots, for tdFdeltaNumPivots() in a single instrument
+ *  build (see tdFdeltaCore.h).
+ */
+unsigned tdFdeltaPivots = 0;
+
+/*
+ *  The callbacks and instrument of the plan this thread is running, see
+ *  tdFdeltaUse().  Until a plan is selected, output is discarded.
+ */
+static tdFdeltaCallbacks noOut;
+static TDFDELTA_TLS const tdFdeltaCallbacks *out = &noOut;
+static TDFDELTA_TLS FpilType planInst = 0;
+
+#ifdef TDFDELTA_REENTRANT
+static pthread_mutex_t coreLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaDataNew
+
+ *  Function:
+      Create the data for a plan.
+
+ *  Description:
+      Allocates a tdFdeltaType, reusing a released one if possible.  The
+      structure is aligned to a cache line.  The crossover lists are
+      empty, no pivots
+      are flagged as failed, the command file name is "blank", the
+      statistics are zeroed and there are no output callbacks.  The
+      caller must fill in the field details (current, crosses, constants,
+      offsets_, fids and target) and clearances.
+
+ *  Language:
+      C
+
+ *  Call:
+      (tdFdeltaType *) = tdFdeltaDataNew (check, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) check       (short)           Check flags.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      The new structure, which should be released with
+      tdFdeltaDataFree(), or NULL on error.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, extracted from
+                        tdFdeltaNewActData().
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC tdFdeltaType  *tdFdeltaDataNew (
+        short       check,
+        StatusType  *status)
+{
+    tdFdeltaType  *data;
+
+    if (*status != STATUS__OK) return NULL;
+
+    tdFdeltaLock();
+    data = (poolUsed > 0 ? pool[--poolUsed] : 0);
+    tdFdeltaUnlock();
+    if (!data) {
+        char *raw;
+        if ((raw = (char *)malloc(sizeof(tdFdeltaType) + sizeof(void *) +
+                                  POOL_ALIGN)) == NULL) {
+            *status = TDFDELTA__MALLOCERR;
+            return NULL;
+        }
+        data = (tdFdeltaType *)(raw + POOL_ALIGN -
+            ((unsigned long)(raw + sizeof(void *)) % POOL_ALIGN) +
+            sizeof(void *));
+        ((void **)data)[-1] = raw;
+    }
+    memset(data, 0, sizeof(*data));
+    data->check = check;
+    strcpy(data->name,"blank");
+    data->seq.started = NO;
+    data->seq.cancel  = NO;
+    data->warm.ref    = -1;
+    tdFdeltaStatsInit(&data->stats);
+    return data;
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaDataFree
+
+ *  Function:
+      Release the data for a plan.
+
+ *  Description:
+      Frees the crossover lists, any result cache recording, trace and
+      input snapshot (neither is written), releases any warm start
+      reference and returns the structure to the pool for reuse by
+      tdFdeltaDataNew(), or frees it if the pool is full.  The output
+      callbacks and the instrument description are the caller's and are
+      not touched.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaDataFree (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The plan data.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, replaces the release code in
+                        the sequencers, REPLAN and tdFdeltaSnapFree().
+      18-Oct-2026  AGT  Release the result cache recording.
+      18-Oct-2026  AGT  Return the structure to the pool.
+      18-Oct-2026  AGT  Release the trace, snapshot and warm start
+                        reference.  May be called from any thread.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaDataFree (
+        tdFdeltaType  *data)
+{
+    int i;
+    if (!data) return;
+    if (out == &data->out) {
+        out = &noOut;
+        planInst = 0;
+        tdFdeltaStatsUse(0);
+        tdFdeltaWarmUse(0);
+    }
+    for (i = 0; i < FPIL_MAXPIVOTS ; ++i) {
+        FibreCross *p = data->crosses.above[i];
+        while (p) {
+            FibreCross *next = p->next;
+            free(p);
+            p = next;
+        }
+        p = data->crosses.below[i];
+        while (p) {
+            FibreCross *next = p->next;
+            free(p);
+            p = next;
+        }
+        data->crosses.above[i] = data->crosses.below[i] = 0;
+    }
+    tdFdeltaCacheFree(data->cache);
+    data->cache = 0;
+    tdFdeltaTraceFree(data);
+    tdFdeltaSnapFree(data);
+    tdFdeltaWarmRelease(data);
+    tdFdeltaLock();
+    if (poolUsed < POOL_SIZE) {
+        pool[poolUsed++] = data;
+        data = 0;
+    }
+    tdFdeltaUnlock();
+    if (data)
+        free(((void **)data)[-1]);
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaDataPoolFlush
+
+ *  Function:
+      Free the released plan data kept for reuse.
+
+ *  Description:
+      Frees the plan data structures kept by tdFdeltaDataFree() for
+      reuse by tdFdeltaDataNew().  Structures in use are not affected.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaDataPoolFlush ()
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaDataPoolFlush (
+        void)
+{
+    tdFdeltaLock();
+    while (poolUsed > 0)
+        free(((void **)pool[--poolUsed])[-1]);
+    tdFdeltaUnlock();
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaPlan
+
+ *  Function:
+      Check and sequence a field.
+
+ *  Description:
+      Selects the plan (see tdFdeltaUse()), then runs the field check and,
+      if it passes, the sequencer given by the SPECIAL flag, to completion.
+      The command file is passed to the plan's cfNew, cfLine, cfCount and
+      cfDone callbacks.  The statistics are passed to its stats callback.
+
+      If cancel is not null, *cancel is polled by the field check and by
+      both sequencers, and if set, the command file is discarded and we
+      return with good status.  It may be set from another thread, with
+      TDFDELTA_STORE().
+
+      The data is not released.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaPlan (data, cancel, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (>) cancel      (volatile int *)  Cancel flag.  May be null.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Prior requirements:
+      The instrument must have been set with tdFdeltaFpilSet().
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, extracted from the worker
+                        thread.
+      18-Oct-2026  AGT  The field check and special sequencer also poll
+                        the cancel flag.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaPlan (
+        tdFdeltaType  *data,
+        volatile int  *cancel,
+        StatusType    *status)
+{
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaUse(data);
+    if ((!tdFdeltaFieldCheckRun(data, cancel, status)) ||
+        (TDFDELTA_CANCELLED(cancel))) {
+        StatusType ignore = STATUS__OK;
+        tdFdeltaPutStats(&data->stats, &ignore);
+    } else if (data->check & SPECIAL) {
+        tdFdeltaSequencerSpecialRun(data, cancel, status);
+    } else {
+        tdFdeltaSequencerRun(data, cancel, status);
+    }
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaUse
+
+ *  Function:
+      Select the plan the core is working on.
+
+ *  Description:
+      Makes the plan's callbacks, statistics, instrument, trace, result
+      cache recording and warm start state current in the calling
+      thread.  The core keeps these as thread local globals, rather than
+      passing the plan data down to every function that may output or
+      count something, so must be called whenever we start or resume
+      work on a plan.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaUse (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The plan data.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Select the result cache recording.
+      18-Oct-2026  AGT  Select the collision geometry.
+      18-Oct-2026  AGT  Select the plan's instrument, trace and warm start
+                        state.
+      19-Oct-2026  AGT  No collision geometry to select.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaUse (
+        tdFdeltaType  *data)
+{
+    out = &data->out;
+    planInst = data->inst;
+    tdFdeltaStatsUse(&data->stats);
+    tdFdeltaTraceUse(data->trace);
+    tdFdeltaCacheUse(data->cache);
+    tdFdeltaWarmUse(&data->warm);
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaOut
+
+ *  Function:
+      Returns the callbacks of the current plan.
+
+ *  Description:
+      For use within the core, e.g. by the command file functions.  The
+      members may be null.
+
+ *  Language:
+      C
+
+ *  Call:
+      (const tdFdeltaCallbacks *) = tdFdeltaOut ()
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL const tdFdeltaCallbacks  *tdFdeltaOut (void)
+{
+    return out;
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaLock, tdFdeltaUnlock
+
+ *  Function:
+      Lock and unlock what plans share.
+
+ *  Description:
+      Serialises the use of the plan data pool, the result cache, the
+      warm start references and the integer button outlines, which may
+      be used by plans running at the same time in different threads.
+      The lock is not recursive and must not be held whilst calling out
+      of the core.  Does nothing if the core is built without thread
+      support (see TDFDELTA_TLS).
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaLock ()
+      (void) = tdFdeltaUnlock ()
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaLock (void)
+{
+#ifdef TDFDELTA_REENTRANT
+    pthread_mutex_lock(&coreLock);
+#endif
+}
+
+TDFDELTA_INTERNAL void  tdFdeltaUnlock (void)
+{
+#ifdef TDFDELTA_REENTRANT
+    pthread_mutex_unlock(&coreLock);
+#endif
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaFpilSet
+
+ *  Function:
+      Sets the FPIL instrument description.
+
+ *  Description:
+      The instrument description is used by all plans which do not have
+      their own (data->inst).  It must not be changed whilst a plan is
+      running.  Any cached results and the warm start pair matrices are
+      discarded.  Its number of pivots is saved for tdFdeltaNumPivots().
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaFpilSet (inst)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) inst        (FpilType)        The instrument description.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Clear the result cache.
+      18-Oct-2026  AGT  Clear the warm start pair matrix.
+      19-Oct-2026  AGT  Save the number of pivots.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaFpilSet (
+        FpilType    inst)
+{
+    tdFdeltaInstrument = inst;
+    tdFdeltaPivots = FpilGetNumPivots(inst);
+    tdFdeltaCacheClear();
+    tdFdeltaWarmClear();
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaFpilInst
+
+ *  Function:
+      Returns the FPIL instrument variable
+
+ *  Description:
+      Returns the instrument description of the plan selected in the
+      calling thread (see tdFdeltaUse()), which is that given to
+      tdFdeltaFpilSet() unless the plan has its own.
+
+ *  Language:
+      C
+
+ *  Call:
+      (FpilType *) = tdFdeltaFpilInst ()
+
+
+ *  Prior requirements:
+      tdFdeltaFpilSet() must have been invoked.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      28-Jan-2000 TJF Original version
+      18-Oct-2026 AGT Moved from tdFdelta.c.
+      18-Oct-2026 AGT The selected plan's own instrument, if it has one.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC FpilType  tdFdeltaFpilInst (void)
+{
+    return (planInst ? planInst : tdFdeltaInstrument);
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaFpilFixed
+
+ *  Function:
+      Does an instrument suit this build.
+
+ *  Description:
+      In a build for only one instrument, whether parked buttons may
+      collide is a compile time constant (see tdFdeltaCore.h).  This
+      checks an instrument description agrees with it before it is given
+      to tdFdeltaFpilSet().  Any number of pivots will do.  In a build
+      for both instruments, any instrument will do.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaFpilFixed (inst)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) inst        (FpilType)        The instrument description.
+
+ *  Returned value:
+      YES if the instrument may be used, otherwise NO.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      19-Oct-2026  AGT  Only ParkMayCollide is a compile time constant.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC int  tdFdeltaFpilFixed (
+        FpilType    inst)
+{
+#ifdef TDFDELTA_PARK_MAY_COLLIDE
+    return ((FpilParkMayCollide(inst) ? YES : NO) ==
+                                            TDFDELTA_PARK_MAY_COLLIDE);
+#else
+    return YES;
+#endif
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaClock
+
+ *  Function:
+      Returns a monotonic time in seconds.
+
+ *  Description:
+      Used for timing things within the task, such as the sequencer
+      time slices.  The value has no particular origin, so only
+      differences are meaningful.  Where the system has no monotonic
+      clock, the time of day is used.
+
+ *  Language:
+      C
+
+ *  Call:
+      (double) = tdFdeltaClock ()
+
+ *  Returned value:
+      The time in seconds.
+
+ *  Proir Requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelUtil.c.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL double  tdFdeltaClock (void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC,&ts) == 0)
+        return ((double)ts.tv_sec + (double)ts.tv_nsec*1.0e-9);
+#endif
+    {
+        struct timeval tv;
+        gettimeofday(&tv,0);
+        return ((double)tv.tv_sec + (double)tv.tv_usec*1.0e-6);
+    }
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaProgInit
+
+ *  Function:
+      Initialise a progress model.
+
+ *  Description:
+      Starts the clock for tdFdeltaProgress().  Should be called once the
+      number of pivots to be sequenced is known.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaProgInit (prog, pivotsLeft)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (<) prog        (tdFprogress *)   The progress model.
+      (>) pivotsLeft  (unsigned)        The number of pivots to sequence.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelUtil.c.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaProgInit (
+        tdFprogress  *prog,
+        unsigned     pivotsLeft)
+{
+    prog->tStart   = tdFdeltaClock();
+    prog->tLast    = prog->tStart;
+    prog->tPut     = prog->tStart;
+    prog->cost     = 0.0;
+    prog->leftLast = pivotsLeft;
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaProgress
+
+ *  Function:
+      Update the DELTA_PROG and DELTA_ETA parameters.
+
+ *  Description:
+      Called by the sequencers after each move or park.  Each time the
+      number of pivots left drops, the time since it last dropped gives a
+      sample of the cost of sequencing a pivot, which is smoothed into a
+      running estimate.  The remaining time is this cost times the number
+      of pivots left, and the percentage complete is the elapsed time as a
+      fraction of the elapsed plus remaining time.
+
+      The parameters are only published every TDFDELTA_PROG_MS
+      milliseconds, plus once when all pivots are done, so the cost of
+      publishing does not depend on the size of the field.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaProgress (prog, pivotsLeft, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) prog        (tdFprogress *)   The progress model.
+      (>) pivotsLeft  (unsigned)        The number of pivots left to sequence.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Prior Requirements:
+      tdFdeltaProgInit() must have been called.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, replaces the DisplayProgress()
+                        functions in the sequencers.
+      18-Oct-2026  AGT  Moved from tdFdelUtil.c.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaProgress (
+        tdFprogress  *prog,
+        unsigned     pivotsLeft,
+        StatusType   *status)
+{
+    double now;
+    double elapsed;
+    double remaining;
+    float  percent;
+
+    if (*status != STATUS__OK) return;
+
+    now = tdFdeltaClock();
+    if (pivotsLeft < prog->leftLast) {
+        double sample = (now - prog->tLast)/(double)(prog->leftLast-pivotsLeft);
+        if (prog->cost == 0.0)
+            prog->cost = sample;
+        else
+            prog->cost += PROG_WEIGHT*(sample - prog->cost);
+        prog->tLast    = now;
+        prog->leftLast = pivotsLeft;
+    }
+    if ((pivotsLeft > 0) && (now - prog->tPut < TDFDELTA_PROG_MS/1000.0))
+        return;
+    prog->tPut = now;
+
+    elapsed   = now - prog->tStart;
+    remaining = (double)pivotsLeft*prog->cost;
+    if (pivotsLeft == 0)
+        percent = 100.0;
+    else if (elapsed + remaining <= 0.0)
+        percent = 0.0;
+    else
+        percent = 100.0*elapsed/(elapsed + remaining);
+
+    tdFdeltaPutProgress(percent, (long)(remaining*1000.0), status);
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaPutProgress
+
+ *  Function:
+      Reports progress.
+
+ *  Description:
+      Passes the progress to the current plan's progress callback.  The
+      task publishes these as the DELTA_PROG and DELTA_ETA parameters.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaPutProgress (progress, eta, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) progress    (float)           Percentage complete.
+      (>) eta         (long int)        Estimated milliseconds remaining.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Add eta argument.
+      18-Oct-2026  AGT  Moved from tdFdelThread.c, now calls the
+                        progress callback.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaPutProgress (
+        float       progress,
+        long int    eta,
+        StatusType  *status)
+{
+    if (*status != STATUS__OK) return;
+    if (out->progress)
+        (*out->progress)(out->clientData, progress, eta, status);
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaPutStats
+
+ *  Function:
+      Reports the planner statistics.
+
+ *  Description:
+      Passes the statistics to the current plan's stats callback.  The
+      task publishes these as the DELTA_STATS parameter.
+
+      If the plan's command file was completed, the result is first
+      cached, and the cache statistics are added (see
+      tdFdeltaCacheStats()).
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaPutStats (stats, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) stats       (const tdFstats *) The statistics.
+      (!) status      (StatusType *)     Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelThread.c, now calls the
+                        stats callback.
+      18-Oct-2026  AGT  Cache the result.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaPutStats (
+        const tdFstats  *stats,
+        StatusType      *status)
+{
+    tdFstats copy;
+    if (*status != STATUS__OK) return;
+    copy = *stats;
+    tdFdeltaCacheStats(&copy);
+    if (out->stats)
+        (*out->stats)(out->clientData, &copy, status);
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaErrorText
+
+ *  Function:
+      Returns the text for a status code.
+
+ *  Description:
+      Uses the current plan's errorText callback.  Without one, the
+      status is returned as a number.
+
+ *  Language:
+      C
+
+ *  Call:
+      (const char *) = tdFdeltaErrorText (status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) status      (StatusType)      The status code.
+
+ *  Returned value:
+      The text, which may be overwritten by the next call.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL const char  *tdFdeltaErrorText (
+        StatusType  status)
+{
+    static TDFDELTA_TLS char buffer[40];
+    if (out->errorText)
+        return (*out->errorText)(out->clientData, status);
+    sprintf(buffer, "status %ld", (long)status);
+    return buffer;
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaMsgOut
+
+ *  Function:
+      Output a message.
+
+ *  Description:
+      Formats the message and passes it to the current plan's msgOut
+      callback.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaMsgOut (status, fmt, ...)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status      (StatusType *)    Modified status.
+      (>) fmt         (char *)          Format, as per MsgOut().
+      (>) ...         (...)             Format arguments.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelThread.c, now calls the
+                        msgOut callback.
+      {@change entry@}
+ */
+#ifdef DSTDARG_OK
+    TDFDELTA_INTERNAL void  tdFdeltaMsgOut (
+            StatusType  *status,
+            const char  *fmt,
+            ...)
+#else
+    TDFDELTA_INTERNAL void  tdFdeltaMsgOut (va_alist)
+            va_dcl
+#endif
+{
+    va_list    args;
+    char       buffer[CMDLINE_LENGTH];
+
+#   ifdef DSTDARG_OK
+        va_start(args,fmt);
+#   else
+        StatusType  *status;
+        char        *fmt;
+
+        va_start(args);
+        status = va_arg(args, StatusType *);
+        fmt    = va_arg(args, char *);
+#   endif
+
+    if ((*status != STATUS__OK)||(!out->msgOut)) {
+        va_end(args);
+        return;
+    }
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    (*out->msgOut)(out->clientData, buffer);
+}
+
+
+/*+        T D F D E L T A C O R E
+
+ *  Function name:
+      tdFdeltaErsRep
+
+ *  Function:
+      Report an error.
+
+ *  Description:
+      Formats the message and passes it to the current plan's ersRep
+      callback.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaErsRep (flags, status, fmt, ...)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) flags       (int)             Flags, as per ErsRep().
+      (!) status      (StatusType *)    Modified status.
+      (>) fmt         (char *)          Format, as per ErsRep().
+      (>) ...         (...)             Format arguments.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelThread.c, now calls the
+                        ersRep callback.
+      {@change entry@}
+ */
+#ifdef DSTDARG_OK
+    TDFDELTA_INTERNAL void  tdFdeltaErsRep (
+            int         flags,
+            StatusType  *status,
+            const char  *fmt,
+            ...)
+#else
+    TDFDELTA_INTERNAL void  tdFdeltaErsRep (va_alist)
+            va_dcl
+#endif
+{
+    va_list    args;
+    char       buffer[CMDLINE_LENGTH];
+
+#   ifdef DSTDARG_OK
+        va_start(args,fmt);
+#   else
+        int         flags;
+        StatusType  *status;
+        char        *fmt;
+
+        va_start(args);
+        flags  = va_arg(args, int);
+        status = va_arg(args, StatusType *);
+        fmt    = va_arg(args, char *);
+#   endif
+
+    if (!out->ersRep) {
+        va_end(args);
+        return;
+    }
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    (*out->ersRep)(out->clientData, flags, status, buffer);
+}
@@ -11,6 +11,9 @@
       any fibre crossing above and below it. This file contains the functions used
       to manage these linked lists - namely ADD, DELETE, and SEARCH.
 
+      tdFdeltaCrossesCheck() checks a set of lists against the fibre
+      positions (see tdFdelSweep.c).
+
  *  Language:
       C
 
@@ -20,6 +23,18 @@
 
  *  History:
       01-Jul-1994  JW   Original version
+      18-Oct-2026  AGT  Add tdFdeltaCrossesMoved() and tdFdeltaCrossesParked()
+                        so the sequencers and REPLAN share the crossover
+                        list updates made when a fibre is moved or parked.
+      18-Oct-2026  AGT  Count list edits for DELTA_STATS.
+      18-Oct-2026  AGT  Trace list edits.
+      18-Oct-2026  AGT  Moved to the planning core.
+      18-Oct-2026  AGT  Collision checks through tdFdelGeom.c (INT_GEOM flag).
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
+      18-Oct-2026  AGT  Add tdFdeltaCrossesCheck().
+      19-Oct-2026  AGT  Collision checks call FPIL directly again,
+                        tdFdelGeom.c removed.
       {@change entry@}
 
  *  @(#) $Id: ACMM:2dFdelta/tdFdelCrosses.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
@@ -34,13 +49,14 @@ static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelCrosses.c,v 3.17 25-Aug-2014 1
 static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
 
 
-#include "tdFdelta.h"
+#include "tdFdeltaCore.h"
 #include "tdFdelta_Err.h"
 #include "status.h"        /* STATUS__OK definition */
 
 #include <stdio.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 
 /*
@@ -98,6 +114,7 @@ TDFDELTA_INTERNAL void  tdFdeltaAddCross (
         p = *start;
         new->next = (p)?  p: NULL;
         *start = new;
+        TDFDELTA_STAT(crossAdds);
     }
 }
 
@@ -153,6 +170,7 @@ TDFDELTA_INTERNAL void  tdFdeltaDeleteCross (
     if (current->piv==cross) {
         *start = current->next;
         free((void *)current);
+        TDFDELTA_STAT(crossDeletes);
         return;
     }
 
@@ -170,6 +188,7 @@ TDFDELTA_INTERNAL void  tdFdeltaDeleteCross (
              */
             previous->next = current->next;
             free((void *)current);
+            TDFDELTA_STAT(crossDeletes);
             return;
         }
         previous = current;
@@ -229,3 +248,395 @@ TDFDELTA_INTERNAL FibreCross  *tdFdeltaFindCross(
     }
     return NULL;
 }
+
+
+/*
+ *+           T D F D E L T A C R O S S E S
+
+ *  Function name:
+      tdFdeltaCrossesParked
+
+ *  Function:
+      Update the crossover lists after a fibre has been parked.
+
+ *  Description:
+      A fibre being parked can not be crossed by any other fibre (otherwise
+      it could not have been picked up), so all that is required is to
+      remove the fibres it was crossing above from its below list, and
+      remove it from the above lists of those fibres.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCrossesParked (piv,cur,crosses,status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) piv           (unsigned)      Index of the pivot parked.
+      (!) cur           (tdFinterim *)  Interim field details, the nAbove
+                                        and nBelow counts are updated.
+      (!) crosses       (tdFcrosses *)  Crossover lists.
+      (!) status        (StatusType *)  Modified status.
+
+ *  Prior requirements:
+
+ *  Support: James Wilcox, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, extracted from the sequencers.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCrossesParked (
+        unsigned            piv,
+        tdFinterim          *cur,
+        tdFcrosses          *crosses,
+        StatusType          *status)
+{
+    FibreCross  *ptmp;
+
+    if (*status != STATUS__OK) return;
+
+    ptmp = crosses->below[piv];
+    while ((ptmp)&&(*status == STATUS__OK)) {
+        TDFDELTA_TRACE(TDF_TRACE_CROSS_DEL, piv+1, ptmp->piv, 0);
+        tdFdeltaDeleteCross(piv+1,
+                            &crosses->above[(ptmp->piv)-1],
+                            status);
+        cur->nAbove[(ptmp->piv)-1]--;
+        tdFdeltaDeleteCross(ptmp->piv,
+                            &ptmp,
+                            status);
+    }
+    crosses->below[piv] = NULL;
+    cur->nBelow[piv]    = 0;
+}
+
+
+/*
+ *+           T D F D E L T A C R O S S E S
+
+ *  Function name:
+      tdFdeltaCrossesMoved
+
+ *  Function:
+      Update the crossover lists after a fibre has been moved on the plate.
+
+ *  Description:
+      In order to save some time, take advantage of a couple of our
+      rules, namely -
+        - As a fibre can only be moved if there is no fibre crossing
+          above it, and it can not be placed under another button,
+          the crossover.above list for the button being moved is
+          unchanged.
+        - Any fibre/fibre collisions that will occur must result in
+          the fibre being moved crossing above them (a fibre can
+          not be placed under abother button), therefore these
+          fibres must be added to the crossover.below list for the
+          moved fibre, with the old crossover.below list being
+          deleted.
+
+      The interim field details for piv must already have been updated
+      to its new position.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCrossesMoved (piv,parkMayCollide,con,cur,crosses,
+                                     status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) piv            (unsigned)       Index of the pivot moved.
+      (>) parkMayCollide (int)            If false, parked fibres are not
+                                          checked.
+      (>) con            (tdFconstants *) Field constants (pivot positions).
+      (!) cur            (tdFinterim *)   Interim field details, the nAbove
+                                          and nBelow counts are updated.
+      (!) crosses        (tdFcrosses *)   Crossover lists.
+      (!) status         (StatusType *)   Modified status.
+
+ *  Prior requirements:
+      tdFdeltaActivate() must have been invoked.
+
+ *  Support: James Wilcox, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, extracted from the sequencers.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCrossesMoved (
+        unsigned            piv,
+        int                 parkMayCollide,
+        const tdFconstants  *con,
+        tdFinterim          *cur,
+        tdFcrosses          *crosses,
+        StatusType          *status)
+{
+    unsigned  j;
+    unsigned  numPivots;
+
+    tdFdeltaCrossesParked(piv, cur, crosses, status);
+    if (*status != STATUS__OK) return;
+
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    for (j=0; j < numPivots; j++) {
+        int flag;
+        if (piv == j) continue;
+        if ((cur->park[j] == YES)&&(!parkMayCollide)) continue;
+        flag = FpilColFibFib (
+            tdFdeltaFpilInst(),
+            (double)con->xPiv[piv],
+            (double)con->yPiv[piv],
+            (double)cur->fvpX[piv],
+            (double)cur->fvpY[piv],
+            (double)con->xPiv[j],
+            (double)con->yPiv[j],
+            (double)cur->fvpX[j],
+            (double)cur->fvpY[j]);
+
+        if (flag == YES) {
+            TDFDELTA_TRACE(TDF_TRACE_CROSS_ADD, piv+1, j+1, 0);
+            tdFdeltaAddCross(j+1,&crosses->below[piv],status);
+            tdFdeltaAddCross(piv+1,&crosses->above[j],status);
+            cur->nAbove[j]++;
+            cur->nBelow[piv]++;
+        }
+    }
+}
+
+
+/*
+ *  Sweep results for tdFdeltaCrossesCheck().  found and listed have a bit
+ *  for each pair of pivots, set if the sweep found they cross and if
+ *  they are in the lists.
+ */
+typedef struct {
+    unsigned        numPivots;
+    unsigned char   *found;
+    unsigned char   *listed;
+    unsigned        *pairs;
+    unsigned long   numPairs;
+    unsigned long   maxPairs;
+    int             failed;
+    } CheckState;
+
+static int PairGet(
+        const unsigned char  *bits,
+        unsigned             numPivots,
+        unsigned             a,
+        unsigned             b)
+{
+    unsigned long i = (unsigned long)a*numPivots + b;
+    return ((bits[i >> 3] >> (i & 7)) & 1);
+}
+
+static void PairSet(
+        unsigned char  *bits,
+        unsigned       numPivots,
+        unsigned       a,
+        unsigned       b)
+{
+    unsigned long i = (unsigned long)a*numPivots + b;
+    unsigned long j = (unsigned long)b*numPivots + a;
+    bits[i >> 3] |= (unsigned char)(1 << (i & 7));
+    bits[j >> 3] |= (unsigned char)(1 << (j & 7));
+}
+
+static void CheckFound(
+        void      *clientData,
+        unsigned  a,
+        unsigned  b)
+{
+    CheckState *cs = (CheckState *)clientData;
+    if (cs->numPairs == cs->maxPairs) {
+        unsigned long max = 2*cs->maxPairs + 64;
+        unsigned *pairs = (unsigned *)realloc(cs->pairs,
+                                              max*2*sizeof(unsigned));
+        if (!pairs) {
+            cs->failed = 1;
+            return;
+        }
+        cs->pairs = pairs;
+        cs->maxPairs = max;
+    }
+    cs->pairs[2*cs->numPairs]   = a;
+    cs->pairs[2*cs->numPairs+1] = b;
+    ++cs->numPairs;
+    PairSet(cs->found, cs->numPivots, a, b);
+}
+
+/*
+ *  Do the fibres of pivots a and b cross, as per the sequencer.
+ */
+static int CheckCross(
+        const tdFconstants  *con,
+        const tdFinterim    *cur,
+        unsigned            a,
+        unsigned            b)
+{
+    TDFDELTA_STAT(colFibFib);
+    return (FpilColFibFib(tdFdeltaFpilInst(),
+                          (double)con->xPiv[a], (double)con->yPiv[a],
+                          (double)cur->fvpX[a], (double)cur->fvpY[a],
+                          (double)con->xPiv[b], (double)con->yPiv[b],
+                          (double)cur->fvpX[b], (double)cur->fvpY[b])
+            == YES);
+}
+
+
+/*
+ *+           T D F D E L T A C R O S S E S
+
+ *  Function name:
+      tdFdeltaCrossesCheck
+
+ *  Function:
+      Check the crossover lists agree with the fibre positions.
+
+ *  Description:
+      Finds all the fibre crossings of the field with tdFdeltaSweep() and
+      compares them with the crossover lists.  Every pair of fibres which
+      cross must have one (and only one) listed as crossing above the
+      other, no others may be listed, and the nAbove counts must agree
+      with the lists.  Where the sweep and the lists disagree, the pair
+      is checked with FpilColFibFib(), as the sequencer would, before
+      it is reported, so this only reports lists the sequencer itself
+      would not have made.  Fibres which are parked are ignored unless
+      parkMayCollide is set, again as per the sequencer.
+
+      Each disagreement is output as a warning.  This costs the sweep
+      plus a look at each list item, much less than rebuilding the lists.
+
+ *  Language:
+      C
+
+ *  Call:
+      (unsigned) = tdFdeltaCrossesCheck (what,parkMayCollide,con,cur,
+                                         crosses,status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) what           (const char *)   Field description for messages,
+                                          e.g. "current".
+      (>) parkMayCollide (int)            If false, parked fibres are not
+                                          checked.
+      (>) con            (tdFconstants *) Field constants (pivot positions).
+      (>) cur            (tdFinterim *)   Field details.
+      (>) crosses        (tdFcrosses *)   Crossover lists for cur.
+      (!) status         (StatusType *)   Modified status.
+
+ *  Returned value:
+      The number of disagreements.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL unsigned  tdFdeltaCrossesCheck (
+        const char          *what,
+        int                 parkMayCollide,
+        const tdFconstants  *con,
+        const tdFinterim    *cur,
+        const tdFcrosses    *crosses,
+        StatusType          *status)
+{
+    CheckState     cs;
+    short          use[FPIL_MAXPIVOTS];
+    unsigned       numPivots;
+    unsigned       bad = 0;
+    unsigned       i;
+    unsigned long  p;
+
+    if (*status != STATUS__OK) return 0;
+
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    for (i = 0; i < numPivots ; ++i)
+        use[i] = ((cur->park[i] != YES)||(parkMayCollide));
+
+    memset(&cs, 0, sizeof(cs));
+    cs.numPivots = numPivots;
+    cs.found  = (unsigned char *)calloc(((size_t)numPivots*numPivots+7)/8+1,
+                                        1);
+    cs.listed = (unsigned char *)calloc(((size_t)numPivots*numPivots+7)/8+1,
+                                        1);
+    if ((!cs.found)||(!cs.listed)) {
+        free(cs.found);
+        free(cs.listed);
+        *status = TDFDELTA__MALLOCERR;
+        tdFdeltaErsRep(0, status, "Error allocating crossover check memory");
+        return 0;
+    }
+    tdFdeltaSweep(numPivots, con, cur->fvpX, cur->fvpY, use,
+                  CheckFound, &cs, status);
+    if ((cs.failed)&&(*status == STATUS__OK)) {
+        *status = TDFDELTA__MALLOCERR;
+        tdFdeltaErsRep(0, status, "Error allocating crossover check memory");
+    }
+    if (*status != STATUS__OK) goto CLEANUP;
+
+    /*
+     *  Everything in the lists must cross.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        FibreCross *ptmp;
+        int        n = 0;
+        for (ptmp = crosses->above[i]; ptmp ; ptmp = ptmp->next, ++n) {
+            unsigned j = (unsigned)(ptmp->piv - 1);
+            if ((ptmp->piv < 1)||(j >= numPivots)||(j == i)) {
+                tdFdeltaMsgOut(status,
+                    "WARNING:Fibre %d listed as crossing above fibre %d in %s field",
+                    (int)ptmp->piv, i+1, what);
+                ++bad;
+                continue;
+            }
+            if (PairGet(cs.listed, numPivots, i, j)) {
+                tdFdeltaMsgOut(status,
+                    "WARNING:Fibres %d and %d listed as crossing above each other in %s field",
+                    j+1, i+1, what);
+                ++bad;
+            } else if ((PairGet(cs.found, numPivots, i, j))||
+                       (CheckCross(con, cur, i, j))) {
+                PairSet(cs.listed, numPivots, i, j);
+            } else {
+                tdFdeltaMsgOut(status,
+                    "WARNING:Fibre %d listed as crossing above fibre %d in %s field, but they don't cross",
+                    j+1, i+1, what);
+                ++bad;
+            }
+        }
+        if (n != cur->nAbove[i]) {
+            tdFdeltaMsgOut(status,
+                "WARNING:Fibre %d has %d fibres listed as crossing above it in %s field, but a count of %d",
+                i+1, n, what, (int)cur->nAbove[i]);
+            ++bad;
+        }
+    }
+
+    /*
+     *  Everything which crosses must be in the lists.
+     */
+    for (p = 0; p < cs.numPairs ; ++p) {
+        unsigned a = cs.pairs[2*p];
+        unsigned b = cs.pairs[2*p+1];
+        if ((!PairGet(cs.listed, numPivots, a, b))&&
+            (CheckCross(con, cur, a, b))) {
+            tdFdeltaMsgOut(status,
+                "WARNING:Fibres %d and %d cross in %s field, but neither is listed as crossing above the other",
+                a+1, b+1, what);
+            ++bad;
+        }
+    }
+
+ CLEANUP:
+    free(cs.found);
+    free(cs.listed);
+    free(cs.pairs);
+    return bad;
+}
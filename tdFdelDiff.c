@@ -0,0 +1,887 @@
+/*+               T D F D E L T A
+
+ *  Module name:
+      tdFdiff
+
+ *  Function:
+      Planner equivalence harness.
+
+ *  Description:
+      Runs the reference sequencer and each of the alternative sequencer
+      engines on the same inputs and checks they produce the same
+      command file.  The MF and PF line sequences and the numMoves and
+      numParks counts are compared.  For each input, a line is written
+      for each engine giving its time, the speed-up over the reference
+      and the result, which is one of -
+
+          same       - Identical to the reference.
+          better     - Different, but with fewer moves plus parks than
+                       the reference.  Such differences must be documented
+                       with the engine.
+          DIFF       - Different, and no better.  The first differing
+                       line is reported.
+          BAD        - The engine failed where the reference did not, or
+                       the reverse.
+
+      An engine is a set of check flags which are added to the input's
+      flags and the way the plan is run.  Alternative engines are added
+      to the engines table as they are implemented.  The engines are
+      currently -
+
+          reference  - The normal (or SPECIAL) sequencer.
+          warm       - With the warm start pair matrix (see tdFdelWarm.c)
+                       built from the current field, as if it had been
+                       set up by the previous plan.
+          cache      - Planned once to fill the result cache (see
+                       tdFdelCache.c), then looked up again, the command
+                       file being the one replayed from the cache.  A
+                       miss is reported as BAD.
+          packed     - The PACKED flag.  The lines are passed to the
+                       cfCmd callback as commands and formatted again
+                       with tdFdeltaCFformat(), as for older readers.
+          thread     - The THREAD flag.  Sequenced in a worker thread
+                       with its own instrument model, as by the task,
+                       the lines being picked up when it completes.
+          stream     - The THREAD and STREAM flags.  As per thread, but
+                       the lines are picked up as they come, whilst the
+                       worker runs.
+
+      The field check of random fields is always made in the calling
+      thread, before the engine is run.
+
+      The reference results may also be written to a directory, with
+      -w, and compared with those from an earlier build, with -k, so that
+      a change to the reference sequencer itself can be checked.
+
+      Inputs are either GENERATE input snapshots (see tdFdelSnap.c), or
+      random fields from tdFdeltaGenField() (see tdFdelGen.c).  The
+      program is linked with the stand-in instrument model, so snapshots
+      taken with the real instruments are run with the stand-in model
+      of similar geometry and the field check is skipped for them.  As
+      every engine sees the same model, this doesn't affect the
+      comparison.  Random fields are checked and skipped if the check
+      fails.
+
+      Every engine but warm is run cold, the warm start pair matrix
+      being cleared first.
+
+      Usage:
+
+          tdFdiff [options] [snapshot ...]
+
+      Options:
+
+          -g 2df|6df|both       Geometry of random fields, default both.
+          -n first,last,step    Numbers of pivots of random fields.  The
+                                default is 100,400,100 when no snapshots
+                                are given, otherwise no random fields.
+          -d density            As per tdFbench.
+          -c crossing           As per tdFbench.
+          -m mustMove           As per tdFbench.
+          -t tweak              As per tdFbench.
+          -s seed               As per tdFbench.
+          -r repeats            As per tdFbench.
+          -w dir                Write the reference results to dir.
+          -k dir                Compare the reference results with those
+                                in dir.
+          -v                    Output planner messages to stderr.
+
+      The exit status is 0 if all engines gave the same or better results,
+      otherwise 1.
+
+      In a single instrument build (see tdFdeltaCore.h), random fields
+      are only made for that instrument at its nominal number of pivots,
+      and other snapshots fail.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Add the tweak option.
+      18-Oct-2026  AGT  Add the intgeom engine.
+      18-Oct-2026  AGT  Skip instruments which do not suit a single
+                        instrument build.
+      18-Oct-2026  AGT  Free the stand-in instruments, each is allocated.
+      19-Oct-2026  AGT  Remove the intgeom engine, INT_GEOM is gone.
+      19-Oct-2026  AGT  Add the warm, cache, packed, thread and stream
+                        engines.  Every other engine is run cold.
+      {@change entry@}
+
+ *  @(#) $Id: ACMM:2dFdelta/tdFdelDiff.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
+ */
+
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelDiff.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"             /* STATUS__OK definition          */
+
+#include "tdFdeltaCore.h"       /* Planning core                  */
+#include "tdFdelta_Err.h"       /* TDFDLETA Errors                */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef TDFDELTA_REENTRANT
+#   include <pthread.h>
+#endif
+
+/*
+ *  How an engine is run.
+ */
+#define RUN_COLD        0           /* In this thread, no warm start     */
+#define RUN_WARM        1           /* With the warm start pair matrix   */
+#define RUN_CACHE       2           /* Replayed from the result cache    */
+#define RUN_THREAD      3           /* In a worker thread                */
+
+#define POLL_NS   1000000           /* Stream engine poll interval       */
+
+/*
+ *  The sequencer engines.  The first is the reference.
+ */
+typedef struct {
+    const char  *name;
+    short       check;              /* Check flags added to the input's */
+    int         run;                /* RUN_...                          */
+    } Engine;
+
+static const Engine engines[] = {
+    { "reference",  0,               RUN_COLD },
+    { "warm",       0,               RUN_WARM },
+    { "cache",      0,               RUN_CACHE },
+    { "packed",     PACKED,          RUN_COLD },
+    { "thread",     THREAD,          RUN_THREAD },
+    { "stream",     THREAD|STREAM,   RUN_THREAD },
+    };
+
+#define NUM_ENGINES ((int)(sizeof(engines)/sizeof(engines[0])))
+
+/*
+ *  The result of one run.
+ */
+typedef struct {
+    char        **lines;            /* MF and PF lines                  */
+    unsigned    numLines;
+    unsigned    allocLines;
+    long        moves;              /* numMoves                         */
+    long        parks;              /* numParks                         */
+    StatusType  status;
+    double      ms;                 /* Sequencer wall time              */
+    int         verbose;
+    } Result;
+
+/*
+ *  An input, either a snapshot file or random field.
+ */
+typedef struct {
+    const char     *snapshot;       /* Snapshot file, or null           */
+    tdFgenParams   gen;             /* Random field parameters          */
+    unsigned long  seed;
+    char           name[FILENAME_LENGTH];
+    } Input;
+
+static int verbose = 0;
+
+/*
+ *  Output callbacks.
+ */
+static void DiffMsgOut(
+        void        *clientData,
+        const char  *text)
+{
+    if (((Result *)clientData)->verbose)
+        fprintf(stderr, "%s\n", text);
+}
+
+static void DiffErsRep(
+        void        *clientData,
+        int         flags,
+        StatusType  *status,
+        const char  *text)
+{
+    if (((Result *)clientData)->verbose)
+        fprintf(stderr, "!! %s\n", text);
+}
+
+static void DiffCfLine(
+        void        *clientData,
+        const char  *name,
+        const char  *line,
+        StatusType  *status)
+{
+    Result *res = (Result *)clientData;
+    if ((strncmp(line, "MF", 2) != 0)&&(strncmp(line, "PF", 2) != 0))
+        return;
+    if (res->numLines == res->allocLines) {
+        unsigned n = res->allocLines ? res->allocLines*2 : 256;
+        char **p = (char **)realloc(res->lines, n*sizeof(char *));
+        if (!p) {
+            *status = TDFDELTA__MALLOCERR;
+            return;
+        }
+        res->lines = p;
+        res->allocLines = n;
+    }
+    if ((res->lines[res->numLines] = (char *)malloc(strlen(line)+1)) == NULL) {
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    strcpy(res->lines[res->numLines++], line);
+}
+
+static void DiffCfCount(
+        void        *clientData,
+        const char  *name,
+        long int    value,
+        StatusType  *status)
+{
+    Result *res = (Result *)clientData;
+    if (strcmp(name, "numMoves") == 0)
+        res->moves = value;
+    else if (strcmp(name, "numParks") == 0)
+        res->parks = value;
+}
+
+static void ResultFree(
+        Result  *res)
+{
+    unsigned i;
+    for (i = 0; i < res->numLines ; ++i)
+        free(res->lines[i]);
+    free(res->lines);
+    memset(res, 0, sizeof(*res));
+}
+
+/*
+ *  Set up the stand-in instrument for a snapshot, replacing that of the
+ *  last snapshot.
+ */
+static FpilType snapInst = 0;
+
+static int SnapInstrument(
+        const char  *instName,
+        int         numPivots)
+{
+    StatusType  status = STATUS__OK;
+    FpilType    inst;
+    int         sixdf = (strchr(instName, '6') != 0);
+    tdFdeltaFpilSimInit(tdFdeltaFpilSimGeom(sixdf), (unsigned)numPivots,
+                        &inst, &status);
+    if (status != STATUS__OK) return 0;
+    if (!tdFdeltaFpilFixed(inst)) {
+        FpilFree(inst);
+        return 0;
+    }
+    tdFdeltaFpilSet(inst);
+    if (snapInst) FpilFree(snapInst);
+    snapInst = inst;
+    return 1;
+}
+
+/*
+ *  A command line passed as a command, with the PACKED flag.
+ */
+static void DiffCfCmd(
+        void            *clientData,
+        int             lineNo,
+        const tdFcfCmd  *cmd,
+        StatusType      *status)
+{
+    char line[CMDLINE_LENGTH];
+    tdFdeltaCFformat(cmd, line, status);
+    if (*status == STATUS__OK)
+        DiffCfLine(clientData, "", line, status);
+}
+
+/*
+ *  Set up an input for an engine, with its output to res.  Returns null
+ *  if the input could not be set up.
+ */
+static tdFdeltaType *Load(
+        const Input   *input,
+        const Engine  *engine,
+        Result        *res)
+{
+    StatusType    status = STATUS__OK;
+    tdFdeltaType  *data;
+
+    if (input->snapshot) {
+        char  instName[32];
+        int   numPivots;
+        if ((data = tdFdeltaSnapLoad(input->snapshot, sizeof(instName),
+                                     instName, &numPivots, &status)) == NULL)
+            return NULL;
+        if (!SnapInstrument(instName, numPivots)) {
+            tdFdeltaDataFree(data);
+            return NULL;
+        }
+        data->check &= ~(THREAD|TRACE|SNAPSHOT|PACKED|STREAM);
+    } else if ((data = tdFdeltaGenField(&input->gen, input->seed,
+                                        &status)) == NULL) {
+        return NULL;
+    }
+
+    data->check |= engine->check;
+    data->out.clientData = res;
+    data->out.msgOut = DiffMsgOut;
+    data->out.ersRep = DiffErsRep;
+    data->out.cfLine = DiffCfLine;
+    data->out.cfCount = DiffCfCount;
+    if (data->check & PACKED)
+        data->out.cfCmd = DiffCfCmd;
+    tdFdeltaUse(data);
+    return data;
+}
+
+/*
+ *  Run the sequencer given by the plan's flags.
+ */
+static void Sequence(
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    int never = 0;
+    if (data->check & SPECIAL)
+        tdFdeltaSequencerSpecialRun(data, 0, status);
+    else
+        tdFdeltaSequencerRun(data, &never, status);
+}
+
+/*
+ *  A worker thread, for the thread and stream engines.  The result is
+ *  first, so the message callbacks may be given the worker.
+ */
+typedef struct {
+    Result          res;            /* Output of the worker             */
+    tdFdeltaType    *data;
+    StatusType      status;
+    volatile int    done;
+#ifdef TDFDELTA_REENTRANT
+    pthread_t       thread;
+    pthread_mutex_t lock;           /* Protects res                     */
+#endif
+    } Worker;
+
+static void WorkerLock(
+        Worker  *worker)
+{
+#ifdef TDFDELTA_REENTRANT
+    pthread_mutex_lock(&worker->lock);
+#endif
+}
+
+static void WorkerUnlock(
+        Worker  *worker)
+{
+#ifdef TDFDELTA_REENTRANT
+    pthread_mutex_unlock(&worker->lock);
+#endif
+}
+
+static void WorkerCfLine(
+        void        *clientData,
+        const char  *name,
+        const char  *line,
+        StatusType  *status)
+{
+    Worker *worker = (Worker *)clientData;
+    WorkerLock(worker);
+    DiffCfLine(&worker->res, name, line, status);
+    WorkerUnlock(worker);
+}
+
+static void WorkerCfCount(
+        void        *clientData,
+        const char  *name,
+        long int    value,
+        StatusType  *status)
+{
+    Worker *worker = (Worker *)clientData;
+    WorkerLock(worker);
+    DiffCfCount(&worker->res, name, value, status);
+    WorkerUnlock(worker);
+}
+
+static void *WorkerMain(
+        void  *arg)
+{
+    Worker *worker = (Worker *)arg;
+    tdFdeltaUse(worker->data);
+    Sequence(worker->data, &worker->status);
+    TDFDELTA_STORE(&worker->done, 1);
+    return 0;
+}
+
+/*
+ *  Copy the lines the worker has output since the last call to res.
+ */
+static void WorkerTake(
+        Worker    *worker,
+        Result    *res,
+        unsigned  *taken)
+{
+    StatusType ignore = STATUS__OK;
+    WorkerLock(worker);
+    while (*taken < worker->res.numLines)
+        DiffCfLine(res, "", worker->res.lines[(*taken)++], &ignore);
+    res->moves = worker->res.moves;
+    res->parks = worker->res.parks;
+    WorkerUnlock(worker);
+}
+
+/*
+ *  Sequence in a worker thread with its own instrument model, as the
+ *  task does with the THREAD flag.  With the STREAM flag, the lines are
+ *  picked up as they come.  Built without TDFDELTA_REENTRANT, the plan
+ *  is run in the calling thread.
+ */
+static void RunThread(
+        tdFdeltaType  *data,
+        Result        *res)
+{
+    StatusType    status = STATUS__OK;
+    Worker        worker;
+    FpilType      inst;
+    unsigned      taken = 0;
+
+    tdFdeltaFpilSimInit(tdFdeltaFpilSimGeom(
+                            strchr(FpilGetInstName(tdFdeltaFpilInst()), '6')
+                            != 0),
+                        tdFdeltaNumPivots(tdFdeltaFpilInst()), &inst, &status);
+    if (status != STATUS__OK) {
+        res->status = status;
+        return;
+    }
+    memset(&worker, 0, sizeof(worker));
+    worker.res.verbose = res->verbose;
+    worker.data = data;
+    worker.status = STATUS__OK;
+    data->inst = inst;
+    data->out.clientData = &worker;
+    data->out.cfLine = WorkerCfLine;
+    data->out.cfCount = WorkerCfCount;
+
+#ifdef TDFDELTA_REENTRANT
+    pthread_mutex_init(&worker.lock, 0);
+    if (pthread_create(&worker.thread, 0, WorkerMain, &worker) == 0) {
+        while ((data->check & STREAM)&&(!TDFDELTA_LOAD(&worker.done))) {
+            struct timespec ts;
+            ts.tv_sec = 0;
+            ts.tv_nsec = POLL_NS;
+            nanosleep(&ts, 0);
+            WorkerTake(&worker, res, &taken);
+        }
+        pthread_join(worker.thread, 0);
+    } else {
+        worker.status = TDFDELTA__DELTAERR;
+    }
+#else
+    WorkerMain(&worker);
+#endif
+    WorkerTake(&worker, res, &taken);
+    res->status = worker.status;
+
+#ifdef TDFDELTA_REENTRANT
+    pthread_mutex_destroy(&worker.lock);
+#endif
+    ResultFree(&worker.res);
+    data->inst = 0;
+    tdFdeltaUse(data);              /* Drop the worker's instrument      */
+    FpilFree(inst);
+}
+
+/*
+ *  Plan an input once, so that its result is in the cache.  Returns false
+ *  if the input could not be set up or a random field fails the field
+ *  check.
+ */
+static int Prime(
+        const Input   *input,
+        const Engine  *engine)
+{
+    StatusType    status = STATUS__OK;
+    tdFdeltaType  *data;
+    Result        res;
+
+    memset(&res, 0, sizeof(res));
+    res.verbose = verbose;
+    if ((data = Load(input, engine, &res)) == NULL)
+        return 0;
+    tdFdeltaCacheClear();
+    if ((tdFdeltaCacheLookup(data, &status))||
+        ((!input->snapshot)&&(!tdFdeltaFieldCheckRun(data, 0, &status)))) {
+        tdFdeltaDataFree(data);
+        ResultFree(&res);
+        return 0;
+    }
+    Sequence(data, &status);
+    tdFdeltaDataFree(data);
+    ResultFree(&res);
+    return 1;
+}
+
+/*
+ *  Run one engine on an input.  Returns false if the input could not be
+ *  set up, or a random field fails the field check.
+ */
+static int RunEngine(
+        const Input   *input,
+        const Engine  *engine,
+        Result        *res)
+{
+    StatusType    status = STATUS__OK;
+    tdFdeltaType  *data;
+    double        tStart;
+
+    memset(res, 0, sizeof(*res));
+    res->verbose = verbose;
+
+    if ((engine->run == RUN_CACHE)&&(!Prime(input, engine)))
+        return 0;
+    if ((data = Load(input, engine, res)) == NULL)
+        return 0;
+    tdFdeltaWarmClear();
+
+    if (engine->run == RUN_CACHE) {
+        tStart = tdFdeltaClock();
+        if (!tdFdeltaCacheLookup(data, &status)) {
+            if (status == STATUS__OK) status = TDFDELTA__DELTAERR;
+            DiffErsRep(res, 0, &status, "Result not found in the cache");
+        }
+        res->ms = (tdFdeltaClock() - tStart)*1.0e3;
+        res->status = status;
+        tdFdeltaCacheClear();
+        tdFdeltaDataFree(data);
+        return 1;
+    }
+
+    if ((!input->snapshot)&&(!tdFdeltaFieldCheckRun(data, 0, &status))) {
+        tdFdeltaDataFree(data);
+        return 0;
+    }
+    if (engine->run == RUN_WARM) {
+        tdFdeltaWarmSave(data, &status);
+        tdFdeltaStatsInit(&data->stats);
+    }
+    tStart = tdFdeltaClock();
+    if (engine->run == RUN_THREAD) {
+        RunThread(data, res);
+    } else {
+        Sequence(data, &status);
+        res->status = status;
+    }
+    res->ms = (tdFdeltaClock() - tStart)*1.0e3;
+    tdFdeltaDataFree(data);
+    return 1;
+}
+
+/*
+ *  Compare a result with the reference.  Returns the result text and the
+ *  first differing line number (from 1) in *line, or 0 if the
+ *  difference is in the counts.
+ */
+static const char *Compare(
+        const Result  *ref,
+        const Result  *res,
+        unsigned      *line)
+{
+    unsigned i;
+
+    *line = 0;
+    if ((ref->status == STATUS__OK) != (res->status == STATUS__OK))
+        return "BAD";
+    if (ref->status != STATUS__OK)
+        return "same";
+    for (i = 0; (i < ref->numLines)&&(i < res->numLines) ; ++i) {
+        if (strcmp(ref->lines[i], res->lines[i]) != 0)
+            break;
+    }
+    if ((i == ref->numLines)&&(i == res->numLines)&&
+        (ref->moves == res->moves)&&(ref->parks == res->parks))
+        return "same";
+    if ((i < ref->numLines)||(i < res->numLines))
+        *line = i+1;
+    if (res->moves + res->parks < ref->moves + ref->parks)
+        return "better";
+    return "DIFF";
+}
+
+/*
+ *  Write the reference results to, or read them from, dir.  The file is
+ *  the counts followed by the lines.
+ */
+static int WriteResult(
+        const char    *dir,
+        const Input   *input,
+        const Result  *res)
+{
+    char     file[FILENAME_LENGTH*2+10];
+    FILE     *fp;
+    unsigned i;
+
+    sprintf(file, "%s/%s.cf", dir, input->name);
+    if ((fp = fopen(file, "w")) == NULL) {
+        fprintf(stderr, "tdFdiff: failed to create %s\n", file);
+        return 0;
+    }
+    fprintf(fp, "%ld %ld %d\n", res->moves, res->parks,
+            (res->status == STATUS__OK));
+    for (i = 0; i < res->numLines ; ++i)
+        fprintf(fp, "%s\n", res->lines[i]);
+    fclose(fp);
+    return 1;
+}
+
+static int ReadResult(
+        const char    *dir,
+        const Input   *input,
+        Result        *res)
+{
+    char     file[FILENAME_LENGTH*2+10];
+    char     line[200];
+    FILE     *fp;
+    int      ok = 0;
+
+    memset(res, 0, sizeof(*res));
+    sprintf(file, "%s/%s.cf", dir, input->name);
+    if ((fp = fopen(file, "r")) == NULL) {
+        fprintf(stderr, "tdFdiff: failed to open %s\n", file);
+        return 0;
+    }
+    if (fscanf(fp, "%ld %ld %d\n", &res->moves, &res->parks, &ok) != 3) {
+        fprintf(stderr, "tdFdiff: %s is not a results file\n", file);
+        fclose(fp);
+        return 0;
+    }
+    res->status = ok ? STATUS__OK : TDFDELTA__DELTAERR;
+    while (fgets(line, sizeof(line), fp)) {
+        StatusType ignore = STATUS__OK;
+        line[strcspn(line, "\n")] = '\0';
+        DiffCfLine(res, "", line, &ignore);
+    }
+    fclose(fp);
+    return 1;
+}
+
+/*
+ *  Run all the engines on an input and report.  Returns false if any
+ *  engine's results were not the same or better.
+ */
+static int RunInput(
+        const Input  *input,
+        const char   *writeDir,
+        const char   *checkDir)
+{
+    Result    ref;
+    int       ok = 1;
+    int       e;
+
+    if (!RunEngine(input, &engines[0], &ref)) {
+        printf("%-24s skipped, failed to set up or check the field\n",
+               input->name);
+        return 1;
+    }
+    printf("%-24s %-12s %10.3f ms %8.2fx %6ld %6ld  %s\n", input->name,
+           engines[0].name, ref.ms, 1.0, ref.moves, ref.parks,
+           ref.status == STATUS__OK ? "ok" : "failed");
+
+    for (e = 1; e < NUM_ENGINES ; ++e) {
+        Result       res;
+        const char   *what;
+        unsigned     line;
+        if (!RunEngine(input, &engines[e], &res)) {
+            printf("%-24s %-12s BAD, failed to set up\n", input->name,
+                   engines[e].name);
+            ok = 0;
+            continue;
+        }
+        what = Compare(&ref, &res, &line);
+        printf("%-24s %-12s %10.3f ms %8.2fx %6ld %6ld  %s", input->name,
+               engines[e].name, res.ms,
+               (res.ms > 0 ? ref.ms/res.ms : 0.0), res.moves, res.parks,
+               what);
+        if (line)
+            printf(" at line %u: \"%s\" vs \"%s\"", line,
+                   line <= ref.numLines ? ref.lines[line-1] : "",
+                   line <= res.numLines ? res.lines[line-1] : "");
+        printf("\n");
+        if ((strcmp(what, "same") != 0)&&(strcmp(what, "better") != 0))
+            ok = 0;
+        ResultFree(&res);
+    }
+
+    if (writeDir && !WriteResult(writeDir, input, &ref))
+        ok = 0;
+    if (checkDir) {
+        Result       old;
+        const char   *what;
+        unsigned     line;
+        if (!ReadResult(checkDir, input, &old)) {
+            ok = 0;
+        } else {
+            what = Compare(&old, &ref, &line);
+            printf("%-24s %-12s %6ld %6ld  %s", input->name, "(recorded)",
+                   old.moves, old.parks, what);
+            if (line)
+                printf(" at line %u: \"%s\" vs \"%s\"", line,
+                       line <= old.numLines ? old.lines[line-1] : "",
+                       line <= ref.numLines ? ref.lines[line-1] : "");
+            printf("\n");
+            if (strcmp(what, "same") != 0)
+                ok = 0;
+            ResultFree(&old);
+        }
+    }
+    ResultFree(&ref);
+    return ok;
+}
+
+static void Usage(
+        const char  *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [-g 2df|6df|both] [-n first,last,step] [-d density]\n"
+        "          [-c crossing] [-m mustMove] [-t tweak] [-s seed]\n"
+        "          [-r repeats] [-w dir | -k dir] [-v] [snapshot ...]\n",
+        prog);
+}
+
+int main(
+        int   argc,
+        char  *argv[])
+{
+    Input        input;
+    const char   *writeDir = 0;
+    const char   *checkDir = 0;
+    unsigned     first = 100;
+    unsigned     last = 400;
+    unsigned     step = 100;
+    unsigned     repeats = 1;
+    int          random = -1;
+    int          geomFirst = 0;
+    int          geomLast = 1;
+    int          ok = 1;
+    int          sixdf;
+    int          i;
+
+    memset(&input, 0, sizeof(input));
+    input.gen.density  = 0.8;
+    input.gen.crossing = 0.5;
+    input.gen.mustMove = 0.7;
+    input.seed         = 1;
+
+    for (i = 1; i < argc ; ++i) {
+        const char *opt = argv[i];
+        const char *val = (i+1 < argc ? argv[i+1] : 0);
+        if (opt[0] != '-')
+            break;
+        if (strcmp(opt, "-v") == 0) {
+            verbose = 1;
+            continue;
+        }
+        if ((!val)||(opt[2] != '\0')) {
+            Usage(argv[0]);
+            return 2;
+        }
+        ++i;
+        switch (opt[1]) {
+          case 'g':
+            if (strcmp(val, "2df") == 0)       geomLast = 0;
+            else if (strcmp(val, "6df") == 0) geomFirst = 1;
+            else if (strcmp(val, "both") != 0) { Usage(argv[0]); return 2; }
+            break;
+          case 'n':
+            if ((sscanf(val, "%u,%u,%u", &first, &last, &step) != 3)||
+                (first == 0)||(step == 0)) {
+                Usage(argv[0]);
+                return 2;
+            }
+            random = 1;
+            break;
+          case 'd': input.gen.density  = atof(val); break;
+          case 'c': input.gen.crossing = atof(val); break;
+          case 'm': input.gen.mustMove = atof(val); break;
+          case 't': input.gen.tweak    = atol(val); break;
+          case 's': input.seed         = strtoul(val, 0, 10); break;
+          case 'r': repeats            = (unsigned)atoi(val); break;
+          case 'w': writeDir           = val; break;
+          case 'k': checkDir           = val; break;
+          default:
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((writeDir)&&(checkDir)) {
+        Usage(argv[0]);
+        return 2;
+    }
+    if (random < 0)
+        random = (i == argc);
+
+    /*
+     *  Snapshots.
+     */
+    for ( ; i < argc ; ++i) {
+        const char *base = strrchr(argv[i], '/');
+        input.snapshot = argv[i];
+        strncpy(input.name, base ? base+1 : argv[i], sizeof(input.name)-1);
+        if (!RunInput(&input, writeDir, checkDir))
+            ok = 0;
+    }
+    input.snapshot = 0;
+
+    /*
+     *  Random fields.
+     */
+    for (sixdf = geomFirst; random && (sixdf <= geomLast) ; ++sixdf) {
+        unsigned n;
+        for (n = first; n <= last ; n += step) {
+            StatusType     status = STATUS__OK;
+            FpilType       inst;
+            unsigned long  seed = input.seed;
+            unsigned       r;
+
+            if (n > FPIL_MAXPIVOTS) {
+                fprintf(stderr,
+                        "%s: %u pivots skipped, FPIL_MAXPIVOTS is %d\n",
+                        argv[0], n, FPIL_MAXPIVOTS);
+                continue;
+            }
+            tdFdeltaFpilSimInit(tdFdeltaFpilSimGeom(sixdf), n, &inst,
+                                &status);
+            if (status != STATUS__OK) {
+                fprintf(stderr, "%s: failed to create instrument\n", argv[0]);
+                return 1;
+            }
+            if (!tdFdeltaFpilFixed(inst)) {
+                fprintf(stderr,
+                        "%s: %s with %u pivots skipped, not this build's "
+                        "instrument\n", argv[0], FpilGetInstName(inst), n);
+                FpilFree(inst);
+                continue;
+            }
+            tdFdeltaFpilSet(inst);
+
+            for (r = 0; r < repeats ; ++r) {
+                input.seed = seed + r;
+                sprintf(input.name, "%s-%u-s%lu",
+                        FpilGetInstName(inst), n, input.seed);
+                if (!RunInput(&input, writeDir, checkDir))
+                    ok = 0;
+            }
+            input.seed = seed;
+            FpilFree(inst);
+        }
+    }
+
+    return (ok ? 0 : 1);
+}
@@ -0,0 +1,1706 @@
+/*+                T D F D E L T A
+
+ *  Module name:
+      tdFdeltaDrama
+
+ *  Function:
+      Connects the planning core to DRAMA.
+
+ *  Description:
+      The planning core (tdFdeltaCore.h) makes no DRAMA calls, all its
+      output goes through the callbacks in the plan's tdFdeltaCallbacks.
+      This module provides the callbacks used by the task -
+
+          msgOut, ersRep  - MsgOut() and ErsRep().
+          progress        - The DELTA_PROG and DELTA_ETA parameters.
+          stats           - The DELTA_STATS parameter.
+          errorText       - DitsErrorText().
+          cfNew ... cfDone- Build the command file as an Sds structure,
+                            which is returned as the action argument.
+
+      along with the action handlers which run the core's field check and
+      sequencers within the action, the Sds command file functions and the
+      DELTA_STATS parameter functions.
+
+      The "above" item from the current field details is held with the
+      callbacks, since the core does not know of Sds.  It is inserted into
+      the command file when that is created.
+
+      The callbacks must only be invoked from the main thread.  The worker
+      thread (tdFdelThread.c) substitutes its own, then passes the saved
+      output on to these.
+
+      With the PACKED flag (see tdFdeltaDramaPacked()), the lines of the
+      command file are not written as `line<n>' strings.  The commands
+      are gathered in columns instead and written on completion as one
+      array of each of the op codes, pivots, x, y and theta, with any
+      comments in a single character array.  tdFdeltaCFread() reads
+      either form back in bulk and tdFdeltaCFlegacy() adds the lines to
+      a packed command file for older readers.
+
+      With the STREAM flag (see tdFdeltaDramaStream()), the lines are
+      also sent as they come, each line being final once added, so the
+      positioner may start on them whilst the rest are planned.  Each
+      chunk is sent as a trigger message of the action, a structure
+      CmdFileChunk with the items firstLine and numLines and the lines,
+      as `lineX' strings, or as the arrays of a packed command file.
+      The comments of a packed chunk are those added since the last, so
+      its cmdText starts at offset textOffset of the command file's.
+      A chunk is sent as soon as the first move or park is added, every
+      STREAM_LINES lines, after each slice of the sequencer or poll of
+      its worker thread (see tdFdeltaDramaFlush()) and before the
+      complete command file is returned.
+
+      The plan is only validated at the end, by the final crossover check
+      of the sequencer, so lines may be sent for a plan which then fails.
+      If a plan fails or is cancelled once chunks have been sent, a
+      trigger message CmdFileAbort is sent before the action completes,
+      with the item lastLine, the last line sent.  A positioner which
+      streams must honour it - it must start no further lines of the
+      command file, complete any move already under way (a fibre is not
+      left part way through a move) and then stop.  The lines it has
+      carried out are each valid in turn, but the crossover lists of the
+      failed plan are not, so the field must not be continued with
+      REPLAN.  Instead the positions are read back and a new plan made
+      with GENERATE from them.  A positioner which does not stream need
+      do nothing, as the command file is only returned once the plan has
+      passed its checks.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version.  The action handlers and the Sds
+                        parts of tdFdeltaCmdFile and tdFdeltaStats moved
+                        here from tdFdelFieldCh.c, tdFdelSeq.c,
+                        tdFdelSeqSp.c, tdFdelCmdFile.c and tdFdelStats.c.
+      18-Oct-2026  AGT  Add the result cache items to DELTA_STATS.
+      18-Oct-2026  AGT  Add warmSkips to DELTA_STATS.
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
+      18-Oct-2026  AGT  The trace and snapshot are held with the plan.
+      18-Oct-2026  AGT  Add packed command files, tdFdeltaDramaPacked(),
+                        tdFdeltaCFread(), tdFdeltaCFfree() and
+                        tdFdeltaCFlegacy().
+      18-Oct-2026  AGT  Add tdFdeltaDramaStream() and tdFdeltaDramaFlush()
+                        to send the lines as they come.
+      19-Oct-2026  AGT  Send CmdFileAbort if a streamed plan fails.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelDrama.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelDrama.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "DitsTypes.h"       /* Basic dits types            */
+#include "Dits_Err.h"        /* Dits error codes            */
+#include "DitsSys.h"         /* For PutActionHandlers       */
+#include "DitsFix.h"         /* For various Dits routines   */
+#include "DitsMsgOut.h"      /* For MsgOut                  */
+#include "DitsUtil.h"        /* For DitsErrorText           */
+#include "arg.h"             /* For ARG_ macros             */
+#include "sds.h"             /* For SDS_ macros             */
+#include "Sdp.h"             /* Sdp routines                */
+#include "Ers.h"
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdelta.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STATS_PARAM "DELTA_STATS"
+
+#define PACK_LINES  256         /* Initial lines allocated for a packed
+                                   command file                         */
+#define STREAM_LINES 32         /* Lines sent at a time when streaming  */
+
+/*
+ *  The clientData of the DRAMA callbacks.
+ */
+typedef struct {
+    SdsIdType   above;          /* Above item for the command file       */
+    SdsIdType   cmdFileId;      /* Command file being built, if any      */
+    short       packed;         /* Write a packed command file           */
+    tdFcmdFile  pack;           /* Lines of the packed command file      */
+    short       stream;         /* Send the lines as they come           */
+    SdsIdType   chunk;          /* Lines not yet sent, if not packed     */
+    unsigned long firstLine;    /* First line not yet sent               */
+    unsigned long lastLine;     /* Last line added                       */
+    unsigned long textSent;     /* Packed comment text sent              */
+    unsigned long numChunks;    /* Chunks sent                           */
+} tdFdramaOut;
+
+
+/*
+ *  Set line lineNo of a packed command file, extending it as needed.
+ */
+static void PackCmd(
+    tdFcmdFile      *file,
+    int             lineNo,
+    const tdFcfCmd  *cmd,
+    StatusType      *status)
+{
+    unsigned long i, n;
+    short         *op, *piv;
+    INT32         *xf, *yf;
+    double        *theta;
+    char          *text;
+
+    if (*status != STATUS__OK) return;
+    if (lineNo < 1) {
+        *status = TDFDELTA__CF_NOCMD;
+        return;
+    }
+    i = lineNo-1;
+    if (i >= file->alloc) {
+        n = (file->alloc ? file->alloc*2 : PACK_LINES);
+        if (n <= i)
+            n = i+1;
+        if ((op = (short *)realloc(file->op,n*sizeof(short))) != NULL)
+            file->op = op;
+        if ((piv = (short *)realloc(file->piv,n*sizeof(short))) != NULL)
+            file->piv = piv;
+        if ((xf = (INT32 *)realloc(file->xf,n*sizeof(INT32))) != NULL)
+            file->xf = xf;
+        if ((yf = (INT32 *)realloc(file->yf,n*sizeof(INT32))) != NULL)
+            file->yf = yf;
+        if ((theta = (double *)realloc(file->theta,n*sizeof(double))) != NULL)
+            file->theta = theta;
+        if ((!op)||(!piv)||(!xf)||(!yf)||(!theta)) {
+            *status = TDFDELTA__MALLOCERR;
+            return;
+        }
+        file->alloc = n;
+    }
+
+    /*
+     *  Lines are normally added in order, but clear any skipped.
+     */
+    for (n = file->numLines; n < i; ++n) {
+        file->op[n] = file->piv[n] = 0;
+        file->xf[n] = file->yf[n] = 0;
+        file->theta[n] = 0;
+    }
+    if (i >= file->numLines)
+        file->numLines = i+1;
+
+    file->op[i]    = cmd->op;
+    file->piv[i]   = (short)cmd->piv;
+    file->xf[i]    = cmd->xf;
+    file->yf[i]    = cmd->yf;
+    file->theta[i] = cmd->theta;
+    if (cmd->comment) {
+        n = strlen(cmd->comment);
+        if (file->textLen+n+1 > file->textAlloc) {
+            unsigned long size = file->textAlloc*2;
+            if (size < file->textLen+n+1)
+                size = file->textLen+n+1+CMDLINE_LENGTH;
+            if ((text = (char *)realloc(file->text,size)) == NULL) {
+                *status = TDFDELTA__MALLOCERR;
+                return;
+            }
+            file->text = text;
+            file->textAlloc = size;
+        }
+        memcpy(file->text+file->textLen,cmd->comment,n+1);
+        file->xf[i] = (INT32)file->textLen;
+        file->yf[i] = (INT32)n;
+        file->textLen += n+1;
+    }
+}
+
+/*
+ *  Write an array to a new item of a command file.
+ */
+static void PutArray(
+    SdsIdType       cmdFileId,
+    const char      *name,
+    SdsCodeType     code,
+    unsigned long   n,
+    size_t          size,
+    void            *values,
+    StatusType      *status)
+{
+    SdsIdType       id = 0;
+    unsigned long   dims = (n ? n : 1);
+    StatusType      ignore = STATUS__OK;
+
+    SdsNew(cmdFileId,(char *)name,0,NULL,code,1,&dims,&id,status);
+    if (n)
+        SdsPut(id,n*size,0,values,status);
+    if (id)
+        SdsFreeId(id,&ignore);
+}
+
+/*
+ *  Write n lines of a packed command file from index first, as bulk
+ *  array copies, with the comment text from offset textFirst.
+ */
+static void PackWrite(
+    SdsIdType         cmdFileId,
+    const tdFcmdFile  *file,
+    unsigned long     first,
+    unsigned long     n,
+    unsigned long     textFirst,
+    StatusType        *status)
+{
+    if (*status != STATUS__OK) return;
+    ArgPuti(cmdFileId,"numLines",(long)n,status);
+    PutArray(cmdFileId,"cmdOp",   SDS_SHORT, n,sizeof(short), file->op+first,   status);
+    PutArray(cmdFileId,"cmdPiv",  SDS_SHORT, n,sizeof(short), file->piv+first,  status);
+    PutArray(cmdFileId,"cmdXf",   SDS_INT,   n,sizeof(INT32), file->xf+first,   status);
+    PutArray(cmdFileId,"cmdYf",   SDS_INT,   n,sizeof(INT32), file->yf+first,   status);
+    PutArray(cmdFileId,"cmdTheta",SDS_DOUBLE,n,sizeof(double),file->theta+first,status);
+    if (file->textLen > textFirst)
+        PutArray(cmdFileId,"cmdText",SDS_CHAR,file->textLen-textFirst,1,
+                 file->text+textFirst,status);
+}
+
+/*
+ *  Send the lines not yet sent as a trigger message.
+ */
+static void StreamFlush(
+    tdFdramaOut *ctx,
+    StatusType  *status)
+{
+    unsigned long n;
+    StatusType    ignore = STATUS__OK;
+
+    if ((*status != STATUS__OK)||(!ctx->stream)||
+        (ctx->lastLine < ctx->firstLine))
+        return;
+    n = ctx->lastLine-ctx->firstLine+1;
+    if (ctx->packed) {
+        SdsNew(0,"CmdFileChunk",0,NULL,SDS_STRUCT,0,NULL,&ctx->chunk,status);
+        PackWrite(ctx->chunk,&ctx->pack,ctx->firstLine-1,n,ctx->textSent,
+                  status);
+        if (ctx->pack.textLen > ctx->textSent)
+            ArgPuti(ctx->chunk,"textOffset",(long)ctx->textSent,status);
+        ctx->textSent = ctx->pack.textLen;
+    } else {
+        ArgPuti(ctx->chunk,"numLines",(long)n,status);
+    }
+    ArgPuti(ctx->chunk,"firstLine",(long)ctx->firstLine,status);
+    DitsTrigger(ctx->chunk,status);
+    if (ctx->chunk) {
+        SdsDelete(ctx->chunk,&ignore);
+        SdsFreeId(ctx->chunk,&ignore);
+        ctx->chunk = 0;
+    }
+    ctx->firstLine = ctx->lastLine+1;
+    ++ctx->numChunks;
+}
+
+/*
+ *  The command file is being discarded after chunks have been sent.
+ *  Send CmdFileAbort so the positioner stops (see the module
+ *  description).  Sent with its own status, as the action has usually
+ *  failed already.
+ */
+static void StreamAbort(
+    tdFdramaOut *ctx)
+{
+    SdsIdType   id = 0;
+    StatusType  ignore = STATUS__OK;
+
+    if ((!ctx->stream)||(ctx->numChunks == 0))
+        return;
+    SdsNew(0,"CmdFileAbort",0,NULL,SDS_STRUCT,0,NULL,&id,&ignore);
+    ArgPuti(id,"lastLine",(long)ctx->firstLine-1,&ignore);
+    DitsTrigger(id,&ignore);
+    if (id) {
+        ignore = STATUS__OK;
+        SdsDelete(id,&ignore);
+        SdsFreeId(id,&ignore);
+    }
+    ctx->numChunks = 0;
+}
+
+/*
+ *  A line has been added.  If streaming, it is added to the chunk,
+ *  which is sent every STREAM_LINES lines and as soon as the first move
+ *  or park is known, so the positioner can start.
+ */
+static void StreamLine(
+    tdFdramaOut *ctx,
+    int         lineNo,
+    const char  *name,
+    const char  *line,
+    int         isMove,
+    StatusType  *status)
+{
+    if ((*status != STATUS__OK)||(!ctx->stream)) return;
+    if (!ctx->packed) {
+        if (!ctx->chunk)
+            SdsNew(0,"CmdFileChunk",0,NULL,SDS_STRUCT,0,NULL,&ctx->chunk,
+                   status);
+        ArgPutString(ctx->chunk,(char *)name,(char *)line,status);
+    }
+    if ((lineNo > 0)&&((unsigned long)lineNo > ctx->lastLine))
+        ctx->lastLine = lineNo;
+    if ((ctx->lastLine-ctx->firstLine+1 >= STREAM_LINES)||
+        ((isMove)&&(ctx->numChunks == 0)))
+        StreamFlush(ctx,status);
+}
+
+
+/*
+ *  Read part of an array item of a command file.  The offset is in
+ *  elements, the length in bytes.
+ */
+static void GetArray(
+    SdsIdType       cmdFileId,
+    const char      *name,
+    unsigned long   offset,
+    unsigned long   length,
+    void            *values,
+    StatusType      *status)
+{
+    SdsIdType       id = 0;
+    unsigned long   actlen;
+    StatusType      ignore = STATUS__OK;
+
+    if (*status != STATUS__OK) return;
+    ArgFind(cmdFileId,(char *)name,&id,status);
+    SdsGet(id,length,offset,values,&actlen,status);
+    if ((*status == STATUS__OK)&&(actlen != length))
+        *status = TDFDELTA__CF_NOCMD;
+    if (id)
+        SdsFreeId(id,&ignore);
+}
+
+/*
+ *  Is the command file packed.
+ */
+static int IsPacked(
+    SdsIdType   cmdFileId,
+    StatusType  *status)
+{
+    SdsIdType   id = 0;
+
+    if (*status != STATUS__OK) return (0);
+    SdsFind(cmdFileId,"cmdOp",&id,status);
+    if (*status == SDS__NOITEM) {
+        *status = STATUS__OK;
+        return (0);
+    }
+    if (id)
+        SdsFreeId(id,status);
+    return (*status == STATUS__OK);
+}
+
+/*
+ *  tdFdeltaCFgetCmd() for a packed command file.
+ */
+static int GetPacked(
+    SdsIdType   cmdFileId,
+    int         lineNo,
+    tdFcmdLine  *line,
+    StatusType  *status)
+{
+    static const char * const names[] = { "", "MF", "PF", "!", "*" };
+    long        numLines;
+    short       op, piv;
+    INT32       xf, yf;
+    double      theta;
+
+    if (!IsPacked(cmdFileId,status))
+        return (0);
+    ArgGeti(cmdFileId,"numLines",&numLines,status);
+    if ((*status != STATUS__OK)||(lineNo < 1)||(lineNo > numLines))
+        return (0);
+
+    GetArray(cmdFileId,"cmdOp",   lineNo-1,sizeof(op),   &op,   status);
+    GetArray(cmdFileId,"cmdPiv",  lineNo-1,sizeof(piv),  &piv,  status);
+    GetArray(cmdFileId,"cmdXf",   lineNo-1,sizeof(xf),   &xf,   status);
+    GetArray(cmdFileId,"cmdYf",   lineNo-1,sizeof(yf),   &yf,   status);
+    GetArray(cmdFileId,"cmdTheta",lineNo-1,sizeof(theta),&theta,status);
+    if (*status != STATUS__OK) return (0);
+    if ((op < TDF_CF_MF)||(op > TDF_CF_ECHO)) {
+        *status = TDFDELTA__CF_NOCMD;
+        ErsRep(0,status,"Unknown command %d in command file line %d",
+               op,lineNo);
+        return (0);
+    }
+
+    strcpy(line->cmd,names[op]);
+    line->comment[0] = '\0';
+    if ((op == TDF_CF_NOTE)||(op == TDF_CF_ECHO)) {
+        line->piv = 0;
+        line->xf = line->yf = 0;
+        line->theta = 0;
+        if ((yf < 0)||(yf >= CMDLINE_LENGTH)) {
+            *status = TDFDELTA__CF_NOCMD;
+            ErsRep(0,status,"Invalid comment in command file line %d",lineNo);
+            return (0);
+        }
+        GetArray(cmdFileId,"cmdText",xf,yf,line->comment,status);
+        line->comment[yf] = '\0';
+    } else {
+        line->piv = piv;
+        line->xf = xf;
+        line->yf = yf;
+        line->theta = theta;
+    }
+    return (*status == STATUS__OK);
+}
+
+
+/*
+ *  The callbacks.
+ */
+static void DramaMsgOut(
+    void        *clientData,
+    const char  *text)
+{
+    StatusType ignore = STATUS__OK;
+    MsgOut(&ignore, "%s", text);
+}
+
+static void DramaErsRep(
+    void        *clientData,
+    int         flags,
+    StatusType  *status,
+    const char  *text)
+{
+    ErsRep(flags, status, "%s", text);
+}
+
+static void DramaProgress(
+    void        *clientData,
+    float       progress,
+    long int    eta,
+    StatusType  *status)
+{
+    SdpPutf("DELTA_PROG", progress, status);
+    SdpPuti("DELTA_ETA", eta, status);
+}
+
+static void DramaStats(
+    void            *clientData,
+    const tdFstats  *stats,
+    StatusType      *status)
+{
+    tdFdeltaStatsPublish(stats, status);
+}
+
+static const char *DramaErrorText(
+    void        *clientData,
+    StatusType  status)
+{
+    return DitsErrorText(status);
+}
+
+static void DramaCFnew(
+    void              *clientData,
+    const char        *name,
+    const tdFinterim  *cur,
+    StatusType        *status)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)clientData;
+    ctx->pack.numLines = 0;
+    ctx->pack.textLen = 0;
+    ctx->firstLine = 1;
+    ctx->lastLine = 0;
+    ctx->textSent = 0;
+    ctx->numChunks = 0;
+    ctx->cmdFileId = tdFdeltaCFcreate(name, cur, &ctx->above, status);
+}
+
+/*
+ *  Lines come here as text without the cfCmd callback, or when passed
+ *  on from a worker thread or the result cache.  When packed, they
+ *  are parsed back into their commands.
+ */
+static void DramaCFline(
+    void        *clientData,
+    const char  *name,
+    const char  *line,
+    StatusType  *status)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)clientData;
+    tdFcfCmd    cmd;
+    int         lineNo = (strncmp(name, "line", 4) == 0 ? atoi(name+4) : 0);
+
+    if (!ctx->packed) {
+        ArgPutString(ctx->cmdFileId, (char *)name, (char *)line, status);
+    } else if (*status == STATUS__OK) {
+        if ((lineNo < 1)||(!tdFdeltaCFparse(line, &cmd))) {
+            *status = TDFDELTA__CF_NOCMD;
+            ErsRep(0, status, "Invalid command file line %s \"%s\"",
+                   name, line);
+            return;
+        }
+        PackCmd(&ctx->pack, lineNo, &cmd, status);
+    }
+    StreamLine(ctx, lineNo, name, line,
+               ((line[0] == 'M')||(line[0] == 'P')), status);
+}
+
+static void DramaCFcmd(
+    void            *clientData,
+    int             lineNo,
+    const tdFcfCmd  *cmd,
+    StatusType      *status)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)clientData;
+    PackCmd(&ctx->pack, lineNo, cmd, status);
+    StreamLine(ctx, lineNo, 0, 0,
+               ((cmd->op == TDF_CF_MF)||(cmd->op == TDF_CF_PF)), status);
+}
+
+static void DramaCFcount(
+    void        *clientData,
+    const char  *name,
+    long int    value,
+    StatusType  *status)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)clientData;
+    ArgPuti(ctx->cmdFileId, (char *)name, value, status);
+}
+
+static void DramaCFdone(
+    void        *clientData,
+    int         keep,
+    StatusType  *status)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)clientData;
+    StatusType  ignore = STATUS__OK;
+
+    if ((!keep)&&(ctx->chunk)) {
+        SdsDelete(ctx->chunk, &ignore);
+        SdsFreeId(ctx->chunk, &ignore);
+        ctx->chunk = 0;
+    }
+    if (!ctx->cmdFileId)
+        return;
+    if (keep) {
+        StreamFlush(ctx, status);
+        if (ctx->packed)
+            PackWrite(ctx->cmdFileId, &ctx->pack, 0, ctx->pack.numLines, 0,
+                      status);
+        DitsPutArgument(ctx->cmdFileId, DITS_ARG_DELETE, status);
+    } else {
+        StreamAbort(ctx);
+        SdsDelete(ctx->cmdFileId, &ignore);
+        SdsFreeId(ctx->cmdFileId, &ignore);
+    }
+    ctx->cmdFileId = 0;
+}
+
+/*
+ *  Write the statistics into an SDS structure.
+ */
+static void StatsToSds(
+        const tdFstats  *stats,
+        SdsIdType       id,
+        StatusType      *status)
+{
+    char name[40];
+    int  i;
+
+    for (i = 0; i < TDF_NUM_PHASES; ++i) {
+        sprintf(name, "%sCount", tdFdeltaStatsPhaseName(i));
+        ArgPuti(id, name, (long)stats->phase[i].count, status);
+        sprintf(name, "%sNs", tdFdeltaStatsPhaseName(i));
+        ArgPutd(id, name, stats->phase[i].ns, status);
+    }
+    ArgPuti(id, "colButBut",    (long)stats->colButBut,    status);
+    ArgPuti(id, "colButFib",    (long)stats->colButFib,    status);
+    ArgPuti(id, "colFibFib",    (long)stats->colFibFib,    status);
+    ArgPuti(id, "crossAdds",    (long)stats->crossAdds,    status);
+    ArgPuti(id, "crossDeletes", (long)stats->crossDeletes, status);
+    ArgPuti(id, "cacheHits",    (long)stats->cacheHits,    status);
+    ArgPuti(id, "cacheMisses",  (long)stats->cacheMisses,  status);
+    ArgPuti(id, "cacheEntries", (long)stats->cacheEntries, status);
+    ArgPuti(id, "cacheBytes",   (long)stats->cacheBytes,   status);
+    ArgPuti(id, "warmSkips",    (long)stats->warmSkips,    status);
+}
+
+/*
+ *  Used when the action is complete.  Ends any trace, writes the input
+ *  snapshot if needed and releases the action data.
+ */
+static void ActionDone(
+    tdFdeltaType        * const data,
+    StatusType          * const status)
+{
+    tdFdeltaTraceDone(data, status);
+    tdFdeltaSnapDone(data, status);
+    tdFdeltaFreeActData(data);
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaDramaOut
+
+ *  Function:
+      Set up the planning core output callbacks for DRAMA.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaDramaOut (out, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (<) out         (tdFdeltaCallbacks *) The callbacks.  Release with
+                                            tdFdeltaDramaOutFree().
+      (!) status      (StatusType *)        Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaDramaOut (
+        tdFdeltaCallbacks  *out,
+        StatusType         *status)
+{
+    tdFdramaOut *ctx;
+
+    if (*status != STATUS__OK) return;
+
+    if ((ctx = (tdFdramaOut *)malloc(sizeof(tdFdramaOut))) == NULL) {
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+
+    memset(out, 0, sizeof(*out));
+    out->clientData = ctx;
+    out->msgOut     = DramaMsgOut;
+    out->ersRep     = DramaErsRep;
+    out->progress   = DramaProgress;
+    out->stats      = DramaStats;
+    out->errorText  = DramaErrorText;
+    out->cfNew      = DramaCFnew;
+    out->cfLine     = DramaCFline;
+    out->cfCount    = DramaCFcount;
+    out->cfDone     = DramaCFdone;
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaDramaOutFree
+
+ *  Function:
+      Release callbacks set up by tdFdeltaDramaOut().
+
+ *  Description:
+      Any partially built command file and the above item are deleted.
+      Does nothing if the callbacks were not set up.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaDramaOutFree (out)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) out         (tdFdeltaCallbacks *) The callbacks, zeroed.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaDramaOutFree (
+        tdFdeltaCallbacks  *out)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)out->clientData;
+    StatusType  ignore = STATUS__OK;
+
+    if (!ctx)
+        return;
+    DramaCFdone(ctx, 0, &ignore);
+    if (ctx->above) {
+        SdsDelete(ctx->above, &ignore);
+        SdsFreeId(ctx->above, &ignore);
+    }
+    tdFdeltaCFfree(&ctx->pack);
+    free(ctx);
+    memset(out, 0, sizeof(*out));
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaDramaPacked
+
+ *  Function:
+      Have callbacks set up by tdFdeltaDramaOut() write a packed
+      command file.
+
+ *  Description:
+      Used for the PACKED flag.  The plan's commands are given to the
+      cfCmd callback, so the lines need not be formatted, and are
+      written on completion as arrays (see the module description).
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaDramaPacked (out)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) out         (tdFdeltaCallbacks *) The callbacks.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaDramaPacked (
+        tdFdeltaCallbacks  *out)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)out->clientData;
+
+    if (!ctx)
+        return;
+    ctx->packed = YES;
+    out->cfCmd  = DramaCFcmd;
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaDramaStream
+
+ *  Function:
+      Have callbacks set up by tdFdeltaDramaOut() send the lines of the
+      command file as they come.
+
+ *  Description:
+      Used for the STREAM flag.  The lines are sent in chunks as trigger
+      messages of the action (see the module description), as well as
+      in the command file returned on completion.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaDramaStream (out)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) out         (tdFdeltaCallbacks *) The callbacks.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaDramaStream (
+        tdFdeltaCallbacks  *out)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)out->clientData;
+
+    if (ctx)
+        ctx->stream = YES;
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaDramaFlush
+
+ *  Function:
+      Send the lines of the command file not yet sent.
+
+ *  Description:
+      Called when the action is about to wait, e.g. between slices of
+      the sequencer, so the lines added are not held up until the
+      chunk fills.  Does nothing if not streaming.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaDramaFlush (out, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) out         (tdFdeltaCallbacks *) The callbacks.
+      (!) status      (StatusType *)        Modified status.
+
+ *  Prior requirements:
+      Must be called from an action handler.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaDramaFlush (
+        const tdFdeltaCallbacks  *out,
+        StatusType               *status)
+{
+    tdFdramaOut *ctx = (tdFdramaOut *)out->clientData;
+
+    if ((ctx)&&(ctx->cmdFileId))
+        StreamFlush(ctx, status);
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaAbove
+
+ *  Function:
+      Returns the address of the above item held for an action.
+
+ *  Description:
+      The item is set by tdFdeltaConvertCurToC() or
+      tdFdeltaConvertCrossesToSds() and inserted into the command file
+      when it is created.
+
+ *  Language:
+      C
+
+ *  Call:
+      (SdsIdType *) = tdFdeltaAbove (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The action data, as created by
+                                        tdFdeltaNewActData().
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, replaces the above item of
+                        tdFdeltaType.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL SdsIdType  *tdFdeltaAbove (
+        tdFdeltaType  *data)
+{
+    return &((tdFdramaOut *)data->out.clientData)->above;
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaFreeActData
+
+ *  Function:
+      Release action data created by tdFdeltaNewActData().
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaFreeActData (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The action data, may be null.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaFreeActData (
+        tdFdeltaType  *data)
+{
+    if (!data) return;
+    tdFdeltaDramaOutFree(&data->out);
+    tdFdeltaDataFree(data);
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaFieldCheck
+
+ *  Function:
+      Action handler which checks the validity of a new field configuration.
+
+ *  Description:
+      Runs tdFdeltaFieldCheckRun() and, if the field is valid, reschedules
+      the action to run tdFdeltaSequencer() or, with the SPECIAL flag,
+      tdFdeltaSequencerSpecial().  Otherwise the action completes.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaFieldCheck (status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status      (StatusType *)    Modified status.
+
+ *  Proir Requirements:
+      DitsGetActData() must return a pointer to a structure of type
+      tdFdeltaType, created by tdFdeltaNewActData().
+
+ *  Support: James Wilcox, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Moved from tdFdelFieldCh.c.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
+        StatusType  *status)
+{
+    tdFdeltaType  *data = DitsGetActData();/* Function parameters            */
+
+    if (*status != STATUS__OK) return;
+    tdFdeltaUse(data);
+
+    /*
+     *  Reschedule delta process if OK, otherwise complete action.
+     */
+    if (tdFdeltaFieldCheckRun(data,0,status)) {
+        if (data->check & SPECIAL)
+            DitsPutHandler(tdFdeltaSequencerSpecial,status);
+        else
+            DitsPutHandler(tdFdeltaSequencer,status);
+        DitsPutRequest(DITS_REQ_STAGE,status);
+    }
+    else
+    {
+        StatusType ignore = STATUS__OK;
+        tdFdeltaPutStats(&data->stats,&ignore);
+        ActionDone(data,status);
+    }
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaSequencer
+
+ *  Function:
+      Action handler which generates the sequence of moves.
+
+ *  Description:
+      Each invocation runs one time slice of the sequencer (see
+      tdFdeltaSequencerSlice()), then reschedules the action until the
+      sequence is complete.  When streaming, the lines added by the
+      slice are sent before the action is rescheduled.  A kick (see tdFdeltaKick()) sets
+      data->seq.cancel, and the sequence is abandoned at the start of
+      the next slice.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaSequencer (status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status      (StatusType *)    Modified status.
+
+ *  Proir Requirements:
+      DitsGetActData() must return a pointer to a structure of type
+      tdFdeltaType, created by tdFdeltaNewActData().
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Moved from tdFdelSeq.c.
+      18-Oct-2026  AGT  Flush the lines when streaming.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSequencer (
+        StatusType  *status)
+{
+    tdFdeltaType  *data = DitsGetActData();/* Function parameters            */
+
+    if (*status != STATUS__OK) return;
+    tdFdeltaUse(data);
+
+    /*
+     * Initialise the sequencer state on the first slice.  On later slices
+     * check if we have been kicked.
+     */
+    if (!data->seq.started) {
+        if (!tdFdeltaSequencerStart(data, status)) {
+            ActionDone(data, status);
+            return;
+        }
+    } else if (data->seq.cancel) {
+        tdFdeltaSequencerCancel(data, status);
+        ActionDone(data, status);
+        MsgOut(status,"%s action terminated",tdFdeltaActionName());
+        DitsPutRequest(DITS_REQ_END,status);
+        return;
+    }
+    if (tdFdeltaSequencerSlice(data, status)) {
+        tdFdeltaDramaFlush(&data->out, status);
+        DitsPutRequest(DITS_REQ_STAGE,status);
+    }
+    else
+        ActionDone(data, status);
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaSequencerSpecial
+
+ *  Function:
+      Action handler which generates the sequence of moves for
+      instruments such as 6dF.
+
+ *  Description:
+      See tdFdeltaSequencerSpecialRun().
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaSequencerSpecial (status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status      (StatusType *)    Modified status.
+
+ *  Proir Requirements:
+      DitsGetActData() must return a pointer to a structure of type
+      tdFdeltaType, created by tdFdeltaNewActData().
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Moved from tdFdelSeqSp.c.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecial (
+        StatusType  *status)
+{
+    tdFdeltaType  *data = DitsGetActData();/* Function parameters            */
+
+    tdFdeltaUse(data);
+    tdFdeltaSequencerSpecialRun(data, 0, status);
+    ActionDone(data, status);
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaStatsCreate
+
+ *  Function:
+      Create the DELTA_STATS parameter.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaStatsCreate (status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status      (StatusType *)    Modified status.
+
+ *  Prior requirements:
+      Called from tdFdeltaActivate() once the parameter system exists.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelStats.c.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaStatsCreate (
+        StatusType  *status)
+{
+    SdsIdType id = 0;
+    tdFstats  zero;
+
+    if (*status != STATUS__OK) return;
+
+    memset(&zero, 0, sizeof(zero));
+    SdsNew(0, STATS_PARAM, 0, 0, SDS_STRUCT, 0, 0, &id, status);
+    StatsToSds(&zero, id, status);
+    SdpCreateItem(id, status);
+    if (*status != STATUS__OK)
+        ErsRep(0, status, "Error creating %s parameter - %s",
+               STATS_PARAM, DitsErrorText(*status));
+}
+
+
+/*+        T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaStatsPublish
+
+ *  Function:
+      Update the DELTA_STATS parameter.
+
+ *  Description:
+      Main thread only.  This is the stats callback of the DRAMA output.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaStatsPublish (stats, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) stats       (const tdFstats *) The statistics.
+      (!) status      (StatusType *)     Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelStats.c.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaStatsPublish (
+        const tdFstats  *stats,
+        StatusType      *status)
+{
+    SdsIdType  id = 0;
+    StatusType ignore = STATUS__OK;
+
+    if (*status != STATUS__OK) return;
+
+    SdpGetSds(STATS_PARAM, &id, status);
+    StatsToSds(stats, id, status);
+    SdpUpdate(id, status);
+    if (*status != STATUS__OK)
+        ErsRep(0, status, "Error updating %s parameter - %s",
+               STATS_PARAM, DitsErrorText(*status));
+    if (id)
+        SdsFreeId(id, &ignore);
+}
+
+
+/*
+ *+           T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaCFcreate
+
+ *  Function:
+      Creates a new command file.
+
+ *  Description:
+      This function creates a new command file and records the current x, y, and theta
+      coordinates for each button in that field. This allow the position of each button
+      to be checked at the time of command file execution to confirm command file
+      validity.
+
+      The function returns the SdsIdType for the generated command file.
+
+ *  Language:
+      C
+
+ *  Call:
+      (SdsIdType) = tdFdeltaCFcreate (name,currDetails,above,status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) name         (char *)        Name of the command file to be generated.
+      (>) currDetails  (tdFinterim *)  Pointer to current field details.
+      (!) above        (SdsIdType *)  The SDS id of the above item from
+                                      the original plate current details
+                                      structure.  This is just copied
+                                      to the output file, and zeroed.
+      (!) status       (StatusType *)  Modified status.
+
+ *  Prior requirements:
+
+ *  Support: James Wilcox, AAO
+
+ *-
+
+ *  History:
+      01-Jul-1994  JW    Original version
+      01-Feb-2000  TJF   Change intial value of dims from NUM_PIVOTS to
+                         the value returned by FpilGetNumPivots().
+      20-Oct-2000  TJF   Add the new "above" item to the output so that
+                         we can reconstruct the conditions before the
+                         delta.
+      18-Oct-2026  AGT   Moved from tdFdeltaCFnew() in tdFdelCmdFile.c,
+                         now the cfNew callback of the DRAMA output.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL SdsIdType  tdFdeltaCFcreate (
+        const char        *name,
+        const tdFinterim  *currDetails,
+        SdsIdType         *above,
+        StatusType        *status)
+{
+    SdsIdType          newCmdFile,
+                       xId, yId,
+                       thetaId;
+    unsigned long int  dims = tdFdeltaNumPivots(tdFdeltaFpilInst());
+
+    if (*status != STATUS__OK) return (0);
+
+    /*
+     *  Create new command file (Sds structure).
+     */
+    SdsNew(0,(char *)name,0,NULL,SDS_STRUCT,0,NULL,&newCmdFile,status);
+    SdsNew(newCmdFile,"xf",0,NULL,SDS_INT,1,&dims,&xId,status);
+    SdsNew(newCmdFile,"yf",0,NULL,SDS_INT,1,&dims,&yId,status);
+    SdsNew(newCmdFile,"theta",0,NULL,SDS_DOUBLE,1,&dims,&thetaId,status);
+    /*
+     * If the SDS above structure exists, insert it into the
+     * command file and then free the id and make.
+     */
+    if (*above) {
+        SdsInsert(newCmdFile, *above, status);
+        SdsFreeId(*above, status);
+        *above = 0;
+    }
+
+    /*
+     *  Add x,y,theta for current field.
+     */
+    SdsPut(xId,sizeof(INT32)*dims,0,(void *)currDetails->xf,status);
+    SdsPut(yId,sizeof(INT32)*dims,0,(void *)currDetails->yf,status);
+    SdsPut(thetaId,sizeof(double)*dims,0,(void *)currDetails->theta,status);
+
+    /*
+     *  Free sds id's.
+     */
+    SdsFreeId(xId,status);
+    SdsFreeId(yId,status);
+    SdsFreeId(thetaId,status);
+
+    /*
+     *  Return SdsIdType for command file.
+     */
+    return (newCmdFile);
+}
+
+
+/*
+ *+           T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaCFgetCmd
+
+ *  Function:
+      Reads a command back from a command file.
+
+ *  Description:
+      The inverse of tdFdeltaCFaddCmd().  Fetches the line named
+      `lineX' (X being the line number) from the command file and
+      parses it into its command and parameters.
+
+      For MF lines, the pivot and target x, y and theta are returned. For
+      PF lines only the pivot is returned.  For comment lines (! and *)
+      the comment text is returned.
+
+      For a packed command file, the line's element of each array is
+      read instead.  To read every line, tdFdeltaCFread() is quicker.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaCFgetCmd (cmdFileId,lineNo,line,status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) cmdFileId     (SdsIdType)     The Sds Id for the command file.
+      (>) lineNo        (int)           The number of the line to read.
+      (<) line          (tdFcmdLine *)  The parsed command.
+      (!) status        (StatusType *)  Modified status.
+
+ *  Returned value:
+      1 if the line was read, 0 if there is no such line (i.e. we are
+      past the end of the command file) or on error.
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved from tdFdelCmdFile.c.
+      18-Oct-2026  AGT  Support packed command files.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaCFgetCmd (
+        SdsIdType   cmdFileId,
+        int         lineNo,
+        tdFcmdLine  *line,
+        StatusType  *status)
+{
+    SdsIdType  lineId;
+    char       lineName[10],             /* Name of entry         */
+               cmdLine[CMDLINE_LENGTH];  /* Command line contents */
+    char       *p;
+    long       xf, yf;
+    int        n;
+
+    if (*status != STATUS__OK) return (0);
+
+    /*
+     *  Does the line exist?  Note, we use SdsFind() rather then ArgFind()
+     *  here as not finding the item is not an error.
+     */
+    sprintf(lineName,"line%d",lineNo);
+    SdsFind(cmdFileId,lineName,&lineId,status);
+    if (*status == SDS__NOITEM) {
+        *status = STATUS__OK;
+        return (GetPacked(cmdFileId,lineNo,line,status));
+    }
+    SdsFreeId(lineId,status);
+    ArgGetString(cmdFileId,lineName,sizeof(cmdLine),cmdLine,status);
+    if (*status != STATUS__OK) return (0);
+
+    /*
+     *  Split off the command.
+     */
+    line->piv = 0;
+    line->xf = line->yf = 0;
+    line->theta = 0;
+    line->comment[0] = '\0';
+    for (p = cmdLine, n = 0; *p && *p != ' ' && n < CMD_NAME_LENGTH-1; ++p)
+        line->cmd[n++] = *p;
+    line->cmd[n] = '\0';
+    while (*p == ' ') ++p;
+
+    if (strcmp("MF",line->cmd) == 0) {
+        if (sscanf(p,"%d %ld %ld %lf",&line->piv,&xf,&yf,&line->theta) != 4) {
+            *status = TDFDELTA__CF_NOCMD;
+            ErsRep(0,status,"Invalid command file line %s \"%s\"",
+                   lineName,cmdLine);
+            return (0);
+        }
+        line->xf = xf;
+        line->yf = yf;
+    }
+    else if (strcmp("PF",line->cmd) == 0) {
+        if (sscanf(p,"%d",&line->piv) != 1) {
+            *status = TDFDELTA__CF_NOCMD;
+            ErsRep(0,status,"Invalid command file line %s \"%s\"",
+                   lineName,cmdLine);
+            return (0);
+        }
+    }
+    else if ((strcmp("!",line->cmd) == 0)||(strcmp("*",line->cmd) == 0)) {
+        strncpy(line->comment,p,sizeof(line->comment)-1);
+        line->comment[sizeof(line->comment)-1] = '\0';
+    }
+    else {
+        *status = TDFDELTA__CF_NOCMD;
+        ErsRep(0,status,"Unknown command in command file line %s \"%s\"",
+               lineName,cmdLine);
+        return (0);
+    }
+    return (1);
+}
+
+
+/*
+ *+           T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaCFread
+
+ *  Function:
+      Reads all the commands of a command file.
+
+ *  Description:
+      For a packed command file, each array is copied in one go.
+      Otherwise the `lineX' items are read and parsed in turn.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCFread (cmdFileId,file,status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) cmdFileId     (SdsIdType)     The Sds Id for the command file.
+      (<) file          (tdFcmdFile *)  The commands.  Release with
+                                        tdFdeltaCFfree(), even on error.
+      (!) status        (StatusType *)  Modified status.
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCFread (
+        SdsIdType   cmdFileId,
+        tdFcmdFile  *file,
+        StatusType  *status)
+{
+    SdsIdType       id = 0;
+    SdsCodeType     code;
+    long            ndims;
+    unsigned long   dims[7];
+    char            lineName[10],             /* Name of entry         */
+                    cmdLine[CMDLINE_LENGTH];  /* Command line contents */
+    char            name[20];
+    tdFcfCmd        cmd;
+    long            numLines;
+    unsigned long   n, l;
+
+    memset(file,0,sizeof(*file));
+    if (*status != STATUS__OK) return;
+
+    /*
+     *  Without the arrays, parse the lines.
+     */
+    if (!IsPacked(cmdFileId,status)) {
+        for (l = 1; *status == STATUS__OK; ++l) {
+            sprintf(lineName,"line%lu",l);
+            SdsFind(cmdFileId,lineName,&id,status);
+            if (*status == SDS__NOITEM) {
+                *status = STATUS__OK;
+                break;
+            }
+            SdsFreeId(id,status);
+            ArgGetString(cmdFileId,lineName,sizeof(cmdLine),cmdLine,status);
+            if (*status != STATUS__OK)
+                break;
+            if (!tdFdeltaCFparse(cmdLine,&cmd)) {
+                *status = TDFDELTA__CF_NOCMD;
+                ErsRep(0,status,"Invalid command file line %s \"%s\"",
+                       lineName,cmdLine);
+                break;
+            }
+            PackCmd(file,(int)l,&cmd,status);
+        }
+        return;
+    }
+
+    /*
+     *  Packed, so allocate and copy each array.
+     */
+    ArgGeti(cmdFileId,"numLines",&numLines,status);
+    if (*status != STATUS__OK) return;
+    n = (numLines > 0 ? numLines : 0);
+    file->alloc = (n ? n : 1);
+    file->op    = (short *) malloc(file->alloc*sizeof(short));
+    file->piv   = (short *) malloc(file->alloc*sizeof(short));
+    file->xf    = (INT32 *) malloc(file->alloc*sizeof(INT32));
+    file->yf    = (INT32 *) malloc(file->alloc*sizeof(INT32));
+    file->theta = (double *)malloc(file->alloc*sizeof(double));
+    if ((!file->op)||(!file->piv)||(!file->xf)||(!file->yf)||(!file->theta)) {
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    if (n) {
+        GetArray(cmdFileId,"cmdOp",   0,n*sizeof(short), file->op,   status);
+        GetArray(cmdFileId,"cmdPiv",  0,n*sizeof(short), file->piv,  status);
+        GetArray(cmdFileId,"cmdXf",   0,n*sizeof(INT32), file->xf,   status);
+        GetArray(cmdFileId,"cmdYf",   0,n*sizeof(INT32), file->yf,   status);
+        GetArray(cmdFileId,"cmdTheta",0,n*sizeof(double),file->theta,status);
+    }
+
+    /*
+     *  The comments, if any.
+     */
+    SdsFind(cmdFileId,"cmdText",&id,status);
+    if (*status == SDS__NOITEM) {
+        *status = STATUS__OK;
+    } else if (*status == STATUS__OK) {
+        SdsInfo(id,name,&code,&ndims,dims,status);
+        SdsFreeId(id,status);
+        if (*status != STATUS__OK) return;
+        file->textAlloc = (ndims == 1 ? dims[0] : 0);
+        if ((file->text = (char *)malloc(file->textAlloc+1)) == NULL) {
+            *status = TDFDELTA__MALLOCERR;
+            return;
+        }
+        GetArray(cmdFileId,"cmdText",0,file->textAlloc,file->text,status);
+        file->text[file->textAlloc] = '\0';
+        file->textLen = file->textAlloc;
+    }
+    if (*status != STATUS__OK) return;
+
+    /*
+     *  Check the commands, so the caller need not.
+     */
+    for (l = 0; l < n; ++l) {
+        if ((file->op[l] < TDF_CF_MF)||(file->op[l] > TDF_CF_ECHO)||
+            ((file->op[l] >= TDF_CF_NOTE)&&
+             ((file->xf[l] < 0)||(file->yf[l] < 0)||
+              ((unsigned long)file->xf[l]+file->yf[l] >= file->textLen+1)))) {
+            *status = TDFDELTA__CF_NOCMD;
+            ErsRep(0,status,"Invalid command in command file line %lu",l+1);
+            return;
+        }
+    }
+    file->numLines = n;
+}
+
+
+/*
+ *+           T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaCFfree
+
+ *  Function:
+      Releases the commands read by tdFdeltaCFread().
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCFfree (file)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (!) file          (tdFcmdFile *)  The commands, zeroed.
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCFfree (
+        tdFcmdFile  *file)
+{
+    free(file->op);
+    free(file->piv);
+    free(file->xf);
+    free(file->yf);
+    free(file->theta);
+    free(file->text);
+    memset(file,0,sizeof(*file));
+}
+
+
+/*
+ *+           T D F D E L T A D R A M A
+
+ *  Function name:
+      tdFdeltaCFlegacy
+
+ *  Function:
+      Adds the lines to a packed command file.
+
+ *  Description:
+      For readers which only know the `lineX' items.  Each command of a
+      packed command file is formatted as tdFdeltaCFaddCmd() would and
+      added as its line.  Does nothing if the command file is not
+      packed, or already has the lines.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaCFlegacy (cmdFileId,status)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) cmdFileId     (SdsIdType)     The Sds Id for the command file.
+      (!) status        (StatusType *)  Modified status.
+
+ *  Prior requirements:
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCFlegacy (
+        SdsIdType   cmdFileId,
+        StatusType  *status)
+{
+    SdsIdType       id = 0;
+    tdFcmdFile      file;
+    tdFcfCmd        cmd;
+    char            lineName[10],             /* Name for new entry    */
+                    cmdLine[CMDLINE_LENGTH];  /* Command line contents */
+    unsigned long   l;
+
+    if (!IsPacked(cmdFileId,status))
+        return;
+    SdsFind(cmdFileId,"line1",&id,status);
+    if (*status == STATUS__OK) {
+        SdsFreeId(id,status);
+        return;
+    } else if (*status != SDS__NOITEM) {
+        return;
+    }
+    *status = STATUS__OK;
+
+    tdFdeltaCFread(cmdFileId,&file,status);
+    for (l = 0; (l < file.numLines)&&(*status == STATUS__OK); ++l) {
+        memset(&cmd,0,sizeof(cmd));
+        cmd.op = file.op[l];
+        if (cmd.op >= TDF_CF_NOTE) {
+            cmd.comment = file.text+file.xf[l];
+        } else {
+            cmd.piv   = file.piv[l];
+            cmd.xf    = file.xf[l];
+            cmd.yf    = file.yf[l];
+            cmd.theta = file.theta[l];
+        }
+        sprintf(lineName,"line%lu",l+1);
+        tdFdeltaCFformat(&cmd,cmdLine,status);
+        ArgPutString(cmdFileId,lineName,cmdLine,status);
+    }
+    tdFdeltaCFfree(&file);
+}
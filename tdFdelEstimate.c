@@ -0,0 +1,647 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaEstimate
+
+ *  Function:
+      Estimate the cost of a plan without planning it.
+
+ *  Description:
+      For scheduling, where the cost of many reconfigurations is wanted
+      but not their command files.  The estimate follows the sequencer's
+      rules, but with none of its searching -
+
+        - The fibres to move are those whose target differs from the
+          current field.
+
+        - A fibre not moving but crossing above one which is must be
+          lifted out of the way - parked, then put back at the end.
+
+        - A moving fibre must wait for the moving fibres which are in the
+          way of its target (see tdFdeltaTargetBlocked()) and those
+          crossing above it to move first.
+
+        - Fibres are moved (or parked) as soon as nothing is in their way.
+          When every fibre left is waiting on another, the one the most
+          are waiting on is parked out of the way, to be moved later.
+
+      The robot time follows the moves and parks in that order (see
+      tdFdelRobot.c).  Should no fibre need to be lifted or parked out of
+      the way, the estimate is flagged as confident, the sequencer usually
+      finding the same number of moves and parks.  Otherwise it is only
+      a guide.
+
+      Parked fibres are not checked against, even where parked buttons
+      may collide.  The pair checks are only made for pivots close enough
+      together for their fibres to meet, found from neighbour lists -
+      the other pivots ordered by distance - which depend only on the
+      constants and instrument, so may be built once
+      (tdFdeltaNeighboursNew()) and shared by many estimates.  A broad
+      phase first compares bounding boxes - the pivot, virtual pivot and
+      button of each fibre, grown by the largest clearance - and pairs
+      whose boxes do not meet need no FPIL check.  The button radius for
+      the boxes is found, with the lists, by probing FpilColButFib() with
+      a fibre beside a button at each orientation.  Being conservative,
+      this does not change the estimate.
+
+      With the SPECIAL flag (6dF), the fibres are instead parked and
+      moved in the order of the special sequencer (see
+      tdFdeltaSequencerSpecialOrder()), which does no searching, so the
+      numbers of moves and parks are those of the plan.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Broad phase bounding box test.
+      19-Oct-2026  AGT  Button radius probed from FPIL, so the broad phase
+                        is used with every instrument.  Estimate the
+                        special sequencer's order with the SPECIAL flag.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelEstimate.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelEstimate.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ *  Fibre states.
+ */
+#define EST_STAYS        0      /* Not moving                            */
+#define EST_WAITING      1      /* To move                               */
+#define EST_OUT          2      /* Parked out of the way, still to move  */
+#define EST_DONE         3      /* Moved                                 */
+
+/*
+ *  Button radius probing.  Orientations tried, starting distance and the
+ *  largest radius believed (microns), and the slack added to the result.
+ */
+#define RADIUS_STEPS    64
+#define RADIUS_START    1000.0
+#define RADIUS_LIMIT    100000.0
+#define RADIUS_FIBRE    1000000.0
+#define RADIUS_SLACK    0.01
+
+/*
+ *  The fibres waiting for each fibre, as linked lists.
+ */
+typedef struct {
+    int         head[FPIL_MAXPIVOTS];   /* First item for each fibre, or -1 */
+    short       *waiter;                /* Fibre waiting                    */
+    int         *next;                  /* Next item, or -1                 */
+    unsigned    num;
+    unsigned    alloc;
+    } Waiters;
+
+static void Wait(
+        Waiters     *w,
+        unsigned    on,
+        unsigned    waiter,
+        StatusType  *status)
+{
+    if (*status != STATUS__OK) return;
+    if (w->num == w->alloc) {
+        unsigned n = (w->alloc ? w->alloc*2 : 1024);
+        short *waiters = (short *)realloc(w->waiter, n*sizeof(short));
+        int   *next;
+        if (waiters) w->waiter = waiters;
+        next = (waiters ? (int *)realloc(w->next, n*sizeof(int)) : 0);
+        if (!next) {
+            *status = TDFDELTA__MALLOCERR;
+            tdFdeltaErsRep(0, status, "Failed to allocate estimate dependencies");
+            return;
+        }
+        w->next = next;
+        w->alloc = n;
+    }
+    w->waiter[w->num] = (short)waiter;
+    w->next[w->num] = w->head[on];
+    w->head[on] = (int)(w->num++);
+}
+
+
+/*
+ *  Bounding box of a fibre and its button, for the broad phase.
+ */
+typedef struct {
+    long        xMin, yMin, xMax, yMax;
+    } Box;
+
+static void BoxFibre(
+        Box     *box,
+        long    xPiv,
+        long    yPiv,
+        long    fvpX,
+        long    fvpY,
+        long    xf,
+        long    yf,
+        long    radius)
+{
+    box->xMin = box->xMax = xPiv;
+    box->yMin = box->yMax = yPiv;
+    if (fvpX < box->xMin) box->xMin = fvpX;
+    if (fvpX > box->xMax) box->xMax = fvpX;
+    if (fvpY < box->yMin) box->yMin = fvpY;
+    if (fvpY > box->yMax) box->yMax = fvpY;
+    if (xf - radius < box->xMin) box->xMin = xf - radius;
+    if (xf + radius > box->xMax) box->xMax = xf + radius;
+    if (yf - radius < box->yMin) box->yMin = yf - radius;
+    if (yf + radius > box->yMax) box->yMax = yf + radius;
+}
+
+static int BoxesMeet(
+        const Box   *a,
+        const Box   *b,
+        long        margin)
+{
+    return ((a->xMin - margin <= b->xMax)&&(b->xMin - margin <= a->xMax)&&
+            (a->yMin - margin <= b->yMax)&&(b->yMin - margin <= a->yMax));
+}
+
+
+/*
+ *  Sort of the neighbour lists.
+ */
+static TDFDELTA_TLS const float *sortDist;
+
+static int CompareNeighbour(
+        const void  *a,
+        const void  *b)
+{
+    float da = sortDist[*(const short *)a];
+    float db = sortDist[*(const short *)b];
+    if (da < db) return -1;
+    if (da > db) return 1;
+    return (*(const short *)a < *(const short *)b ? -1 : 1);
+}
+
+
+/*
+ *  The radius about the fibre end within which a button lies, whatever
+ *  its orientation, or -1 if it can't be found.  At each orientation a
+ *  long fibre is brought up beside the button until FPIL reports that it
+ *  touches, giving how far the button reaches in that direction.  The
+ *  fibre clearance is left at one micron, FPIL's checks being strict.
+ */
+static long ButtonRadius(
+        FpilType    inst)
+{
+    double   reach = 0;
+    unsigned i;
+
+    if (!inst) return -1;
+    FpilSetFibClear(inst, 1);
+    for (i = 0; i < RADIUS_STEPS ; ++i) {
+        double theta = 2.0*PI*i/RADIUS_STEPS;
+        double lo = 0, hi = RADIUS_START;
+        if (!FpilColButFib(inst, 0, 0, theta, 0, -RADIUS_FIBRE,
+                           0, RADIUS_FIBRE))
+            return -1;
+        while (FpilColButFib(inst, 0, 0, theta, hi, -RADIUS_FIBRE,
+                             hi, RADIUS_FIBRE)) {
+            lo = hi;
+            if ((hi *= 2) > RADIUS_LIMIT) return -1;
+        }
+        while (hi - lo > 1) {
+            double mid = (lo + hi)/2;
+            if (FpilColButFib(inst, 0, 0, theta, mid, -RADIUS_FIBRE,
+                              mid, RADIUS_FIBRE))
+                lo = mid;
+            else
+                hi = mid;
+        }
+        if (hi > reach) reach = hi;
+    }
+    return (long)ceil(reach*(1 + RADIUS_SLACK)) + 1;
+}
+
+
+/*+        T D F D E L T A E S T I M A T E
+
+ *  Function name:
+      tdFdeltaNeighboursNew, tdFdeltaNeighboursFree
+
+ *  Function:
+      Create and release the pivot neighbour lists.
+
+ *  Description:
+      For each pivot, the other pivots in order of distance, nearest
+      first, and their distances.  Also the button radius of the
+      instrument of the current plan (see tdFdeltaUse()), for the broad
+      phase, or -1 if FPIL's checks don't give one.
+
+ *  Language:
+      C
+
+ *  Call:
+      (tdFneighbours *) = tdFdeltaNeighboursNew (numPivots, con, status)
+      (void) = tdFdeltaNeighboursFree (nb)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) numPivots   (unsigned)        Number of pivots.
+      (>) con         (const tdFconstants *) Pivot positions.
+      (!) status      (StatusType *)    Modified status.
+      (>) nb          (tdFneighbours *) The lists to release.
+
+ *  Returned value:
+      The lists, or NULL on error.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      19-Oct-2026  AGT  Find the button radius.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL tdFneighbours  *tdFdeltaNeighboursNew (
+        unsigned            numPivots,
+        const tdFconstants  *con,
+        StatusType          *status)
+{
+    tdFneighbours *nb;
+    float         *dist;
+    unsigned      i, j;
+
+    if (*status != STATUS__OK) return NULL;
+
+    nb = (tdFneighbours *)malloc(sizeof(tdFneighbours));
+    dist = (float *)malloc(sizeof(float)*(numPivots+1));
+    if (nb) {
+        nb->piv = (short *)malloc(sizeof(short)*(numPivots*numPivots+1));
+        nb->dist = (float *)malloc(sizeof(float)*(numPivots*numPivots+1));
+    }
+    if ((!nb)||(!dist)||(!nb->piv)||(!nb->dist)) {
+        *status = TDFDELTA__MALLOCERR;
+        tdFdeltaErsRep(0, status, "Failed to allocate the neighbour lists");
+        free(dist);
+        tdFdeltaNeighboursFree(nb);
+        return NULL;
+    }
+    nb->numPivots = numPivots;
+    nb->radius = ButtonRadius(tdFdeltaFpilInst());
+
+    sortDist = dist;
+    for (i = 0; i < numPivots ; ++i) {
+        short *piv = nb->piv + i*numPivots;
+        for (j = 0; j < numPivots ; ++j) {
+            dist[j] = (float)sqrt(
+                SQRD((double)con->xPiv[i] - (double)con->xPiv[j]) +
+                SQRD((double)con->yPiv[i] - (double)con->yPiv[j]));
+            piv[j] = (short)j;
+        }
+        qsort(piv, numPivots, sizeof(short), CompareNeighbour);
+        for (j = 0; j < numPivots ; ++j)
+            nb->dist[i*numPivots + j] = dist[piv[j]];
+    }
+    free(dist);
+    return nb;
+}
+
+TDFDELTA_INTERNAL void  tdFdeltaNeighboursFree (
+        tdFneighbours  *nb)
+{
+    if (!nb) return;
+    free(nb->piv);
+    free(nb->dist);
+    free(nb);
+}
+
+
+/*
+ *  The estimate with the SPECIAL flag.  A fibre must move if its target
+ *  differs from the current field.
+ */
+static void EstimateSpecial(
+        const tdFdeltaType  *from,
+        const tdFtarget     *target,
+        tdFestimate         *est,
+        StatusType          *status)
+{
+    const tdFinterim *cur = &from->current;
+    tdFrobot         robot;
+    short            mustMove[FPIL_MAXPIVOTS];
+    short            parkOrder[FPIL_MAXPIVOTS];
+    short            moveOrder[FPIL_MAXPIVOTS];
+    unsigned         numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    unsigned         numParks, numMoves;
+    unsigned         i;
+
+    for (i = 0; i < numPivots ; ++i) {
+        mustMove[i] = ((cur->park[i] != target->park[i])||
+                       ((target->park[i] != YES)&&
+                        ((cur->xf[i] != target->xf[i])||
+                         (cur->yf[i] != target->yf[i])||
+                         (cur->theta[i] != target->theta[i])))) ? YES : NO;
+    }
+    tdFdeltaSequencerSpecialOrder(from, target, mustMove,
+                                  parkOrder, &numParks,
+                                  moveOrder, &numMoves, status);
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaRobotStart(&robot, cur, &from->constants);
+    for (i = 0; i < numParks ; ++i)
+        tdFdeltaRobotPark(&robot, (unsigned)parkOrder[i]);
+    for (i = 0; i < numMoves ; ++i) {
+        unsigned piv = (unsigned)moveOrder[i];
+        tdFdeltaRobotMove(&robot, piv, target->xf[piv], target->yf[piv]);
+    }
+    est->numParks = numParks;
+    est->numMoves = numMoves;
+    est->robotTime = robot.time;
+    est->confident = YES;
+}
+
+
+/*+        T D F D E L T A E S T I M A T E
+
+ *  Function name:
+      tdFdeltaEstimate
+
+ *  Function:
+      Estimate the moves, parks and robot time of a plan.
+
+ *  Description:
+      Estimates the cost of reconfiguring from the current field and
+      crossovers of from to the given target, as described above.  The
+      checks are made with the instrument of the current plan (see
+      tdFdeltaUse()) and from's clearances.  The numbers of pair checks
+      made and avoided by the broad phase are also returned.  With the
+      SPECIAL flag, the special sequencer's order is followed instead.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaEstimate (from, target, nb, est, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) from        (const tdFdeltaType *) The current field, crossover
+                                        lists, constants and clearances.
+                                        Its target is not used.
+      (>) target      (const tdFtarget *) The target field.  mustMove is
+                                        not used.
+      (>) nb          (const tdFneighbours *) Neighbour lists for from's
+                                        constants, or null to build them.
+      (<) est         (tdFestimate *)   The estimate.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Broad phase before the pair checks.
+      19-Oct-2026  AGT  Button radius from the neighbour lists.  SPECIAL
+                        flag support.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaEstimate (
+        const tdFdeltaType   *from,
+        const tdFtarget      *target,
+        const tdFneighbours  *nb,
+        tdFestimate          *est,
+        StatusType           *status)
+{
+    const tdFinterim   *cur = &from->current;
+    const tdFconstants *con = &from->constants;
+    tdFneighbours      *own = 0;
+    tdFrobot           robot;
+    Waiters            w;
+    short              state[FPIL_MAXPIVOTS];
+    short              lifted[FPIL_MAXPIVOTS];
+    short              waitingOn[FPIL_MAXPIVOTS];
+    short              ready[FPIL_MAXPIVOTS];
+    Box                tBox[FPIL_MAXPIVOTS];  /* At the target      */
+    Box                cBox[FPIL_MAXPIVOTS];  /* At the current     */
+    long               radius, margin = 0;
+    unsigned           numPivots;
+    unsigned           numReady = 0, numLeft = 0;
+    double             maxLength = 0;
+    unsigned           i;
+
+    memset(est, 0, sizeof(*est));
+    if (*status != STATUS__OK) return;
+    if (from->check & SPECIAL) {
+        EstimateSpecial(from, target, est, status);
+        return;
+    }
+
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    if (!nb) {
+        if ((nb = own = tdFdeltaNeighboursNew(numPivots, con, status)) == NULL)
+            return;
+    }
+    memset(&w, 0, sizeof(w));
+    memset(lifted, 0, sizeof(lifted));
+
+    /*
+     *  Which fibres move.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        w.head[i] = -1;
+        waitingOn[i] = 0;
+        state[i] = EST_STAYS;
+        if (con->inUse[i] == NO) continue;
+        if (cur->park[i] != target->park[i])
+            state[i] = EST_WAITING;
+        else if ((target->park[i] != YES)&&
+                 ((cur->xf[i] != target->xf[i])||
+                  (cur->yf[i] != target->yf[i])||
+                  (cur->theta[i] != target->theta[i])))
+            state[i] = EST_WAITING;
+        if (state[i] == EST_WAITING) ++numLeft;
+        if ((cur->park[i] != YES)&&(cur->fibreLength[i] > maxLength))
+            maxLength = cur->fibreLength[i];
+    }
+
+    /*
+     *  Broad phase boxes, if the button size is known.
+     */
+    if ((radius = nb->radius) >= 0) {
+        margin = from->butClearG;
+        if (from->butClearO > margin) margin = from->butClearO;
+        if (from->fibClearG > margin) margin = from->fibClearG;
+        if (from->fibClearO > margin) margin = from->fibClearO;
+        margin += 1;
+        for (i = 0; i < numPivots ; ++i) {
+            if ((state[i] == EST_WAITING)&&(target->park[i] != YES))
+                BoxFibre(&tBox[i], con->xPiv[i], con->yPiv[i],
+                         target->fvpX[i], target->fvpY[i],
+                         target->xf[i], target->yf[i], radius);
+            if (cur->park[i] != YES)
+                BoxFibre(&cBox[i], con->xPiv[i], con->yPiv[i],
+                         cur->fvpX[i], cur->fvpY[i],
+                         cur->xf[i], cur->yf[i], radius);
+        }
+    }
+
+    /*
+     *  What each moving fibre must wait for.
+     */
+    for (i = 0; (i < numPivots)&&(*status == STATUS__OK) ; ++i) {
+        const short *piv = nb->piv + i*nb->numPivots;
+        const float *dist = nb->dist + i*nb->numPivots;
+        FibreCross  *p;
+        unsigned    j;
+
+        if (state[i] != EST_WAITING) continue;
+
+        /*
+         *  Fibres crossing above it must move first, or be lifted.
+         */
+        for (p = from->crosses.above[i]; p ; p = p->next) {
+            unsigned above = p->piv-1;
+            if (state[above] == EST_WAITING) {
+                Wait(&w, above, i, status);
+                ++waitingOn[i];
+            } else if (!lifted[above]) {
+                lifted[above] = YES;
+                ++est->numParks;
+                ++est->numMoves;
+            }
+        }
+
+        /*
+         *  Moving fibres in the way of its target.  Only those close
+         *  enough for the fibres to meet need be checked.
+         */
+        if (target->park[i] == YES) continue;
+        for (j = 1; j < nb->numPivots ; ++j) {
+            unsigned other = piv[j];
+            if (dist[j] >= target->fibreLength[i] + maxLength) break;
+            if ((state[other] != EST_WAITING)||(cur->park[other] == YES)||
+                (lifted[other]))
+                continue;
+            if ((radius >= 0)&&
+                (!BoxesMeet(&tBox[i], &cBox[other], margin))) {
+                ++est->pairsSkipped;
+                continue;
+            }
+            ++est->pairsChecked;
+            if (tdFdeltaTargetBlocked(cur, target, con,
+                                      from->butClearG, from->butClearO,
+                                      from->fibClearG, from->fibClearO,
+                                      i, other)) {
+                Wait(&w, other, i, status);
+                ++waitingOn[i];
+            }
+        }
+    }
+    if (*status != STATUS__OK) {
+        free(w.waiter);
+        free(w.next);
+        tdFdeltaNeighboursFree(own);
+        return;
+    }
+
+    /*
+     *  Lift the fibres in the way.
+     */
+    tdFdeltaRobotStart(&robot, cur, con);
+    for (i = 0; i < numPivots ; ++i) {
+        if (lifted[i]) tdFdeltaRobotPark(&robot, i);
+    }
+
+    /*
+     *  Move the fibres with nothing in their way.  When there are none,
+     *  park the fibre most are waiting on.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        if ((state[i] == EST_WAITING)&&(!waitingOn[i]))
+            ready[numReady++] = (short)i;
+    }
+    while (numLeft) {
+        unsigned next;
+        int      item;
+        int      gone;      /* Fibre leaves its current position */
+
+        if (numReady) {
+            next = ready[--numReady];
+            gone = (state[next] == EST_WAITING);
+            if (target->park[next] == YES) {
+                ++est->numParks;
+                tdFdeltaRobotPark(&robot, next);
+            } else {
+                ++est->numMoves;
+                tdFdeltaRobotMove(&robot, next, target->xf[next],
+                                  target->yf[next]);
+            }
+            state[next] = EST_DONE;
+            --numLeft;
+        } else {
+            int most = -1;
+            int mostWaiting = -1;
+            for (i = 0; i < numPivots ; ++i) {
+                int n = 0;
+                if (state[i] != EST_WAITING) continue;
+                for (item = w.head[i]; item >= 0; item = w.next[item])
+                    ++n;
+                if (n > mostWaiting) {
+                    most = (int)i;
+                    mostWaiting = n;
+                }
+            }
+            if (most < 0) break;
+            next = (unsigned)most;
+            gone = YES;
+            ++est->numParks;
+            tdFdeltaRobotPark(&robot, next);
+            if (target->park[next] == YES) {
+                state[next] = EST_DONE;
+                --numLeft;
+            } else {
+                state[next] = EST_OUT;
+                ++est->parkedOut;
+            }
+        }
+        if (gone) {
+            for (item = w.head[next]; item >= 0; item = w.next[item]) {
+                unsigned waiter = w.waiter[item];
+                if ((--waitingOn[waiter] == 0)&&
+                    (state[waiter] != EST_DONE))
+                    ready[numReady++] = (short)waiter;
+            }
+        }
+    }
+
+    /*
+     *  Put the lifted fibres back.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        if (lifted[i]) {
+            tdFdeltaRobotMove(&robot, i, cur->xf[i], cur->yf[i]);
+            ++est->lifted;
+        }
+    }
+    est->robotTime = robot.time;
+    est->confident = ((est->lifted == 0)&&(est->parkedOut == 0));
+
+    free(w.waiter);
+    free(w.next);
+    tdFdeltaNeighboursFree(own);
+}
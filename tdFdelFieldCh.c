@@ -27,6 +27,28 @@
       23-Mar-2006  TJF  MsgOut messages on fibre collisions etc now
                          have WARNING prefixed to they are shown in
                          yellow on 2dF interface.
+      18-Oct-2026  AGT  Checks moved to tdFdeltaFieldCheckRun() so they may
+                         be run from a worker thread.  Messages are output
+                         with tdFdeltaMsgOut() and tdFdeltaErsRep().
+      18-Oct-2026  AGT  Count collision checks and time each check for
+                         DELTA_STATS.
+      18-Oct-2026  AGT  Support TRACE flag.
+      18-Oct-2026  AGT  Release the input snapshot on completion.
+      18-Oct-2026  AGT  Moved to the planning core.  The action handler
+                         moves to tdFdelDrama.c.
+      18-Oct-2026  AGT  Skip pairs known to be clear from the last plan
+                         (see tdFdelWarm.c).
+      18-Oct-2026  AGT  Collision checks through tdFdelGeom.c (INT_GEOM flag).
+      18-Oct-2026  AGT  Pivot count and ParkMayCollide from
+                        tdFdeltaNumPivots() and tdFdeltaParkMayCollide(),
+                        constant in a single instrument build.
+      18-Oct-2026  AGT  Check the current field crossover lists.
+      18-Oct-2026  AGT  tdFdeltaFieldCheckRun() polls a cancel flag.
+      19-Oct-2026  AGT  Document the plan data argument of the check.
+      19-Oct-2026  AGT  Collision checks call FPIL directly again,
+                        tdFdelGeom.c removed.
+      19-Oct-2026  AGT  Add tdFdeltaFieldCheckFailed(), the collision
+                        checks against failed fibres for REPLAN.
       {@change entry@}
 
 
@@ -42,21 +64,9 @@ static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelFieldCh.c,v 3.17 25-Aug-2014 1
 static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
 
 
-#include "DitsTypes.h"       /* Basic dits types            */
-#include "Dits_Err.h"        /* Dits error codes            */
-#include "DitsSys.h"         /* For PutActionHandlers       */
-#include "DitsFix.h"         /* For various Dits routines   */
-#include "DitsMsgOut.h"      /* For MsgOut                  */
-#include "DitsParam.h"       /* For DitsGetParId            */
-#include "DitsPeek.h"        /* For DitsPeek                */
-#include "DitsUtil.h"        /* For DitsErrorText           */
-#include "mess.h"            /* For MessPutFacility         */
-#include "sds.h"             /* For SDS_ macros             */
-#include "arg.h"             /* For ARG_ macros             */
-#include "Ers.h"
 #include "status.h"          /* STATUS__OK definition       */
 
-#include "tdFdelta.h"
+#include "tdFdeltaCore.h"
 #include "tdFdelta_Err.h"
 
 #include <stdio.h>
@@ -90,18 +100,26 @@ static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
       to be moved (as if a button does not need to be moved, it must 
       already be there, hence its position must be a valid one!).
 
+      The checks are made by tdFdeltaFieldCheckRun(), below.  The action
+      handler tdFdeltaFieldCheck() calling it is in tdFdelDrama.c.
+
  *  Language:
       C
 
  *  Call:
-      (void) = tdFdeltaFieldCheck (status)
+      (int) = tdFdeltaFieldCheckRun (data,cancel,status)
 
  *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The plan data.
+      (>) cancel      (volatile int *)  Cancel flag, may be null.
       (!) status      (StatusType *)    Modified status.
 
  *  Proir Requirements:
-      DitsGetActData() must return a pointer to a structure of type 
-      tdFdeltaType (see tdFdelta.h for structure details).
+      data must have been created by tdFdeltaDataNew() (or by
+      tdFdeltaNewActData() in the task) and filled in, and tdFdeltaUse(data)
+      must have been called in this thread since any other plan was
+      worked on, so the output, statistics and instrument are those of
+      this plan.
 
  *  Support: James Wilcox, AAO
 
@@ -194,15 +212,20 @@ static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
                          but we don't need provide any real value for 2dF/6dF 
                          and it is just set to zero.
       10-Sep-2013 TJF  Robot contants file is now named tdFconstantsDF.sds.
+      18-Oct-2026 AGT  The action handler is now in tdFdelDrama.c, the
+                        checks are done by tdFdeltaFieldCheckRun().
       {@change entry@}
  */
 
 
 
 /*
- *  Check for collisions between buttons.
+ *  Check for collisions between buttons.  If against is given, buttons
+ *  are only checked against the pivots flagged in it.  If blocked is
+ *  given, the buttons found to collide are flagged in it.
  */
 static void CheckForButButCollisions(
+    volatile int        * const cancel,
     const FpilType      inst,
     const unsigned      actionFlags,
     const unsigned      numPivots,
@@ -211,6 +234,8 @@ static void CheckForButButCollisions(
     const short         type[],
     const tdFtarget     * const target,
     const tdFconstants  * const constants,
+    const short         * const against,
+    short               * const blocked,
     unsigned            * const numErrors,
     StatusType * const status)
 {
@@ -220,12 +245,12 @@ static void CheckForButButCollisions(
     if (*status != STATUS__OK) return;
 
     if (actionFlags & SHOW)
-        MsgOut(status,"...checking for button/button collisions");
+        tdFdeltaMsgOut(status,"...checking for button/button collisions");
     /*
      * We need to determine if we have to check for collisions against
      * parked fibres.
      */
-    ParkMayCollide = FpilParkMayCollide(inst);
+    ParkMayCollide = tdFdeltaParkMayCollide(inst);
 
     for (firstPivot=0; firstPivot < numPivots; firstPivot++) {
 
@@ -233,6 +258,8 @@ static void CheckForButButCollisions(
         int firstPivotX;
         int firstPivotY;
         double firstPivotTheta;
+
+        if (TDFDELTA_CANCELLED(cancel)) return;
         /*
          *  Only check buttons that have to move unless otherwise specified.
          */
@@ -283,6 +310,8 @@ static void CheckForButButCollisions(
                       (target->mustMove[otherPivot] == IF_NEEDED)||
                       (actionFlags & CHECK_FULL_FIELD)))
                 continue;
+            else if ((against)&&(!against[otherPivot]))
+                continue;
 
             /*
              * For non-parked fibres, check against target position.
@@ -302,7 +331,7 @@ static void CheckForButButCollisions(
             } else {
                 continue;
             }
-            
+
             /*
              *  Check button firstPivot against button otherPivot for collision.
              */
@@ -313,17 +342,32 @@ static void CheckForButButCollisions(
                 buttonClear = butClearO;
 
             FpilSetButClear(inst, buttonClear);
+
+            /*
+             *  Pairs known to be clear from the last plan need no check.
+             */
+            if ((target->park[firstPivot] != YES)&&
+                (target->park[otherPivot] != YES)&&
+                (tdFdeltaWarmSkip(firstPivot, otherPivot, NO,
+                                  target->xf[otherPivot],
+                                  target->yf[otherPivot],
+                                  target->theta[otherPivot],
+                                  target->fvpX[otherPivot],
+                                  target->fvpY[otherPivot])))
+                continue;
+            TDFDELTA_STAT(colButBut);
             flag = FpilColButBut(inst,
                                  firstPivotX, firstPivotY, firstPivotTheta,
                                  otherPivotX, otherPivotY, otherPivotTheta);
 
             if (flag == YES) {
-                MsgOut(status,
+                tdFdeltaMsgOut(status,
            "WARNING:Button/button collision detected in target field (but=%d,%d)",
                        firstPivot+1,otherPivot+1);
                 (*numErrors)++;
+                if (blocked) blocked[firstPivot] = YES;
                 if (actionFlags & SHOW)
-		    MsgOut(status,
+		    tdFdeltaMsgOut(status,
 			   "But %d at %d, %d, %g, But %d at %d, %d, %g",
 			   firstPivot+1, firstPivotX, firstPivotY, firstPivotTheta,
                            otherPivot+1, otherPivotX, otherPivotY, otherPivotTheta);
@@ -335,9 +379,12 @@ static void CheckForButButCollisions(
 }
 
 /*
- *  Check for collisions between buttons and fibres.
+ *  Check for collisions between buttons and fibres.  against and blocked
+ *  are as per CheckForButButCollisions(), a button being blocked if it
+ *  or its fibre collides.
  */
 static void CheckForButFibCollisions(
+    volatile int        * const cancel,
     const FpilType      inst,
     const unsigned      actionFlags,
     const unsigned      numPivots,
@@ -345,6 +392,8 @@ static void CheckForButFibCollisions(
     const long int      fibClearG,
     const tdFconstants  * const constants,
     const tdFtarget     * const target,
+    const short         * const against,
+    short               * const blocked,
     unsigned            * const numErrors,
     StatusType * const status)
 {
@@ -357,11 +406,11 @@ static void CheckForButFibCollisions(
      * We need to determine if we have to check for collisions against
      * parked fibres.
      */
-    ParkMayCollide = FpilParkMayCollide(inst);
+    ParkMayCollide = tdFdeltaParkMayCollide(inst);
 
 
     if (actionFlags & SHOW)
-        MsgOut(status,"...checking for button/fibre collisions");
+        tdFdeltaMsgOut(status,"...checking for button/fibre collisions");
     for (firstPivot=0; firstPivot < numPivots; firstPivot++) {
 
         register unsigned otherPivot;
@@ -369,6 +418,8 @@ static void CheckForButFibCollisions(
         int firstPivotY;
         double firstPivotTheta;
 
+        if (TDFDELTA_CANCELLED(cancel)) return;
+
         /*
          *  Only check buttons that have to move unless otherwise specified.
          */
@@ -419,6 +470,8 @@ static void CheckForButFibCollisions(
                       (target->mustMove[otherPivot] == IF_NEEDED)||
                       (actionFlags & CHECK_FULL_FIELD)))
                 continue;
+            else if ((against)&&(!against[otherPivot]))
+                continue;
  
 
             /*
@@ -440,6 +493,24 @@ static void CheckForButFibCollisions(
                 continue;
             }
 
+            /*
+             *  Pairs known to be clear from the last plan need no check, but
+             *  leave the fibre clearance as the checks would, since the
+             *  fiducial check uses it.
+             */
+            if ((target->park[firstPivot] != YES)&&
+                (target->park[otherPivot] != YES)&&
+                (tdFdeltaWarmSkip(firstPivot, otherPivot, NO,
+                                  target->xf[otherPivot],
+                                  target->yf[otherPivot],
+                                  target->theta[otherPivot],
+                                  target->fvpX[otherPivot],
+                                  target->fvpY[otherPivot]))) {
+                FpilSetFibClear(inst, constants->type[firstPivot] == GUIDE ?
+                                      fibClearG : fibClearO);
+                continue;
+            }
+
             /*
              *  Check button firstPivot against fibre otherPivot for collision.
              */
@@ -450,6 +521,8 @@ static void CheckForButFibCollisions(
             
             FpilSetFibClear(inst, fibreClear);
 
+            TDFDELTA_STAT(colButFib);
+
             flag = FpilColButFib(inst,
                                  firstPivotX, firstPivotY, firstPivotTheta,
                                  (double)target->fvpX[otherPivot],
@@ -459,12 +532,13 @@ static void CheckForButFibCollisions(
 
 
             if (flag == YES) {
-                MsgOut(status,
+                tdFdeltaMsgOut(status,
             "WARNING:Button/Fibre collision detected in target field (but=%d,fib=%d)",
                        firstPivot+1,otherPivot+1);
                 (*numErrors)++;
+                if (blocked) blocked[firstPivot] = YES;
                 if (actionFlags & SHOW)
-		    MsgOut(status,"Button %d at %d,%d,%g with fibre %d from %d,%d to %d,%d",
+		    tdFdeltaMsgOut(status,"Button %d at %d,%d,%g with fibre %d from %d,%d to %d,%d",
 			   firstPivot+1, 
  			   firstPivotX, firstPivotY, firstPivotTheta,
  			   otherPivot+1,
@@ -484,6 +558,8 @@ static void CheckForButFibCollisions(
                 fibreClear = fibClearO;
             FpilSetFibClear(inst, fibreClear);
             
+            TDFDELTA_STAT(colButFib);
+            
             flag = FpilColButFib(inst,
                                  otherPivotX, otherPivotY, otherPivotTheta,
                                  (double)target->fvpX[firstPivot],
@@ -493,12 +569,13 @@ static void CheckForButFibCollisions(
 
 
             if (flag == YES) {
-                MsgOut(status,
+                tdFdeltaMsgOut(status,
          "WARNING:Button/fibre collision detected in target field (but=%d,fib=%d)",
                        otherPivot+1,firstPivot+1);
                 (*numErrors)++;
+                if (blocked) blocked[firstPivot] = YES;
                 if (actionFlags & SHOW)
-		    MsgOut(status,"Button %d at %d,%d,%g with fibre %d from %d,%d to %d,%d",
+		    tdFdeltaMsgOut(status,"Button %d at %d,%d,%g with fibre %d from %d,%d to %d,%d",
 			   otherPivot+1,
                            otherPivotX, otherPivotY, otherPivotTheta,
 		           firstPivot+1,
@@ -528,7 +605,7 @@ static void CheckFibreExtension(
     register unsigned pivot;
 
     if (actionFlags & SHOW)
-        MsgOut(status,"...checking fibre extensions");
+        tdFdeltaMsgOut(status,"...checking fibre extensions");
 
     for (pivot=0; pivot < numPivots; pivot++) {
 
@@ -547,7 +624,7 @@ static void CheckFibreExtension(
          *  Check fibre extensions.
          */
         if (target->fibreLength[pivot] > constants->maxExt[pivot]) {
-            MsgOut(status,
+            tdFdeltaMsgOut(status,
                    "WARNING:Maximum fibre length exceeded (%ld) in target field (piv=%d, proposed length = %ld)",
                    constants->maxExt[pivot],
                    pivot+1,
@@ -621,7 +698,7 @@ static void CheckBendAngles(
     if (*status != STATUS__OK) return;
 
     if (actionFlags & SHOW)
-        MsgOut(status,"...checking button/fibre and pivot/fibre bend angles");
+        tdFdeltaMsgOut(status,"...checking button/fibre and pivot/fibre bend angles");
     for (pivot=0; pivot< numPivots ; pivot++) {
 
         double thetaButFib;            /* Angle between button and fibre    */
@@ -690,14 +767,14 @@ static void CheckBendAngles(
          */
         if (FpilGetFibAngVar(inst)) {
             if (thetaButFib > maxButFibAngle) {
-                MsgOut(status,
+                tdFdeltaMsgOut(status,
            "WARNING:Out of range %s angle detected in target field (piv=%d,ang=%.3f)",
                        "button/fibre",pivot+1,thetaButFib*180/PI);
                 (*numErrors)++;
             }
         }
         if (thetaPivFib > maxPivFibAngle) {
-            MsgOut(status,
+            tdFdeltaMsgOut(status,
             "WARNING:Out or range %s angle detected in target field (piv=%d,ang=%.3f)",
                    "pivot/fibre",pivot+1,thetaPivFib*180/PI);
             (*numErrors)++;
@@ -722,7 +799,7 @@ static void CheckValidFieldPosition(
     if (*status != STATUS__OK) return;
 
     if (actionFlags & SHOW)
-        MsgOut(status,
+        tdFdeltaMsgOut(status,
                "...checking if target location is valid field plate position");
 
     for (pivot=0; pivot < numPivots; pivot++) {
@@ -745,7 +822,7 @@ static void CheckValidFieldPosition(
         if (!FpilOnField(inst,
                          target->xf[pivot],
                          target->yf[pivot])) {
-            MsgOut(status,
+            tdFdeltaMsgOut(status,
               "WARNING:Button outside usable field plate area and not parked (piv=%d)",
                pivot+1);
             (*numErrors)++;
@@ -764,7 +841,7 @@ static void CheckValidFieldPosition(
 
         
         if (obstructed == YES) {
-            MsgOut(status,
+            tdFdeltaMsgOut(status,
                "WARNING:Button/screw-hole collision detected in target field (but=%d)",
                pivot+1);
             (*numErrors)++;
@@ -800,7 +877,7 @@ static void CheckFiducials(
     if (*status != STATUS__OK) return;
 
     if (actionFlags & SHOW)
-        MsgOut(status,
+        tdFdeltaMsgOut(status,
                "...checking that not all fiducial marks will be obstructed");
  
     for (fiducial=0; fiducial < NumFids; fiducial++) {
@@ -856,12 +933,12 @@ static void CheckFiducials(
 
     if (numUnObstructed <= 2) {
         if (numUnObstructed == 0) {
-            MsgOut(status, "WARNING:All fiducials are obstructed in target field");
-            MsgOut(status, "  We must have three unobstructed fiducials");
+            tdFdeltaMsgOut(status, "WARNING:All fiducials are obstructed in target field");
+            tdFdeltaMsgOut(status, "  We must have three unobstructed fiducials");
         } else {
-            MsgOut(status,
+            tdFdeltaMsgOut(status,
       "WARNING:Target field does not have enough unobstructed fiducials for a survey");
-            MsgOut(status, "  We have %d of the three needed for a survey",
+            tdFdeltaMsgOut(status, "  We have %d of the three needed for a survey",
                    numUnObstructed);
         }
         (*numErrors)++;
@@ -870,11 +947,11 @@ static void CheckFiducials(
     if (actionFlags & SHOW) {
         for (fiducial=0; fiducial < NumFids; fiducial++) {
             if (fids->inUse[fiducial] == 0)
-                MsgOut(status,"Fiducial %d NOT IN USE",fiducial+1);
+                tdFdeltaMsgOut(status,"Fiducial %d NOT IN USE",fiducial+1);
             else if (fidFlags[fiducial] == 0)
-                MsgOut(status,"Fiducial %d not obstructed",fiducial+1);
+                tdFdeltaMsgOut(status,"Fiducial %d not obstructed",fiducial+1);
             else
-                MsgOut(status,"Fiducial %d OBSTRUCTED by button/fibre %d",
+                tdFdeltaMsgOut(status,"Fiducial %d OBSTRUCTED by button/fibre %d",
                        fiducial+1,fidFlags[fiducial]);
         }
     }
@@ -882,15 +959,66 @@ static void CheckFiducials(
 
 }
 
-TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
-        StatusType  *status)
+/*+        T D F D E L T A F I E L D C H E C K
+
+ *  Function name:
+      tdFdeltaFieldCheckRun
+
+ *  Function:
+      Performs the checks for tdFdeltaFieldCheck().
+
+ *  Description:
+      This does the work of tdFdeltaFieldCheck(), but given the plan
+      data rather then fetching it and without rescheduling the action, so
+      that it may also be used from a worker thread or without DRAMA.
+
+      Unless the NO_DELTA flag is given, the crossover lists of the
+      current field are first checked with tdFdeltaCrossesCheck(), even
+      with NO_FIELD_CHECK.
+
+      The cancel flag is polled between the checks and for each button
+      of the collision checks.  If it is set, we return 0 with good
+      status.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaFieldCheckRun (data,cancel,status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The action data.
+      (>) cancel      (volatile int *)  Cancel flag, see tdFdeltaPlan().
+                                        May be null.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      1 if the sequencer should now be run, 0 on error or if cancelled.
+
+ *  Support: James Wilcox, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Extracted from tdFdeltaFieldCheck().
+      18-Oct-2026  AGT  Start using the warm start pair matrix.
+      18-Oct-2026  AGT  Check the current field crossover lists.
+      18-Oct-2026  AGT  Poll the cancel flag.
+      19-Oct-2026  AGT  Pass no against or blocked flags to the
+                        collision checks.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaFieldCheckRun (
+        tdFdeltaType  *data,
+        volatile int  *cancel,
+        StatusType    *status)
 {
-    tdFdeltaType  *data = DitsGetActData();/* Function parameters            */
     unsigned      numErrors = 0;           /* Total number of error detected */
     unsigned      numPivots;               /* Number of pivots               */
     FpilType      inst;                    /* Instrument description         */
+    double        tStart;                  /* Start of current check         */
 
-    if (*status != STATUS__OK) return;
+    if (*status != STATUS__OK) return 0;
 
 
     /*
@@ -900,29 +1028,52 @@ TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(inst);
+    numPivots = tdFdeltaNumPivots(inst);
+
+    /*
+     *  Unless we won't be sequencing, check the crossover lists of the
+     *  current field (the "above" array) agree with its fibres.  The
+     *  sequencer trusts them, and stale lists lead it to move fibres it
+     *  can't, so this is done even if the target is not to be checked.
+     */
+    if (!(data->check & NO_DELTA)) {
+        unsigned bad;
+        tStart = tdFdeltaClock();
+        bad = tdFdeltaCrossesCheck("current",
+                                   0,   /* As per the sequencers */
+                                   &data->constants,
+                                   &data->current,
+                                   &data->crosses,
+                                   status);
+        tdFdeltaStatsPhase(TDF_PHASE_CHECK_CROSS, tStart);
+        if (*status != STATUS__OK) return 0;
+        if (bad) {
+            *status = TDFDELTA__CROSSESERR;
+            tdFdeltaErsRep(0,status,
+                   "Current field crossover details (above) are INCONSISTENT - %d %s - see scrolling message area for details.",
+                   bad, (bad == 1 ? "ERROR" : "ERRORS"));
+            return 0;
+        }
+    }
 
     /*
      *  Bypass checking if requested.
      */
     if (data->check & NO_FIELD_CHECK) {
-        MsgOut(status,"WARNING:Target field validity checking NOT performed - %s",
+        tdFdeltaMsgOut(status,"WARNING:Target field validity checking NOT performed - %s",
                "NO_FIELD_CHECK specified");
-        if (data->check & SPECIAL) 
-            DitsPutHandler(tdFdeltaSequencerSpecial,status);
-        else
-            DitsPutHandler(tdFdeltaSequencer,status);
-            
-        DitsPutRequest(DITS_REQ_STAGE,status);
-        return;
+        return (*status == STATUS__OK);
     }
     else
-        MsgOut(status,"Checking target field validity...");
+        tdFdeltaMsgOut(status,"Checking target field validity...");
+    tdFdeltaWarmBegin(data);
 
     /*
      *  Check for button/button collisions.
      */
-    CheckForButButCollisions(inst,
+    tStart = tdFdeltaClock();
+    CheckForButButCollisions(cancel,
+                             inst,
                              data->check,
                              numPivots,
                              data->butClearO,
@@ -930,32 +1081,44 @@ TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
                              data->constants.type,
                              &data->target,
                              &data->constants,
+                             0,
+                             0,
                              &numErrors,
                              status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_BUTBUT, tStart);
 
     /*
      *  Check for button/fibre collisions.
      */
-    CheckForButFibCollisions(inst,
+    if (TDFDELTA_CANCELLED(cancel)) return 0;
+    tStart = tdFdeltaClock();
+    CheckForButFibCollisions(cancel,
+                             inst,
                              data->check,
                              numPivots,
                              data->fibClearO,
                              data->fibClearG,
                              &data->constants,
                              &data->target,
+                             0,
+                             0,
                              &numErrors,
                              status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_BUTFIB, tStart);
 
 
     /*
      *  Check fibre extension is within limits.
      */
+    if (TDFDELTA_CANCELLED(cancel)) return 0;
+    tStart = tdFdeltaClock();
     CheckFibreExtension(&data->constants,
                         data->check,
                         numPivots,
                         &data->target,
                         &numErrors,
                         status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_EXT, tStart);
 
 
 
@@ -964,6 +1127,7 @@ TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
      */
 
 
+    tStart = tdFdeltaClock();
     CheckBendAngles(inst,
                     data->check,
                     numPivots,
@@ -975,18 +1139,21 @@ TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
                     &data->target,
                     &numErrors,
                     status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_BEND, tStart);
 
 
     /*
      *  Check that button is placed in valid field position (ie, not outside 
      I  field limits or on the 2 screws).
      */
+    tStart = tdFdeltaClock();
     CheckValidFieldPosition(inst,
                             data->check,
                             numPivots,
                             &data->target,
                             &numErrors,
                             status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_POS, tStart);
 
     /*
      *  Check that at least three fiducials will not be obstructed when the
@@ -994,6 +1161,7 @@ TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
      *  SURVEY action to determine the position of the field plate relative 
      *  to the gantry after tumbling).
      */
+    tStart = tdFdeltaClock();
     CheckFiducials(inst,
                    data->check,
                    numPivots,
@@ -1002,46 +1170,135 @@ TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
                    &data->fids,
                    &numErrors,
                    status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_FIDS, tStart);
 
 
 
     /*
      *  Summarise field check findings.
      */
-    if (numErrors == 0) {
+    if (TDFDELTA_CANCELLED(cancel)) {
+        return 0;
+    } else if (numErrors == 0) {
         if (data->check & SHOW)
-            MsgOut(status,"Target field configuration is VALID");
+            tdFdeltaMsgOut(status,"Target field configuration is VALID");
     } else {
         *status = TDFDELTA__INVFIELD;
-        ErsRep(0,status,
+        tdFdeltaErsRep(0,status,
                "Target field configuration is INVALID - %d %s DETECTED - see scrolling message area for details.",
                numErrors,
                (numErrors == 1?  "ERROR": "ERRORS"));
-        ErsRep(0,status,
+        tdFdeltaErsRep(0,status,
                "Common causes are - wrong time compared to configuration time (HA) and robot status file (tdFconstantsDF.sds) has changed since fibre allocation");
-        ErsRep(0, status,
+        tdFdeltaErsRep(0, status,
                "Try tweaking for \"proposal date\" (and aborting once it starts).  If that works, then the original configuration time is likely to be wrong compared to the observing (tweak) time.");
     }
 
-    /*
-     *  Reschedule delta process if OK, otherwise complete action.
-     */
-    if (*status == STATUS__OK) {
-        if (data->check & SPECIAL) 
-            DitsPutHandler(tdFdeltaSequencerSpecial,status);
-        else
-            DitsPutHandler(tdFdeltaSequencer,status);
-        DitsPutRequest(DITS_REQ_STAGE,status);
-    }
-    else
-    {
-        if (data->above)
-        {
-            StatusType ignore = STATUS__OK;
-            SdsDelete(data->above,&ignore);
-            SdsFreeId(data->above,&ignore);
-            data->above = 0;
-        }
-        free((void *)data);
-    }
+    return (*status == STATUS__OK);
+}
+
+
+/*+        T D F D E L T A F I E L D C H E C K
+
+ *  Function name:
+      tdFdeltaFieldCheckFailed
+
+ *  Function:
+      Check the targets against fibres which have failed.
+
+ *  Description:
+      Used by REPLAN when fibres are reported as failed.  Their targets
+      have been set to their interim positions, where they will stay,
+      so the remaining targets may now collide with them.  This runs the
+      button/button and button/fibre collision checks of
+      tdFdeltaFieldCheckRun(), but only of the pivots which must move
+      against the failed pivots (data->failed).  The pivots whose
+      target collides are flagged in blocked.
+
+      The other checks don't involve the failed fibres and were made
+      when the original command file was generated, so are not repeated.
+
+ *  Language:
+      C
+
+ *  Call:
+      (unsigned) = tdFdeltaFieldCheckFailed (data,blocked,status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The plan data.
+      (<) blocked     (short *)         FPIL_MAXPIVOTS flags, set YES
+                                        for each pivot whose target now
+                                        can't be reached, otherwise NO.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      The number of pivots flagged in blocked.
+
+ *  Proir Requirements:
+      As per tdFdeltaFieldCheckRun().
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      19-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL unsigned  tdFdeltaFieldCheckFailed (
+        tdFdeltaType  *data,
+        short         *blocked,
+        StatusType    *status)
+{
+    unsigned      numErrors = 0;           /* Total number of error detected */
+    unsigned      numBlocked = 0;
+    unsigned      numPivots;
+    unsigned      i;
+    FpilType      inst;
+    double        tStart;
+
+    memset(blocked, 0, sizeof(short)*FPIL_MAXPIVOTS);
+    if (*status != STATUS__OK) return 0;
+
+    inst = tdFdeltaFpilInst();
+    numPivots = tdFdeltaNumPivots(inst);
+    if (data->check & SHOW)
+        tdFdeltaMsgOut(status,
+                       "Checking remaining targets against failed fibres...");
+    tdFdeltaWarmBegin(data);
+
+    tStart = tdFdeltaClock();
+    CheckForButButCollisions(0,
+                             inst,
+                             data->check & ~CHECK_FULL_FIELD,
+                             numPivots,
+                             data->butClearO,
+                             data->butClearG,
+                             data->constants.type,
+                             &data->target,
+                             &data->constants,
+                             data->failed,
+                             blocked,
+                             &numErrors,
+                             status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_BUTBUT, tStart);
+
+    tStart = tdFdeltaClock();
+    CheckForButFibCollisions(0,
+                             inst,
+                             data->check & ~CHECK_FULL_FIELD,
+                             numPivots,
+                             data->fibClearO,
+                             data->fibClearG,
+                             &data->constants,
+                             &data->target,
+                             data->failed,
+                             blocked,
+                             &numErrors,
+                             status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_BUTFIB, tStart);
+
+    for (i = 0; i < numPivots ; ++i)
+        if (blocked[i]) ++numBlocked;
+    return numBlocked;
 }
@@ -0,0 +1,797 @@
+/*+                T D F D E L T A
+
+ *  Module name:
+      tdFdeltaFpilSim
+
+ *  Function:
+      Stand-in instrument model for running the planner without hardware.
+
+ *  Description:
+      A simple 2dF-like or 6dF-like instrument, for benchmarks and offline
+      tests of the planning core.  The pivots and park positions are
+      evenly spaced on circles around a circular field and the fiducials
+      are on a circle inside the field.  Fibres are straight lines from the
+      pivot to the fibre virtual pivot point.  Buttons are convex polygons
+      - the 2dF-like button is a long chamfered block, the 6dF-like button
+      is round.  Buttons may not be placed over a screw hole or within
+      the keep out distance of the pivot circle (FpilColInvPos()).
+
+      Clearances are applied as the minimum distance between outlines,
+      or between an outline and a fibre.
+
+      This module provides the FPIL entry points used by the core
+      (FpilGetNumPivots(), FpilColButBut() etc.), so a program linked with
+      it must NOT also be linked with the FPIL library - only fpil.h is
+      needed, for FpilType and the array sizes.  The instrument handle is
+      a pointer to a model allocated by tdFdeltaFpilSimInit() and freed
+      by FpilFree().  Each handle is independent, so plans running at the
+      same time may each have their own.
+
+      Lengths are in microns, angles in radians, with the convention used
+      by the core - zero along +y, increasing anticlockwise.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Button outlines, pivot circle keep out and screw
+                        holes.
+      18-Oct-2026  AGT  Give the button outline to tdFdeltaGeomShape().
+      18-Oct-2026  AGT  A model for each handle.
+      19-Oct-2026  AGT  tdFdelGeom.c removed, the outline is no longer
+                        given to it.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelFpilSim.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelFpilSim.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  The nominal geometries.  Roughly the size of the real instruments,
+ *  but not their actual dimensions.
+ */
+static const tdFsimGeom simGeom2dF = {
+    "2dFsim",               /* name            */
+    "AAT",                  /* telescope       */
+    400,                    /* numPivots       */
+    4,                      /* numGuide        */
+    8,                      /* numFids         */
+    NO,                     /* parkMayCollide  */
+    YES,                    /* fibAngVar       */
+    253000,                 /* fieldRadius     */
+    290000,                 /* pivotRadius     */
+    6000,                   /* pivotKeepOut    */
+    275000,                 /* parkRadius      */
+    120000,                 /* fidRadius       */
+    5,                      /* numOutline      */
+    { {-1500,-1500}, {5000,-1500}, {6000,0}, {5000,1500}, {-1500,1500} },
+    2,                      /* numScrews       */
+    { {0,180000}, {0,-180000} },
+    3000,                   /* screwRadius     */
+    7500,                   /* virPivLen       */
+    340000,                 /* maxExt          */
+    14.0*PI/180.0,          /* maxPivAng       */
+    14.0*PI/180.0,          /* maxButAng       */
+    400,                    /* butClear        */
+    200,                    /* fibClear        */
+    0                       /* butRadius       */
+};
+
+static const tdFsimGeom simGeom6dF = {
+    "6dFsim",               /* name            */
+    "UKST",                 /* telescope       */
+    150,                    /* numPivots       */
+    0,                      /* numGuide        */
+    6,                      /* numFids         */
+    YES,                    /* parkMayCollide  */
+    NO,                     /* fibAngVar       */
+    170000,                 /* fieldRadius     */
+    195000,                 /* pivotRadius     */
+    4000,                   /* pivotKeepOut    */
+    185000,                 /* parkRadius      */
+    80000,                  /* fidRadius       */
+    8,                      /* numOutline      */
+    { {1800,0}, {1273,1273}, {0,1800}, {-1273,1273},
+      {-1800,0}, {-1273,-1273}, {0,-1800}, {1273,-1273} },
+    3,                      /* numScrews       */
+    { {0,110000}, {-95263,-55000}, {95263,-55000} },
+    2500,                   /* screwRadius     */
+    5000,                   /* virPivLen       */
+    240000,                 /* maxExt          */
+    20.0*PI/180.0,          /* maxPivAng       */
+    20.0*PI/180.0,          /* maxButAng       */
+    400,                    /* butClear        */
+    200,                    /* fibClear        */
+    0                       /* butRadius       */
+};
+
+/*
+ *  The model.  The FpilType handle points to one.
+ */
+typedef struct SimModel {
+      tdFsimGeom     geom;       /* Geometry, scaled for numPivots      */
+      unsigned long  butClear;   /* Set by FpilSetButClear()            */
+      unsigned long  fibClear;   /* Set by FpilSetFibClear()            */
+      } SimModel;
+
+#define SIM(inst) ((SimModel *)(void *)(inst))
+
+/*
+ *  Distance from point (px,py) to the segment (x1,y1)-(x2,y2).
+ */
+static double SegDist(
+    double px, double py,
+    double x1, double y1,
+    double x2, double y2)
+{
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    double len2 = dx*dx + dy*dy;
+    double t = 0;
+    if (len2 > 0) {
+        t = ((px - x1)*dx + (py - y1)*dy)/len2;
+        if (t < 0) t = 0;
+        else if (t > 1) t = 1;
+    }
+    dx = x1 + t*dx - px;
+    dy = y1 + t*dy - py;
+    return sqrt(dx*dx + dy*dy);
+}
+
+/*
+ *  Which side of the line (x1,y1)-(x2,y2) is (px,py).
+ */
+static int Side(
+    double px, double py,
+    double x1, double y1,
+    double x2, double y2)
+{
+    double c = (x2 - x1)*(py - y1) - (y2 - y1)*(px - x1);
+    return (c > 0) - (c < 0);
+}
+
+/*
+ *  Do the segments (x1,y1)-(x2,y2) and (x3,y3)-(x4,y4) cross.
+ */
+static int SegCross(
+    double x1, double y1,
+    double x2, double y2,
+    double x3, double y3,
+    double x4, double y4)
+{
+    return ((Side(x3, y3, x1, y1, x2, y2) * Side(x4, y4, x1, y1, x2, y2) < 0)&&
+            (Side(x1, y1, x3, y3, x4, y4) * Side(x2, y2, x3, y3, x4, y4) < 0));
+}
+
+/*
+ *  The outline of a button with its fibre end at (x,y), orientation theta.
+ */
+static void Outline(
+    const tdFsimGeom  *g,
+    double            x,
+    double            y,
+    double            theta,
+    double            pts[TDF_SIM_OUTLINE][2])
+{
+    double dx = -sin(theta);        /* Along the button, toward pivot */
+    double dy =  cos(theta);
+    unsigned i;
+    for (i = 0; i < g->numOutline ; ++i) {
+        double u = (double)g->outline[i][0];
+        double v = (double)g->outline[i][1];
+        pts[i][0] = x + u*dx + v*dy;
+        pts[i][1] = y + u*dy - v*dx;
+    }
+}
+
+/*
+ *  Is the point inside the convex outline.
+ */
+static int Inside(
+    double            px,
+    double            py,
+    unsigned          n,
+    double            pts[TDF_SIM_OUTLINE][2])
+{
+    int      sign = 0;
+    unsigned i;
+    for (i = 0; i < n ; ++i) {
+        unsigned j = (i+1)%n;
+        int side = Side(px, py, pts[i][0], pts[i][1], pts[j][0], pts[j][1]);
+        if (side == 0) continue;
+        if (sign == 0) sign = side;
+        else if (side != sign) return 0;
+    }
+    return 1;
+}
+
+/*
+ *  Distance from a segment to the outline, zero if they touch.
+ */
+static double OutlineSegDist(
+    double            x1,
+    double            y1,
+    double            x2,
+    double            y2,
+    unsigned          n,
+    double            pts[TDF_SIM_OUTLINE][2])
+{
+    double   d = -1;
+    unsigned i;
+
+    if (Inside(x1, y1, n, pts)) return 0;
+    for (i = 0; i < n ; ++i) {
+        unsigned j = (i+1)%n;
+        double e;
+        if (SegCross(x1, y1, x2, y2, pts[i][0], pts[i][1],
+                     pts[j][0], pts[j][1]))
+            return 0;
+        e = SegDist(pts[i][0], pts[i][1], x1, y1, x2, y2);
+        if ((d < 0)||(e < d)) d = e;
+        e = SegDist(x1, y1, pts[i][0], pts[i][1], pts[j][0], pts[j][1]);
+        if (e < d) d = e;
+        e = SegDist(x2, y2, pts[i][0], pts[i][1], pts[j][0], pts[j][1]);
+        if (e < d) d = e;
+    }
+    return d;
+}
+
+/*
+ *  Distance from a point to the outline, zero if inside.
+ */
+static double OutlinePointDist(
+    double            px,
+    double            py,
+    unsigned          n,
+    double            pts[TDF_SIM_OUTLINE][2])
+{
+    return OutlineSegDist(px, py, px, py, n, pts);
+}
+
+
+/*+        T D F D E L T A F P I L S I M
+
+ *  Function name:
+      tdFdeltaFpilSimGeom
+
+ *  Function:
+      Returns a nominal stand-in geometry.
+
+ *  Language:
+      C
+
+ *  Call:
+      (const tdFsimGeom *) = tdFdeltaFpilSimGeom (sixdf)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) sixdf       (int)   True for the 6dF-like geometry, otherwise
+                              the 2dF-like geometry.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC const tdFsimGeom  *tdFdeltaFpilSimGeom (
+        int  sixdf)
+{
+    return (sixdf ? &simGeom6dF : &simGeom2dF);
+}
+
+
+/*+        T D F D E L T A F P I L S I M
+
+ *  Function name:
+      tdFdeltaFpilSimCurrent
+
+ *  Function:
+      Returns the geometry of the stand-in instrument.
+
+ *  Description:
+      As scaled by tdFdeltaFpilSimInit() for its number of pivots.  The
+      instrument is that of the plan selected in the calling thread (see
+      tdFdeltaFpilInst()).
+
+ *  Language:
+      C
+
+ *  Call:
+      (const tdFsimGeom *) = tdFdeltaFpilSimCurrent ()
+
+ *  Prior requirements:
+      The instrument must be a stand-in instrument.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  The selected plan's instrument.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC const tdFsimGeom  *tdFdeltaFpilSimCurrent (void)
+{
+    return &SIM(tdFdeltaFpilInst())->geom;
+}
+
+
+/*+        T D F D E L T A F P I L S I M
+
+ *  Function name:
+      tdFdeltaFpilSimInit
+
+ *  Function:
+      Create the stand-in instrument.
+
+ *  Description:
+      Creates a model from the given geometry with numPivots pivots and
+      returns its handle, which should be given to tdFdeltaFpilSet(), or
+      used as a plan's own instrument (data->inst), and released with
+      FpilFree().  If
+      numPivots is more than the geometry's nominal number of pivots, the
+      radii, screw hole positions and maximum extension are scaled up in
+      proportion, keeping the pivot spacing.  The button bounding radius
+      is worked out from the outline.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaFpilSimInit (geom, numPivots, inst, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) geom        (const tdFsimGeom *) The nominal geometry.
+      (>) numPivots   (unsigned)        The number of pivots, up to
+                                        FPIL_MAXPIVOTS.
+      (<) inst        (FpilType *)      The instrument handle.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Give the outline to tdFdeltaGeomShape().
+      18-Oct-2026  AGT  Allocate a model for each handle.
+      19-Oct-2026  AGT  Outline no longer given to tdFdeltaGeomShape().
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaFpilSimInit (
+        const tdFsimGeom  *geom,
+        unsigned          numPivots,
+        FpilType          *inst,
+        StatusType        *status)
+{
+    SimModel    *model;
+    tdFsimGeom  *g;
+    double      scale;
+    unsigned    i;
+
+    if (*status != STATUS__OK) return;
+    if ((numPivots == 0)||(numPivots > FPIL_MAXPIVOTS)||
+        (geom->numFids > FPIL_MAXFIDS)||(geom->numOutline < 3)||
+        (geom->numOutline > TDF_SIM_OUTLINE)||
+        (geom->numScrews > TDF_SIM_SCREWS)) {
+        *status = TDFDELTA__OUTOFRANGE;
+        return;
+    }
+    if ((model = (SimModel *)malloc(sizeof(SimModel))) == NULL) {
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+
+    g = &model->geom;
+    *g = *geom;
+    g->numPivots = numPivots;
+    if (g->numGuide > numPivots) g->numGuide = numPivots;
+    scale = (numPivots > geom->numPivots ?
+             (double)numPivots/(double)geom->numPivots : 1.0);
+    g->fieldRadius = (long)(geom->fieldRadius*scale);
+    g->pivotRadius = (long)(geom->pivotRadius*scale);
+    g->parkRadius  = (long)(geom->parkRadius*scale);
+    g->fidRadius   = (long)(geom->fidRadius*scale);
+    g->maxExt      = (long)(geom->maxExt*scale);
+    for (i = 0; i < g->numScrews ; ++i) {
+        g->screw[i][0] = (long)(geom->screw[i][0]*scale);
+        g->screw[i][1] = (long)(geom->screw[i][1]*scale);
+    }
+    g->butRadius = 0;
+    for (i = 0; i < g->numOutline ; ++i) {
+        long r = (long)ceil(sqrt((double)g->outline[i][0]*g->outline[i][0] +
+                                 (double)g->outline[i][1]*g->outline[i][1]));
+        if (r > g->butRadius) g->butRadius = r;
+    }
+
+    model->butClear = geom->butClear;
+    model->fibClear = geom->fibClear;
+    *inst = (FpilType)(void *)model;
+}
+
+
+/*+        T D F D E L T A F P I L S I M
+
+ *  Function name:
+      tdFdeltaFpilSimConstants
+
+ *  Function:
+      Fill in the constant field details for the stand-in instrument.
+
+ *  Description:
+      Sets the pivot and park positions, pivot types and maximum
+      extensions in data->constants, the fiducials, the clearances and the
+      angle limits from the plan's stand-in geometry - that of data->inst
+      if set, otherwise of tdFdeltaFpilSimCurrent().  The positioning
+      offsets and grasp offsets are zero.  The first pivot is at the
+      top (+y), the others follow anticlockwise.  The guide pivots are
+      spread evenly amongst them.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaFpilSimConstants (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+
+ *  Prior requirements:
+      tdFdeltaFpilSimInit() must have been called.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Geometry of the plan's own instrument, if any.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaFpilSimConstants (
+        tdFdeltaType  *data)
+{
+    const tdFsimGeom  *g = (data->inst ? &SIM(data->inst)->geom :
+                                         tdFdeltaFpilSimCurrent());
+    tdFconstants      *con = &data->constants;
+    unsigned          piv;
+    unsigned          fid;
+
+    memset(con, 0, sizeof(*con));
+    memset(&data->offsets_, 0, sizeof(data->offsets_));
+    memset(&data->fids, 0, sizeof(data->fids));
+
+    for (piv = 0; piv < g->numPivots ; ++piv) {
+        double a = 2*PI*piv/g->numPivots;
+        con->xPiv[piv]  = (INT32)floor(-g->pivotRadius*sin(a) + 0.5);
+        con->yPiv[piv]  = (INT32)floor( g->pivotRadius*cos(a) + 0.5);
+        con->xPark[piv] = (INT32)floor(-g->parkRadius*sin(a) + 0.5);
+        con->yPark[piv] = (INT32)floor( g->parkRadius*cos(a) + 0.5);
+        con->tPark[piv] = a;
+        con->type[piv]  = OBJECT;
+        con->inUse[piv] = YES;
+        con->maxExt[piv] = g->maxExt;
+    }
+    for (piv = 0; piv < g->numGuide ; ++piv)
+        con->type[piv*(g->numPivots/g->numGuide)] = GUIDE;
+
+    for (fid = 0; fid < g->numFids ; ++fid) {
+        double a = 2*PI*(fid + 0.5)/g->numFids;
+        data->fids.fidX[fid]  = (INT32)floor(-g->fidRadius*sin(a) + 0.5);
+        data->fids.fidY[fid]  = (INT32)floor( g->fidRadius*cos(a) + 0.5);
+        data->fids.inUse[fid] = YES;
+    }
+
+    data->butClearO = data->butClearG = g->butClear;
+    data->fibClearO = data->fibClearG = g->fibClear;
+    data->maxPivAngO = data->maxPivAngG = g->maxPivAng;
+    data->maxButAngO = data->maxButAngG = g->maxButAng;
+}
+
+
+/*+        T D F D E L T A F P I L S I M
+
+ *  Function name:
+      tdFdeltaFpilSimFibre
+
+ *  Function:
+      Work out the fibre for a fibre end position.
+
+ *  Description:
+      Given a pivot position and the fibre end position, returns the
+      button orientation for a straight fibre, the fibre virtual pivot
+      point and the pivot to virtual pivot point distance, as would be
+      supplied to the task in the field details, for the instrument of
+      tdFdeltaFpilSimCurrent().
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaFpilSimFibre (xPiv, yPiv, xf, yf, theta, fvpX, fvpY,
+                                     fibreLength)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) xPiv, yPiv  (long)            Pivot position.
+      (>) xf, yf      (long)            Fibre end position.
+      (<) theta       (double *)        Button orientation.
+      (<) fvpX, fvpY  (INT32 *)         Fibre virtual pivot point.
+      (<) fibreLength (double *)        Pivot to virtual pivot distance.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Uses the selected plan's instrument.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaFpilSimFibre (
+        long    xPiv,
+        long    yPiv,
+        long    xf,
+        long    yf,
+        double  *theta,
+        INT32   *fvpX,
+        INT32   *fvpY,
+        double  *fibreLength)
+{
+    double dx = (double)(xPiv - xf);
+    double dy = (double)(yPiv - yf);
+    double len = sqrt(dx*dx + dy*dy);
+    double l = tdFdeltaFpilSimCurrent()->virPivLen;
+    double vx, vy;
+
+    if (len <= l) {
+        vx = (double)xPiv;
+        vy = (double)yPiv;
+    } else {
+        vx = xf + dx*l/len;
+        vy = yf + dy*l/len;
+    }
+    *fvpX = (INT32)floor(vx + 0.5);
+    *fvpY = (INT32)floor(vy + 0.5);
+    dx = xPiv - vx;
+    dy = yPiv - vy;
+    *fibreLength = sqrt(dx*dx + dy*dy);
+
+    /*
+     *  The button points back along the fibre, toward the pivot.
+     */
+    *theta = atan2(-dx, dy);
+    if (*theta < 0) *theta += 2*PI;
+}
+
+
+/*
+ *  The FPIL entry points used by the planning core.
+ */
+extern unsigned FpilGetNumPivots(
+        FpilType  inst)
+{
+    return SIM(inst)->geom.numPivots;
+}
+
+extern unsigned FpilGetNumFiducials(
+        FpilType  inst)
+{
+    return SIM(inst)->geom.numFids;
+}
+
+extern int FpilParkMayCollide(
+        FpilType  inst)
+{
+    return SIM(inst)->geom.parkMayCollide;
+}
+
+extern int FpilGetFibAngVar(
+        FpilType  inst)
+{
+    return SIM(inst)->geom.fibAngVar;
+}
+
+extern const char *FpilGetInstName(
+        FpilType  inst)
+{
+    return SIM(inst)->geom.name;
+}
+
+extern const char *FpilGetTelescope(
+        FpilType  inst)
+{
+    return SIM(inst)->geom.telescope;
+}
+
+extern void FpilSetButClear(
+        FpilType       inst,
+        unsigned long  clear)
+{
+    SIM(inst)->butClear = clear;
+}
+
+extern void FpilSetFibClear(
+        FpilType       inst,
+        unsigned long  clear)
+{
+    SIM(inst)->fibClear = clear;
+}
+
+extern void FpilFree(
+        FpilType  inst)
+{
+    free(SIM(inst));
+}
+
+/*
+ *  Do two buttons collide.
+ */
+extern int FpilColButBut(
+        FpilType  inst,
+        double    butXa,
+        double    butYa,
+        double    thetaa,
+        double    butXb,
+        double    butYb,
+        double    thetab)
+{
+    const SimModel *m = SIM(inst);
+    const tdFsimGeom *g = &m->geom;
+    double ptsA[TDF_SIM_OUTLINE][2];
+    double ptsB[TDF_SIM_OUTLINE][2];
+    double dx = butXa - butXb;
+    double dy = butYa - butYb;
+    double lim = 2*g->butRadius + (double)m->butClear;
+    unsigned i;
+
+    if ((dx*dx + dy*dy) >= lim*lim) return NO;
+
+    Outline(g, butXa, butYa, thetaa, ptsA);
+    Outline(g, butXb, butYb, thetab, ptsB);
+    for (i = 0; i < g->numOutline ; ++i) {
+        unsigned j = (i+1)%g->numOutline;
+        if (OutlineSegDist(ptsA[i][0], ptsA[i][1], ptsA[j][0], ptsA[j][1],
+                           g->numOutline, ptsB) < (double)m->butClear)
+            return YES;
+    }
+    return NO;
+}
+
+/*
+ *  Does a button collide with a fibre.
+ */
+extern int FpilColButFib(
+        FpilType  inst,
+        double    butX,
+        double    butY,
+        double    theta,
+        double    fvpX,
+        double    fvpY,
+        double    pivX,
+        double    pivY)
+{
+    const SimModel *m = SIM(inst);
+    const tdFsimGeom *g = &m->geom;
+    double pts[TDF_SIM_OUTLINE][2];
+
+    if (SegDist(butX, butY, fvpX, fvpY, pivX, pivY) >=
+        g->butRadius + (double)m->fibClear)
+        return NO;
+    Outline(g, butX, butY, theta, pts);
+    return (OutlineSegDist(fvpX, fvpY, pivX, pivY, g->numOutline, pts) <
+            (double)m->fibClear ? YES : NO);
+}
+
+/*
+ *  Do two fibres cross.
+ */
+extern int FpilColFibFib(
+        FpilType  inst,
+        double    pivXa,
+        double    pivYa,
+        double    fvpXa,
+        double    fvpYa,
+        double    pivXb,
+        double    pivYb,
+        double    fvpXb,
+        double    fvpYb)
+{
+    return (SegCross(pivXa, pivYa, fvpXa, fvpYa,
+                     pivXb, pivYb, fvpXb, fvpYb) ? YES : NO);
+}
+
+/*
+ *  Is the position invalid - the button is over a screw hole or too
+ *  close to the pivot circle.
+ */
+extern int FpilColInvPos(
+        FpilType  inst,
+        unsigned  plate,
+        int       fibreType,
+        long      x,
+        long      y,
+        double    theta)
+{
+    const tdFsimGeom *g = &SIM(inst)->geom;
+    double pts[TDF_SIM_OUTLINE][2];
+    double lim = (double)(g->pivotRadius - g->pivotKeepOut);
+    unsigned i;
+
+    Outline(g, (double)x, (double)y, theta, pts);
+    for (i = 0; i < g->numOutline ; ++i) {
+        if (pts[i][0]*pts[i][0] + pts[i][1]*pts[i][1] > lim*lim)
+            return YES;
+    }
+    for (i = 0; i < g->numScrews ; ++i) {
+        if (OutlinePointDist((double)g->screw[i][0], (double)g->screw[i][1],
+                             g->numOutline, pts) < (double)g->screwRadius)
+            return YES;
+    }
+    return NO;
+}
+
+/*
+ *  Does a button or its fibre obstruct a fiducial.
+ */
+extern int FpilColFiducial(
+        FpilType  inst,
+        long      butX,
+        long      butY,
+        double    theta,
+        long      pivX,
+        long      pivY,
+        long      fvpX,
+        long      fvpY,
+        long      fidX,
+        long      fidY)
+{
+    const SimModel *m = SIM(inst);
+    const tdFsimGeom *g = &m->geom;
+    double pts[TDF_SIM_OUTLINE][2];
+
+    if (SegDist((double)fidX, (double)fidY, (double)fvpX, (double)fvpY,
+                (double)pivX, (double)pivY) < (double)m->fibClear)
+        return YES;
+    Outline(g, (double)butX, (double)butY, theta, pts);
+    return (OutlinePointDist((double)fidX, (double)fidY, g->numOutline, pts) <
+            (double)m->butClear ? YES : NO);
+}
+
+/*
+ *  Is the position within the field.
+ */
+extern int FpilOnField(
+        FpilType  inst,
+        long      x,
+        long      y)
+{
+    const SimModel *m = SIM(inst);
+    double r = (double)m->geom.fieldRadius;
+    return (((double)x*x + (double)y*y) <= r*r);
+}
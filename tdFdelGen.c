@@ -0,0 +1,529 @@
+/*+                T D F D E L T A
+
+ *  Module name:
+      tdFdeltaGen
+
+ *  Function:
+      Random field generator for the stand-in instrument.
+
+ *  Description:
+      Generates random, but valid, current and target fields for the
+      stand-in instrument (see tdFdelFpilSim.c), for benchmarks and
+      equivalence tests of the planner.  Each field is generated from a
+      seed, so may be generated again exactly.  The fields are generated
+      as follows -
+
+        - The current field.  In a random order, each pivot is placed on
+          the field with probability <density>, at a random position
+          which doesn't collide with those already placed.  If no
+          position is found, the fibre is left parked.  The fibres are
+          laid closest to the centre first, as the special sequencer
+          places them, so later fibres cross above earlier ones.
+
+        - The target field.  Each pivot must move with probability
+          <mustMove>, the others stay where they are.  In a random order,
+          each pivot which must move is placed on the field with
+          probability <density>, at a random position which doesn't
+          collide with those already decided.  Otherwise, or if no
+          position is found, it is parked.
+
+        - Or, if <tweak> is positive, the target field is a tweak of the
+          current field.  Parked pivots stay parked.  Each placed pivot
+          must move with probability <mustMove> and, in a random order,
+          is moved by a random offset of up to <tweak> microns which
+          doesn't collide with those already decided.  If no offset is
+          found, it stays where it is or, if that now collides, is
+          parked.
+
+      Positions are chosen by taking a random fibre length and a random
+      angle from the line between the pivot and the field centre, of up
+      to <crossing> times the maximum pivot/fibre angle.  So with a
+      <crossing> of zero, all fibres are radial and never cross.
+
+      The generator state is thread local, so threads may generate
+      fields at the same time.  Not part of the tdFdeltaCore library.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, the generator from tdFdelBench.c.
+      18-Oct-2026  AGT  Reject button positions over screw holes or too
+                        close to the pivot circle.
+      18-Oct-2026  AGT  Add tweak target fields.
+      18-Oct-2026  AGT  Generator state thread local.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelGen.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelGen.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  Number of positions tried for a fibre before we give up and park it.
+ */
+#define MAX_TRIES 20
+
+
+/*
+ *  One field, current or target, as arrays.
+ */
+typedef struct {
+    INT32   *xf, *yf, *xb, *yb, *fvpX, *fvpY;
+    double  *theta, *fibreLength;
+    short   *park;
+    } Field;
+
+/*
+ *  Random numbers.  We use our own generator so that the fields are the
+ *  same on all machines for a given seed.
+ */
+static TDFDELTA_TLS unsigned long randState;
+
+static void RandSeed(
+        unsigned long  seed)
+{
+    randState = (seed & 0xFFFFFFFFUL) ? (seed & 0xFFFFFFFFUL) : 1;
+}
+
+/*
+ *  Uniform in [0,1).
+ */
+static double Rand(void)
+{
+    randState ^= (randState << 13) & 0xFFFFFFFFUL;
+    randState ^= (randState >> 17);
+    randState ^= (randState << 5) & 0xFFFFFFFFUL;
+    return (double)(randState & 0xFFFFFFFFUL)/4294967296.0;
+}
+
+/*
+ *  A random permutation of 0..n-1.
+ */
+static void Shuffle(
+        unsigned  n,
+        unsigned  *order)
+{
+    unsigned i;
+    for (i = 0; i < n ; ++i) order[i] = i;
+    for (i = n; i > 1 ; --i) {
+        unsigned j = (unsigned)(Rand()*i);
+        unsigned t = order[i-1];
+        order[i-1] = order[j];
+        order[j] = t;
+    }
+}
+
+static void CurrentField(
+        tdFdeltaType  *data,
+        Field         *f)
+{
+    f->xf = data->current.xf;     f->yf = data->current.yf;
+    f->xb = data->current.xb;     f->yb = data->current.yb;
+    f->fvpX = data->current.fvpX; f->fvpY = data->current.fvpY;
+    f->theta = data->current.theta;
+    f->fibreLength = data->current.fibreLength;
+    f->park = data->current.park;
+}
+
+static void TargetField(
+        tdFdeltaType  *data,
+        Field         *f)
+{
+    f->xf = data->target.xf;      f->yf = data->target.yf;
+    f->xb = 0;                    f->yb = 0;
+    f->fvpX = data->target.fvpX;  f->fvpY = data->target.fvpY;
+    f->theta = data->target.theta;
+    f->fibreLength = data->target.fibreLength;
+    f->park = data->target.park;
+}
+
+/*
+ *  Put a pivot in a position.
+ */
+static void Place(
+        const tdFconstants  *con,
+        Field               *f,
+        unsigned            piv,
+        long                xf,
+        long                yf,
+        short               park)
+{
+    f->xf[piv] = (INT32)xf;
+    f->yf[piv] = (INT32)yf;
+    if (f->xb) {
+        f->xb[piv] = (INT32)xf;
+        f->yb[piv] = (INT32)yf;
+    }
+    f->park[piv] = park;
+    tdFdeltaFpilSimFibre(con->xPiv[piv], con->yPiv[piv], xf, yf,
+                         &f->theta[piv], &f->fvpX[piv], &f->fvpY[piv],
+                         &f->fibreLength[piv]);
+    if (park == YES)
+        f->theta[piv] = con->tPark[piv];
+}
+
+static void Park(
+        const tdFconstants  *con,
+        Field               *f,
+        unsigned            piv)
+{
+    Place(con, f, piv, con->xPark[piv], con->yPark[piv], YES);
+}
+
+/*
+ *  Choose a random position for a pivot, within reach.  Returns false
+ *  if it is not on the field.
+ */
+static int Candidate(
+        const tdFsimGeom    *geom,
+        const tdFconstants  *con,
+        const tdFgenParams  *params,
+        unsigned            piv,
+        long                *xf,
+        long                *yf)
+{
+    FpilType inst = tdFdeltaFpilInst();
+    double xp = con->xPiv[piv];
+    double yp = con->yPiv[piv];
+    double toCentre = atan2(xp, -yp);   /* Direction pivot->centre */
+    double minLen = geom->pivotRadius - geom->fieldRadius + geom->butRadius;
+    double maxLen = (double)con->maxExt[piv] - geom->virPivLen;
+    double a = toCentre + params->crossing*geom->maxPivAng*0.95*(2*Rand()-1);
+    double len = minLen + (maxLen - minLen)*Rand();
+
+    *xf = (long)floor(xp - len*sin(a) + 0.5);
+    *yf = (long)floor(yp + len*cos(a) + 0.5);
+    return FpilOnField(inst, *xf, *yf);
+}
+
+/*
+ *  Check a placed pivot's position (screw holes, fiducials), then check
+ *  it against those already decided.  Parked pivots are only checked if
+ *  parked buttons may collide.
+ */
+static int Valid(
+        const tdFdeltaType  *data,
+        const Field         *f,
+        unsigned            piv,
+        const short         *decided,
+        unsigned            numPivots)
+{
+    FpilType             inst = tdFdeltaFpilInst();
+    const tdFconstants   *con = &data->constants;
+    int                  parkMayCollide = FpilParkMayCollide(inst);
+    unsigned             j;
+    unsigned             fid;
+
+    if (FpilColInvPos(inst, 0, 0, f->xf[piv], f->yf[piv],
+                      f->theta[piv]))
+        return 0;
+    for (fid = 0; fid < FpilGetNumFiducials(inst) ; ++fid) {
+        FpilSetButClear(inst, data->butClearO);
+        FpilSetFibClear(inst, data->fibClearO);
+        if (FpilColFiducial(inst, f->xf[piv], f->yf[piv], f->theta[piv],
+                            con->xPiv[piv], con->yPiv[piv],
+                            f->fvpX[piv], f->fvpY[piv],
+                            data->fids.fidX[fid], data->fids.fidY[fid]))
+            return 0;
+    }
+
+    for (j = 0; j < numPivots ; ++j) {
+        int guide;
+        if ((j == piv)||(!decided[j])) continue;
+        if ((f->park[j] == YES)&&(!parkMayCollide)) continue;
+        guide = (con->type[piv] == GUIDE)||(con->type[j] == GUIDE);
+        FpilSetButClear(inst, guide ? data->butClearG : data->butClearO);
+        if (FpilColButBut(inst, f->xf[piv], f->yf[piv], f->theta[piv],
+                          f->xf[j], f->yf[j], f->theta[j]) == YES)
+            return 0;
+        FpilSetFibClear(inst, con->type[j] == GUIDE ?
+                              data->fibClearG : data->fibClearO);
+        if (FpilColButFib(inst, f->xf[piv], f->yf[piv], f->theta[piv],
+                          f->fvpX[j], f->fvpY[j],
+                          con->xPiv[j], con->yPiv[j]) == YES)
+            return 0;
+        FpilSetFibClear(inst, con->type[piv] == GUIDE ?
+                              data->fibClearG : data->fibClearO);
+        if (FpilColButFib(inst, f->xf[j], f->yf[j], f->theta[j],
+                          f->fvpX[piv], f->fvpY[piv],
+                          con->xPiv[piv], con->yPiv[piv]) == YES)
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ *  Try to place a pivot at a random position.  If we can't, it is
+ *  parked.
+ */
+static void PlaceRandom(
+        const tdFsimGeom    *geom,
+        const tdFgenParams  *params,
+        tdFdeltaType        *data,
+        Field               *f,
+        unsigned            piv,
+        const short         *decided,
+        unsigned            numPivots)
+{
+    const tdFconstants *con = &data->constants;
+    int try;
+    for (try = 0; try < MAX_TRIES ; ++try) {
+        long xf, yf;
+        if (!Candidate(geom, con, params, piv, &xf, &yf))
+            continue;
+        Place(con, f, piv, xf, yf, NO);
+        if (Valid(data, f, piv, decided, numPivots))
+            return;
+    }
+    Park(con, f, piv);
+}
+
+/*
+ *  Try to move a pivot by a random offset from its current position.  If
+ *  we can't, it stays where it is if that is still valid, otherwise it
+ *  is parked.
+ */
+static void PlaceTweak(
+        const tdFgenParams  *params,
+        tdFdeltaType        *data,
+        const Field         *cur,
+        Field               *f,
+        unsigned            piv,
+        const short         *decided,
+        unsigned            numPivots)
+{
+    const tdFconstants *con = &data->constants;
+    int try;
+    for (try = 0; try < MAX_TRIES ; ++try) {
+        double r = params->tweak*sqrt(Rand());
+        double a = 2*PI*Rand();
+        long   xf = cur->xf[piv] + (long)floor(r*cos(a) + 0.5);
+        long   yf = cur->yf[piv] + (long)floor(r*sin(a) + 0.5);
+        if (!FpilOnField(tdFdeltaFpilInst(), xf, yf))
+            continue;
+        Place(con, f, piv, xf, yf, NO);
+        if (Valid(data, f, piv, decided, numPivots))
+            return;
+    }
+    Place(con, f, piv, cur->xf[piv], cur->yf[piv], NO);
+    if (!Valid(data, f, piv, decided, numPivots))
+        Park(con, f, piv);
+}
+
+/*
+ *  Order pivots by increasing fibre end distance from the field centre.
+ */
+static TDFDELTA_TLS const Field *sortField;
+
+static int CompareDistance(
+        const void  *a,
+        const void  *b)
+{
+    unsigned pa = *(const unsigned *)a;
+    unsigned pb = *(const unsigned *)b;
+    double   da = (double)sortField->xf[pa]*sortField->xf[pa] +
+                  (double)sortField->yf[pa]*sortField->yf[pa];
+    double   db = (double)sortField->xf[pb]*sortField->xf[pb] +
+                  (double)sortField->yf[pb]*sortField->yf[pb];
+    if (da < db) return -1;
+    if (da > db) return 1;
+    return (pa < pb ? -1 : (pa > pb));
+}
+
+static void SortByDistance(
+        const Field  *f,
+        unsigned     n,
+        unsigned     *order)
+{
+    unsigned i;
+    for (i = 0; i < n ; ++i) order[i] = i;
+    sortField = f;
+    qsort(order, n, sizeof(order[0]), CompareDistance);
+}
+
+/*+        T D F D E L T A G E N
+
+ *  Function name:
+      tdFdeltaGenField
+
+ *  Function:
+      Generate a random field.
+
+ *  Description:
+      Generates the current and target fields, crossover lists and
+      constants for the stand-in instrument, as per the module
+      description.  The same seed always gives the same field.  The
+      plan is selected with tdFdeltaUse() and its statistics are zero.
+
+ *  Language:
+      C
+
+ *  Call:
+      (tdFdeltaType *) = tdFdeltaGenField (params, seed, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) params      (const tdFgenParams *) Field parameters.
+      (>) seed        (unsigned long)   Random number seed.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      The plan data, which should be released with tdFdeltaDataFree(),
+      or NULL on error.
+
+ *  Prior requirements:
+      The stand-in instrument must have been created with
+      tdFdeltaFpilSimInit() and given to tdFdeltaFpilSet().
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, moved from tdFdelBench.c.
+      18-Oct-2026  AGT  Add tweak target fields.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC tdFdeltaType  *tdFdeltaGenField (
+        const tdFgenParams  *params,
+        unsigned long       seed,
+        StatusType          *status)
+{
+    const tdFsimGeom *geom;
+    tdFdeltaType     *data;
+    unsigned         numPivots;
+    unsigned         order[FPIL_MAXPIVOTS];
+    short            decided[FPIL_MAXPIVOTS];
+    long             xf[FPIL_MAXPIVOTS];
+    long             yf[FPIL_MAXPIVOTS];
+    short            park[FPIL_MAXPIVOTS];
+    Field            cur;
+    Field            tar;
+    unsigned         i;
+
+    if ((data = tdFdeltaDataNew(0, status)) == NULL)
+        return NULL;
+    strcpy(data->name, "bench");
+    tdFdeltaFpilSimConstants(data);
+    geom = tdFdeltaFpilSimCurrent();
+    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    data->extSpringOut = 0;
+    tdFdeltaUse(data);
+    RandSeed(seed);
+
+    /*
+     *  Current field.
+     */
+    CurrentField(data, &cur);
+    memset(decided, 0, sizeof(decided));
+    for (i = 0; i < numPivots ; ++i)
+        Park(&data->constants, &cur, i);
+    Shuffle(numPivots, order);
+    for (i = 0; i < numPivots ; ++i) {
+        unsigned piv = order[i];
+        if (Rand() < params->density)
+            PlaceRandom(geom, params, data, &cur, piv, decided, numPivots);
+        decided[piv] = 1;
+    }
+
+    /*
+     *  Lay the fibres, closest to the centre first, as the special
+     *  sequencer would have.  Each must be laid with only those already
+     *  laid on the field.
+     */
+    SortByDistance(&cur, numPivots, order);
+    for (i = 0; i < numPivots ; ++i) {
+        xf[i] = cur.xf[i];
+        yf[i] = cur.yf[i];
+        park[i] = cur.park[i];
+        Park(&data->constants, &cur, i);
+    }
+    for (i = 0; i < numPivots ; ++i) {
+        unsigned piv = order[i];
+        if (park[piv] == YES) continue;
+        Place(&data->constants, &cur, piv, xf[piv], yf[piv], NO);
+        tdFdeltaCrossesMoved(piv, FpilParkMayCollide(tdFdeltaFpilInst()),
+                             &data->constants, &data->current,
+                             &data->crosses, status);
+    }
+
+    /*
+     *  Target field, the pivots not moving first.
+     */
+    TargetField(data, &tar);
+    memset(decided, 0, sizeof(decided));
+    if (params->tweak > 0) {
+        for (i = 0; i < numPivots ; ++i) {
+            data->target.mustMove[i] = ((cur.park[i] != YES)&&
+                                        (Rand() < params->mustMove)) ?
+                                       YES : NO;
+            if (data->target.mustMove[i] == NO) {
+                Place(&data->constants, &tar, i, cur.xf[i], cur.yf[i],
+                      cur.park[i]);
+                tar.theta[i] = cur.theta[i];
+                decided[i] = 1;
+            } else {
+                Park(&data->constants, &tar, i);
+            }
+        }
+        Shuffle(numPivots, order);
+        for (i = 0; i < numPivots ; ++i) {
+            unsigned piv = order[i];
+            if (data->target.mustMove[piv] == NO) continue;
+            PlaceTweak(params, data, &cur, &tar, piv, decided, numPivots);
+            decided[piv] = 1;
+        }
+    } else {
+        for (i = 0; i < numPivots ; ++i) {
+            data->target.mustMove[i] = (Rand() < params->mustMove) ? YES : NO;
+            if (data->target.mustMove[i] == NO) {
+                Place(&data->constants, &tar, i, cur.xf[i], cur.yf[i],
+                      cur.park[i]);
+                tar.theta[i] = cur.theta[i];
+                decided[i] = 1;
+            } else {
+                Park(&data->constants, &tar, i);
+            }
+        }
+        Shuffle(numPivots, order);
+        for (i = 0; i < numPivots ; ++i) {
+            unsigned piv = order[i];
+            if (data->target.mustMove[piv] == NO) continue;
+            if (Rand() < params->density)
+                PlaceRandom(geom, params, data, &tar, piv, decided,
+                            numPivots);
+            decided[piv] = 1;
+        }
+    }
+
+    /*
+     *  Start the statistics from here.
+     */
+    tdFdeltaStatsInit(&data->stats);
+    if (*status != STATUS__OK) {
+        tdFdeltaDataFree(data);
+        return NULL;
+    }
+    return data;
+}
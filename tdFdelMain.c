@@ -21,6 +21,9 @@
  *  History:
       01-Jul-1994  JW   Original version
       31-Jan-2000  TJF  Call FpilFree after DitsMainLoop() has exited.
+      18-Oct-2026  AGT  Free the plan data pool on exit.
+      19-Oct-2026  AGT  Stop and reap the PREPARE workers before
+                        flushing the data pool.
       {@change entry@}
 
  *  @(#) $Id: ACMM:2dFdelta/tdFdelMain.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
@@ -88,9 +91,12 @@ TDFDELTA_PUBLIC int  tdFdeltaMain (
 
     /*
      *  Since we don't have a tdFdeltaDeActivate routine, we must call
-     *  this at this point.
+     *  this at this point.  Any plans still being prepared are stopped
+     *  first, as they use the data pool.
      */ 
+    tdFdeltaThreadReap(YES);
     FpilFree(tdFdeltaFpilInst());
+    tdFdeltaDataPoolFlush();
     /*
      *  Exit - shutdown dits and exit.
      */
@@ -0,0 +1,443 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaMatrix
+
+ *  Function:
+      The cost of reconfiguring between each pair of candidate fields.
+
+ *  Description:
+      To choose the order of the fields of a night, a scheduler needs the
+      cost of going from each candidate field to each other.  Given M
+      candidate fields for a plate, tdFdeltaMatrix() fills in the M by M
+      matrix of estimated moves, parks and robot time (see
+      tdFdelEstimate.c).
+
+      Each field is taken as configured as the special sequencer would
+      have laid it - fibres closest to the centre first, so later fibres
+      cross above earlier ones.  This state, its crossover lists (from a
+      sweep for the crossings, see tdFdelSweep.c) and the pivot neighbour
+      lists are built once and shared by every pair.
+
+      The rows (from each field) are estimated concurrently, a row at a
+      time per thread, each thread with its own instrument description.
+      Optionally, the cheapest few from each field, by estimated robot
+      time, are then planned in full to give their exact costs.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      19-Oct-2026  AGT  Read and set the cancel flag atomically.
+      19-Oct-2026  AGT  mustMove of refined fields derived by
+                        tdFdeltaBatchChain(), as for BATCH.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelMatrix.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelMatrix.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef TDFDELTA_REENTRANT
+#   include <pthread.h>
+#endif
+
+/*
+ *  What is shared by the threads.
+ */
+typedef struct {
+    tdFmatrix       *matrix;
+    tdFdeltaType    **from;             /* Each field as configured       */
+    tdFneighbours   *nb;
+    } Shared;
+
+/*
+ *  A thread estimating rows.
+ */
+typedef struct {
+    Shared          *shared;
+    FpilType        inst;
+#ifdef TDFDELTA_REENTRANT
+    pthread_t       thread;
+#endif
+    } Worker;
+
+/*
+ *  Laying of a field, for the sweep's found callback.
+ */
+typedef struct {
+    tdFdeltaType    *data;
+    unsigned        rank[FPIL_MAXPIVOTS]; /* Order laid                    */
+    StatusType      *status;
+    } Lay;
+
+
+/*
+ *  Release crossover lists.
+ */
+static void FreeCrosses(
+        tdFcrosses  *crosses)
+{
+    unsigned i;
+    for (i = 0; i < FPIL_MAXPIVOTS ; ++i) {
+        while (crosses->above[i]) {
+            FibreCross *next = crosses->above[i]->next;
+            free(crosses->above[i]);
+            crosses->above[i] = next;
+        }
+        while (crosses->below[i]) {
+            FibreCross *next = crosses->below[i]->next;
+            free(crosses->below[i]);
+            crosses->below[i] = next;
+        }
+    }
+}
+
+/*
+ *  Sweep callback, the fibre laid later crosses above.
+ */
+static void LayFound(
+        void      *clientData,
+        unsigned  a,
+        unsigned  b)
+{
+    Lay          *lay = (Lay *)clientData;
+    tdFdeltaType *data = lay->data;
+    unsigned     above = (lay->rank[a] > lay->rank[b] ? a : b);
+    unsigned     below = (above == a ? b : a);
+
+    tdFdeltaAddCross(above+1, &data->crosses.above[below], lay->status);
+    tdFdeltaAddCross(below+1, &data->crosses.below[above], lay->status);
+    data->current.nAbove[below]++;
+    data->current.nBelow[above]++;
+}
+
+static TDFDELTA_TLS const tdFtarget *sortTarget;
+
+static int CompareDistance(
+        const void  *a,
+        const void  *b)
+{
+    unsigned pa = *(const unsigned *)a;
+    unsigned pb = *(const unsigned *)b;
+    double   da = (double)sortTarget->xf[pa]*sortTarget->xf[pa] +
+                  (double)sortTarget->yf[pa]*sortTarget->yf[pa];
+    double   db = (double)sortTarget->xf[pb]*sortTarget->xf[pb] +
+                  (double)sortTarget->yf[pb]*sortTarget->yf[pb];
+    if (da < db) return -1;
+    if (da > db) return 1;
+    return (pa < pb ? -1 : (pa > pb));
+}
+
+/*
+ *  Create a plan whose current field is the target, as configured.
+ */
+static tdFdeltaType *Configured(
+        const tdFdeltaType  *start,
+        const tdFtarget     *target,
+        unsigned            index,
+        unsigned            numPivots,
+        StatusType          *status)
+{
+    tdFdeltaType *data;
+    tdFinterim   *cur;
+    Lay          lay;
+    unsigned     order[FPIL_MAXPIVOTS];
+    short        use[FPIL_MAXPIVOTS];
+    unsigned     i;
+
+    if ((data = tdFdeltaBatchChain(start, target, NO, index, status)) == NULL)
+        return NULL;
+    FreeCrosses(&data->crosses);
+
+    cur = &data->current;
+    for (i = 0; i < numPivots ; ++i) {
+        double cosT = cos(target->theta[i]);
+        double sinT = sin(target->theta[i]);
+        cur->theta[i]       = target->theta[i];
+        cur->fibreLength[i] = target->fibreLength[i];
+        cur->fvpX[i]        = target->fvpX[i];
+        cur->fvpY[i]        = target->fvpY[i];
+        cur->xf[i]          = target->xf[i];
+        cur->yf[i]          = target->yf[i];
+        cur->park[i]        = target->park[i];
+        cur->nAbove[i]      = 0;
+        cur->nBelow[i]      = 0;
+        if (target->park[i] == YES) {
+            cur->theta[i]       = data->constants.tPark[i];
+            cur->fibreLength[i] = 0;
+            cur->fvpX[i] = cur->xf[i] = cur->xb[i] = data->constants.xPark[i];
+            cur->fvpY[i] = cur->yf[i] = cur->yb[i] = data->constants.yPark[i];
+        } else {
+            cur->xb[i] = target->xf[i] -
+                ((double)data->constants.graspX[i]*cosT -
+                 (double)data->constants.graspY[i]*sinT);
+            cur->yb[i] = target->yf[i] -
+                ((double)data->constants.graspX[i]*cosT +
+                 (double)data->constants.graspY[i]*sinT);
+        }
+        use[i] = (target->park[i] != YES);
+        order[i] = i;
+    }
+
+    /*
+     *  Lay the fibres closest to the centre first.
+     */
+    sortTarget = target;
+    qsort(order, numPivots, sizeof(order[0]), CompareDistance);
+    for (i = 0; i < numPivots ; ++i)
+        lay.rank[order[i]] = i;
+    lay.data = data;
+    lay.status = status;
+    tdFdeltaSweep(numPivots, &data->constants, cur->fvpX, cur->fvpY, use,
+                  LayFound, &lay, status);
+    if (*status != STATUS__OK) {
+        tdFdeltaDataFree(data);
+        return NULL;
+    }
+    return data;
+}
+
+/*
+ *  Plan the cheapest of a row in full.
+ */
+static void Refine(
+        Shared        *shared,
+        unsigned      row,
+        FpilType      inst,
+        tdFdeltaType  *scratch)
+{
+    tdFmatrix   *matrix = shared->matrix;
+    tdFestimate *cost = matrix->cost + row*matrix->numFields;
+    tdFdeltaType *from = shared->from[row];
+    short       picked[FPIL_MAXPIVOTS];
+    unsigned    n, i;
+
+    memset(picked, 0, sizeof(picked));
+    for (n = 0; (n < matrix->refine)&&(!TDFDELTA_LOAD(&matrix->cancel)) ; ++n) {
+        tdFdeltaType  *data;
+        tdFbatchField field;
+        StatusType    status = STATUS__OK;
+        int           best = -1;
+
+        for (i = 0; i < matrix->numFields ; ++i) {
+            if ((i == row)||(picked[i])||(cost[i].status != STATUS__OK))
+                continue;
+            if ((best < 0)||(cost[i].robotTime < cost[best].robotTime))
+                best = (int)i;
+        }
+        if (best < 0) break;
+        picked[best] = YES;
+
+        if ((data = tdFdeltaBatchChain(from, &matrix->targets[best], YES,
+                                       best, &status)) == NULL) {
+            cost[best].status = status;
+            continue;
+        }
+        tdFdeltaBatchField(data, inst, &matrix->cancel, &field);
+        tdFdeltaDataFree(data);
+        tdFdeltaUse(scratch);
+
+        if (field.status == STATUS__OK) {
+            memset(&cost[best], 0, sizeof(cost[best]));
+            cost[best].numMoves = field.numMoves;
+            cost[best].numParks = field.numParks;
+            cost[best].robotTime = field.robotTime;
+            cost[best].confident = YES;
+            cost[best].exact = YES;
+        } else if (field.status != TDFDELTA__BATCHSKIP) {
+            cost[best].status = field.status;
+        }
+    }
+}
+
+/*
+ *  Estimate rows until there are none left.
+ */
+static void *WorkerMain(
+        void  *arg)
+{
+    Worker       *worker = (Worker *)arg;
+    Shared       *shared = worker->shared;
+    tdFmatrix    *matrix = shared->matrix;
+    tdFdeltaType *scratch;
+    StatusType   status = STATUS__OK;
+
+    /*
+     *  The estimates use the instrument, and count pair checks, of the
+     *  current plan.
+     */
+    if ((scratch = tdFdeltaDataNew(matrix->start->check, &status)) == NULL)
+        return 0;
+    scratch->inst = worker->inst;
+    tdFdeltaUse(scratch);
+
+    for (;;) {
+        unsigned row, j;
+        tdFdeltaLock();
+        row = matrix->nextRow++;
+        tdFdeltaUnlock();
+        if (row >= matrix->numFields) break;
+
+        for (j = 0; j < matrix->numFields ; ++j) {
+            tdFestimate *cost = &matrix->cost[row*matrix->numFields + j];
+            if (TDFDELTA_LOAD(&matrix->cancel)) {
+                memset(cost, 0, sizeof(*cost));
+                cost->status = TDFDELTA__BATCHSKIP;
+                continue;
+            }
+            if (j == row) {
+                memset(cost, 0, sizeof(*cost));
+                cost->confident = YES;
+                cost->exact = YES;
+                continue;
+            }
+            status = STATUS__OK;
+            tdFdeltaEstimate(shared->from[row], &matrix->targets[j],
+                             shared->nb, cost, &status);
+            cost->status = status;
+        }
+        Refine(shared, row, worker->inst, scratch);
+
+        tdFdeltaLock();
+        ++matrix->rowsDone;
+        tdFdeltaUnlock();
+    }
+    tdFdeltaDataFree(scratch);
+    return 0;
+}
+
+
+/*+        T D F D E L T A M A T R I X
+
+ *  Function name:
+      tdFdeltaMatrix
+
+ *  Function:
+      Estimate the cost between each pair of candidate fields.
+
+ *  Description:
+      Fills in matrix->cost[from*numFields + to] with the estimated
+      cost of reconfiguring from each field, as configured, to each
+      other, as above.  The diagonal is zero.  Then, if matrix->refine is
+      non-zero, that many of the cheapest from each field are planned in
+      full, replacing their estimates (exact set).  A field which fails to
+      plan keeps its estimate, with the plan's status.
+
+      The rows are shared between one thread per instrument given, the
+      calling thread being one of them, and this returns when all are
+      done.  Setting the matrix's cancel item stops it, the costs not
+      done then having status TDFDELTA__BATCHSKIP.  matrix->rowsDone
+      counts the rows finished, for progress reports from another thread.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaMatrix (matrix, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) matrix      (tdFmatrix *)     The candidates, input, and their
+                                        costs, output.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaMatrix (
+        tdFmatrix   *matrix,
+        StatusType  *status)
+{
+    Shared   shared;
+    Worker   workers[TDFDELTA_BATCH_THREADS];
+    unsigned numWorkers = 1;
+    unsigned numPivots;
+    unsigned i;
+
+    if (*status != STATUS__OK) return;
+
+    matrix->nextRow = 0;
+    matrix->rowsDone = 0;
+    if (matrix->numFields == 0) return;
+
+    /*
+     *  The geometry shared by all pairs.
+     */
+    numPivots = tdFdeltaNumPivots(matrix->insts ? matrix->insts[0] :
+                                                  tdFdeltaFpilInst());
+    shared.matrix = matrix;
+    shared.nb = tdFdeltaNeighboursNew(numPivots, &matrix->start->constants,
+                                      status);
+    shared.from = (tdFdeltaType **)calloc(matrix->numFields,
+                                          sizeof(tdFdeltaType *));
+    if ((*status == STATUS__OK)&&(!shared.from)) {
+        *status = TDFDELTA__MALLOCERR;
+        tdFdeltaErsRep(0, status, "Failed to allocate the matrix fields");
+    }
+    for (i = 0; (i < matrix->numFields)&&(*status == STATUS__OK) ; ++i)
+        shared.from[i] = Configured(matrix->start, &matrix->targets[i], i,
+                                    numPivots, status);
+
+    if (*status == STATUS__OK) {
+        workers[0].shared = &shared;
+        workers[0].inst = (matrix->insts ? matrix->insts[0] : 0);
+#ifdef TDFDELTA_REENTRANT
+        if (matrix->insts) {
+            numWorkers = matrix->numInsts;
+            if (numWorkers > TDFDELTA_BATCH_THREADS)
+                numWorkers = TDFDELTA_BATCH_THREADS;
+            if (numWorkers > matrix->numFields)
+                numWorkers = matrix->numFields;
+            if (numWorkers < 1)
+                numWorkers = 1;
+        }
+        for (i = 1; i < numWorkers ; ++i) {
+            workers[i].shared = &shared;
+            workers[i].inst = matrix->insts[i];
+            if (pthread_create(&workers[i].thread, 0, WorkerMain,
+                               &workers[i]) != 0) {
+                numWorkers = i;
+                break;
+            }
+        }
+#endif
+        WorkerMain(&workers[0]);
+#ifdef TDFDELTA_REENTRANT
+        for (i = 1; i < numWorkers ; ++i)
+            pthread_join(workers[i].thread, 0);
+#endif
+    }
+
+    if (shared.from) {
+        for (i = 0; i < matrix->numFields ; ++i)
+            tdFdeltaDataFree(shared.from[i]);
+        free(shared.from);
+    }
+    tdFdeltaNeighboursFree(shared.nb);
+}
@@ -0,0 +1,802 @@
+/*+                T D F D E L T A
+
+ *  Module name:
+      tdFdeltaQueue
+
+ *  Function:
+      Implements the BATCH and MATRIX actions, planning a night's fields.
+
+ *  Description:
+      Rather than a GENERATE for each field as it comes up, the BATCH
+      action takes the whole night - for each plate, the field now on it
+      and the fields to be configured on it, in order - and plans them all
+      in one go (see tdFdeltaBatch()).  Each field is planned from where
+      the plan of the one before leaves the plate.  It returns the moves,
+      parks and estimated robot time (see tdFdelRobot.c) of each field,
+      each plate and the night, but not the command files, which depend
+      on the actual state of the plate and are produced by GENERATE when
+      each field is configured.
+
+      The arguments are as per GENERATE, except that the field details
+      are in argument 10, "segments".  This is a structure with an item
+      for each plate (or independent list of fields), each a structure
+      containing the plate's tdFcurrent, tdFconstants, tdFoffsets and
+      tdFfiducials items and a "fields" item, a structure containing a
+      tdFtarget structure for each field in the order they will be
+      configured.  If the SPECIAL flag is given, extSpringOut is also
+      required.  The THREAD, TRACE and SNAPSHOT flags do not apply.
+
+      The arguments are converted in the action, the planning is run in a
+      thread (with threads of its own for the segments, see
+      tdFdelBatch.c) which the action polls, publishing the DELTA_PROG
+      parameter.  A kick cancels it.  The result is a structure with an
+      item for each segment, named as per the argument, containing the
+      segment totals and arrays of the per field values, and the totals of
+      all segments.  Fields which could not be planned are reported with
+      MsgOut.
+
+      The MATRIX action takes the same arguments, but each segment's
+      fields are candidates to choose between rather than an order, and
+      its tdFcurrent item is not needed.  It returns, for each segment, the
+      cost of going from each candidate to each other - the moves, parks
+      and robot time, estimated (see tdFdelEstimate.c) or, for the
+      cheapest "refine" (argument 12, default 0) from each, planned in
+      full (see tdFdelMatrix.c).  The segments are done one after the
+      other, each with the threads of tdFdeltaMatrix().
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Add the MATRIX action.
+      19-Oct-2026  AGT  Read and set the cancel flag atomically.
+      19-Oct-2026  AGT  INT_GEOM flag no longer allowed.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelQueue.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelQueue.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "DitsTypes.h"       /* Basic dits types            */
+#include "Dits_Err.h"        /* Dits error codes            */
+#include "DitsSys.h"         /* For PutActionHandlers       */
+#include "DitsFix.h"         /* For various Dits routines   */
+#include "DitsMsgOut.h"      /* For MsgOut                  */
+#include "DitsUtil.h"        /* For DitsErrorText           */
+#include "arg.h"             /* For ARG_ macros             */
+#include "sds.h"             /* For SDS_ macros             */
+#include "Sdp.h"             /* Sdp routines                */
+#include "Git.h"             /* Git routines                */
+#include "Ers.h"
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdelta.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define POLL_MS   100       /* Interval at which the action polls the batch */
+#define NAME_LEN   20       /* SDS item name length                          */
+
+/*
+ *  The action data.
+ */
+typedef struct {
+    tdFbatch        batch;
+    tdFbatchSeg     *segs;
+    char            (*names)[NAME_LEN]; /* Segment names                   */
+    tdFtarget       *targets;           /* All segment's fields            */
+    tdFbatchField   *fields;
+    unsigned        numFields;          /* Total fields                    */
+    tdFmatrix       *matrices;          /* Per segment, MATRIX action only */
+    tdFestimate     *costs;             /* All segment's matrices          */
+    FpilType        insts[TDFDELTA_BATCH_THREADS];
+    pthread_t       thread;
+    volatile int    done;               /* Thread finished (locked)        */
+    StatusType      status;             /* tdFdeltaBatch() status          */
+    float           lastProgress;
+    } tdFqueue;
+
+TDFDELTA_PRIVATE void  tdFdeltaQueuePoll(StatusType *status);
+TDFDELTA_PRIVATE void  tdFdeltaQueueKick(StatusType *status);
+
+
+/*
+ *  Release the action data.
+ */
+static void FreeQueue(
+        tdFqueue  *queue)
+{
+    unsigned i;
+
+    if (!queue) return;
+    if (queue->segs) {
+        for (i = 0; i < queue->batch.numSegs ; ++i)
+            tdFdeltaDataFree(queue->segs[i].start);
+    }
+    for (i = 0; i < queue->batch.numInsts ; ++i)
+        FpilFree(queue->insts[i]);
+    free(queue->segs);
+    free(queue->names);
+    free(queue->targets);
+    free(queue->fields);
+    free(queue->matrices);
+    free(queue->costs);
+    free(queue);
+}
+
+/*
+ *  Count the items of a structure.
+ */
+static unsigned CountItems(
+        SdsIdType   id,
+        StatusType  *status)
+{
+    unsigned  n = 0;
+    SdsIdType tmpId;
+
+    if (*status != STATUS__OK) return 0;
+    for (;;) {
+        SdsIndex(id,(long)n+1,&tmpId,status);
+        if (*status != STATUS__OK) {
+            if (*status != SDS__NOMEM) *status = STATUS__OK;
+            return n;
+        }
+        SdsFreeId(tmpId,status);
+        ++n;
+    }
+}
+
+/*
+ *  Get the item of a structure by its position, and its name.
+ */
+static SdsIdType GetItem(
+        SdsIdType   id,
+        unsigned    index,
+        char        *name,
+        StatusType  *status)
+{
+    SdsIdType      itemId = 0;
+    SdsCodeType    code;
+    long           ndims;
+    unsigned long  dims[7];
+
+    if (*status != STATUS__OK) return 0;
+    SdsIndex(id,(long)index+1,&itemId,status);
+    SdsInfo(itemId,name,&code,&ndims,dims,status);
+    if ((*status == STATUS__OK)&&(code != SDS_STRUCT)) {
+        *status = TDFDELTA__INVARG;
+        ErsRep(0,status,"Item \"%s\" must be a structure",name);
+    }
+    return itemId;
+}
+
+/*
+ *  Convert a segment - its start field details and the targets of its
+ *  fields.  numFields is the fields converted so far, which is updated.
+ */
+static void ConvertSeg(
+        tdFqueue        *queue,
+        tdFbatchSeg     *seg,
+        SdsIdType       segId,
+        const char      *segName,
+        long int        maxFibExt,
+        const tdFdeltaType *common,
+        int             needCurrent,
+        unsigned        *numFields,
+        StatusType      *status)
+{
+    tdFdeltaType *data = seg->start;
+    SdsIdType    curId = 0, conId = 0, offId = 0, fidId = 0, fieldsId = 0;
+    SdsIdType    above = 0;
+    StatusType   ignore = STATUS__OK;
+    unsigned     n, i;
+
+    if (*status != STATUS__OK) return;
+
+    data->maxButAngG   = common->maxButAngG;
+    data->maxPivAngG   = common->maxPivAngG;
+    data->maxButAngO   = common->maxButAngO;
+    data->maxPivAngO   = common->maxPivAngO;
+    data->butClearG    = common->butClearG;
+    data->fibClearG    = common->fibClearG;
+    data->butClearO    = common->butClearO;
+    data->fibClearO    = common->fibClearO;
+    data->extSpringOut = common->extSpringOut;
+    sprintf(data->name,"%s",segName);
+
+    if (needCurrent)
+        ArgFind(segId,"tdFcurrent",&curId,status);
+    ArgFind(segId,"tdFconstants",&conId,status);
+    ArgFind(segId,"tdFoffsets",&offId,status);
+    ArgFind(segId,"tdFfiducials",&fidId,status);
+    ArgFind(segId,"fields",&fieldsId,status);
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Segment \"%s\" is incomplete - %s",
+               segName,DitsErrorText(*status));
+        return;
+    }
+    tdFdeltaConvertConToC(conId,maxFibExt,&data->constants,data->check,
+                          status);
+    tdFdeltaConvertOffToC(offId,&data->offsets_,data->check,status);
+    tdFdeltaConvertFidToC(fidId,&data->fids,data->check,status);
+    if (needCurrent) {
+        tdFdeltaConvertCurToC(curId,&data->current,&data->crosses,&above,
+                              data->check,status);
+        if (above) {
+            SdsDelete(above,&ignore);
+            SdsFreeId(above,&ignore);
+        }
+    }
+
+    seg->targets = queue->targets + *numFields;
+    seg->fields  = queue->fields + *numFields;
+    n = seg->numFields;
+    for (i = 0; (i < n)&&(*status == STATUS__OK) ; ++i) {
+        char      name[NAME_LEN];
+        SdsIdType tarId = GetItem(fieldsId,i,name,status);
+        tdFdeltaConvertTarToC(tarId,&queue->targets[*numFields],
+                              data->check,status);
+        if (tarId) SdsFreeId(tarId,&ignore);
+        ++(*numFields);
+    }
+    if (*status != STATUS__OK)
+        ErsRep(0,status,"Error converting segment \"%s\"",segName);
+
+    if (curId) SdsFreeId(curId,&ignore);
+    SdsFreeId(conId,&ignore);
+    SdsFreeId(offId,&ignore);
+    SdsFreeId(fidId,&ignore);
+    SdsFreeId(fieldsId,&ignore);
+}
+
+/*
+ *  Get the arguments and convert the segments.  For the MATRIX action,
+ *  matrix is set.
+ */
+static tdFqueue *NewQueue(
+        short       check,
+        int         matrix,
+        StatusType  *status)
+{
+    tdFqueue     *queue;
+    tdFdeltaType common;
+    SdsIdType    segsId;
+    long int     maxFibExt;
+    long int     refine = 0;
+    unsigned long numCosts = 0;
+    unsigned     numSegs, numFields = 0;
+    unsigned     s;
+
+    if (*status != STATUS__OK) return NULL;
+
+    memset(&common,0,sizeof(common));
+    GitArgGetI(DitsGetArgument(),"maxFibExt",1,0,0,GIT_M_ARG_KEEPERR,&maxFibExt,status);
+    GitArgGetD(DitsGetArgument(),"maxButAngG",2,0,0,GIT_M_ARG_KEEPERR,&common.maxButAngG,status);
+    GitArgGetD(DitsGetArgument(),"maxPivAngG",3,0,0,GIT_M_ARG_KEEPERR,&common.maxPivAngG,status);
+    GitArgGetD(DitsGetArgument(),"maxButAngO",4,0,0,GIT_M_ARG_KEEPERR,&common.maxButAngO,status);
+    GitArgGetD(DitsGetArgument(),"maxPivAngO",5,0,0,GIT_M_ARG_KEEPERR,&common.maxPivAngO,status);
+    GitArgGetI(DitsGetArgument(),"butClearG",6,0,0,GIT_M_ARG_KEEPERR,&common.butClearG,status);
+    GitArgGetI(DitsGetArgument(),"fibClearG",7,0,0,GIT_M_ARG_KEEPERR,&common.fibClearG,status);
+    GitArgGetI(DitsGetArgument(),"butClearO",8,0,0,GIT_M_ARG_KEEPERR,&common.butClearO,status);
+    GitArgGetI(DitsGetArgument(),"fibClearO",9,0,0,GIT_M_ARG_KEEPERR,&common.fibClearO,status);
+    GitArgNamePos(DitsGetArgument(),"segments",10,&segsId,status);
+    if (check & SPECIAL) {
+        GitArgGetI(DitsGetArgument(),"extSpringOut",11,0,0,
+                   GIT_M_ARG_KEEPERR,&common.extSpringOut,status);
+    }
+    if (matrix) {
+        GitArgGetI(DitsGetArgument(),"refine",12,0,0,0,&refine,status);
+        if ((*status == STATUS__OK)&&(refine < 0)) {
+            *status = TDFDELTA__INVARG;
+            ErsRep(0,status,"refine must not be negative");
+        }
+    }
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error getting %s argument(s) - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        return NULL;
+    }
+
+    if ((numSegs = CountItems(segsId,status)) == 0) {
+        if (*status == STATUS__OK) {
+            *status = TDFDELTA__INVARG;
+            ErsRep(0,status,"No segments given to %s",tdFdeltaActionName());
+        }
+        return NULL;
+    }
+
+    /*
+     *  Allocate the action data, counting the fields of each segment
+     *  to size the target and result arrays.
+     */
+    if ((queue = (tdFqueue *)calloc(1,sizeof(tdFqueue))) == NULL) {
+        *status = TDFDELTA__MALLOCERR;
+        return NULL;
+    }
+    queue->segs = (tdFbatchSeg *)calloc(numSegs,sizeof(tdFbatchSeg));
+    queue->names = (char (*)[NAME_LEN])calloc(numSegs,NAME_LEN);
+    if ((!queue->segs)||(!queue->names)) {
+        *status = TDFDELTA__MALLOCERR;
+        FreeQueue(queue);
+        return NULL;
+    }
+    queue->batch.segs = queue->segs;
+    queue->batch.numSegs = numSegs;
+    for (s = 0; (s < numSegs)&&(*status == STATUS__OK) ; ++s) {
+        SdsIdType segId = GetItem(segsId,s,queue->names[s],status);
+        SdsIdType fieldsId = 0;
+        ArgFind(segId,"fields",&fieldsId,status);
+        queue->segs[s].numFields = CountItems(fieldsId,status);
+        numFields += queue->segs[s].numFields;
+        numCosts += (unsigned long)queue->segs[s].numFields*
+                    queue->segs[s].numFields;
+        queue->segs[s].start = tdFdeltaDataNew(check,status);
+        if (fieldsId) SdsFreeId(fieldsId,status);
+        if (segId) SdsFreeId(segId,status);
+    }
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error getting the %s segments - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        FreeQueue(queue);
+        return NULL;
+    }
+    queue->numFields = numFields;
+    queue->targets = (tdFtarget *)malloc(sizeof(tdFtarget)*(numFields+1));
+    queue->fields = (tdFbatchField *)calloc(numFields+1,
+                                            sizeof(tdFbatchField));
+    if ((!queue->targets)||(!queue->fields)) {
+        *status = TDFDELTA__MALLOCERR;
+        FreeQueue(queue);
+        return NULL;
+    }
+    if (matrix) {
+        queue->matrices = (tdFmatrix *)calloc(numSegs,sizeof(tdFmatrix));
+        queue->costs = (tdFestimate *)calloc(numCosts+1,
+                                             sizeof(tdFestimate));
+        if ((!queue->matrices)||(!queue->costs)) {
+            *status = TDFDELTA__MALLOCERR;
+            FreeQueue(queue);
+            return NULL;
+        }
+    }
+
+    /*
+     *  Convert the field details.
+     */
+    numFields = 0;
+    for (s = 0; (s < numSegs)&&(*status == STATUS__OK) ; ++s) {
+        SdsIdType segId = GetItem(segsId,s,queue->names[s],status);
+        ConvertSeg(queue,&queue->segs[s],segId,queue->names[s],maxFibExt,
+                   &common,!matrix,&numFields,status);
+        if (segId) SdsFreeId(segId,status);
+    }
+    if (*status != STATUS__OK) {
+        FreeQueue(queue);
+        return NULL;
+    }
+
+    /*
+     *  Each segment's matrix has its part of the costs.
+     */
+    if (matrix) {
+        numCosts = 0;
+        for (s = 0; s < numSegs ; ++s) {
+            tdFmatrix *m = &queue->matrices[s];
+            m->start = queue->segs[s].start;
+            m->targets = queue->segs[s].targets;
+            m->numFields = queue->segs[s].numFields;
+            m->refine = (unsigned)refine;
+            m->cost = queue->costs + numCosts;
+            numCosts += (unsigned long)m->numFields*m->numFields;
+        }
+    }
+    return queue;
+}
+
+/*
+ *  The batch thread.
+ */
+static void *QueueMain(void *arg)
+{
+    tdFqueue *queue = (tdFqueue *)arg;
+
+    queue->status = STATUS__OK;
+    if (queue->matrices) {
+        unsigned s;
+        for (s = 0; (s < queue->batch.numSegs)&&
+                    (!TDFDELTA_LOAD(&queue->batch.cancel)) ; ++s)
+            tdFdeltaMatrix(&queue->matrices[s],&queue->status);
+    } else {
+        tdFdeltaBatch(&queue->batch,&queue->status);
+    }
+    tdFdeltaLock();
+    queue->done = 1;
+    tdFdeltaUnlock();
+    return 0;
+}
+
+/*
+ *  Return the results and report the fields not planned.
+ */
+static void PutResult(
+        tdFqueue    *queue,
+        StatusType  *status)
+{
+    SdsIdType     id = 0;
+    unsigned long moves = 0, parks = 0, planned = 0;
+    double        robotTime = 0.0;
+    unsigned      s, i;
+
+    if (*status != STATUS__OK) return;
+
+    SdsNew(0,"BatchResult",0,NULL,SDS_STRUCT,0,NULL,&id,status);
+    for (s = 0; s < queue->batch.numSegs ; ++s) {
+        const tdFbatchSeg *seg = &queue->segs[s];
+        unsigned long dims = (seg->numFields ? seg->numFields : 1);
+        SdsIdType     segId = 0, mId = 0, pId = 0, tId = 0;
+        INT32         *m, *p;
+        double        *t;
+
+        SdsNew(id,queue->names[s],0,NULL,SDS_STRUCT,0,NULL,&segId,status);
+        ArgPuti(segId,"numMoves",(long)seg->numMoves,status);
+        ArgPuti(segId,"numParks",(long)seg->numParks,status);
+        ArgPutd(segId,"robotTime",seg->robotTime,status);
+        ArgPuti(segId,"numPlanned",(long)seg->numPlanned,status);
+        SdsNew(segId,"fieldMoves",0,NULL,SDS_INT,1,&dims,&mId,status);
+        SdsNew(segId,"fieldParks",0,NULL,SDS_INT,1,&dims,&pId,status);
+        SdsNew(segId,"fieldTime",0,NULL,SDS_DOUBLE,1,&dims,&tId,status);
+
+        m = (INT32 *)calloc(dims,sizeof(INT32));
+        p = (INT32 *)calloc(dims,sizeof(INT32));
+        t = (double *)calloc(dims,sizeof(double));
+        if ((!m)||(!p)||(!t)) {
+            if (*status == STATUS__OK) *status = TDFDELTA__MALLOCERR;
+        } else {
+            for (i = 0; i < seg->numFields ; ++i) {
+                m[i] = (INT32)seg->fields[i].numMoves;
+                p[i] = (INT32)seg->fields[i].numParks;
+                t[i] = seg->fields[i].robotTime;
+            }
+            SdsPut(mId,sizeof(INT32)*dims,0,(void *)m,status);
+            SdsPut(pId,sizeof(INT32)*dims,0,(void *)p,status);
+            SdsPut(tId,sizeof(double)*dims,0,(void *)t,status);
+        }
+        free(m);
+        free(p);
+        free(t);
+        if (mId) SdsFreeId(mId,status);
+        if (pId) SdsFreeId(pId,status);
+        if (tId) SdsFreeId(tId,status);
+        if (segId) SdsFreeId(segId,status);
+
+        moves += seg->numMoves;
+        parks += seg->numParks;
+        robotTime += seg->robotTime;
+        planned += seg->numPlanned;
+
+        /*
+         *  Say why fields were not planned.  Those skipped only because
+         *  an earlier one failed are not worth a message each.
+         */
+        for (i = 0; i < seg->numFields ; ++i) {
+            const tdFbatchField *field = &seg->fields[i];
+            if ((field->status == STATUS__OK)||
+                (field->status == TDFDELTA__BATCHSKIP))
+                continue;
+            MsgOut(status,"%s field %u not planned - %s",queue->names[s],
+                   i+1,(field->error[0] ? field->error :
+                                          DitsErrorText(field->status)));
+        }
+    }
+    ArgPuti(id,"numMoves",(long)moves,status);
+    ArgPuti(id,"numParks",(long)parks,status);
+    ArgPutd(id,"robotTime",robotTime,status);
+    ArgPuti(id,"numPlanned",(long)planned,status);
+    ArgPuti(id,"numFields",(long)queue->numFields,status);
+    if (*status != STATUS__OK) {
+        StatusType ignore = STATUS__OK;
+        ErsRep(0,status,"Error creating the %s result - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        if (id) {
+            SdsDelete(id,&ignore);
+            SdsFreeId(id,&ignore);
+        }
+        return;
+    }
+    DitsPutArgument(id,DITS_ARG_DELETE,status);
+    if (planned < queue->numFields)
+        MsgOut(status,"%lu of %u fields planned",planned,queue->numFields);
+}
+
+/*
+ *  Return the MATRIX results - for each segment, two dimensional arrays
+ *  indexed [from][to].
+ */
+static void PutMatrix(
+        tdFqueue    *queue,
+        StatusType  *status)
+{
+    SdsIdType     id = 0;
+    unsigned long failed = 0;
+    unsigned      s, i;
+
+    if (*status != STATUS__OK) return;
+
+    SdsNew(0,"MatrixResult",0,NULL,SDS_STRUCT,0,NULL,&id,status);
+    for (s = 0; s < queue->batch.numSegs ; ++s) {
+        const tdFmatrix *matrix = &queue->matrices[s];
+        unsigned long n = matrix->numFields*matrix->numFields;
+        unsigned long dims[2];
+        SdsIdType     segId = 0, mId = 0, pId = 0, tId = 0, xId = 0;
+        INT32         *m, *p, *x;
+        double        *t;
+
+        dims[0] = dims[1] = (matrix->numFields ? matrix->numFields : 1);
+        if (n == 0) n = 1;
+        SdsNew(id,queue->names[s],0,NULL,SDS_STRUCT,0,NULL,&segId,status);
+        SdsNew(segId,"numMoves",0,NULL,SDS_INT,2,dims,&mId,status);
+        SdsNew(segId,"numParks",0,NULL,SDS_INT,2,dims,&pId,status);
+        SdsNew(segId,"robotTime",0,NULL,SDS_DOUBLE,2,dims,&tId,status);
+        SdsNew(segId,"exact",0,NULL,SDS_INT,2,dims,&xId,status);
+
+        m = (INT32 *)calloc(n,sizeof(INT32));
+        p = (INT32 *)calloc(n,sizeof(INT32));
+        x = (INT32 *)calloc(n,sizeof(INT32));
+        t = (double *)calloc(n,sizeof(double));
+        if ((!m)||(!p)||(!x)||(!t)) {
+            if (*status == STATUS__OK) *status = TDFDELTA__MALLOCERR;
+        } else {
+            for (i = 0; i < matrix->numFields*matrix->numFields ; ++i) {
+                const tdFestimate *cost = &matrix->cost[i];
+                if (cost->status != STATUS__OK) {
+                    m[i] = p[i] = -1;
+                    t[i] = -1.0;
+                    ++failed;
+                    continue;
+                }
+                m[i] = (INT32)cost->numMoves;
+                p[i] = (INT32)cost->numParks;
+                x[i] = (INT32)cost->exact;
+                t[i] = cost->robotTime;
+            }
+            SdsPut(mId,sizeof(INT32)*n,0,(void *)m,status);
+            SdsPut(pId,sizeof(INT32)*n,0,(void *)p,status);
+            SdsPut(xId,sizeof(INT32)*n,0,(void *)x,status);
+            SdsPut(tId,sizeof(double)*n,0,(void *)t,status);
+        }
+        free(m);
+        free(p);
+        free(x);
+        free(t);
+        if (mId) SdsFreeId(mId,status);
+        if (pId) SdsFreeId(pId,status);
+        if (tId) SdsFreeId(tId,status);
+        if (xId) SdsFreeId(xId,status);
+        if (segId) SdsFreeId(segId,status);
+    }
+    if (*status != STATUS__OK) {
+        StatusType ignore = STATUS__OK;
+        ErsRep(0,status,"Error creating the %s result - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        if (id) {
+            SdsDelete(id,&ignore);
+            SdsFreeId(id,&ignore);
+        }
+        return;
+    }
+    DitsPutArgument(id,DITS_ARG_DELETE,status);
+    if (failed)
+        MsgOut(status,"%lu costs could not be estimated (given as -1)",
+               failed);
+}
+
+
+/*
+ *  Start either action.
+ */
+static void Start(
+        int         matrix,
+        StatusType  *status)
+{
+    tdFqueue   *queue;
+    short      check;
+    unsigned   i, n;
+    DitsDeltaTimeType delay;
+
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaFlagCheck(DitsGetArgument(),
+                      _DEBUG | DISPLAY | CHECK_FULL_FIELD | NO_FIELD_CHECK |
+                      NO_ORDER_CHECK | SPECIAL,
+                      &check,
+                      status);
+    if ((queue = NewQueue(check,matrix,status)) == NULL)
+        return;
+
+    n = (matrix ? TDFDELTA_BATCH_THREADS : queue->batch.numSegs);
+    if (n > TDFDELTA_BATCH_THREADS) n = TDFDELTA_BATCH_THREADS;
+    for (i = 0; i < n ; ++i) {
+        if (!tdFdeltaFpilNew(&queue->insts[i])) {
+            *status = TDFDELTA__THREADERR;
+            ErsRep(0,status,"Failed to create the batch instrument models");
+            FreeQueue(queue);
+            return;
+        }
+        queue->batch.numInsts = i+1;
+    }
+    queue->batch.insts = queue->insts;
+    if (matrix) {
+        for (i = 0; i < queue->batch.numSegs ; ++i) {
+            queue->matrices[i].insts = queue->insts;
+            queue->matrices[i].numInsts = queue->batch.numInsts;
+        }
+    }
+
+    if (pthread_create(&queue->thread,0,QueueMain,queue) != 0) {
+        *status = TDFDELTA__THREADERR;
+        ErsRep(0,status,"Failed to create the batch thread");
+        FreeQueue(queue);
+        return;
+    }
+    if (check & SHOW)
+        MsgOut(status,"%s %u fields of %u segments...",
+               (matrix ? "Costing" : "Planning"),
+               queue->numFields,queue->batch.numSegs);
+
+    SdpPutf("DELTA_PROG",0.0,status);
+    DitsPutActData(queue,status);
+    DitsPutKickHandler(tdFdeltaQueueKick,status);
+    DitsPutHandler(tdFdeltaQueuePoll,status);
+    DitsDeltaTime(0,POLL_MS*1000,&delay);
+    DitsPutDelay(&delay,status);
+    DitsPutRequest(DITS_REQ_WAIT,status);
+}
+
+
+/*+        T D F D E L T A Q U E U E
+
+ *  Function name:
+      tdFdeltaQueue, tdFdeltaQueueMatrix
+
+ *  Function:
+      The BATCH and MATRIX action handlers.
+
+ *  Description:
+      Converts the arguments, see above, creates an instrument
+      description for each thread and starts the batch thread.  The
+      action is then rescheduled to poll it every POLL_MS milliseconds.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaQueue (status)
+      (void) = tdFdeltaQueueMatrix (status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Add tdFdeltaQueueMatrix(), both using Start().
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaQueue (
+        StatusType  *status)
+{
+    Start(0,status);
+}
+
+TDFDELTA_INTERNAL void  tdFdeltaQueueMatrix (
+        StatusType  *status)
+{
+    Start(1,status);
+}
+
+/*
+ *  Internal Function, name:
+      tdFdeltaQueuePoll
+
+ *  Description:
+      Action handler checking on the batch thread.  Publishes progress
+      and, once the batch or matrices are complete, returns the
+      results.
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaQueuePoll (
+        StatusType  *status)
+{
+    tdFqueue *queue = DitsGetActData();
+    unsigned fieldsDone;
+    float    progress;
+    int      done;
+    DitsDeltaTimeType delay;
+
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaLock();
+    fieldsDone = queue->batch.fieldsDone;
+    if (queue->matrices) {
+        unsigned s;
+        for (s = 0; s < queue->batch.numSegs ; ++s)
+            fieldsDone += queue->matrices[s].rowsDone;
+    }
+    done = queue->done;
+    tdFdeltaUnlock();
+
+    progress = (queue->numFields ?
+                (float)fieldsDone/(float)queue->numFields : 1.0);
+    if (progress != queue->lastProgress) {
+        queue->lastProgress = progress;
+        SdpPutf("DELTA_PROG",progress,status);
+    }
+    if (!done) {
+        DitsDeltaTime(0,POLL_MS*1000,&delay);
+        DitsPutDelay(&delay,status);
+        DitsPutRequest(DITS_REQ_WAIT,status);
+        return;
+    }
+    pthread_join(queue->thread,0);
+
+    if (TDFDELTA_LOAD(&queue->batch.cancel)) {
+        MsgOut(status,"%s action terminated",tdFdeltaActionName());
+    } else if (queue->status != STATUS__OK) {
+        *status = queue->status;
+        ErsRep(0,status,"Error planning the %s - %s",tdFdeltaActionName(),
+               DitsErrorText(*status));
+    } else if (queue->matrices) {
+        PutMatrix(queue,status);
+    } else {
+        PutResult(queue,status);
+    }
+    FreeQueue(queue);
+}
+
+/*
+ *  Internal Function, name:
+      tdFdeltaQueueKick
+
+ *  Description:
+      Kick handler whilst the batch runs.  Asks it to stop, the poll
+      handler ends the action once it has.
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaQueueKick (
+        StatusType  *status)
+{
+    tdFqueue *queue = DitsGetActData();
+    unsigned s;
+    TDFDELTA_STORE(&queue->batch.cancel, 1);
+    if (queue->matrices) {
+        for (s = 0; s < queue->batch.numSegs ; ++s)
+            TDFDELTA_STORE(&queue->matrices[s].cancel, 1);
+    }
+}
@@ -0,0 +1,625 @@
+/*+                T D F D E L T A
+
+ *  Module name:
+      tdFdeltaReplan
+
+ *  Function:
+      Generate a command file to complete a partially executed command file.
+
+ *  Description:
+      If a configuration is interrupted (a fault, a fibre which fails to
+      place, a pivot found to be broken), we would otherwise have to rerun
+      the GENERATE action from scratch.  This module implements the REPLAN
+      action, which instead takes the original command file and the number
+      of the last line which was completed.  The interim field is rebuilt
+      by replaying the completed lines against the field the original
+      command file was generated from, updating the crossover lists as we
+      go, rather than recomputing the crossover details from a new
+      `above' array.
+
+      If no fibres are reported as failed, the remaining lines of the
+      original command file are still valid and are simply written to
+      a new command file.  Otherwise the remaining targets are checked
+      against the failed fibres (see tdFdeltaFieldCheckFailed()) and
+      the sequencer is run from the interim field, with the failed
+      fibres left where they are.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  The command file is written through the planning
+                        core's output callbacks.
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
+      19-Oct-2026  AGT  Check the remaining targets against failed
+                        fibres before sequencing.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelReplan.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelReplan.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "DitsTypes.h"       /* Basic dits types            */
+#include "Dits_Err.h"        /* Dits error codes            */
+#include "DitsSys.h"         /* For PutActionHandlers       */
+#include "DitsFix.h"         /* For various Dits routines   */
+#include "DitsMsgOut.h"      /* For MsgOut                  */
+#include "DitsUtil.h"        /* For DitsErrorText           */
+#include "arg.h"             /* For ARG_ macros             */
+#include "sds.h"             /* For SDS_ macros             */
+#include "Sdp.h"             /* Sdp routines                */
+#include "Git.h"             /* Git routines                */
+#include "Git_Err.h"         /* GIT__ codes                 */
+#include "Ers.h"
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdelta.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+
+/*
+ *  Release the action data.  Also ends any trace.
+ */
+static void FreeData(
+    tdFdeltaType        * const data)
+{
+    StatusType ignore = STATUS__OK;
+    tdFdeltaTraceDone(data,&ignore);
+    tdFdeltaFreeActData(data);
+}
+
+/*
+ *  Get the optional "failed" argument - an array of the numbers of the
+ *  pivots which have failed.
+ */
+static void GetFailed(
+    SdsIdType           argId,
+    const unsigned      numPivots,
+    short               * const failed,
+    unsigned            * const numFailed,
+    StatusType          * const status)
+{
+    SdsIdType      id;
+    SdsCodeType    code;
+    char           name[20];
+    long           ndims;
+    unsigned long  dims[7];
+    unsigned long  actlen;
+    short          pivs[FPIL_MAXPIVOTS];
+    unsigned long  i;
+
+    *numFailed = 0;
+    if (*status != STATUS__OK) return;
+
+    SdsFind(argId,"failed",&id,status);
+    if (*status == SDS__NOITEM) {
+        *status = STATUS__OK;
+        return;
+    }
+    SdsInfo(id,name,&code,&ndims,dims,status);
+    if (*status != STATUS__OK) return;
+    if ((code != SDS_SHORT)||(ndims > 1)||
+        ((ndims == 1)&&(dims[0] > FPIL_MAXPIVOTS))) {
+        *status = TDFDELTA__INVARG;
+        ErsRep(0,status,
+               "\"failed\" argument must be a short array of at most %d pivots",
+               FPIL_MAXPIVOTS);
+        SdsFreeId(id,status);
+        return;
+    }
+    if (ndims == 0) dims[0] = 1;
+    SdsGet(id,sizeof(short)*dims[0],0,pivs,&actlen,status);
+    SdsFreeId(id,status);
+    if (*status != STATUS__OK) return;
+
+    for (i = 0; i < dims[0] ; ++i) {
+        if ((pivs[i] < 1)||((unsigned)pivs[i] > numPivots)) {
+            *status = TDFDELTA__OUTOFRANGE;
+            ErsRep(0,status,"Failed pivot number %d is out of range",pivs[i]);
+            return;
+        }
+        if (!failed[pivs[i]-1]) {
+            failed[pivs[i]-1] = YES;
+            (*numFailed)++;
+        }
+    }
+}
+
+/*
+ *  Check the command file was generated from the current field we were
+ *  given.
+ */
+static void CheckCmdFile(
+    SdsIdType           cmdFileId,
+    const unsigned      numPivots,
+    const tdFinterim    * const current,
+    StatusType          * const status)
+{
+    SdsIdType      id;
+    INT32          xf[FPIL_MAXPIVOTS];
+    INT32          yf[FPIL_MAXPIVOTS];
+    unsigned long  actlen;
+    unsigned       i;
+
+    if (*status != STATUS__OK) return;
+
+    ArgFind(cmdFileId,"xf",&id,status);
+    SdsGet(id,sizeof(INT32)*numPivots,0,xf,&actlen,status);
+    SdsFreeId(id,status);
+    ArgFind(cmdFileId,"yf",&id,status);
+    SdsGet(id,sizeof(INT32)*numPivots,0,yf,&actlen,status);
+    SdsFreeId(id,status);
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error reading command file field details - %s",
+               DitsErrorText(*status));
+        return;
+    }
+    for (i = 0; i < numPivots ; ++i) {
+        if ((xf[i] != current->xf[i])||(yf[i] != current->yf[i])) {
+            *status = TDFDELTA__CF_MISMATCH;
+            ErsRep(0,status,
+                   "Pivot %d is at %ld,%ld in the command file, but %ld,%ld in the current field",
+                   i+1, (long)xf[i], (long)yf[i],
+                   (long)current->xf[i], (long)current->yf[i]);
+            return;
+        }
+    }
+}
+
+/*
+ *  Replay a completed move.  This is equivalent to the interim field
+ *  update done by the sequencers when they record a move.
+ */
+static void ReplayMove(
+    const tdFcmdLine    * const line,
+    const unsigned      numPivots,
+    tdFinterim          * const current,
+    tdFtarget           * const target,
+    const tdFconstants  * const constants,
+    tdFcrosses          * const crosses,
+    StatusType          * const status)
+{
+    unsigned piv;
+    double cosT,sinT;
+
+    if (*status != STATUS__OK) return;
+
+    if ((line->piv < 1)||((unsigned)line->piv > numPivots)) {
+        *status = TDFDELTA__OUTOFRANGE;
+        ErsRep(0,status,"Command file pivot number %d is out of range",
+               line->piv);
+        return;
+    }
+    piv = line->piv - 1;
+    if ((line->xf != target->xf[piv])||(line->yf != target->yf[piv])) {
+        *status = TDFDELTA__CF_MISMATCH;
+        ErsRep(0,status,
+               "Command file moves pivot %d to %ld,%ld, but the target is %ld,%ld",
+               piv+1, (long)line->xf, (long)line->yf,
+               (long)target->xf[piv], (long)target->yf[piv]);
+        return;
+    }
+
+    current->theta[piv]       = target->theta[piv];
+    current->fibreLength[piv] = target->fibreLength[piv];
+    current->fvpX[piv]        = target->fvpX[piv];
+    current->fvpY[piv]        = target->fvpY[piv];
+    current->xf[piv]          = target->xf[piv];
+    current->yf[piv]          = target->yf[piv];
+    current->park[piv]        = target->park[piv];
+    target->mustMove[piv]     = NO;
+
+    cosT = cos(target->theta[piv]);
+    sinT = sin(target->theta[piv]);
+
+    current->xb[piv] = target->xf[piv] -
+        ((double)constants->graspX[piv]*cosT -
+         (double)constants->graspY[piv]*sinT);
+    current->yb[piv] = target->yf[piv] -
+        ((double)constants->graspX[piv]*cosT +
+         (double)constants->graspY[piv]*sinT);
+
+    tdFdeltaCrossesMoved(piv, 0, constants, current, crosses, status);
+}
+
+/*
+ *  Replay a completed park.
+ */
+static void ReplayPark(
+    const tdFcmdLine    * const line,
+    const unsigned      numPivots,
+    tdFinterim          * const current,
+    tdFtarget           * const target,
+    const tdFconstants  * const constants,
+    tdFcrosses          * const crosses,
+    StatusType          * const status)
+{
+    unsigned piv;
+
+    if (*status != STATUS__OK) return;
+
+    if ((line->piv < 1)||((unsigned)line->piv > numPivots)) {
+        *status = TDFDELTA__OUTOFRANGE;
+        ErsRep(0,status,"Command file pivot number %d is out of range",
+               line->piv);
+        return;
+    }
+    piv = line->piv - 1;
+
+    /*
+     *  If the target is not the park position, the fibre must now be
+     *  moved back onto the plate.
+     */
+    target->mustMove[piv] = (target->park[piv] == YES) ? NO : YES;
+
+    current->theta[piv]       = constants->tPark[piv];
+    current->fibreLength[piv] = 0;
+    current->fvpX[piv]        = constants->xPark[piv];
+    current->fvpY[piv]        = constants->yPark[piv];
+    current->park[piv]        = YES;
+    current->xf[piv] = current->xb[piv] = constants->xPark[piv];
+    current->yf[piv] = current->yb[piv] = constants->yPark[piv];
+
+    tdFdeltaCrossesParked(piv, current, crosses, status);
+}
+
+/*
+ *  No fibres have failed, so the remainder of the original command file
+ *  is still valid.  Write it out to the new command file, along with the
+ *  interim field details.
+ */
+static void WriteRemaining(
+    tdFdeltaType        * const data,
+    const SdsIdType     oldCmdFileId,
+    const long          lastLine,
+    const long          parksDone,
+    StatusType          * const status)
+{
+    tdFcmdLine  line;
+    unsigned    lineNumber = 1;
+    unsigned    numMoves = 0;
+    unsigned    numParks = 0;
+    long        springOutParks = 0;
+    long        l;
+
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaConvertCrossesToSds(&data->current,&data->crosses,
+                                tdFdeltaAbove(data),status);
+    tdFdeltaCFnew(data->name,&data->current,status);
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error opening new command file - %s",
+               DitsErrorText(*status));
+        return;
+    }
+
+    for (l = lastLine+1;
+         tdFdeltaCFgetCmd(oldCmdFileId,l,&line,status); ++l) {
+        if (strcmp(line.cmd,"MF") == 0) {
+            tdFdeltaCFaddCmd(status,lineNumber++,"MF",
+                             line.piv,line.xf,line.yf,line.theta);
+            ++numMoves;
+        } else if (strcmp(line.cmd,"PF") == 0) {
+            tdFdeltaCFaddCmd(status,lineNumber++,"PF",line.piv);
+            ++numParks;
+        } else {
+            tdFdeltaCFaddCmd(status,lineNumber++,line.cmd,
+                             line.comment);
+        }
+    }
+    tdFdeltaCFaddMoves((long int)numMoves,(long int)numParks,status);
+
+    /*
+     *  The spring out parks are always done first.
+     */
+    if (data->check & SPECIAL) {
+        ArgGeti(oldCmdFileId,"springOutParks",&springOutParks,status);
+        springOutParks -= parksDone;
+        if (springOutParks < 0) springOutParks = 0;
+        tdFdeltaCFaddSpringOutParks(springOutParks,status);
+    }
+    if (*status != STATUS__OK) {
+        tdFdeltaCFdelete();
+        return;
+    }
+
+    MsgOut(status,"Command file generated - %s (%d %s, %d %s remaining)",
+           data->name,
+           numMoves, numMoves == 1?  "move": "moves",
+           numParks, numParks == 1?  "park": "parks");
+
+    tdFdeltaCFdone(status);
+}
+
+
+/*+        T D F D E L T A R E P L A N
+
+ *  Function name:
+      tdFdeltaReplan
+
+ *  Action:  REPLAN  maxFibExt maxButAngG maxPivAngG maxButAngO maxPivAngO
+                     butClearG fibClearG butClearO fibClearO
+                     tdFtarget tdFconstants tdFoffsets tdFfiducials
+                     tdFcurrent cmdFile lastLine name [extSpringOut]
+                     [failed] [flag]
+
+ *  Parameters:
+      maxFibExt...tdFfiducials
+                   -            - As per the GENERATE action.  These must
+                                  be the values used to generate cmdFile.
+      tdFcurrent   - SDS_STRUCT - The current field details used to
+                                  generate cmdFile.
+      cmdFile      - SDS_STRUCT - The command file being executed.
+      lastLine     - SDS_INT    - The number of the last line of cmdFile
+                                  which was completed.  Zero if none.
+      name         - ARG_STRING - Name of the command file to be generated.
+      [extSpringOut] - SDS_INT    As per GENERATE, only needed if SPECIAL
+                                  flag is supplied.
+      [failed]     - SDS_SHORT  - Named argument only.  An array of the
+                                  numbers of the pivots which have failed
+                                  and must not be moved again.
+      [flag]       - ARG_STRING - DISPLAY
+                                - DEBUG
+                                - NO_ORDER_CHECK
+                                - SPECIAL (for 6dF)
+                                - TRACE
+                                - PACKED
+                                - STREAM
+
+ *  Description:
+      Rebuilds the interim field at the point the command file was
+      interrupted by replaying lines 1 to lastLine against tdFcurrent,
+      and generates a new command file which completes the configuration
+      from there.
+
+      If no fibres are reported as failed, the new command file contains
+      the remaining lines of cmdFile, renumbered from one.  Otherwise, the
+      failed fibres are left where they are in the interim field (their
+      target becomes their interim position) and the sequencer is run
+      to generate a new order.  First, the targets still to be reached
+      are checked for collisions with the failed fibres.  Any that
+      collide can no longer be reached, they are reported and the
+      action fails with TDFDELTA__INVFIELD.  The other target field
+      validity checks are not repeated.
+
+      The cmdFile may be packed (see tdFdelDrama.c).  With the PACKED
+      flag, so is the new command file.  With the STREAM flag, its lines
+      are sent as they come, as for GENERATE.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaReplan (status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Support TRACE flag.
+      18-Oct-2026  AGT  Use tdFdeltaFreeActData(), the above item is
+                        held by the output callbacks.
+      18-Oct-2026  AGT  No longer rejected whilst a worker thread runs.
+      18-Oct-2026  AGT  Support packed command files and PACKED flag.
+      18-Oct-2026  AGT  Support STREAM flag.
+      19-Oct-2026  AGT  Release the current field and command file ids on
+                        every error return.
+      19-Oct-2026  AGT  Check the remaining targets against the failed
+                        fibres and report those which can't be reached.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaReplan (
+        StatusType  *status)
+{
+    tdFdeltaType  *data;                   /* Will contain all action parameters   */
+    SdsIdType     curId = 0;               /* SDS structure identifiers            */
+    SdsIdType     cmdFileId = 0;
+    SdsIdType     aboveId = 0;             /* Original field above item            */
+    StatusType    ignore = STATUS__OK;     /* Releasing ids on error paths         */
+    char          name[FILENAME_LENGTH];   /* Name of command file to be generated */
+    long int      extSpringOut = 0;
+    long int      lastLine;
+    long int      l;
+    long int      parksDone = 0;
+    unsigned      numPivots;
+    unsigned      numFailed;
+    unsigned      numBlocked;
+    unsigned      i;
+    short         blocked[FPIL_MAXPIVOTS]; /* Targets which can't be reached   */
+    int           index;
+    short         check;
+    tdFcmdLine    line;
+    double        tStart;
+
+    if (*status != STATUS__OK) return;
+
+    /*
+     *  Get action arguments.
+     */
+    tdFdeltaFlagCheck(DitsGetArgument(),
+                      _DEBUG | DISPLAY | NO_ORDER_CHECK | SPECIAL | TRACE |
+                      PACKED | STREAM,
+                      &check,
+                      status);
+
+    GitArgNamePos(DitsGetArgument(),"tdFcurrent",14,&curId,status);
+    GitArgNamePos(DitsGetArgument(),"cmdFile",15,&cmdFileId,status);
+    GitArgGetI(DitsGetArgument(),"lastLine",16,0,0,GIT_M_ARG_KEEPERR,
+               &lastLine,status);
+    GitArgGetS(DitsGetArgument(),"name",17,0,0,GIT_M_ARG_KEEPERR,
+               sizeof(name),name,&index,status);
+    if (check & SPECIAL) {
+        GitArgGetI(DitsGetArgument(),"extSpringOut",18,0,0,
+                   GIT_M_ARG_KEEPERR,&extSpringOut,status);
+    }
+    if ((*status == STATUS__OK)&&(lastLine < 0)) {
+        *status = TDFDELTA__OUTOFRANGE;
+        ErsRep(0,status,"lastLine argument must not be negative");
+    }
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error getting %s argument(s) - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        if (curId) SdsFreeId(curId,&ignore);
+        if (cmdFileId) SdsFreeId(cmdFileId,&ignore);
+        return;
+    }
+
+    /*
+     *  Create parameter structure and convert the current field.
+     */
+    if ((data = tdFdeltaNewActData(check,status)) == NULL) {
+        SdsFreeId(curId,&ignore);
+        SdsFreeId(cmdFileId,&ignore);
+        return;
+    }
+    tdFdeltaUse(data);
+    data->extSpringOut = extSpringOut;
+    if (ErsSPrintf(sizeof(data->name),data->name,"%s",name) == EOF) {
+        *status = TDFDELTA__SPRINTF;
+        SdsFreeId(curId,&ignore);
+        SdsFreeId(cmdFileId,&ignore);
+        tdFdeltaFreeActData(data);
+        return;
+    }
+    if (check & TRACE)
+        tdFdeltaTraceStart(data,status);
+    tStart = tdFdeltaClock();
+    tdFdeltaConvertCurToC(curId,&data->current,&data->crosses,
+                          &aboveId,check,status);
+    tdFdeltaStatsPhase(TDF_PHASE_CONVERT, tStart);
+    /*
+     *  The above item describes the original field, not the interim one.
+     */
+    if (aboveId) {
+        SdsDelete(aboveId,&ignore);
+        SdsFreeId(aboveId,&ignore);
+    }
+    if (*status != STATUS__OK) {
+        SdsFreeId(cmdFileId,&ignore);
+        FreeData(data);
+        return;
+    }
+
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    GetFailed(DitsGetArgument(),numPivots,data->failed,&numFailed,status);
+    CheckCmdFile(cmdFileId,numPivots,&data->current,status);
+
+    /*
+     *  Replay the completed lines.
+     */
+    for (l = 1; (l <= lastLine)&&(*status == STATUS__OK); ++l) {
+        if (!tdFdeltaCFgetCmd(cmdFileId,l,&line,status)) {
+            if (*status == STATUS__OK) {
+                *status = TDFDELTA__OUTOFRANGE;
+                ErsRep(0,status,"Command file has only %ld lines",l-1);
+            }
+        } else if (strcmp(line.cmd,"MF") == 0) {
+            ReplayMove(&line,numPivots,&data->current,&data->target,
+                       &data->constants,&data->crosses,status);
+        } else if (strcmp(line.cmd,"PF") == 0) {
+            ReplayPark(&line,numPivots,&data->current,&data->target,
+                       &data->constants,&data->crosses,status);
+            ++parksDone;
+        }
+    }
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error replaying command file - %s",
+               DitsErrorText(*status));
+        SdsFreeId(cmdFileId,&ignore);
+        FreeData(data);
+        return;
+    }
+    if (check & SHOW)
+        MsgOut(status,"Replayed %ld command file lines, %u failed %s",
+               lastLine, numFailed, numFailed == 1 ? "fibre" : "fibres");
+
+    /*
+     *  If nothing failed, the rest of the original plan stands.
+     */
+    if (numFailed == 0) {
+        WriteRemaining(data,cmdFileId,lastLine,parksDone,status);
+        SdsFreeId(cmdFileId,&ignore);
+        tdFdeltaPutStats(&data->stats,status);
+        FreeData(data);
+        return;
+    }
+    SdsFreeId(cmdFileId,status);
+
+    /*
+     *  Leave the failed fibres where they are and sequence the remainder
+     *  from the interim field.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        if (!data->failed[i]) continue;
+        data->target.theta[i]       = data->current.theta[i];
+        data->target.fibreLength[i] = data->current.fibreLength[i];
+        data->target.fvpX[i]        = data->current.fvpX[i];
+        data->target.fvpY[i]        = data->current.fvpY[i];
+        data->target.xf[i]          = data->current.xf[i];
+        data->target.yf[i]          = data->current.yf[i];
+        data->target.park[i]        = data->current.park[i];
+        data->target.mustMove[i]    = NO;
+    }
+
+    /*
+     *  The remaining targets may collide with the failed fibres, so check
+     *  them before sequencing.
+     */
+    numBlocked = tdFdeltaFieldCheckFailed(data,blocked,status);
+    if ((*status == STATUS__OK)&&(numBlocked > 0)) {
+        for (i = 0; i < numPivots ; ++i) {
+            if (blocked[i])
+                MsgOut(status,
+                       "WARNING:Target of pivot %d can no longer be reached, it collides with a failed fibre",
+                       i+1);
+        }
+        *status = TDFDELTA__INVFIELD;
+        ErsRep(0,status,
+               "%d %s can no longer be reached due to the failed fibres - see scrolling message area for details.",
+               numBlocked, numBlocked == 1 ? "target" : "targets");
+    }
+    if (*status != STATUS__OK) {
+        FreeData(data);
+        return;
+    }
+
+    tdFdeltaConvertCrossesToSds(&data->current,&data->crosses,
+                                tdFdeltaAbove(data),status);
+    if (*status != STATUS__OK) {
+        FreeData(data);
+        return;
+    }
+
+    DitsPutActData(data,status);
+    if (check & SPECIAL)
+        DitsPutHandler(tdFdeltaSequencerSpecial,status);
+    else
+        DitsPutHandler(tdFdeltaSequencer,status);
+    DitsPutRequest(DITS_REQ_STAGE,status);
+}
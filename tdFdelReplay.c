@@ -0,0 +1,154 @@
+/*+               T D F D E L T A
+
+ *  Module name:
+      tdFreplay
+
+ *  Function:
+      Re-run the planner on a GENERATE input snapshot.
+
+ *  Description:
+      Loads a snapshot written by the GENERATE action (see tdFdelSnap.c)
+      and runs the field check and sequencer on it, outside the task.  The
+      instrument model is initialised to match the snapshot.  Messages
+      and errors are written to stdout and stderr, the command file (as
+      "<item> <line>" pairs) to the file named by the second argument,
+      which defaults to "<name>.replay" where <name> is the original
+      command file name.  The time taken and the planner statistics
+      (as per DELTA_STATS) are then written to stdout.
+
+      The flags the snapshot was taken with apply, except THREAD and
+      SNAPSHOT.  If TRACE was given, a trace is written as per the task.
+
+      Usage:
+
+          tdFreplay <snapshot> [<output>]
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Use tdFdeltaDataFree().
+      18-Oct-2026  AGT  The trace is held with the plan.
+      {@change entry@}
+
+ *  @(#) $Id: ACMM:2dFdelta/tdFdelReplay.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
+ */
+
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelReplay.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "Ers.h"
+#include "status.h"             /* STATUS__OK definition          */
+
+#include "tdFdelta.h"           /* TDFDLETA def'ns and structs    */
+#include "tdFdelta_Err.h"       /* TDFDLETA Errors                */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ *  Initialise the instrument the snapshot was taken with.  Returns
+ *  false if we don't support it.
+ */
+static int InitInstrument(
+        const char  *instName,
+        int         numPivots)
+{
+    int sixdf;
+    for (sixdf = 0; sixdf <= 1 ; ++sixdf) {
+        if (!tdFdeltaFpilInit(sixdf))
+            continue;
+        if ((strcmp(FpilGetInstName(tdFdeltaFpilInst()), instName) == 0)&&
+            ((int)FpilGetNumPivots(tdFdeltaFpilInst()) == numPivots))
+            return 1;
+        FpilFree(tdFdeltaFpilInst());
+    }
+    return 0;
+}
+
+/*
+ *  Output the statistics.
+ */
+static void PrintStats(
+        const tdFstats  *stats)
+{
+    int i;
+    for (i = 0; i < TDF_NUM_PHASES ; ++i) {
+        if (stats->phase[i].count == 0) continue;
+        printf("  %-16s %8lu  %12.3f ms\n", tdFdeltaStatsPhaseName(i),
+               stats->phase[i].count, stats->phase[i].ns/1.0e6);
+    }
+    printf("  colButBut    %10lu\n", stats->colButBut);
+    printf("  colButFib    %10lu\n", stats->colButFib);
+    printf("  colFibFib    %10lu\n", stats->colFibFib);
+    printf("  crossAdds    %10lu\n", stats->crossAdds);
+    printf("  crossDeletes %10lu\n", stats->crossDeletes);
+}
+
+int main(
+        int   argc,
+        char  *argv[])
+{
+    StatusType    status = STATUS__OK;
+    tdFdeltaType  *data;
+    tdFstats      stats;
+    char          instName[32];
+    char          outName[FILENAME_LENGTH+10];
+    int           numPivots;
+    FILE          *out;
+    double        tStart;
+
+    if ((argc < 2)||(argc > 3)) {
+        fprintf(stderr, "Usage: %s <snapshot> [<output>]\n", argv[0]);
+        return 2;
+    }
+
+    if ((data = tdFdeltaSnapLoad(argv[1], sizeof(instName), instName,
+                                 &numPivots, &status)) == NULL) {
+        ErsFlush(&status);
+        return 1;
+    }
+    if (!InitInstrument(instName, numPivots)) {
+        fprintf(stderr, "%s: snapshot is for %s with %d pivots, which is not supported\n",
+                argv[0], instName, numPivots);
+        tdFdeltaDataFree(data);
+        return 1;
+    }
+
+    if (argc == 3)
+        strcpy(outName, argv[2]);
+    else
+        sprintf(outName, "%s.replay", data->name);
+    if ((out = fopen(outName, "w")) == NULL) {
+        fprintf(stderr, "%s: failed to open %s\n", argv[0], outName);
+        tdFdeltaDataFree(data);
+        FpilFree(tdFdeltaFpilInst());
+        return 1;
+    }
+
+    data->check &= ~THREAD;
+    if (data->check & TRACE)
+        tdFdeltaTraceStart(data, &status);
+
+    memset(&stats, 0, sizeof(stats));
+    tStart = tdFdeltaClock();
+    tdFdeltaThreadRunHere(data, out, &stats, &status);
+    printf("Replayed %s in %.3f ms, status %s\n", argv[1],
+           (tdFdeltaClock() - tStart)*1.0e3,
+           (status == STATUS__OK ? "ok" : "bad"));
+    PrintStats(&stats);
+
+    fclose(out);
+    FpilFree(tdFdeltaFpilInst());
+    return (status == STATUS__OK ? 0 : 1);
+}
@@ -0,0 +1,222 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaRobot
+
+ *  Function:
+      Estimate how long the robot will take to execute a plan.
+
+ *  Description:
+      A simple model of the positioner, for scheduling rather than
+      control.  The gripper starts at the field centre.  For each move
+      (MF) it travels to the button, picks it up, carries it to the new
+      position and puts it down.  A park (PF) is the same, with the park
+      position as the destination.  Each axis of the gantry moves at
+      TDFDELTA_ROBOT_SPEED at the same time, so a travel takes the
+      larger of the x and y distances over the speed, and each pick up
+      or put down takes TDFDELTA_ROBOT_GRASP seconds.  Acceleration,
+      theta rotation and the grasp offsets are ignored.
+
+      The model follows the fibre ends, starting from the current field
+      given to tdFdeltaRobotStart(), and is then given each move and park
+      in the order they are made, either directly or as command file
+      lines (see tdFdeltaRobotLine()).
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelRobot.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelRobot.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ *  Travel of the gripper to a position.
+ */
+static void Travel(
+        tdFrobot  *robot,
+        INT32     x,
+        INT32     y)
+{
+    double dx = (double)x - (double)robot->x;
+    double dy = (double)y - (double)robot->y;
+    if (dx < 0) dx = -dx;
+    if (dy < 0) dy = -dy;
+    robot->time += (dx > dy ? dx : dy)/TDFDELTA_ROBOT_SPEED;
+    robot->x = x;
+    robot->y = y;
+}
+
+
+/*+        T D F D E L T A R O B O T
+
+ *  Function name:
+      tdFdeltaRobotStart
+
+ *  Function:
+      Start estimating the robot time of a plan.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaRobotStart (robot, cur, con)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (<) robot       (tdFrobot *)           The model.
+      (>) cur         (const tdFinterim *)   The field the plan starts
+                                             from.
+      (>) con         (const tdFconstants *) The field constants, for the
+                                             park positions.  Must remain
+                                             until the model is finished
+                                             with.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaRobotStart (
+        tdFrobot            *robot,
+        const tdFinterim    *cur,
+        const tdFconstants  *con)
+{
+    robot->time = 0.0;
+    robot->x = 0;
+    robot->y = 0;
+    robot->con = con;
+    memcpy(robot->xf, cur->xf, sizeof(robot->xf));
+    memcpy(robot->yf, cur->yf, sizeof(robot->yf));
+}
+
+
+/*+        T D F D E L T A R O B O T
+
+ *  Function name:
+      tdFdeltaRobotMove, tdFdeltaRobotPark
+
+ *  Function:
+      Add a move or a park to the robot time.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaRobotMove (robot, piv, x, y)
+      (void) = tdFdeltaRobotPark (robot, piv)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) robot       (tdFrobot *)      The model.
+      (>) piv         (unsigned)        The pivot index, from 0.
+      (>) x, y        (INT32)           The new fibre end position.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaRobotMove (
+        tdFrobot  *robot,
+        unsigned  piv,
+        INT32     x,
+        INT32     y)
+{
+    if (piv >= FPIL_MAXPIVOTS) return;
+    Travel(robot, robot->xf[piv], robot->yf[piv]);
+    Travel(robot, x, y);
+    robot->time += 2*TDFDELTA_ROBOT_GRASP;
+    robot->xf[piv] = x;
+    robot->yf[piv] = y;
+}
+
+TDFDELTA_INTERNAL void  tdFdeltaRobotPark (
+        tdFrobot  *robot,
+        unsigned  piv)
+{
+    if (piv >= FPIL_MAXPIVOTS) return;
+    tdFdeltaRobotMove(robot, piv, robot->con->xPark[piv],
+                      robot->con->yPark[piv]);
+}
+
+
+/*+        T D F D E L T A R O B O T
+
+ *  Function name:
+      tdFdeltaRobotLine
+
+ *  Function:
+      Add a command file line to the robot time.
+
+ *  Description:
+      MF and PF lines, as output by tdFdeltaCFaddCmd(), are passed on to
+      tdFdeltaRobotMove() and tdFdeltaRobotPark().  Comments are ignored.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaRobotLine (robot, line)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) robot       (tdFrobot *)      The model.
+      (>) line        (const char *)    The command file line.
+
+ *  Returned value:
+      1 for a move, 2 for a park, otherwise 0.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaRobotLine (
+        tdFrobot    *robot,
+        const char  *line)
+{
+    int  piv;
+    long x, y;
+
+    if ((line[0] == 'M')&&(line[1] == 'F')&&
+        (sscanf(line+2, "%d %ld %ld", &piv, &x, &y) == 3)&&(piv > 0)) {
+        tdFdeltaRobotMove(robot, (unsigned)piv-1, (INT32)x, (INT32)y);
+        return 1;
+    }
+    if ((line[0] == 'P')&&(line[1] == 'F')&&
+        (sscanf(line+2, "%d", &piv) == 1)&&(piv > 0)) {
+        tdFdeltaRobotPark(robot, (unsigned)piv-1);
+        return 2;
+    }
+    return 0;
+}
@@ -31,6 +31,17 @@
                         Drop   tdFdelta___DirectField().  Note needed.
                          
 
+      18-Oct-2026  AGT  Collision checks through tdFdelGeom.c (INT_GEOM flag).
+      18-Oct-2026  AGT  Pivot count and ParkMayCollide from
+                        tdFdeltaNumPivots() and tdFdeltaParkMayCollide(),
+                        constant in a single instrument build.
+      18-Oct-2026  AGT  Check the final crossover lists.
+      18-Oct-2026  AGT  The target checks of tdFdelta___DeltaDirectMove()
+                        moved to tdFdeltaTargetBlocked(), for the
+                        estimates of tdFdelEstimate.c.
+      19-Oct-2026  AGT  Document the plan data argument of the sequencer.
+      19-Oct-2026  AGT  Collision checks call FPIL directly again,
+                        tdFdelGeom.c removed.
       {@change entry@}
 
  *  @(#) $Id: ACMM:2dFdelta/tdFdelSeq.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $
@@ -45,24 +56,9 @@ static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelSeq.c,v 3.17 25-Aug-2014 14:38
 static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
 
 
-#include "DitsTypes.h"       /* Basic dits types            */
-#include "Dits_Err.h"        /* Dits error codes            */
-#include "DitsSys.h"         /* For PutActionHandlers       */
-#include "DitsFix.h"         /* For various Dits routines   */
-#include "DitsMsgOut.h"      /* For MsgOut                  */
-#include "DitsUtil.h"        /* For DitsErrorText           */
-#include "DitsParam.h"       /* For DitsGetParId            */
-#include "DitsPeek.h"        /* For DitsPeek                */
-#include "Dmon.h"            /* To DmonCommand              */
-#include "arg.h"             /* For ARG_ macros             */
-#include "sds.h"             /* For SDS_ macros             */
-#include "Sdp.h"             /* Sdp routines                */
-#include "mess.h"            /* For MessPutFacility         */
-#include "Git.h"             /* Git routines                */
-#include "Git_Err.h"         /* GIT__ codes                 */
-#include "Ers.h"
-
-#include "tdFdelta.h"
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
 #include "tdFdelta_Err.h"
 
 #include <stdio.h>
@@ -75,8 +71,6 @@ static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
  */
 #define MAX_PARKS  1      /* Maximum number of times a button can be returned to its.. */
                           /* ..park position during a single field configuration       */
-#define SCALE      0.25   /* Used when calculating the DELTA_CONFIG parameter value..  */
-                          /* ..in an attempt to make progress v time linear            */
 
 
 /*
@@ -93,14 +87,14 @@ static void checkMoveOk(
     if (iField->nAbove[piv] != 0)
     {
         *status = TDFDELTA__CROSSESERR;
-        ErsRep(0, status, "Last chance cross check triggered");
-        ErsRep(0, status, "Attempt to move fibre %d when crossed %d times", 
+        tdFdeltaErsRep(0, status, "Last chance cross check triggered");
+        tdFdeltaErsRep(0, status, "Attempt to move fibre %d when crossed %d times", 
                piv+1, iField->nAbove[piv]);
         if (iCrosses->above[piv])
-            ErsRep(0, status, "First crossing fibre = %d",
+            tdFdeltaErsRep(0, status, "First crossing fibre = %d",
                    iCrosses->above[piv]->piv+1);
         else
-            ErsRep(0, status, "Inconsist cross list");
+            tdFdeltaErsRep(0, status, "Inconsist cross list");
     }
 }
 
@@ -115,6 +109,8 @@ static void checkMoveOk(
 
  *  History:
       09-Apr-2003 TJF   Original version
+      18-Oct-2026 AGT   Skip pairs known to be clear from the last plan
+                        (see tdFdelWarm.c).
       {@change entry@}
  */
 
@@ -244,7 +240,7 @@ TDFDELTA_PRIVATE int  tdFdelta___CheckFibresUnder (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
 
     /* 
      * We can only have crosses below at this point - otherwise we
@@ -272,6 +268,13 @@ TDFDELTA_PRIVATE int  tdFdelta___CheckFibresUnder (
         int flag;
         if (piv == pIndex) continue;
         if ((iField->park[pIndex] == YES)&&(!parkMayCollide)) continue;
+        if (tdFdeltaWarmSkip(piv, pIndex, iField->park[pIndex],
+                             iField->xf[pIndex], iField->yf[pIndex],
+                             iField->theta[pIndex],
+                             iField->fvpX[pIndex], iField->fvpY[pIndex]))
+            continue;
+
+        TDFDELTA_STAT(colFibFib);
 
         flag = FpilColFibFib (tdFdeltaFpilInst(),
                               (double)con->xPiv[piv],
@@ -336,6 +339,8 @@ TDFDELTA_PRIVATE int  tdFdelta___CheckFibresUnder (
         if (piv == pIndex) continue;
         if ((iField->park[pIndex] == YES)&&(!parkMayCollide)) continue;
 
+        TDFDELTA_STAT(colFibFib);
+
         flag = FpilColFibFib (tdFdeltaFpilInst(),
                               (double)con->xPiv[piv],
                               (double)con->yPiv[piv],
@@ -368,6 +373,173 @@ TDFDELTA_PRIVATE int  tdFdelta___CheckFibresUnder (
 
 
 
+/*+        T D F D E L T A S E Q U E N C E R
+
+ *  Function name:
+      tdFdeltaTargetBlocked
+
+ *  Function:
+      Does one fibre prevent another from being placed at its target.
+
+ *  Description:
+      Does otherPiv, at its interim position, prevent piv from being placed
+      at its target position.  The button/fibre, button/button and fibre
+      crossing checks of tdFdelta___DeltaDirectMove(), with the instrument
+      of the current plan (see tdFdeltaUse()).
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaTargetBlocked (iField, tField, con, butClearG,
+                          butClearO, fibClearG, fibClearO, piv, otherPiv)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) iField      (const tdFinterim *)   The interim field.
+      (>) tField      (const tdFtarget *)    The target field.
+      (>) con         (const tdFconstants *) The field constants.
+      (>) butClearG, butClearO, fibClearG, fibClearO (long int)
+                                             The clearances.
+      (>) piv         (unsigned)             The pivot to be placed.
+      (>) otherPiv    (unsigned)             The pivot which may be in
+                                             the way.
+
+ *  Returned value:
+      YES if otherPiv is in the way, otherwise NO.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, from
+                        tdFdelta___DeltaDirectMove().
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaTargetBlocked (
+    const tdFinterim    * const iField,
+    const tdFtarget     * const tField,
+    const tdFconstants  * const con,
+    const long int      butClearG,
+    const long int      butClearO,
+    const long int      fibClearG,
+    const long int      fibClearO,
+    const unsigned      piv,
+    const unsigned      otherPiv)
+{
+    double    pivotDist;                /* Dist between 2 pivot points      */
+    long int  fibreClear, buttonClear;  /* Clearances used during colision 
+                                           detection  */
+    int       flag;                     /* Returned value from collision 
+                                           functions    */
+
+    /*
+     *  Calculate distance between two pivot points and the offsets.
+     */
+    pivotDist = SQRD((double)(con->xPiv[piv] - con->xPiv[otherPiv])) +
+                SQRD((double)(con->yPiv[piv] - con->yPiv[otherPiv]));
+    pivotDist = sqrt(pivotDist);
+
+    /*
+     *  Check if piv(target) and otherPiv(interim) could collide.
+     */
+    if ((tField->fibreLength[piv] + iField->fibreLength[otherPiv]) 
+        > pivotDist) {
+
+        /*
+         *  Pairs known to be clear from the last plan need no check.
+         */
+        if (tdFdeltaWarmSkip(piv, otherPiv, iField->park[otherPiv],
+                             iField->xf[otherPiv], iField->yf[otherPiv],
+                             iField->theta[otherPiv],
+                             iField->fvpX[otherPiv],
+                             iField->fvpY[otherPiv]))
+            return NO;
+
+        /*
+         *  Will the fibre of otherPiv preventing piv from being placed 
+         *  in its target position?
+         */
+        fibreClear = (con->type[otherPiv] == GUIDE)?  fibClearG: fibClearO;
+
+        FpilSetFibClear(tdFdeltaFpilInst(), fibreClear);
+        TDFDELTA_STAT(colButFib);
+        flag = FpilColButFib (
+                              tdFdeltaFpilInst(),
+                              (double)tField->xf[piv] /*- graspXt*/,
+                              (double)tField->yf[piv] /*- graspYt*/,
+                              tField->theta[piv],
+                              (double)iField->fvpX[otherPiv],
+                              (double)iField->fvpY[otherPiv],
+                              (double)con->xPiv[otherPiv],
+                              (double)con->yPiv[otherPiv]);
+
+
+        if (flag > 0) return YES;
+
+        /*
+         *  Will the button of otherPiv prevent piv from being placed 
+         *  in its target position?
+         */
+        buttonClear = ((con->type[piv] == GUIDE) ||
+                       (con->type[otherPiv] == GUIDE))?  butClearG: butClearO;
+        FpilSetButClear(tdFdeltaFpilInst(), buttonClear);
+
+        TDFDELTA_STAT(colButBut);
+
+        flag = FpilColButBut (
+                              tdFdeltaFpilInst(),
+                              (double)tField->xf[piv] /*- graspXt*/,
+                              (double)tField->yf[piv] /*- graspYt*/,
+                              tField->theta[piv],
+                              (double)iField->xf[otherPiv],
+                              (double)iField->yf[otherPiv],
+                              iField->theta[otherPiv]);
+
+
+        if (flag > 0) return YES;
+
+        /*
+         *  Will the fibre of piv cross above a fibre that is not yet 
+         *  moved?
+         */
+        TDFDELTA_STAT(colFibFib);
+        flag = FpilColFibFib (
+                              tdFdeltaFpilInst(),
+                              (double)con->xPiv[piv],
+                              (double)con->yPiv[piv],
+                              (double)tField->fvpX[piv],
+                              (double)tField->fvpY[piv],
+                              (double)con->xPiv[otherPiv],
+                              (double)con->yPiv[otherPiv],
+                              (double)iField->fvpX[otherPiv],
+                              (double)iField->fvpY[otherPiv]);
+
+        if (flag > 0) return YES;
+
+        /*
+         *  Will the fibre of piv collide with another button?
+         */
+        fibreClear = (con->type[piv] == GUIDE)?  fibClearG: fibClearO;
+        FpilSetFibClear(tdFdeltaFpilInst(), fibreClear);
+        TDFDELTA_STAT(colButFib);
+        flag = FpilColButFib (
+                              tdFdeltaFpilInst(),
+                              (double)iField->xf[otherPiv],
+                              (double)iField->yf[otherPiv],
+                              iField->theta[otherPiv],
+                              (double)tField->fvpX[piv],
+                              (double)tField->fvpY[piv],
+                              (double)con->xPiv[piv],
+                              (double)con->yPiv[piv]);
+
+
+        if (flag > 0) return YES;
+    }
+    return NO;
+}
+
+
 /*
  *  Internal Function, name:
       tdFdelta___DeltaDirectMove
@@ -447,6 +619,10 @@ TDFDELTA_PRIVATE int  tdFdelta___CheckFibresUnder (
                          500 microns, the guide fibres are closer to zero).
       25-Aug-2014  TJF   If we are parking (can park can't collide) then clearly
                           we can move directly to the park position, and should.
+      18-Oct-2026  AGT  Skip pairs known to be clear from the last plan
+                          (see tdFdelWarm.c).
+      18-Oct-2026  AGT  Pair checks moved to tdFdeltaTargetBlocked(), for
+                          the estimates.
 
       {@change entry@}
  */
@@ -462,15 +638,10 @@ TDFDELTA_PRIVATE int  tdFdelta___DeltaDirectMove (
     const int           piv,
     StatusType          * const status)
 {
-    double    pivotDist,                /* Dist between 2 pivot points      */
-              graspXt DUNUSED, graspYt DUNUSED; /* X and Y rotated grasp values,
+    double    graspXt DUNUSED, graspYt DUNUSED; /* X and Y rotated grasp values,
                                            target      */
-    long int  fibreClear, buttonClear;  /* Clearances used during colision 
-                                           detection  */
     unsigned  otherPiv;                 /* Pivot that piv is being checked 
                                            against    */
-    int       flag;                     /* Returned value from collision 
-                                           functions    */
     double    cosT DUNUSED, sinT DUNUSED ;/* Sine and Cosine of theta */
     unsigned  numPivots;                /* Number of pivots */
     int ParkMayCollide;                 /* Can fibres collided with parked 
@@ -482,12 +653,12 @@ TDFDELTA_PRIVATE int  tdFdelta___DeltaDirectMove (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
     /*
      * We need to determine if we have to check for collisions against
      * parked fibres.
      */
-    ParkMayCollide = FpilParkMayCollide(tdFdeltaFpilInst());
+    ParkMayCollide = tdFdeltaParkMayCollide(tdFdeltaFpilInst());
     ParkMayCollide = 0;   /* Override since we can't correctly
                              handle it and the 6dF bend angles have
 	                     be modified to prevent it */
@@ -499,7 +670,7 @@ TDFDELTA_PRIVATE int  tdFdelta___DeltaDirectMove (
             return (iCrosses->above[piv]->piv);
         else {
             *status = TDFDELTA__CROSSESERR;
-            ErsRep(0, status, "Crossover list error - fibre %d should have %d fibres acrossing above, but list is empty",
+            tdFdeltaErsRep(0, status, "Crossover list error - fibre %d should have %d fibres acrossing above, but list is empty",
 		   piv+1, iField->nAbove[piv]);
             return (0);
         }
@@ -550,93 +721,11 @@ TDFDELTA_PRIVATE int  tdFdelta___DeltaDirectMove (
         if (tField->mustMove[otherPiv] == NO) continue;
 
         /*
-         *  Calculate distance between two pivot points and the offsets.
-         */
-        pivotDist = SQRD((double)(con->xPiv[piv] - con->xPiv[otherPiv])) +
-                    SQRD((double)(con->yPiv[piv] - con->yPiv[otherPiv]));
-        pivotDist = sqrt(pivotDist);
-
-        /*
-         *  Check if piv(target) and otherPiv(interim) could collide.
+         *  Is otherPiv in the way?
          */
-        if ((tField->fibreLength[piv] + iField->fibreLength[otherPiv]) 
-            > pivotDist) {
-
-            /*
-             *  Will the fibre of otherPiv preventing piv from being placed 
-             *  in its target position?
-             */
-            fibreClear = (con->type[otherPiv] == GUIDE)?  fibClearG: fibClearO;
-
-            FpilSetFibClear(tdFdeltaFpilInst(), fibreClear);
-            flag = FpilColButFib (
-                                  tdFdeltaFpilInst(),
-                                  (double)tField->xf[piv] /*- graspXt*/,
-                                  (double)tField->yf[piv] /*- graspYt*/,
-                                  tField->theta[piv],
-                                  (double)iField->fvpX[otherPiv],
-                                  (double)iField->fvpY[otherPiv],
-                                  (double)con->xPiv[otherPiv],
-                                  (double)con->yPiv[otherPiv]);
-
-
-            if (flag > 0) return (otherPiv+1);
-
-            /*
-             *  Will the button of otherPiv prevent piv from being placed 
-             *  in its target position?
-             */
-            buttonClear = ((con->type[piv] == GUIDE) ||
-                           (con->type[otherPiv] == GUIDE))?  butClearG: butClearO;
-            FpilSetButClear(tdFdeltaFpilInst(), buttonClear);
-
-            flag = FpilColButBut (
-                                  tdFdeltaFpilInst(),
-                                  (double)tField->xf[piv] /*- graspXt*/,
-                                  (double)tField->yf[piv] /*- graspYt*/,
-                                  tField->theta[piv],
-                                  (double)iField->xf[otherPiv],
-                                  (double)iField->yf[otherPiv],
-                                  iField->theta[otherPiv]);
-
-
-            if (flag > 0) return (otherPiv+1);
-
-            /*
-             *  Will the fibre of piv cross above a fibre that is not yet 
-             *  moved?
-             */
-            flag = FpilColFibFib (
-                                  tdFdeltaFpilInst(),
-                                  (double)con->xPiv[piv],
-                                  (double)con->yPiv[piv],
-                                  (double)tField->fvpX[piv],
-                                  (double)tField->fvpY[piv],
-                                  (double)con->xPiv[otherPiv],
-                                  (double)con->yPiv[otherPiv],
-                                  (double)iField->fvpX[otherPiv],
-                                  (double)iField->fvpY[otherPiv]);
-
-            if (flag > 0) return (otherPiv+1);
-
-            /*
-             *  Will the fibre of piv collide with another button?
-             */
-            fibreClear = (con->type[piv] == GUIDE)?  fibClearG: fibClearO;
-            FpilSetFibClear(tdFdeltaFpilInst(), fibreClear);
-            flag = FpilColButFib (
-                                  tdFdeltaFpilInst(),
-                                  (double)iField->xf[otherPiv],
-                                  (double)iField->yf[otherPiv],
-                                  iField->theta[otherPiv],
-                                  (double)tField->fvpX[piv],
-                                  (double)tField->fvpY[piv],
-                                  (double)con->xPiv[piv],
-                                  (double)con->yPiv[piv]);
-
-
-            if (flag > 0) return (otherPiv+1);
-        }
+        if (tdFdeltaTargetBlocked(iField, tField, con, butClearG, butClearO,
+                          fibClearG, fibClearO, piv, otherPiv))
+            return (otherPiv+1);
     }
     /*
      * If we cross other fibres (after moving), then it is required that 
@@ -702,7 +791,7 @@ TDFDELTA_PRIVATE int  tdFdelta___DeltaChoosePark (
     /*
      *  Get the number of pivots in this instrument
      */
-    numPivots = FpilGetNumPivots(tdFdeltaFpilInst());
+    numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
 
     /*
      *  Initialise altNumMovesPrevented.
@@ -844,19 +933,33 @@ TDFDELTA_PRIVATE int  tdFdelta___DeltaChoosePark (
       configuration to the target field configuration.
 
  *  Description:
+      So that the task remains responsive to kicks and parameter monitors
+      on large fields, this runs in time slices of about TDFDELTA_SLICE_MS
+      milliseconds, rescheduling itself with DITS_REQ_STAGE.  The state is
+      kept in the seq item of the action data between slices.
+
+      The sequencing itself is in the planning core, as
+      tdFdeltaSequencerStart(), tdFdeltaSequencerSlice() and
+      tdFdeltaSequencerCancel() (or tdFdeltaSequencerRun() to run to
+      completion).  tdFdeltaSequencer() is the DRAMA action handler
+      calling these and is in tdFdelDrama.c.
 
  *  Language:
       C
 
  *  Call:
-      (void) = tdFdeltaSequencer (status)
+      (void) = tdFdeltaSequencerRun (data, cancel, status)
 
  *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (>) cancel      (volatile int *)  Cancel flag, may be null.
       (!) status      (StatusType *)    Modified status.
 
  *  Proir Requirements:
-      DitsGetActData() must return a pointer to a structure of type tdFdeltaType (see
-      tdFdelta.h for structure details).
+      data must have been created by tdFdeltaDataNew() (or by
+      tdFdeltaNewActData() in the task) and have passed
+      tdFdeltaFieldCheckRun().  tdFdeltaUse(data) must have been called
+      in this thread since any other plan was worked on.
 
  *  Support: James Wilcox, AAO
 
@@ -906,42 +1009,41 @@ TDFDELTA_PRIVATE int  tdFdelta___DeltaChoosePark (
       18-Mar-2008  TJF  Fix memory leak due to cross over lists not being cleaned up.
       20-Aug-2009  TJF  SearchForMove() numMoves argument was signed when
                           it should have been unsigned.  Fixed.
+      18-Oct-2026  AGT  Crossover list updates now done by
+                          tdFdeltaCrossesMoved() and tdFdeltaCrossesParked().
+                          Refuse to park fibres reported as failed by REPLAN.
+      18-Oct-2026  AGT  Run in time slices of TDFDELTA_SLICE_MS, rescheduling
+                          with DITS_REQ_STAGE between them.  All sequencer
+                          state now lives in data->seq.  Cancellation by
+                          kick is checked at the start of each slice.
+      18-Oct-2026  AGT  DisplayProgress() replaced by tdFdeltaProgress(),
+                          which estimates progress from the measured time
+                          per pivot rather than the SCALE heuristic.
+      18-Oct-2026  AGT  Count collision checks and time search passes and
+                          park choices for DELTA_STATS.
+      18-Oct-2026  AGT  Trace move verdicts and park choices.
+      18-Oct-2026  AGT  Release the input snapshot on completion.
+      18-Oct-2026  AGT  Add tdFdeltaSequencerRun() for the worker thread.
+                          The command file is released with tdFdeltaCFdone()
+                          or tdFdeltaCFdelete().
+      18-Oct-2026  AGT  Moved to the planning core.  The action handler
+                          moves to tdFdelDrama.c, the action data is no
+                          longer released here.
+      18-Oct-2026  AGT  Use and update the warm start pair matrix.  Finish
+                          a search pass cut short by the end of a slice
+                          before parking, so the result does not depend on
+                          where the slices end.
+      18-Oct-2026  AGT  Check the crossover lists at the end of sequencing
+                          (tdFdeltaCrossesCheck()).
       {@change entry@}
  */
 
 
-/*
- *  Function to update the progress parameter.
- */
-static void DisplayProgress(
-    const unsigned numMoves,
-    const unsigned numParks,
-    const unsigned pivotsLeft,
-    float * const lastUpdate,
-    StatusType *status)
-{
-    float progress;
-    if (*status != STATUS__OK) return;
-    /*
-     *  Set the DELTA_PROG parameter - this indicates the progress of the
-     *  ordering process.
-     */
-    progress = 100.0*(float)(numMoves+numParks)/
-        ((float)(numMoves+numParks)+((float)pivotsLeft*SCALE));
-    if (((*lastUpdate) - progress > RESOLUTION) ||
-        (progress - (*lastUpdate) > RESOLUTION) ||
-        (progress == 100.0)) {
-        (*lastUpdate) = progress;
-        SdpPutf("DELTA_PROG",progress,status);
-    }
-}
-
 /*
  *  Invoke if we find we can move a fibre directly to it's desired location.
  */
 static void CanMoveDirect(
     const unsigned      curPivot,
-    const SdsIdType     cmdFileId,
     const unsigned      numPivots,
     tdFinterim          * const current,
     tdFtarget           * const target,
@@ -954,14 +1056,12 @@ static void CanMoveDirect(
     unsigned            * const numMoves,
     short               * const numUnParkedNotMovedLeft,
     int                 * const pivotsMoved,
-    float               * const lastUpdate,
+    tdFprogress         * const progress,
     short               alreadyParked[],
     short               alreadyMoved[],
     StatusType          * const status)
 {
     double cosT,sinT;
-    unsigned j;
-    FibreCross *ptmp;
     int ParkMayCollide;
 
     /*
@@ -975,7 +1075,7 @@ static void CanMoveDirect(
      * We need to determine if we have to check for collisions against
      * parked fibres.
      */
-    ParkMayCollide = FpilParkMayCollide(tdFdeltaFpilInst());
+    ParkMayCollide = tdFdeltaParkMayCollide(tdFdeltaFpilInst());
     ParkMayCollide = 0;   /* Override since we can't correctly
                              handle it and the 6dF bend angles have
 	                     be modified to prevent it */
@@ -1027,56 +1127,9 @@ static void CanMoveDirect(
 
     /*
      *  Update crossover lists.
-     *
-     *  In order to save some time, take advantage of a couple of our
-     *  rules, namely -
-     *    - As a fibre can only be moved if there is no fibre crossing
-     *      above it, and it can not be placed under another button,
-     *      the crossover.above list for the button being moved is
-     *      unchanged.
-     *    - Any fibre/fibre collisions that will occur must result in
-     *      the fibre being moved crossing above them (a fibre can
-     *      not be placed under abother button), therefore these
-     *      fibres must be added to the crossover.below list for the
-     *      moved fibre, with the old crossover.below list being
-     *      deleted.
      */
-    ptmp = crosses->below[curPivot];
-    while (ptmp) {
-        tdFdeltaDeleteCross(curPivot+1,
-                            &crosses->above[(ptmp->piv)-1],
-                            status);
-        current->nAbove[(ptmp->piv)-1]--;
-        tdFdeltaDeleteCross(ptmp->piv,
-                            &ptmp,
-                            status);
-    }
-    crosses->below[curPivot] = NULL;
-    current->nBelow[curPivot] = 0;
-    for (j=0; j < numPivots; j++) {
-        int flag;
-        if (curPivot == j) continue;
-        if ((current->park[j] == YES)&&(!ParkMayCollide)) continue;
-        flag = FpilColFibFib (
-            tdFdeltaFpilInst(),
-            (double)constants->xPiv[curPivot],
-            (double)constants->yPiv[curPivot],
-            (double)current->fvpX[curPivot],
-            (double)current->fvpY[curPivot],
-            (double)constants->xPiv[j],
-            (double)constants->yPiv[j],
-            (double)current->fvpX[j],
-            (double)current->fvpY[j]);
-
-
-
-        if (flag == YES) {
-            tdFdeltaAddCross(j+1,&crosses->below[curPivot],status);
-            tdFdeltaAddCross(curPivot+1,&crosses->above[j],status);
-            current->nAbove[j]++;
-            current->nBelow[curPivot]++;
-        }
-    }
+    tdFdeltaCrossesMoved(curPivot, ParkMayCollide, constants, current,
+                         crosses, status);
 
     /*
      *  Add move to command file.
@@ -1089,21 +1142,21 @@ static void CanMoveDirect(
         if (alreadyParked[curPivot])
         {
             *status = TDFDELTA__DELTAERR;
-            ErsRep(0,status,
+            tdFdeltaErsRep(0,status,
                    "Error generating command file - attempted to park fibre %d 2 times",
                curPivot+1);
-            ErsRep(0, status, "within:CanMoveDirect");
-            ErsRep(0, status, "Please use the \"2dfsave\" command from the terminal window to send details of this error to support");
-            ErsRep(0, status, 
+            tdFdeltaErsRep(0, status, "within:CanMoveDirect");
+            tdFdeltaErsRep(0, status, "Please use the \"2dfsave\" command from the terminal window to send details of this error to support");
+            tdFdeltaErsRep(0, status, 
                    "To get going again, first try parking fibres %d through %d (from engineering interface).", 
                    curPivot-20, curPivot+20);
-            ErsRep(0, status, "Then try field again.");
+            tdFdeltaErsRep(0, status, "Then try field again.");
             return;
             
         }
         ++alreadyParked[curPivot];
         tdFdeltaCFaddCmd (status,
-                          cmdFileId,(*lineNumber)++,
+                          (*lineNumber)++,
                           "PF",curPivot+1);
         (*numParks)++;
     } else {                             /* From plate */
@@ -1114,20 +1167,20 @@ static void CanMoveDirect(
         if (alreadyMoved[curPivot])
         {
             *status = TDFDELTA__DELTAERR;
-            ErsRep(0,status,
+            tdFdeltaErsRep(0,status,
                    "Error generating command file - attempted to move fibre %d 2 times",
                curPivot+1);
-            ErsRep(0, status, "Please use the \"2dfsave\" command from the terminal window to send details of this error to support");
-            ErsRep(0, status, 
+            tdFdeltaErsRep(0, status, "Please use the \"2dfsave\" command from the terminal window to send details of this error to support");
+            tdFdeltaErsRep(0, status, 
                    "To get going again, first try parking fibres %d through %d (from engineering interface).", 
                    curPivot-20, curPivot+20);
-            ErsRep(0, status, "Then try field again.");
+            tdFdeltaErsRep(0, status, "Then try field again.");
             return;
             
         }
         ++alreadyMoved[curPivot];
         tdFdeltaCFaddCmd (status,
-                          cmdFileId,(*lineNumber)++,
+                          (*lineNumber)++,
                           "MF",curPivot+1,
                           target->xf[curPivot],
                           target->yf[curPivot],
@@ -1139,11 +1192,10 @@ static void CanMoveDirect(
      *  Set the DELTA_PROG parameter - this indicates the progress of the
      *  ordering process.
      */
-    DisplayProgress(*numMoves, *numParks, *pivotsLeft, 
-                        lastUpdate, status);
+    tdFdeltaProgress(progress, *pivotsLeft, status);
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error updating interim field details - %s",
-               DitsErrorText(*status));
+        tdFdeltaErsRep(0,status,"Error updating interim field details - %s",
+               tdFdeltaErrorText(*status));
         return;
     }
 
@@ -1153,7 +1205,6 @@ static void CanMoveDirect(
  */
 static void CanPark_RecordMoveUpdate(
     const short         parkFibre,
-    const SdsIdType     cmdFileId,
     tdFinterim          * const current,
     tdFtarget           * const target,
     const tdFconstants  * const constants,
@@ -1167,8 +1218,6 @@ static void CanPark_RecordMoveUpdate(
     short               * const extraParks,
     StatusType          * const status)
 {
-    FibreCross *ptmp;
-
     /*
      * Last chance check
      */
@@ -1229,18 +1278,7 @@ static void CanPark_RecordMoveUpdate(
     /*
      *  Update crossover lists.
      */
-    ptmp = crosses->below[parkFibre];
-    while (ptmp) {
-        tdFdeltaDeleteCross(parkFibre+1,
-                            &crosses->above[(ptmp->piv)-1],
-                            status);
-        current->nAbove[(ptmp->piv)-1]--;
-        tdFdeltaDeleteCross(ptmp->piv,
-                            &ptmp,
-                            status);
-    }
-    crosses->below[parkFibre] = NULL;
-    current->nBelow[parkFibre]  = 0;
+    tdFdeltaCrossesParked(parkFibre, current, crosses, status);
 
     /*
      *  Add park to command file.
@@ -1250,7 +1288,7 @@ static void CanPark_RecordMoveUpdate(
         fprintf(stderr,"Park fibre %d (2)\n", parkFibre+1);
 #endif
     tdFdeltaCFaddCmd (status,
-                      cmdFileId,(*lineNumber)++,
+                      (*lineNumber)++,
                       "PF",parkFibre+1);
     (*numParks)++;
 
@@ -1262,7 +1300,6 @@ static void CanPark_RecordMoveUpdate(
  */
 static void CouldNotMove_MustPark(
     const unsigned int  numMoves,
-    const SdsIdType     cmdFileId,
     tdFinterim          * const current,
     tdFtarget           * const target,
     const tdFconstants  * const constants,
@@ -1272,9 +1309,10 @@ static void CouldNotMove_MustPark(
     unsigned            * const lineNumber,
     unsigned            * const numParks,
     short               * const numUnParkedNotMovedLeft,
-    float               * const lastUpdate,
+    tdFprogress         * const progress,
     short               alreadyParked[],
     short               numMovesPrevented[],
+    const short         failed[],
     short               * const extraParks,
     StatusType          * const status)
 {
@@ -1299,27 +1337,36 @@ static void CouldNotMove_MustPark(
 
     parkFibre--;  /* array index = piv#-1 */
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error choosig fibre to park - %s",
-               DitsErrorText(*status));
+        tdFdeltaErsRep(0,status,"Error choosig fibre to park - %s",
+               tdFdeltaErrorText(*status));
         return;
     } else if (alreadyParked[parkFibre] > MAX_PARKS) {
 #ifdef DEBUG_DELTA
         fprintf(stderr,"ERROR, %d already parked\n", parkFibre+1);
 #endif
         *status = TDFDELTA__DELTAERR;
-        ErsRep(0,status,
+        tdFdeltaErsRep(0,status,
           "Error generating command file - attempted to park fibre %d %d times",
                parkFibre+1, MAX_PARKS+1);
-        ErsRep(0, status, "Number of moves prevented by this fibre = %d",
+        tdFdeltaErsRep(0, status, "Number of moves prevented by this fibre = %d",
                numMovesPrevented[parkFibre]);
-        ErsRep(0, status, "Number of crosses = %d, %s",
+        tdFdeltaErsRep(0, status, "Number of crosses = %d, %s",
 	       current->nAbove[parkFibre], 
                (crosses->above ? "list exists": "list empty"));
-        ErsRep(0, status, "Please use the \"2dfsave\" command from the terminal window to send details of this error to support");
-        ErsRep(0, status, 
+        tdFdeltaErsRep(0, status, "Please use the \"2dfsave\" command from the terminal window to send details of this error to support");
+        tdFdeltaErsRep(0, status, 
                "To get going again, first try parking fibres %d through %d (from engineering interface).", 
                parkFibre-20, parkFibre+20);
-        ErsRep(0, status, "Then try field again.");
+        tdFdeltaErsRep(0, status, "Then try field again.");
+        return;
+    } else if (failed[parkFibre]) {
+        /*
+         *  A REPLAN has told us this fibre can't be moved.
+         */
+        *status = TDFDELTA__DELTAERR;
+        tdFdeltaErsRep(0,status,
+          "Error generating command file - fibre %d must be parked but has been reported as failed",
+               parkFibre+1);
         return;
     }
 
@@ -1327,8 +1374,9 @@ static void CouldNotMove_MustPark(
      *  Can park button - record move and update field details.
      */
     else {
+        TDFDELTA_TRACE(TDF_TRACE_PARK, parkFibre+1,
+                       numMovesPrevented[parkFibre], alreadyParked[parkFibre]);
         CanPark_RecordMoveUpdate(parkFibre,
-                                 cmdFileId,
                                  current,
                                  target,
                                  constants,
@@ -1342,23 +1390,24 @@ static void CouldNotMove_MustPark(
                                  extraParks,
                                  status);
 
-        DisplayProgress(numMoves, *numParks, *pivotsLeft, 
-                        lastUpdate, status);
+        tdFdeltaProgress(progress, *pivotsLeft, status);
         if (*status != STATUS__OK) {
-            ErsRep(0,status,
+            tdFdeltaErsRep(0,status,
                    "Error updating interim field details - %s",
-                   DitsErrorText(*status));
+                   tdFdeltaErrorText(*status));
             return;
         }           
     }
 }
 
 /*
- *  Search for a fibre to move.
+ *  Search for a fibre to move.  This pass may be spread over more than one
+ *  time slice, *searchIndex is the index of the next pivot to check, zero
+ *  at the start of a pass.  Returns 1 if the pass was completed, 0 if we
+ *  ran out of time (or on error).
  */
-static void SearchForMove(
+static int SearchForMove(
     const unsigned      numPivots,
-    const SdsIdType     cmdFileId,
     tdFdeltaType        * const data,
     unsigned            * const numMoves,
     int                 * const pivotsLeft,
@@ -1367,27 +1416,38 @@ static void SearchForMove(
     unsigned            * const lineNumber,
     unsigned            * const numParks,
     short               * const numUnParkedNotMovedLeft,
-    float               * const lastUpdate,
+    tdFprogress         * const progress,
     short               numMovesPrevented[],
     short               alreadyParked[],
     short               alreadyMoved[],
+    unsigned            * const searchIndex,
+    const double        deadline,
     StatusType          * const status)
 {
     register unsigned i;
-    if (*status != STATUS__OK) return;
+    if (*status != STATUS__OK) return 0;
     /*
      *  Reset the park candidate list and didMove flag.
      */
-    for (i=0; i< numPivots; i++) numMovesPrevented[i] = 0;
-    (*didMove) = NO;
+    if (*searchIndex == 0) {
+        for (i=0; i< numPivots; i++) numMovesPrevented[i] = 0;
+        (*didMove) = NO;
+    }
 
     /*
      *  Sequentially check each fibre to see if it can be moved directly
      *  to its target position.
      */
-    for (i=0; i< numPivots; i++) {
+    for (i=(*searchIndex); i< numPivots; i++) {
 
         short offendingPivot;
+        /*
+         *  Out of time?  We always check at least one pivot per slice.
+         */
+        if ((i > *searchIndex)&&(tdFdeltaClock() > deadline)) {
+            *searchIndex = i;
+            return 0;
+        }
         /*
          *  Only check fibres that need to be moved.
          */
@@ -1440,12 +1500,12 @@ static void SearchForMove(
                      (data->current.nAbove[i] > 0 ? "crossed" : "collision" ));
 #endif            
             numMovesPrevented[offendingPivot-1]++;  /* array index = piv#-1 */
+            TDFDELTA_TRACE(TDF_TRACE_BLOCKED, i+1, offendingPivot,
+                           data->current.nAbove[i] > 0);
         }
         else if (*status != STATUS__OK) {
-            SdsDelete (cmdFileId,status);
-            SdsFreeId (cmdFileId,status);
-            free((void *)data);
-            return;
+            tdFdeltaCFdelete();
+            return 0;
         }
 
         /*
@@ -1474,8 +1534,8 @@ static void SearchForMove(
                 continue;
             }
 
+            TDFDELTA_TRACE(TDF_TRACE_MOVE, i+1, 0, 0);
             CanMoveDirect(i,
-                          cmdFileId,
                           numPivots,
                           &data->current,
                           &data->target,
@@ -1488,20 +1548,20 @@ static void SearchForMove(
                           numMoves,
                           numUnParkedNotMovedLeft,
                           pivotsMoved,
-                          lastUpdate,
+                          progress,
                           alreadyParked,
                           alreadyMoved,
                           status);
 
             if (*status != STATUS__OK) {
-                SdsDelete (cmdFileId,status);
-                SdsFreeId (cmdFileId,status);
-                free((void *)data);
-                return;
+                tdFdeltaCFdelete();
+                return 0;
             }
 
         }
     }
+    *searchIndex = 0;
+    return 1;
 }
 
 /*
@@ -1510,17 +1570,9 @@ static void SearchForMove(
  */
 static int SequencerInit(
     tdFdeltaType        * const data,
-    unsigned            * const numPivots,
-    time_t              * const tStart,
-    float               * const lastUpdate,
-    SdsIdType           * const cmdFileId,
-    int                 * const pivotsLeft,
-    short               * const numUnParkedNotMovedLeft,
-    short               alreadyParked[],
-    short               numMovesPrevented[],
-    short               alreadyMoved[],
     StatusType * const status)
 {
+    tdFseqState * const seq = &data->seq;
     register unsigned i;
 
     if (*status != STATUS__OK) return(0);
@@ -1528,18 +1580,25 @@ static int SequencerInit(
     /*
      *  Get the number of pivots in this instrument
      */
-    (*numPivots) = FpilGetNumPivots(tdFdeltaFpilInst());
+    seq->numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
 
     /*
      *  Start timing and set parameters/variables.
      */
-    time(tStart);
-    *lastUpdate = 0.0;
-    SdpPutf("DELTA_PROG",0.0,status);
+    seq->tStart = tdFdeltaClock();
+    seq->pivotsLeft = 0;
+    seq->pivotsMoved = 0;
+    seq->didMove = YES;
+    seq->searchIndex = 0;
+    seq->lineNumber = 1;
+    seq->numMoves = 0;
+    seq->numParks = 0;
+    seq->extraParks = 0;
+    seq->numUnParkedNotMovedLeft = 0;
+    tdFdeltaPutProgress(0.0,0,status);
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error updating parameter - %s",
-               DitsErrorText(*status));
-        free((void *)data);
+        tdFdeltaErsRep(0,status,"Error updating parameter - %s",
+               tdFdeltaErrorText(*status));
         goto ERROR_RETURN;
     }
 
@@ -1547,14 +1606,15 @@ static int SequencerInit(
      *  Bypass checking if requested.
      */
     if (data->check & NO_DELTA) {
-        MsgOut(status,"Delta (ordering) process NOT performed");
+        tdFdeltaMsgOut(status,"Delta (ordering) process NOT performed");
         goto ERROR_RETURN;
     } else if (data->check & NO_ORDER_CHECK) {
         *status = TDFDELTA__INVARG;
-        ErsRep(0, status, "Delta no longer supports NO_ORDER_CHECK flag");
+        tdFdeltaErsRep(0, status, "Delta no longer supports NO_ORDER_CHECK flag");
         goto ERROR_RETURN;
     } else
-        MsgOut(status,"Performing delta (ordering) process...");
+        tdFdeltaMsgOut(status,"Performing delta (ordering) process...");
+    tdFdeltaWarmBegin(data);
 
     /*
      *  Open a new command file.
@@ -1563,20 +1623,19 @@ static int SequencerInit(
     fprintf(stderr,"\n**************************\n");
     fprintf(stderr,"Delta starting, command file name %s\n", data->name);
 #endif
-    (*cmdFileId) = tdFdeltaCFnew (data->name,&data->current,
-                                  &data->above,status);
+    tdFdeltaCFnew (data->name,&data->current,status);
     /*
      * Handle command file opening error.
      */
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error opening new command file - %s",
-               DitsErrorText(*status));
+        tdFdeltaErsRep(0,status,"Error opening new command file - %s",
+               tdFdeltaErrorText(*status));
         goto ERROR_RETURN;
     }
     /*
      *  Initialise parameters.
      */
-    for (i=0; i < (*numPivots); i++) {
+    for (i=0; i < seq->numPivots; i++) {
 #ifdef DEBUG_DELTA
         fprintf(stderr, "Pivot %.3d, mustMove=%s, currentlyParked=%s",
                 i+1,
@@ -1607,68 +1666,58 @@ static int SequencerInit(
 #endif
         if (data->target.mustMove[i] == YES) {
             if (data->current.park[i] == NO)
-                (*numUnParkedNotMovedLeft)++;
-            (*pivotsLeft)++;
+                seq->numUnParkedNotMovedLeft++;
+            seq->pivotsLeft++;
         }
-        numMovesPrevented[i] = 0;
-        alreadyParked[i] = 0;
-        alreadyMoved[i] = 0;
+        seq->numMovesPrevented[i] = 0;
+        seq->alreadyParked[i] = 0;
+        seq->alreadyMoved[i] = 0;
     }
+    tdFdeltaProgInit(&seq->progress, seq->pivotsLeft);
+    seq->started = YES;
     return (1);
 
  ERROR_RETURN:
-    /*
-     * This is used to ensure the data structure is freeed correctly
-     * when we return with an error.
-     */
-    if (data->above)
-    {
-        StatusType ignore = STATUS__OK;
-        SdsDelete(data->above,&ignore);
-        SdsFreeId(data->above,&ignore);
-        data->above = 0;
-    }
-    free (data);
     return (0);
     
 }
 
-TDFDELTA_INTERNAL void  tdFdeltaSequencer (
-        StatusType  *status)
+/*
+ *  Check the crossover lists at the end of sequencing.  Parked fibres are
+ *  ignored, as they are when the lists are updated.
+ */
+static int FinalCrossesOk(
+        tdFdeltaType  *data,
+        StatusType    *status)
 {
-    tdFdeltaType  *data = DitsGetActData();/* Function parameters            */
-    SdsIdType     cmdFileId;        /* Command file Id (Sds structure id)    */
-    time_t        tStart, tEnd;     /* Used for timing this function         */
-    static float  lastUpdate;       /* DELTA_PROG at last update             */
-    int           pivotsLeft = 0,   /* Number of pivots left to move         */
-                  pivotsMoved = 0,  /* Number of pivots moved to target pos. */
-                  didMove = YES;    /* Flag indicating that fibre was moved  */
-    unsigned      lineNumber = 1,   /* Counters                              */
-                  numMoves = 0,     /* Final number of pivots to be moved    */
-                  numParks = 0;     /* Final number of pivots to be parked   */
-    short         extraParks = 0;  
-    /*
-     * This array holds for each fibre, the number of times it has
-     * prevented another fibre from being moved.
-     */
-
-    short numMovesPrevented[FPIL_MAXPIVOTS];
-
-    short alreadyMoved[FPIL_MAXPIVOTS];
-    short alreadyParked[FPIL_MAXPIVOTS];/*Flag each pivot when parked*/
-    short numUnParkedNotMovedLeft = 0; /* Number of un-parked pivots not 
-                                          moved  */
-    unsigned numPivots;                /* Number of pivots          */
+    double   tStart = tdFdeltaClock();
+    unsigned bad = tdFdeltaCrossesCheck("final", 0, &data->constants,
+                                        &data->current, &data->crosses,
+                                        status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_CROSS, tStart);
+    if ((bad)&&(*status == STATUS__OK)) {
+        *status = TDFDELTA__CROSSESERR;
+        tdFdeltaErsRep(0,status,
+               "Crossover lists after sequencing are INCONSISTENT - %d %s",
+               bad, (bad == 1 ? "ERROR" : "ERRORS"));
+    }
+    return (*status == STATUS__OK);
+}
 
-    if (*status != STATUS__OK) return;
+/*
+ *  Run one time slice of the sequencer.  Returns 1 if there is more work
+ *  to do.  Otherwise the sequence is complete (or failed).
+ */
+static int SequencerSlice(
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFseqState   *seq = &data->seq;/* Sequencer state, kept between slices */
+    double        deadline;         /* End of this time slice                */
+    double        elapsed;          /* Used for timing this function         */
+    double        tPhase;           /* Start of current phase                */
 
-    /*
-     * Initialise this function's variables etc.
-     */
-    if (!SequencerInit(data,&numPivots, &tStart, &lastUpdate, &cmdFileId,
-                       &pivotsLeft, &numUnParkedNotMovedLeft, alreadyParked,
-                       numMovesPrevented, alreadyMoved, status))
-        return;
+    deadline = tdFdeltaClock() + TDFDELTA_SLICE_MS/1000.0;
 
     /*
      *  Begin main loop.
@@ -1691,64 +1740,82 @@ TDFDELTA_INTERNAL void  tdFdeltaSequencer (
      *  this sequence can be minimised by choosing the optimum fibre to park 
      *  (and perhaps later by also optimising the gripper gantry movement 
      *  between pivot moves).
+     *
+     *  The loop runs for at most TDFDELTA_SLICE_MS milliseconds (give or
+     *  take one pivot check) before rescheduling the action, allowing
+     *  kicks and parameter monitors to be serviced.
      */
-    while (pivotsLeft) {
+    while (seq->pivotsLeft) {
 
+        if (tdFdeltaClock() > deadline)
+            return 1;
 #ifdef DEBUG_DELTA
     fprintf(stderr,"\n-------- N e x t    P a s s -----------------\n");
     fprintf(stderr,"Pivots Left = %d, didMove = %s, UPNM = %d EP = %d\n", 
-            pivotsLeft,
-            (didMove ? "YES" : "NO"), numUnParkedNotMovedLeft, extraParks);
+            seq->pivotsLeft,
+            (seq->didMove ? "YES" : "NO"), seq->numUnParkedNotMovedLeft,
+            seq->extraParks);
 #endif
         /*
          *  Search for pivot to move directly from current to target position.
+         *  A pass cut short by the end of the last slice is always finished,
+         *  even if it has not yet moved anything.
          */
-        if (didMove) {
-            SearchForMove(numPivots,
-                          cmdFileId,
-                          data,
-                          &numMoves,
-                          &pivotsLeft,
-                          &didMove,
-                          &pivotsMoved,
-                          &lineNumber,
-                          &numParks,
-                          &numUnParkedNotMovedLeft,
-                          &lastUpdate,
-                          numMovesPrevented,
-                          alreadyParked,
-                          alreadyMoved,
-                          status);
-            if (*status != STATUS__OK)
-                return;
+        if ((seq->didMove)||(seq->searchIndex)) {
+            int more;
+            tPhase = tdFdeltaClock();
+            more = SearchForMove(seq->numPivots,
+                                 data,
+                                 &seq->numMoves,
+                                 &seq->pivotsLeft,
+                                 &seq->didMove,
+                                 &seq->pivotsMoved,
+                                 &seq->lineNumber,
+                                 &seq->numParks,
+                                 &seq->numUnParkedNotMovedLeft,
+                                 &seq->progress,
+                                 seq->numMovesPrevented,
+                                 seq->alreadyParked,
+                                 seq->alreadyMoved,
+                                 &seq->searchIndex,
+                                 deadline,
+                                 status);
+            tdFdeltaStatsPhase(TDF_PHASE_SEARCH, tPhase);
+            if (!more) {
+                /*
+                 * Out of time part way through the pass, or an error (in
+                 * which case SearchForMove has released the data).
+                 */
+                return (*status == STATUS__OK);
+            }
          } /* didMove*/
         /*
          *  Could not move any fibre directly to target pos - must park a fibre.
          */
         else {
 
-            CouldNotMove_MustPark(numMoves,
-                                  cmdFileId,
+            tPhase = tdFdeltaClock();
+            CouldNotMove_MustPark(seq->numMoves,
                                   &data->current,
                                   &data->target,
                                   &data->constants,
                                   &data->crosses,
-                                  &pivotsLeft,
-                                  &didMove,
-                                  &lineNumber,
-                                  &numParks,
-                                  &numUnParkedNotMovedLeft,
-                                  &lastUpdate,
-                                  alreadyParked,
-                                  numMovesPrevented,
-                                  &extraParks,
+                                  &seq->pivotsLeft,
+                                  &seq->didMove,
+                                  &seq->lineNumber,
+                                  &seq->numParks,
+                                  &seq->numUnParkedNotMovedLeft,
+                                  &seq->progress,
+                                  seq->alreadyParked,
+                                  seq->numMovesPrevented,
+                                  data->failed,
+                                  &seq->extraParks,
                                   status);
+            tdFdeltaStatsPhase(TDF_PHASE_PARK, tPhase);
             
             if (*status != STATUS__OK) {
-                SdsDelete (cmdFileId,status);
-                SdsFreeId (cmdFileId,status);
-                free((void *)data);
-                return;
+                tdFdeltaCFdelete();
+                return 0;
             }
                 
             
@@ -1757,83 +1824,202 @@ TDFDELTA_INTERNAL void  tdFdeltaSequencer (
     } /* while pivotsLeft */
 #ifdef DEBUG_DELTA
     fprintf(stderr,"Delta Complete, moves = %d, parks = %d\n",
-            numMoves, numParks);
+            seq->numMoves, seq->numParks);
     fprintf(stderr,"=====================================\n");
     {
         unsigned i;
-        for (i = 0; i < numPivots ; ++i)
+        for (i = 0; i < seq->numPivots ; ++i)
         {
-            if (alreadyMoved[i] > 1) 
+            if (seq->alreadyMoved[i] > 1) 
             {
                 fprintf(stderr,"Fibre %d moved twice\n", i+1);
             }
         }       
     }
 #endif
+    /*
+     *  The crossover lists are now those of the target field, which
+     *  REPLAN or the next plan may be given.  Check them against its
+     *  fibres.  If streaming, lines will have been sent already - the
+     *  tdFdeltaCFdelete() of a failure has them withdrawn with a
+     *  CmdFileAbort trigger (see tdFdelDrama.c).
+     */
+    if (!FinalCrossesOk(data, status)) {
+        tdFdeltaCFdelete();
+        return 0;
+    }
+
     /*
      *  Record the number of moves and parks in the command file.
      */
-    tdFdeltaCFaddMoves (cmdFileId,(long int)numMoves,(long int)numParks,status);
+    tdFdeltaCFaddMoves ((long int)seq->numMoves,
+                        (long int)seq->numParks,status);
 
     /*
      *  End timimg.
      */
-    time(&tEnd);
+    elapsed = tdFdeltaClock() - seq->tStart;
 
     /*
      *  Command file generated - report and return.
      */
-    MsgOut(status,"Command file generated - %s (%d %s, %d %s) - in %ld %s",
+    tdFdeltaMsgOut(status,"Command file generated - %s (%d %s, %d %s) - in %.2f seconds",
            data->name,
-           numMoves, numMoves == 1?  "move": "moves",
-           numParks, numParks == 1?  "park": "parks",
-           (long)tEnd-tStart, tEnd-tStart == 1?  "second": "seconds");
+           seq->numMoves, seq->numMoves == 1?  "move": "moves",
+           seq->numParks, seq->numParks == 1?  "park": "parks",
+           elapsed);
     
-    DitsPutArgument(cmdFileId,DITS_ARG_DELETE,status);
+    tdFdeltaWarmSave(data,status);
+    tdFdeltaCFdone(status);
+    tdFdeltaPutStats(&data->stats,status);
+    return 0;
+}
 
-    /*
-     * data->above should be gone by now, but just be sure to avoid
-     * memory leaks.
-     */
-    if (data->above)
-    {
-        StatusType ignore = STATUS__OK;
-        SdsDelete(data->above,&ignore);
-        SdsFreeId(data->above,&ignore);
-        data->above = 0;
-    }
-    {
-        unsigned i;
-        for (i = 0; i < numPivots ; ++i)
-        {
-            if (data->crosses.above[i])
-            {
-                FibreCross *p = (data->crosses.above[i]);
-                while (p)
-                {
-                    FibreCross *next = p->next;
-                    free(p);
-                    p = next;
-                }
-                data->crosses.above[i] = 0;
-            }
+/*+        T D F D E L T A S E Q U E N C E R
 
-            if (data->crosses.below[i])
-            {
-                FibreCross *p = (data->crosses.below[i]);
-                while (p)
-                {
-                    FibreCross *next = p->next;
-                    free(p);
-                    p = next;
-                }
-                data->crosses.below[i] = 0;
-            }
+ *  Function name:
+      tdFdeltaSequencerStart
 
-        }
+ *  Function:
+      Start sequencing a field.
 
-    }
-    
+ *  Description:
+      Initialises the sequencer state in data->seq and starts the command
+      file.  tdFdeltaSequencerSlice() should then be called until it
+      returns 0, or tdFdeltaSequencerCancel() to give up.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaSequencerStart (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (!) status      (StatusType *)    Modified status.
 
-    free((void *)data);
+ *  Returned value:
+      1 if sequencing should continue, 0 if it is not wanted (NO_DELTA)
+      or on error.
+
+ *  Proir Requirements:
+      tdFdeltaUse(data) must have been called.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaSequencerStart (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    return SequencerInit(data, status);
+}
+
+
+/*+        T D F D E L T A S E Q U E N C E R
+
+ *  Function name:
+      tdFdeltaSequencerSlice
+
+ *  Function:
+      Run one time slice of the sequencer.
+
+ *  Description:
+      Runs for about TDFDELTA_SLICE_MS milliseconds.  When the sequence
+      is complete the command file is finished with tdFdeltaCFdone() and
+      the statistics are output.  On error, the command file is discarded.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaSequencerSlice (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      1 if there is more work to do, otherwise 0.
+
+ *  Proir Requirements:
+      tdFdeltaSequencerStart() must have returned 1, and tdFdeltaUse(data)
+      must have been called since any other plan was worked on.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaSequencerSlice (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    return SequencerSlice(data, status);
+}
+
+
+/*+        T D F D E L T A S E Q U E N C E R
+
+ *  Function name:
+      tdFdeltaSequencerCancel
+
+ *  Function:
+      Abandon a sequence started with tdFdeltaSequencerStart().
+
+ *  Description:
+      The command file is discarded and the statistics output.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaSequencerCancel (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSequencerCancel (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFdeltaCFdelete();
+    tdFdeltaPutStats(&data->stats,status);
+}
+
+/*
+ *  As per tdFdeltaSequencer(), but runs the whole sequence without
+ *  returning to DRAMA, checking the cancel flag (which may be null)
+ *  between time slices.  Used by tdFdeltaPlan().
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSequencerRun (
+        tdFdeltaType  *data,
+        volatile int  *cancel,
+        StatusType    *status)
+{
+    if (!SequencerInit(data, status))
+        return;
+    while (SequencerSlice(data, status)) {
+        if (TDFDELTA_CANCELLED(cancel)) {
+            tdFdeltaSequencerCancel(data, status);
+            return;
+        }
+    }
 }
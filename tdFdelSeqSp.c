@@ -23,6 +23,26 @@
 
  *  History:
       01-Nov-2000  TJF  Original version
+      18-Oct-2026  AGT  Use the shared crossover list update functions.
+                        CullOk() now drops fibres reported as failed
+                        by REPLAN.
+      18-Oct-2026  AGT  Add tdFdeltaSequencerSpecialRun() for the worker
+                        thread.
+      18-Oct-2026  AGT  DisplayProgress() replaced by tdFdeltaProgress().
+      18-Oct-2026  AGT  Time parking and positioning for DELTA_STATS.
+      18-Oct-2026  AGT  Trace moves and parks.
+      18-Oct-2026  AGT  Release the input snapshot on completion.
+      18-Oct-2026  AGT  Moved to the planning core.  The action handler
+                        moves to tdFdelDrama.c, the action data is no
+                        longer released here.
+      18-Oct-2026  AGT  Update the warm start pair matrix on completion.
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
+      18-Oct-2026  AGT  Check the final crossover lists.
+      19-Oct-2026  AGT  tdFdeltaSequencerSpecialRun() polls a cancel flag.
+      19-Oct-2026  AGT  Include stdlib.h for qsort().  Document the plan
+                        data argument.
+      19-Oct-2026  AGT  Add tdFdeltaSequencerSpecialOrder(), for estimates.
       {@change entry@}
 
 
@@ -39,30 +59,17 @@ static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelSeqSp.c,v 3.17 25-Aug-2014 14:
 static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
 
 
-#include "DitsTypes.h"       /* Basic dits types            */
-#include "Dits_Err.h"        /* Dits error codes            */
-#include "DitsSys.h"         /* For PutActionHandlers       */
-#include "DitsFix.h"         /* For various Dits routines   */
-#include "DitsMsgOut.h"      /* For MsgOut                  */
-#include "DitsUtil.h"        /* For DitsErrorText           */
-#include "sds.h"             /* For SDS_ macros             */
-#include "Sdp.h"             /* Sdp routines                */
-#include "mess.h"            /* For MessPutFacility         */
-#include "Git.h"             /* Git routines                */
-#include "Git_Err.h"         /* GIT__ codes                 */
-#include "Ers.h"
-
-#include "tdFdelta.h"
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
 #include "tdFdelta_Err.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <time.h>
 
-#define SCALE      0.25   /* Used when calculating the DELTA_CONFIG parameter*/
-                          /* value in an attempt to make progress v time 
-                             linear            */
 
 #define DIST_MAX   0.1   /* if the distance from center of two fibres
                             is similar within this proprotion, then
@@ -152,14 +159,18 @@ typedef struct {
       C
 
  *  Call:
-      (void) = tdFdeltaSequencerSpecial (status)
+      (void) = tdFdeltaSequencerSpecialRun (data, cancel, status)
 
  *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (>) cancel      (volatile int *)  Cancel flag, may be null.
       (!) status      (StatusType *)    Modified status.
 
  *  Proir Requirements:
-      DitsGetActData() must return a pointer to a structure of type 
-      tdFdeltaType (see tdFdelta.h for structure details).
+      data must have been created by tdFdeltaDataNew() (or by
+      tdFdeltaNewActData() in the task) with the SPECIAL flag, and have
+      passed tdFdeltaFieldCheckRun().  tdFdeltaUse(data) must have been
+      called in this thread since any other plan was worked on.
 
  *  Support: Tony Farrell, AAO
 
@@ -172,35 +183,10 @@ typedef struct {
                         bugs.
       26-Mar-2001  TJF  Support different altroghims.
       15-May-2001  TJF  The order for handling spring out fibres is reversed.
+      18-Oct-2026  AGT  Pass fibres reported as failed to CullOk().
  */
 
 
-/*
- *  Function to update the progress parameter.
- */
-static void DisplayProgress(
-    const unsigned numMoves,
-    const unsigned numParks,
-    const unsigned pivotsLeft,
-    float * const lastUpdate,
-    StatusType *status)
-{
-    float progress;
-    if (*status != STATUS__OK) return;
-    /*
-     *  Set the DELTA_PROG parameter - this indicates the progress of the
-     *  ordering process.
-     */
-    progress = 100.0*(float)(numMoves+numParks)/
-        ((float)(numMoves+numParks)+((float)pivotsLeft*SCALE));
-    if (((*lastUpdate) - progress > RESOLUTION) ||
-        (progress - (*lastUpdate) > RESOLUTION) ||
-        (progress == 100.0)) {
-        (*lastUpdate) = progress;
-        SdpPutf("DELTA_PROG",progress,status);
-    }
-}
-
 /*
  * Sort routines used by MoveSort when calling qsort().
  */
@@ -413,7 +399,6 @@ static void MoveSort(
  */
 static void RecordMove(
     const unsigned      curPivot,
-    const SdsIdType     cmdFileId,
     const unsigned      numPivots,
     tdFinterim          * const current,
     tdFtarget           * const target,
@@ -423,14 +408,13 @@ static void RecordMove(
     unsigned            * const lineNumber,
     const unsigned      numParks,
     unsigned            * const numMoves,
-    float               * const lastUpdate,
+    tdFprogress         * const progress,
     StatusType          * const status)
 {
     double cosT,sinT;
-    unsigned j;
-    FibreCross *ptmp;
 
     if (*status != STATUS__OK) return;
+    TDFDELTA_TRACE(TDF_TRACE_MOVE, curPivot+1, 0, 0);
 
     /*
      *  Update interim field details.
@@ -456,58 +440,12 @@ static void RecordMove(
     (*pivotsLeft)--;
 
     /*
-     *  Update crossover lists.
-     *
-     *  In order to save some time, take advantage of a couple of our
-     *  rules, namely -
-     *    - As a fibre can only be moved if there is no fibre crossing
-     *      above it, and it can not be placed under another button,
-     *      the crossover.above list for the button being moved is
-     *      unchanged.
-     *    - Any fibre/fibre collisions that will occur must result in
-     *      the fibre being moved crossing above them (a fibre can
-     *      not be placed under abother button), therefore these
-     *      fibres must be added to the crossover.below list for the
-     *      moved fibre, with the old crossover.below list being
-     *      deleted.
+     *  Update crossover lists.  Parked fibres are never checked here.
      */
-    ptmp = crosses->below[curPivot];
-    while (ptmp) {
-        tdFdeltaDeleteCross(curPivot+1,
-                            &crosses->above[(ptmp->piv)-1],
-                            status);
-        current->nAbove[(ptmp->piv)-1]--;
-        tdFdeltaDeleteCross(ptmp->piv,
-                            &ptmp,
-                            status);
-    }
-    crosses->below[curPivot] = NULL;
-    current->nBelow[curPivot] = 0;
-    for (j=0; j < numPivots; j++) {
-        int flag;
-        if (curPivot == j) continue;
-        if (current->park[j] == YES) continue;
-        flag = FpilColFibFib (
-            tdFdeltaFpilInst(),
-            (double)constants->xPiv[curPivot],
-            (double)constants->yPiv[curPivot],
-            (double)current->fvpX[curPivot],
-            (double)current->fvpY[curPivot],
-            (double)constants->xPiv[j],
-            (double)constants->yPiv[j],
-            (double)current->fvpX[j],
-            (double)current->fvpY[j]);
-
-
-        if (flag == YES) {
-            tdFdeltaAddCross(j+1,&crosses->below[curPivot],status);
-            tdFdeltaAddCross(curPivot+1,&crosses->above[j],status);
-            current->nAbove[j]++;
-            current->nBelow[curPivot]++;
-        }
-    }        
+    tdFdeltaCrossesMoved(curPivot, 0, constants, current, crosses, status);
+
     tdFdeltaCFaddCmd (status,
-                      cmdFileId,(*lineNumber)++,
+                      (*lineNumber)++,
                       "MF",curPivot+1,
                       target->xf[curPivot],
                       target->yf[curPivot],
@@ -518,11 +456,10 @@ static void RecordMove(
      *  Set the DELTA_PROG parameter - this indicates the progress of the
      *  ordering process.
      */
-    DisplayProgress(*numMoves, numParks, *pivotsLeft, 
-                        lastUpdate, status);
+    tdFdeltaProgress(progress, *pivotsLeft, status);
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error updating interim field details - %s",
-               DitsErrorText(*status));
+        tdFdeltaErsRep(0,status,"Error updating interim field details - %s",
+               tdFdeltaErrorText(*status));
         return;
     }
 
@@ -533,7 +470,6 @@ static void RecordMove(
  */
 static void RecordPark(
     const short         parkFibre,
-    const SdsIdType     cmdFileId,
     tdFinterim          * const current,
     tdFtarget           * const target,
     const tdFconstants  * const constants,
@@ -542,12 +478,11 @@ static void RecordPark(
     unsigned            * const lineNumber,
     unsigned            * const numParks,
     const unsigned      numMoves,
-    float               * const lastUpdate,
+    tdFprogress         * const progress,
     StatusType          * const status)
 {
-    FibreCross *ptmp;
-
     if (*status != STATUS__OK) return;
+    TDFDELTA_TRACE(TDF_TRACE_PARK, parkFibre+1, 0, 0);
 
     /*
      * Update counter.
@@ -573,24 +508,13 @@ static void RecordPark(
     /*
      *  Update crossover lists.
      */
-    ptmp = crosses->below[parkFibre];
-    while (ptmp) {
-        tdFdeltaDeleteCross(parkFibre+1,
-                            &crosses->above[(ptmp->piv)-1],
-                            status);
-        current->nAbove[(ptmp->piv)-1]--;
-        tdFdeltaDeleteCross(ptmp->piv,
-                            &ptmp,
-                            status);
-    }
-    crosses->below[parkFibre] = NULL;
-    current->nBelow[parkFibre]  = 0;
+    tdFdeltaCrossesParked(parkFibre, current, crosses, status);
 
     /*
      *  Add park to command file.
      */
     tdFdeltaCFaddCmd (status,
-                      cmdFileId,(*lineNumber)++,
+                      (*lineNumber)++,
                       "PF",parkFibre+1);
     (*numParks)++;
 
@@ -599,11 +523,10 @@ static void RecordPark(
      *  Set the DELTA_PROG parameter - this indicates the progress of the
      *  ordering process.
      */
-    DisplayProgress(numMoves, *numParks, *pivotsLeft, 
-                        lastUpdate, status);
+    tdFdeltaProgress(progress, *pivotsLeft, status);
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error updating interim field details - %s",
-               DitsErrorText(*status));
+        tdFdeltaErsRep(0,status,"Error updating interim field details - %s",
+               tdFdeltaErrorText(*status));
         return;
     }
 }
@@ -644,11 +567,11 @@ static void CrossSwap(
     if (i >= numPivots) {
         unsigned int pivot = distanceArray[index].pivot;
         *status = TDFDELTA__DELTAERR;
-        ErsRep(0, status, 
+        tdFdeltaErsRep(0, status, 
                "Cannot park pivot %d since it is crossed by other fibres.", 
                pivot+1);
-        ErsRep(0, status, "And the first crossing fibre - %d - is not in the list to be parked.", otherPiv+1);
-        ErsRep(0, status, "This is probably a programming error.");
+        tdFdeltaErsRep(0, status, "And the first crossing fibre - %d - is not in the list to be parked.", otherPiv+1);
+        tdFdeltaErsRep(0, status, "This is probably a programming error.");
         return;
     }
 
@@ -663,11 +586,11 @@ static void CrossSwap(
     if (distanceDiff/fabs(distanceArray[index].distance) > DIST_MAX) {
         unsigned int pivot = distanceArray[index].pivot;
         *status = TDFDELTA__DELTAERR;
-        ErsRep(0, status, 
+        tdFdeltaErsRep(0, status, 
                "Cannot park pivot %d since it is crossed by other fibres.", 
                pivot+1);
-        ErsRep(0, status, "And the first crossing fibre - %d - is not at a similar distance from the center.", otherPiv+1);
-        ErsRep(0, status, "This is probably because the field was not configured using the 6dF delta technique.");
+        tdFdeltaErsRep(0, status, "And the first crossing fibre - %d - is not at a similar distance from the center.", otherPiv+1);
+        tdFdeltaErsRep(0, status, "This is probably because the field was not configured using the 6dF delta technique.");
         return;
 
 
@@ -699,11 +622,11 @@ static void CrossSwap(
     
 
 /*
- * Called to park the field
+ * Called to park the field.  Stops early, returning 1, if cancelled.
  */
 static int ParkField(
+    volatile int        * const cancel,
     tdFdeltaType        * const data,
-    const SdsIdType     cmdFileId,
     const short         numOps,
     short               * const lastParkIndex,
     short               * const firstMoveIndex,
@@ -712,7 +635,7 @@ static int ParkField(
     unsigned            * const lineNumber,
     unsigned            * const numParks,
     const unsigned      numMoves,
-    float               * const lastUpdate,
+    tdFprogress         * const progress,
     StatusType          * const status)
 {
     register int i;
@@ -722,6 +645,8 @@ static int ParkField(
      */
     for (i = 0; (i <= *lastParkIndex)&&(*status == STATUS__OK) ; ++i) {
         unsigned pivot = distanceArray[i].pivot;
+        if (TDFDELTA_CANCELLED(cancel))
+            break;
         while (data->crosses.above[pivot]) {
             /*
              * We have a cross-over.
@@ -746,7 +671,6 @@ static int ParkField(
          * We want to park this one.
          */
         RecordPark(pivot,
-                   cmdFileId,
                    &data->current,
                    &data->target,
                    &data->constants,
@@ -755,7 +679,7 @@ static int ParkField(
                    lineNumber,
                    numParks,
                    numMoves,
-                   lastUpdate,
+                   progress,
                    status);
         
     }
@@ -771,16 +695,16 @@ static int ParkField(
  * are parked.
  */ 
 static int PositionField(
+    volatile int        * const cancel,
     tdFdeltaType        * const data,
     const unsigned      numPivots,
-    const SdsIdType     cmdFileId,
     const short         firstMoveIndex,
     const pivotDistance * const distanceArray,
     int                 * const pivotsLeft,
     unsigned            * const lineNumber,
     const unsigned      numParks,
     unsigned            * const numMoves,
-    float               * const lastUpdate,
+    tdFprogress         * const progress,
     StatusType          * const status)
 {
     register int i;
@@ -791,12 +715,14 @@ static int PositionField(
      */
     for (i = firstMoveIndex; (i >= 0)&&(*status == STATUS__OK) ; --i) {
         unsigned int pivot = distanceArray[i].pivot;
+        if (TDFDELTA_CANCELLED(cancel))
+            break;
         
         if (data->crosses.above[pivot]) {
             *status = TDFDELTA__DELTAERR;
-            ErsRep(0, status, "Cannot move pivot %i since it is crossed both others", pivot+1);
-            ErsRep(0, status, "This should not be happending in this algrothim");
-            ErsRep(0, status, "Probably a programming error");
+            tdFdeltaErsRep(0, status, "Cannot move pivot %i since it is crossed both others", pivot+1);
+            tdFdeltaErsRep(0, status, "This should not be happending in this algrothim");
+            tdFdeltaErsRep(0, status, "Probably a programming error");
             return 0;
             
             
@@ -805,7 +731,6 @@ static int PositionField(
          * We want to move this one.
          */
         RecordMove(pivot,
-                   cmdFileId,
                    numPivots,
                    &data->current,
                    &data->target,
@@ -815,7 +740,7 @@ static int PositionField(
                    lineNumber,
                    numParks,
                    numMoves,
-                   lastUpdate,
+                   progress,
                    status);
         
     }
@@ -830,27 +755,58 @@ static int PositionField(
  * The idea here is to ensure that if we are restarting a partly configured
  * field, that we don't try to reconfigure fibres which are already in the
  * right spot.
+ *
+ * Fibres reported as failed (by a REPLAN action) are first removed from
+ * both the park and move lists, they are left where they are.
  */
 static int CullOk(
     const short          * const mustMove,
-    const unsigned short numParkOps,
-    const unsigned short numMoveOps,
-    const pivotDistance  * const parkDistArray,
-    const pivotDistance  * const moveDistArray,
+    const short          * const failed,
+    unsigned short       * const numParkOps,
+    unsigned short       * const numMoveOps,
+    pivotDistance        * const parkDistArray,
+    pivotDistance        * const moveDistArray,
+    unsigned short       * const numSpringOutPark,
     int                  * const pivotsLeft,
     short                * const lastParkIndex,
     short                * const firstMoveIndex,
     StatusType           * const status)
 {
+    unsigned short i, n;
+    unsigned short springOut = 0;
+
     if (*status != STATUS__OK) return(0);
+/*
+ *  Drop the failed fibres.  The spring out parks are always at the start
+ *  of the park array, so we must count how many of those survive.
+ */
+    for (i = 0, n = 0; i < *numParkOps ; ++i) {
+        if (failed[parkDistArray[i].pivot]) {
+            (*pivotsLeft)--;
+        } else {
+            if (i < *numSpringOutPark) ++springOut;
+            parkDistArray[n++] = parkDistArray[i];
+        }
+    }
+    *numParkOps = n;
+    *numSpringOutPark = springOut;
+
+    for (i = 0, n = 0; i < *numMoveOps ; ++i) {
+        if (failed[moveDistArray[i].pivot])
+            (*pivotsLeft)--;
+        else
+            moveDistArray[n++] = moveDistArray[i];
+    }
+    *numMoveOps = n;
+
 /*
  *  When we return, we must have lastParkIndex set to the
  *  index in parkDistArray of the last park operation to be done, whilst
  *  firstMoveIndex is the index of the first move to be done.  Note that both
  *  parkDistArray and moveDistArray are sorted in park order.
  */
-    *lastParkIndex = numParkOps - 1;
-    *firstMoveIndex  = numMoveOps - 1;
+    *lastParkIndex = *numParkOps - 1;
+    *firstMoveIndex  = *numMoveOps - 1;
 
 /*
  *  Assume for the moment that both parkDistArray and moveDistArray are
@@ -907,8 +863,6 @@ static int SequencerInit(
     tdFdeltaType        * const data,
     unsigned            * const numPivots,
     time_t              * const tStart,
-    float               * const lastUpdate,
-    SdsIdType           * const cmdFileId,
     int                 * const pivotsLeft,
     unsigned short      * const numParkOps,
     unsigned short      * const numMoveOps,
@@ -925,18 +879,16 @@ static int SequencerInit(
     /*
      *  Get the number of pivots in this instrument
      */
-    (*numPivots) = FpilGetNumPivots(tdFdeltaFpilInst());
+    (*numPivots) = tdFdeltaNumPivots(tdFdeltaFpilInst());
 
     /*
      *  Start timing and set parameters/variables.
      */
     time(tStart);
-    *lastUpdate = 0.0;
-    SdpPutf("DELTA_PROG",0.0,status);
+    tdFdeltaPutProgress(0.0,0,status);
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error updating parameter - %s",
-               DitsErrorText(*status));
-        free((void *)data);
+        tdFdeltaErsRep(0,status,"Error updating parameter - %s",
+               tdFdeltaErrorText(*status));
         goto ERROR_RETURN;
     }
 
@@ -944,22 +896,21 @@ static int SequencerInit(
      *  Bypass checking if requested.
      */
     if (data->check & NO_DELTA) {
-        MsgOut(status,"Delta (ordering) process NOT performed");
+        tdFdeltaMsgOut(status,"Delta (ordering) process NOT performed");
         goto ERROR_RETURN;
     } else
-        MsgOut(status,"Performing special delta (ordering) process...");
+        tdFdeltaMsgOut(status,"Performing special delta (ordering) process...");
 
     /*
      *  Open a new command file.
      */
-    (*cmdFileId) = tdFdeltaCFnew (data->name,&data->current,
-                                  &data->above,status);
+    tdFdeltaCFnew (data->name,&data->current,status);
     /*
      * Handle command file opening error.
      */
     if (*status != STATUS__OK) {
-        ErsRep(0,status,"Error opening new command file - %s",
-               DitsErrorText(*status));
+        tdFdeltaErsRep(0,status,"Error opening new command file - %s",
+               tdFdeltaErrorText(*status));
         goto ERROR_RETURN;
     }
     /*
@@ -1039,34 +990,31 @@ static int SequencerInit(
     return (1);
 
  ERROR_RETURN:
-    /*
-     * This is used to ensure the data structure is freeed correctly
-     * when we return with an error.
-     */
-    if (data->above)
-    {
-        StatusType ignore = STATUS__OK;
-        SdsDelete(data->above,&ignore);
-        SdsFreeId(data->above,&ignore);
-        data->above = 0;
-    }
-    free (data);
     return (0);
     
 }
 
-TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecial (
-        StatusType  *status)
+/*
+ *  As per tdFdeltaSequencerSpecial(), but given the plan data.  The
+ *  action handler (in tdFdelDrama.c) and tdFdeltaPlan() call this.  The
+ *  cancel flag (which may be null) is polled before each park and move,
+ *  as per tdFdeltaSequencerRun().
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecialRun (
+        tdFdeltaType  *data,
+        volatile int  *cancel,
+        StatusType    *status)
 {
-    tdFdeltaType  *data = DitsGetActData();/* Function parameters            */
-    SdsIdType     cmdFileId;        /* Command file Id (Sds structure id)    */
     time_t        tStart, tEnd;     /* Used for timing this function         */
-    static float  lastUpdate;       /* DELTA_PROG at last update             */
+    tdFprogress   progress;         /* DELTA_PROG/DELTA_ETA model            */
     int           pivotsLeft = 0;   /* Number of pivots left to move         */
     unsigned      lineNumber = 1,   /* Counters                              */
                   numMoves = 0,     /* Final number of pivots to be moved    */
                   numParks = 0;     /* Final number of pivots to be parked   */
     unsigned numPivots;             /* Number of pivots                      */
+    double        tPhase;           /* Start of current phase                */
+    int           ok;
+    unsigned      bad;              /* Crossover list disagreements          */
 
     unsigned short numParkOps = 0;
     unsigned short numMoveOps = 0;
@@ -1082,35 +1030,55 @@ TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecial (
     /*
      * Initialise this function's variables etc.
      */
-    if (!SequencerInit(data,&numPivots, &tStart, &lastUpdate, &cmdFileId,
+    if (!SequencerInit(data,&numPivots, &tStart,
                        &pivotsLeft, &numParkOps, &numMoveOps,
                        parkDistArray, moveDistArray, &numSpringOutParks,
                        status))
         return;
 
     if (!CullOk(data->target.mustMove,
-                numParkOps,
-                numMoveOps,
+                data->failed,
+                &numParkOps,
+                &numMoveOps,
                 parkDistArray,
                 moveDistArray,
+                &numSpringOutParks,
                 &pivotsLeft,
                 &lastParkIndex,
                 &firstMoveIndex,
-                status))
+                status)) {
+        tdFdeltaCFdelete();
         return;
+    }
 
+    tdFdeltaProgInit(&progress, (unsigned)pivotsLeft);
 
-    if (!ParkField(data, cmdFileId, numParkOps, &lastParkIndex, 
+    tPhase = tdFdeltaClock();
+    ok = ParkField(cancel, data, numParkOps, &lastParkIndex, 
                    &firstMoveIndex, parkDistArray,
                    &pivotsLeft, &lineNumber,
-                   &numParks, numMoves, &lastUpdate, status))
+                   &numParks, numMoves, &progress, status);
+    tdFdeltaStatsPhase(TDF_PHASE_PARK, tPhase);
+    if (!ok) {
+        tdFdeltaCFdelete();
         return;
+    }
 
-    if ((pivotsLeft)&&
-        (!PositionField(data, numPivots, cmdFileId, firstMoveIndex, 
-                        moveDistArray, &pivotsLeft, &lineNumber,
-                        numParks, &numMoves, &lastUpdate, status)))
+    if ((pivotsLeft)&&(!TDFDELTA_CANCELLED(cancel))) {
+        tPhase = tdFdeltaClock();
+        ok = PositionField(cancel, data, numPivots, firstMoveIndex, 
+                           moveDistArray, &pivotsLeft, &lineNumber,
+                           numParks, &numMoves, &progress, status);
+        tdFdeltaStatsPhase(TDF_PHASE_SEARCH, tPhase);
+        if (!ok) {
+            tdFdeltaCFdelete();
+            return;
+        }
+    }
+    if (TDFDELTA_CANCELLED(cancel)) {
+        tdFdeltaSequencerCancel(data, status);
         return;
+    }
 
                     
 
@@ -1120,11 +1088,32 @@ TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecial (
      */
     if (numParks < numSpringOutParks)
         numSpringOutParks = numParks;
+
+    /*
+     *  Check the crossover lists, now those of the target field, against
+     *  its fibres.  Parked fibres are ignored, as they are when the lists
+     *  are updated.  Lines already streamed are withdrawn on failure,
+     *  see tdFdelDrama.c.
+     */
+    tPhase = tdFdeltaClock();
+    bad = tdFdeltaCrossesCheck("final", 0, &data->constants,
+                               &data->current, &data->crosses, status);
+    tdFdeltaStatsPhase(TDF_PHASE_CHECK_CROSS, tPhase);
+    if ((bad)&&(*status == STATUS__OK)) {
+        *status = TDFDELTA__CROSSESERR;
+        tdFdeltaErsRep(0,status,
+               "Crossover lists after sequencing are INCONSISTENT - %d %s",
+               bad, (bad == 1 ? "ERROR" : "ERRORS"));
+    }
+    if (*status != STATUS__OK) {
+        tdFdeltaCFdelete();
+        return;
+    }
     /*
      *  Record the number of moves and parks in the command file.
      */
-    tdFdeltaCFaddMoves (cmdFileId,(long int)numMoves,(long int)numParks,status);
-    tdFdeltaCFaddSpringOutParks(cmdFileId, (long int)numSpringOutParks, status);
+    tdFdeltaCFaddMoves ((long int)numMoves,(long int)numParks,status);
+    tdFdeltaCFaddSpringOutParks((long int)numSpringOutParks, status);
 
     /*
      *  End timimg.
@@ -1134,24 +1123,104 @@ TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecial (
     /*
      *  Command file generated - report and return.
      */
-    MsgOut(status,"Command file generated - %s (%d %s, %d %s) - in %ld %s",
+    tdFdeltaMsgOut(status,"Command file generated - %s (%d %s, %d %s) - in %ld %s",
            data->name,
            numMoves, numMoves == 1?  "move": "moves",
            numParks, numParks == 1?  "park": "parks",
            (long)tEnd-tStart, tEnd-tStart == 1?  "second": "seconds");
     
-    DitsPutArgument(cmdFileId,DITS_ARG_DELETE,status);
+    tdFdeltaWarmSave(data,status);
+    tdFdeltaCFdone(status);
+    tdFdeltaPutStats(&data->stats,status);
+}
 
-    /*
-     * data->above should be gone by now, but just be sure to avoid
-     * memory leaks.
-     */
-    if (data->above)
-    {
-        StatusType ignore = STATUS__OK;
-        SdsDelete(data->above,&ignore);
-        SdsFreeId(data->above,&ignore);
-        data->above = 0;
-    }
-    free((void *)data);
+
+/*+        T D F D E L T A S E Q U E N C E R S P E C I A L
+
+ *  Function name:
+      tdFdeltaSequencerSpecialOrder
+
+ *  Function:
+      The parks and moves the special 6dF sequencer would make.
+
+ *  Description:
+      Orders the fibres as tdFdeltaSequencerSpecialRun() does - the
+      fibres on the plate are parked (those with springs out first,
+      according to extSpringOut) and the target fibres moved on in the
+      reverse order, less those left in place by the restart cull -
+      without recording anything.  For tdFdeltaEstimate().  The reordering
+      of parks for crossovers is not made, it changes the order but not
+      the number of parks.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaSequencerSpecialOrder (from, target, mustMove,
+                       parkOrder, numParks, moveOrder, numMoves, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) from        (const tdFdeltaType *) The current field, constants
+                                        and extSpringOut.  Fibres it
+                                        reports as failed are left in
+                                        place.
+      (>) target      (const tdFtarget *) The target field.
+      (>) mustMove    (const short *)   Fibres which must be moved even
+                                        if in place, per pivot.
+      (<) parkOrder   (short *)         The pivots to park, in order.
+      (<) numParks    (unsigned *)      The number of parks.
+      (<) moveOrder   (short *)         The pivots to move, in order.
+      (<) numMoves    (unsigned *)      The number of moves.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      19-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecialOrder (
+        const tdFdeltaType  *from,
+        const tdFtarget     *target,
+        const short         *mustMove,
+        short               *parkOrder,
+        unsigned            *numParks,
+        short               *moveOrder,
+        unsigned            *numMoves,
+        StatusType          *status)
+{
+    unsigned short numParkOps = 0;
+    unsigned short numMoveOps = 0;
+    unsigned short numSpringOutParks = 0;
+    unsigned short numSpringOutMoves = 0;
+    pivotDistance  parkDistArray[FPIL_MAXPIVOTS];
+    pivotDistance  moveDistArray[FPIL_MAXPIVOTS];
+    short          lastParkIndex = -1;
+    short          firstMoveIndex = -1;
+    int            pivotsLeft = 0;
+    unsigned       numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    int            i;
+
+    *numParks = *numMoves = 0;
+    if (*status != STATUS__OK) return;
+
+    MoveSort(numPivots, from->extSpringOut,
+             from->constants.xPiv, from->constants.yPiv,
+             from->current.xf, from->current.yf, from->current.park,
+             &numParkOps, parkDistArray, &numSpringOutParks, status);
+    MoveSort(numPivots, from->extSpringOut,
+             from->constants.xPiv, from->constants.yPiv,
+             target->xf, target->yf, target->park,
+             &numMoveOps, moveDistArray, &numSpringOutMoves, status);
+    if (!CullOk(mustMove, from->failed, &numParkOps, &numMoveOps,
+                parkDistArray, moveDistArray, &numSpringOutParks,
+                &pivotsLeft, &lastParkIndex, &firstMoveIndex, status))
+        return;
+
+    for (i = 0; i <= lastParkIndex ; ++i)
+        parkOrder[(*numParks)++] = (short)parkDistArray[i].pivot;
+    for (i = firstMoveIndex; i >= 0 ; --i)
+        moveOrder[(*numMoves)++] = (short)moveDistArray[i].pivot;
 }
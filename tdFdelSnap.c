@@ -0,0 +1,615 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaSnap
+
+ *  Function:
+      Binary snapshots of the GENERATE inputs, for replay.
+
+ *  Description:
+      Once GENERATE has converted its arguments, tdFdeltaSnapTake() copies
+      everything the field check and sequencer will use - the target,
+      constants, offsets, fiducials and current field details (including
+      the crossover lists built from the "above" item), the clearances,
+      angles, flags and command file name - into a compact binary image.
+
+      The image is written to "<name>.snap", where <name> is the command
+      file name, immediately if the SNAPSHOT flag was given, otherwise
+      only if the action fails (see tdFdeltaSnapDone()).  Taking the image
+      is just a few copies, so it is always done.
+
+      A snapshot may be loaded with tdFdeltaSnapLoad(), which maps the
+      file and rebuilds the action data without needing Sds or DRAMA.
+      The tdFreplay program uses this to re-run the planner offline.
+
+      The file starts with a header giving a magic string, format version,
+      byte order marker, the sizes of each section and the instrument
+      name and number of pivots.  The sections follow, each padded to
+      eight bytes, in the order given by the SECT_ codes below.  The
+      sections are the C structures themselves, so any change to their
+      layout must be accompanied by an increment of SNAP_VERSION, but the
+      sizes are checked as well.
+
+      As with the trace, the image is held with the plan (data->snap),
+      so plans running at the same time each have their own.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved to the planning core.  tdFdeltaSnapFree()
+                        replaced by tdFdeltaDataFree().
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
+      18-Oct-2026  AGT  The image is held with the plan.  Add
+                        tdFdeltaSnapFree().
+      19-Oct-2026  AGT  Check the crossover entries against the number
+                        of pivots when loading.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelSnap.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelSnap.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#define SNAP_MAGIC      "2dFdSNAP"
+#define SNAP_VERSION    1
+#define SNAP_BYTE_ORDER 0x01020304
+#define SNAP_ROUND(n)   (((n)+7) & ~(size_t)7)
+
+/*
+ *  Section codes, in file order.
+ */
+#define SECT_CURRENT    0
+#define SECT_CONSTANTS  1
+#define SECT_OFFSETS    2
+#define SECT_FIDUCIALS  3
+#define SECT_TARGET     4
+#define SECT_PARAMS     5
+#define SECT_CROSSES    6
+#define NUM_SECTS       7
+
+typedef struct tdFsnapHeader {
+    char    magic[8];               /* SNAP_MAGIC, not null terminated */
+    INT32   version;                /* SNAP_VERSION                    */
+    INT32   byteOrder;              /* SNAP_BYTE_ORDER                 */
+    INT32   headerSize;             /* sizeof(tdFsnapHeader)           */
+    INT32   maxPivots;              /* FPIL_MAXPIVOTS                  */
+    INT32   maxFids;                /* FPIL_MAXFIDS                    */
+    INT32   numPivots;              /* FpilGetNumPivots()              */
+    INT32   numCrosses;             /* Entries in the SECT_CROSSES     */
+    INT32   sectSize[NUM_SECTS];    /* Unpadded section sizes          */
+    char    instName[32];           /* FpilGetInstName()               */
+    double  taken;                  /* time() when taken               */
+} tdFsnapHeader;
+
+/*
+ *  The scalar items from tdFdeltaType, and the failed pivots.
+ */
+typedef struct tdFsnapParams {
+    double  maxButAngG;
+    double  maxButAngO;
+    double  maxPivAngG;
+    double  maxPivAngO;
+    INT32   butClearG;
+    INT32   butClearO;
+    INT32   fibClearG;
+    INT32   fibClearO;
+    INT32   extSpringOut;
+    short   check;
+    short   spare;
+    char    name[FILENAME_LENGTH];
+    short   failed[FPIL_MAXPIVOTS];
+} tdFsnapParams;
+
+/*
+ *  A crossover list entry.  The lists are written in order, and rebuilt
+ *  by adding entries in reverse order, since tdFdeltaAddCross() adds
+ *  to the start of a list.
+ */
+typedef struct tdFsnapCross {
+    short   below;                  /* 0 - above list, 1 - below list  */
+    short   piv;                    /* Index of pivot owning the list  */
+    short   other;                  /* The list entry (pivot number)   */
+} tdFsnapCross;
+
+struct tdFsnap {
+    char    *image;                 /* Image from tdFdeltaSnapTake()   */
+    size_t  size;
+    int     written;                /* Already written (SNAPSHOT flag) */
+    char    name[FILENAME_LENGTH];
+};
+
+/*
+ *  Return the address of a section within an image.
+ */
+static char *Section(
+        char                 *image,
+        const tdFsnapHeader  *hdr,
+        int                  sect)
+{
+    size_t offset = SNAP_ROUND(sizeof(tdFsnapHeader));
+    int i;
+    for (i = 0; i < sect ; ++i)
+        offset += SNAP_ROUND((size_t)hdr->sectSize[i]);
+    return image + offset;
+}
+
+/*
+ *  Write a plan's image.  Returns 0 on failure.
+ */
+static int WriteImage(
+        const tdFsnap  *snap,
+        char           *fileName)
+{
+    FILE *fp;
+    int  ok;
+
+    sprintf(fileName, "%s.snap", snap->name);
+    if ((fp = fopen(fileName, "wb")) == NULL)
+        return 0;
+    ok = (fwrite(snap->image, 1, snap->size, fp) == snap->size);
+    if (fclose(fp) != 0)
+        ok = 0;
+    return ok;
+}
+
+
+/*+        T D F D E L T A S N A P
+
+ *  Function name:
+      tdFdeltaSnapTake
+
+ *  Function:
+      Take a snapshot of the planner inputs.
+
+ *  Description:
+      Copies the inputs in the action data into a snapshot image held
+      with the plan, replacing any previous one.  If the SNAPSHOT flag
+      is set, the
+      image is written straight away.
+
+      Failure to allocate the image is only an error if the SNAPSHOT
+      flag is set, otherwise we just go without.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaSnapTake (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The action data, as converted
+                                        and before the field check.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Image held in data->snap.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSnapTake (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFsnap        *snap;
+    tdFsnapHeader  hdr;
+    tdFsnapParams  *par;
+    tdFsnapCross   *cross;
+    FibreCross     *p;
+    char           fileName[FILENAME_LENGTH+10];
+    int            numCrosses = 0;
+    int            i;
+
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaSnapFree(data);
+
+    for (i = 0; i < FPIL_MAXPIVOTS ; ++i) {
+        for (p = data->crosses.above[i]; p ; p = p->next) ++numCrosses;
+        for (p = data->crosses.below[i]; p ; p = p->next) ++numCrosses;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAP_MAGIC, sizeof(hdr.magic));
+    hdr.version    = SNAP_VERSION;
+    hdr.byteOrder  = SNAP_BYTE_ORDER;
+    hdr.headerSize = sizeof(tdFsnapHeader);
+    hdr.maxPivots  = FPIL_MAXPIVOTS;
+    hdr.maxFids    = FPIL_MAXFIDS;
+    hdr.numPivots  = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    hdr.numCrosses = numCrosses;
+    hdr.sectSize[SECT_CURRENT]   = sizeof(tdFinterim);
+    hdr.sectSize[SECT_CONSTANTS] = sizeof(tdFconstants);
+    hdr.sectSize[SECT_OFFSETS]   = sizeof(tdFoffsets);
+    hdr.sectSize[SECT_FIDUCIALS] = sizeof(tdFfiducials);
+    hdr.sectSize[SECT_TARGET]    = sizeof(tdFtarget);
+    hdr.sectSize[SECT_PARAMS]    = sizeof(tdFsnapParams);
+    hdr.sectSize[SECT_CROSSES]   = numCrosses*sizeof(tdFsnapCross);
+    strncpy(hdr.instName, FpilGetInstName(tdFdeltaFpilInst()),
+            sizeof(hdr.instName)-1);
+    hdr.taken = (double)time(0);
+
+    if ((snap = (tdFsnap *)calloc(1, sizeof(tdFsnap))) == NULL) {
+        if (data->check & SNAPSHOT)
+            *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    snap->size = SNAP_ROUND(sizeof(hdr));
+    for (i = 0; i < NUM_SECTS ; ++i)
+        snap->size += SNAP_ROUND((size_t)hdr.sectSize[i]);
+    if ((snap->image = (char *)calloc(1, snap->size)) == NULL) {
+        free(snap);
+        if (data->check & SNAPSHOT)
+            *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    data->snap = snap;
+    memcpy(snap->image, &hdr, sizeof(hdr));
+    memcpy(Section(snap->image,&hdr,SECT_CURRENT), &data->current,
+           sizeof(tdFinterim));
+    memcpy(Section(snap->image,&hdr,SECT_CONSTANTS), &data->constants,
+           sizeof(tdFconstants));
+    memcpy(Section(snap->image,&hdr,SECT_OFFSETS), &data->offsets_,
+           sizeof(tdFoffsets));
+    memcpy(Section(snap->image,&hdr,SECT_FIDUCIALS), &data->fids,
+           sizeof(tdFfiducials));
+    memcpy(Section(snap->image,&hdr,SECT_TARGET), &data->target,
+           sizeof(tdFtarget));
+
+    par = (tdFsnapParams *)Section(snap->image,&hdr,SECT_PARAMS);
+    par->maxButAngG   = data->maxButAngG;
+    par->maxButAngO   = data->maxButAngO;
+    par->maxPivAngG   = data->maxPivAngG;
+    par->maxPivAngO   = data->maxPivAngO;
+    par->butClearG    = data->butClearG;
+    par->butClearO    = data->butClearO;
+    par->fibClearG    = data->fibClearG;
+    par->fibClearO    = data->fibClearO;
+    par->extSpringOut = data->extSpringOut;
+    par->check        = data->check;
+    strcpy(par->name, data->name);
+    memcpy(par->failed, data->failed, sizeof(par->failed));
+
+    cross = (tdFsnapCross *)Section(snap->image,&hdr,SECT_CROSSES);
+    for (i = 0; i < FPIL_MAXPIVOTS ; ++i) {
+        for (p = data->crosses.above[i]; p ; p = p->next, ++cross) {
+            cross->below = 0;
+            cross->piv   = i;
+            cross->other = p->piv;
+        }
+        for (p = data->crosses.below[i]; p ; p = p->next, ++cross) {
+            cross->below = 1;
+            cross->piv   = i;
+            cross->other = p->piv;
+        }
+    }
+    strcpy(snap->name, data->name);
+
+    if (data->check & SNAPSHOT) {
+        if (!WriteImage(snap, fileName)) {
+            *status = TDFDELTA__SNAPERR;
+            tdFdeltaErsRep(0, status, "Failed to write snapshot file %s",
+                           fileName);
+            return;
+        }
+        snap->written = YES;
+        tdFdeltaMsgOut(status, "Input snapshot written to %s", fileName);
+    }
+}
+
+
+/*+        T D F D E L T A S N A P
+
+ *  Function name:
+      tdFdeltaSnapDone
+
+ *  Function:
+      Release the snapshot, writing it if the action failed.
+
+ *  Description:
+      Called as the action completes.  If status is bad, and the snapshot
+      was not written already, it is written and an error report added
+      saying where.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaSnapDone (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (!) status      (StatusType *)    Modified status.  Only examined.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Given the plan data.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSnapDone (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    char fileName[FILENAME_LENGTH+10];
+
+    if (!data->snap) return;
+
+    if ((*status != STATUS__OK)&&(!data->snap->written)) {
+        if (WriteImage(data->snap, fileName))
+            tdFdeltaErsRep(0, status,
+                           "Input snapshot written to %s for replay",
+                           fileName);
+        else
+            tdFdeltaErsRep(0, status,
+                           "Failed to write input snapshot %s", fileName);
+    }
+    tdFdeltaSnapFree(data);
+}
+
+
+/*+        T D F D E L T A S N A P
+
+ *  Function name:
+      tdFdeltaSnapFree
+
+ *  Function:
+      Release a plan's snapshot without writing it.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaSnapFree (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSnapFree (
+        tdFdeltaType  *data)
+{
+    if (!data->snap) return;
+    free(data->snap->image);
+    free(data->snap);
+    data->snap = 0;
+}
+
+
+/*+        T D F D E L T A S N A P
+
+ *  Function name:
+      tdFdeltaSnapLoad
+
+ *  Function:
+      Load a snapshot file.
+
+ *  Description:
+      Maps the file, checks it was written by a compatible version on
+      a machine of the same byte order and for the same FPIL_MAXPIVOTS,
+      and creates action data from it, ready for tdFdeltaFieldCheckRun().
+      Sds and DRAMA are not used.
+
+      The instrument name and number of pivots recorded in the snapshot
+      are returned so the caller can initialise the right instrument and
+      check it matches.  The crossover entries must be within that
+      number of pivots, otherwise the snapshot is rejected.
+
+ *  Language:
+      C
+
+ *  Call:
+      (tdFdeltaType *) = tdFdeltaSnapLoad (file, instLen, instName,
+                                           numPivots, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) file        (const char *)    The snapshot file.
+      (>) instLen     (int)             Length of instName.
+      (<) instName    (char *)          The instrument name.
+      (<) numPivots   (int *)           The number of pivots.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      The new plan data, to be released with tdFdeltaDataFree(), or
+      NULL on error.  It has no output callbacks.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      19-Oct-2026  AGT  Terminate the plan name.
+      19-Oct-2026  AGT  Check the pivot count, and the crossover entries
+                        and list entries against it.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL tdFdeltaType  *tdFdeltaSnapLoad (
+        const char  *file,
+        int         instLen,
+        char        *instName,
+        int         *numPivots,
+        StatusType  *status)
+{
+    tdFdeltaType         *data = 0;
+    const tdFsnapHeader  *hdr;
+    const tdFsnapParams  *par;
+    const tdFsnapCross   *cross;
+    struct stat          st;
+    char                 *image;
+    size_t               size;
+    int                  fd;
+    int                  i;
+
+    if (*status != STATUS__OK) return NULL;
+
+    if ((fd = open(file, O_RDONLY)) < 0) {
+        *status = TDFDELTA__SNAPERR;
+        tdFdeltaErsRep(0, status, "Failed to open snapshot file %s", file);
+        return NULL;
+    }
+    if ((fstat(fd, &st) != 0)||(st.st_size < (off_t)sizeof(tdFsnapHeader))) {
+        *status = TDFDELTA__SNAPERR;
+        tdFdeltaErsRep(0, status, "%s is not a snapshot file", file);
+        close(fd);
+        return NULL;
+    }
+    image = (char *)mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+                         fd, 0);
+    close(fd);
+    if (image == (char *)MAP_FAILED) {
+        *status = TDFDELTA__SNAPERR;
+        tdFdeltaErsRep(0, status, "Failed to map snapshot file %s", file);
+        return NULL;
+    }
+
+    /*
+     *  Check the header.
+     */
+    hdr = (const tdFsnapHeader *)image;
+    if (memcmp(hdr->magic, SNAP_MAGIC, sizeof(hdr->magic)) != 0) {
+        *status = TDFDELTA__SNAPERR;
+        tdFdeltaErsRep(0, status, "%s is not a snapshot file", file);
+    } else if (hdr->byteOrder != SNAP_BYTE_ORDER) {
+        *status = TDFDELTA__SNAPERR;
+        tdFdeltaErsRep(0, status,
+                       "Snapshot %s was written on a machine of different byte order",
+                       file);
+    } else if (hdr->version != SNAP_VERSION) {
+        *status = TDFDELTA__SNAPERR;
+        tdFdeltaErsRep(0, status,
+                       "Snapshot %s is version %ld, we support version %d",
+                       file, (long)hdr->version, SNAP_VERSION);
+    } else if ((hdr->headerSize != sizeof(tdFsnapHeader))||
+               (hdr->maxPivots != FPIL_MAXPIVOTS)||
+               (hdr->maxFids != FPIL_MAXFIDS)||
+               (hdr->numPivots < 1)||(hdr->numPivots > FPIL_MAXPIVOTS)||
+               (hdr->sectSize[SECT_CURRENT] != sizeof(tdFinterim))||
+               (hdr->sectSize[SECT_CONSTANTS] != sizeof(tdFconstants))||
+               (hdr->sectSize[SECT_OFFSETS] != sizeof(tdFoffsets))||
+               (hdr->sectSize[SECT_FIDUCIALS] != sizeof(tdFfiducials))||
+               (hdr->sectSize[SECT_TARGET] != sizeof(tdFtarget))||
+               (hdr->sectSize[SECT_PARAMS] != sizeof(tdFsnapParams))||
+               (hdr->sectSize[SECT_CROSSES] !=
+                    hdr->numCrosses*(INT32)sizeof(tdFsnapCross))) {
+        *status = TDFDELTA__SNAPERR;
+        tdFdeltaErsRep(0, status,
+                       "Snapshot %s structure sizes don't match this program",
+                       file);
+    }
+    if (*status == STATUS__OK) {
+        size = SNAP_ROUND(sizeof(tdFsnapHeader));
+        for (i = 0; i < NUM_SECTS ; ++i)
+            size += SNAP_ROUND((size_t)hdr->sectSize[i]);
+        if ((size_t)st.st_size < size) {
+            *status = TDFDELTA__SNAPERR;
+            tdFdeltaErsRep(0, status, "Snapshot %s is truncated", file);
+        }
+    }
+    if (*status == STATUS__OK) {
+        par = (const tdFsnapParams *)Section(image,hdr,SECT_PARAMS);
+        data = tdFdeltaDataNew((short)(par->check & ~SNAPSHOT), status);
+    }
+    if (*status != STATUS__OK) {
+        munmap(image, (size_t)st.st_size);
+        return NULL;
+    }
+
+    /*
+     *  Build the plan data.
+     */
+    memcpy(&data->current, Section(image,hdr,SECT_CURRENT),
+           sizeof(tdFinterim));
+    memcpy(&data->constants, Section(image,hdr,SECT_CONSTANTS),
+           sizeof(tdFconstants));
+    memcpy(&data->offsets_, Section(image,hdr,SECT_OFFSETS),
+           sizeof(tdFoffsets));
+    memcpy(&data->fids, Section(image,hdr,SECT_FIDUCIALS),
+           sizeof(tdFfiducials));
+    memcpy(&data->target, Section(image,hdr,SECT_TARGET),
+           sizeof(tdFtarget));
+
+    data->maxButAngG   = par->maxButAngG;
+    data->maxButAngO   = par->maxButAngO;
+    data->maxPivAngG   = par->maxPivAngG;
+    data->maxPivAngO   = par->maxPivAngO;
+    data->butClearG    = par->butClearG;
+    data->butClearO    = par->butClearO;
+    data->fibClearG    = par->fibClearG;
+    data->fibClearO    = par->fibClearO;
+    data->extSpringOut = par->extSpringOut;
+    strncpy(data->name, par->name, sizeof(data->name)-1);
+    data->name[sizeof(data->name)-1] = '\0';
+    memcpy(data->failed, par->failed, sizeof(data->failed));
+
+    cross = (const tdFsnapCross *)Section(image,hdr,SECT_CROSSES);
+    for (i = hdr->numCrosses-1; (i >= 0)&&(*status == STATUS__OK) ; --i) {
+        /*
+         *  The entries are indices, the list entries pivot numbers.
+         */
+        if ((cross[i].piv < 0)||(cross[i].piv >= hdr->numPivots)||
+            (cross[i].other < 1)||(cross[i].other > hdr->numPivots)) {
+            *status = TDFDELTA__SNAPERR;
+            tdFdeltaErsRep(0, status,
+                           "Snapshot %s has an invalid crossover entry", file);
+        } else if (cross[i].below)
+            tdFdeltaAddCross(cross[i].other,
+                             &data->crosses.below[cross[i].piv], status);
+        else
+            tdFdeltaAddCross(cross[i].other,
+                             &data->crosses.above[cross[i].piv], status);
+    }
+
+    strncpy(instName, hdr->instName, instLen-1);
+    instName[instLen-1] = '\0';
+    *numPivots = hdr->numPivots;
+    munmap(image, (size_t)st.st_size);
+    if (*status != STATUS__OK) {
+        tdFdeltaDataFree(data);
+        return NULL;
+    }
+    return data;
+}
@@ -0,0 +1,255 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaStats
+
+ *  Function:
+      Planner statistics, published as the DELTA_STATS parameter.
+
+ *  Description:
+      Each action keeps a tdFstats structure in its action data.  The hot
+      paths (collision checks, crossover list edits) increment counters in
+      the current statistics structure with TDFDELTA_STAT(), so each action
+      handler must select its own structure with tdFdeltaStatsUse() before
+      doing any work.  The current structure is per thread.  Phases are
+      timed by recording tdFdeltaClock() at the start and calling
+      tdFdeltaStatsPhase() at the end.
+
+      When a plan completes, the statistics are passed to its stats
+      callback.  The task (see tdFdelDrama.c) copies them to the
+      DELTA_STATS parameter, an SDS structure with the following items
+
+          <phase>Count  - INT    - Number of times the phase was entered.
+          <phase>Ns     - DOUBLE - Total time in the phase (nanoseconds).
+          colButBut     - INT    - Number of FpilColButBut() calls.
+          colButFib     - INT    - Number of FpilColButFib() calls.
+          colFibFib     - INT    - Number of FpilColFibFib() calls.
+          crossAdds     - INT    - Crossover list items added.
+          crossDeletes  - INT    - Crossover list items deleted.
+          cacheHits     - INT    - GENERATE results found in the cache.
+          cacheMisses   - INT    - GENERATE results not found.
+          cacheEntries  - INT    - Results in the cache.
+          cacheBytes    - INT    - Memory used by the cache.
+          warmSkips     - INT    - Pair checks skipped by warm start.
+
+      where <phase> is one of convert, checkButBut, checkButFib,
+      checkExtension, checkBend, checkPosition, checkFiducials, search,
+      park, cmdFile, warm and checkCrosses.  The cache items are for the
+      task as a whole (see tdFdelCache.c), the others for the action.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Phases are traced.  Add tdFdeltaStatsPhaseName().
+      18-Oct-2026  AGT  Moved to the planning core.  The DELTA_STATS
+                        parameter functions move to tdFdelDrama.c.
+      18-Oct-2026  AGT  Document the result cache items.
+      18-Oct-2026  AGT  Add the warm phase and warmSkips.
+      18-Oct-2026  AGT  Add the checkCrosses phase.
+      18-Oct-2026  AGT  The current structure is thread local.
+      19-Oct-2026  AGT  The spare structure is thread local too.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelStats.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelStats.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ *  Phase names, in TDF_PHASE_ order.
+ */
+static const char * const phaseNames[TDF_NUM_PHASES] = {
+    "convert",
+    "checkButBut",
+    "checkButFib",
+    "checkExtension",
+    "checkBend",
+    "checkPosition",
+    "checkFiducials",
+    "search",
+    "park",
+    "cmdFile",
+    "warm",
+    "checkCrosses" };
+
+/*
+ *  Counts are added here when no action has selected a structure.  They
+ *  are never read, but each thread has its own so the increments do not
+ *  race.  A thread local address is not a constant, so tdFdeltaStatsCur
+ *  starts null and TDFDELTA_STAT() falls back to the spare.
+ */
+TDFDELTA_TLS tdFstats  tdFdeltaStatsSpare;
+
+TDFDELTA_TLS tdFstats *tdFdeltaStatsCur = 0;
+
+/*+        T D F D E L T A S T A T S
+
+ *  Function name:
+      tdFdeltaStatsInit
+
+ *  Function:
+      Zero a statistics structure and make it current.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaStatsInit (stats)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (<) stats       (tdFstats *)      The statistics.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaStatsInit (
+        tdFstats    *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    tdFdeltaStatsUse(stats);
+}
+
+
+/*+        T D F D E L T A S T A T S
+
+ *  Function name:
+      tdFdeltaStatsUse
+
+ *  Function:
+      Select the statistics structure counters are added to.
+
+ *  Description:
+      Called by tdFdeltaUse() before any counted operations, since plans
+      may be interleaved.  A null pointer selects the thread's spare
+      structure.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaStatsUse (stats)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) stats       (tdFstats *)      The statistics, may be null.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaStatsUse (
+        tdFstats    *stats)
+{
+    tdFdeltaStatsCur = stats;
+}
+
+
+/*+        T D F D E L T A S T A T S
+
+ *  Function name:
+      tdFdeltaStatsPhase
+
+ *  Function:
+      Record the end of a phase.
+
+ *  Description:
+      If tracing, the phase is also added to the trace.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaStatsPhase (phase, tStart)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) phase       (int)             The TDF_PHASE_ code.
+      (>) tStart      (double)          tdFdeltaClock() at the phase start.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Add to the trace.
+      19-Oct-2026  AGT  Use TDFDELTA_STATS_CUR.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaStatsPhase (
+        int         phase,
+        double      tStart)
+{
+    tdFphaseStat *p = &TDFDELTA_STATS_CUR->phase[phase];
+    double       tEnd = tdFdeltaClock();
+    p->count++;
+    p->ns += (tEnd - tStart)*1.0e9;
+    if (tdFdeltaTracing)
+        tdFdeltaTraceSpan(TDF_TRACE_PHASE+phase, tStart, tEnd);
+}
+
+
+/*+        T D F D E L T A S T A T S
+
+ *  Function name:
+      tdFdeltaStatsPhaseName
+
+ *  Function:
+      Return the name of a phase.
+
+ *  Language:
+      C
+
+ *  Call:
+      (const char *) = tdFdeltaStatsPhaseName (phase)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) phase       (int)             The TDF_PHASE_ code.
+
+ *  Returned value:
+      The name, as used in DELTA_STATS.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL const char  *tdFdeltaStatsPhaseName (
+        int         phase)
+{
+    if ((phase < 0)||(phase >= TDF_NUM_PHASES))
+        return "unknown";
+    return phaseNames[phase];
+}
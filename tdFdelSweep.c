@@ -0,0 +1,583 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaSweep
+
+ *  Function:
+      Find all the fibre crossings of a field with a sweep line.
+
+ *  Description:
+      Finds every pair of fibres (pivot to virtual pivot point) which
+      cross, using the Bentley-Ottmann sweep.  A line is swept across the
+      field in x (then y) order, keeping the fibres it cuts sorted from
+      bottom to top.  Only fibres next to each other in that order can
+      cross before anything else changes, so only they are tested, as a
+      fibre is added or removed and as two fibres swap over where they
+      cross.  The fibres cut by the line are held in a skip list, so a
+      fibre is added in O(log N) expected steps, and removed or swapped
+      with its neighbour in O(1).  With the binary heap of events, this
+      takes O((N+K) log N) for N fibres and K crossings, rather than the
+      N*N/2 tests of testing every pair.  The skip list node heights come
+      from a fixed pseudo random sequence, so a field is always swept the
+      same way.
+
+      All the tests which decide the order of the fibres and whether they
+      cross are exact integer orientation (cross product) tests on the
+      micron positions.  Touching is not crossing.  Only the positions of the crossings,
+      which just order the events, are floating point.  Should the sweep
+      find itself in a state it can't be in with exact positions - a fibre
+      ending or starting on another, or three fibres crossing at a point -
+      it gives up and tests every pair instead, so the result is always
+      that of testing every pair.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      19-Oct-2026  AGT  Hold the line in a skip list rather than a sorted
+                        array, so adding and removing fibres is not O(N).
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelSweep.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelSweep.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  A fibre, its ends in sweep order.
+ */
+typedef struct {
+    INT64       lx, ly;                     /* First end swept             */
+    INT64       rx, ry;                     /* Last end swept              */
+    unsigned    piv;                        /* Pivot index                 */
+    } Seg;
+
+/*
+ *  Events, in the order they are handled at the same position.
+ */
+#define EV_START    0
+#define EV_CROSS    1
+#define EV_END      2
+
+typedef struct {
+    double      x, y;
+    int         type;
+    unsigned    a, b;                       /* Seg indices, b for EV_CROSS */
+    } Event;
+
+/*
+ *  The skip list of segs cut by the line, bottom to top.  Each seg added
+ *  gets a new node, numbered from 0, and the head is node numSegs.  A
+ *  node's links at each level are at [node*SKIP_LEVELS + level], NIL
+ *  at the ends.  Nodes keep their place when two segs swap over, the
+ *  segs are swapped between them.
+ */
+#define SKIP_LEVELS 16
+#define NIL         (-1)
+#define NEXT(sw,n,l)    ((sw)->next[(n)*SKIP_LEVELS + (l)])
+#define PREV(sw,n,l)    ((sw)->prev[(n)*SKIP_LEVELS + (l)])
+
+/*
+ *  The sweep state.
+ */
+typedef struct {
+    Seg             *seg;
+    unsigned        numSegs;
+    Event           *heap;                  /* Event queue, a binary heap  */
+    unsigned        numEvents;
+    unsigned        maxEvents;
+    int             *next;                  /* Skip list links up ...      */
+    int             *prev;                  /* ... and down the line       */
+    unsigned char   *height;                /* Levels of each node         */
+    unsigned        *segOf;                 /* Seg held by each node       */
+    unsigned        numNodes;               /* Nodes used, not the head    */
+    int             levels;                 /* Levels in use               */
+    unsigned long   rand;                   /* Node height sequence        */
+    int             *pos;                   /* Node of each seg, -1 if not */
+    unsigned char   *done;                  /* Crossings found, pair bits  */
+    unsigned        *pairs;                 /* Crossings found, in order   */
+    unsigned long   numPairs;
+    unsigned long   maxPairs;
+    int             failed;                 /* Out of memory               */
+    int             degenerate;             /* Must test every pair        */
+    } Sweep;
+
+/*
+ *  The pair bits.
+ */
+#define PAIR_BIT(sw,a,b)  ((unsigned long)(a)*(sw)->numSegs + (b))
+#define PAIR_DONE(sw,a,b) \
+    ((sw)->done[PAIR_BIT(sw,a,b) >> 3] & (1 << (PAIR_BIT(sw,a,b) & 7)))
+#define PAIR_SET(sw,a,b)  \
+    ((sw)->done[PAIR_BIT(sw,a,b) >> 3] |= (1 << (PAIR_BIT(sw,a,b) & 7)))
+
+/*
+ *  Which side of the line a-b is p.
+ */
+static int Side(
+    INT64       px,
+    INT64       py,
+    INT64       ax,
+    INT64       ay,
+    INT64       bx,
+    INT64       by)
+{
+    INT64 c = (bx - ax)*(py - ay) - (by - ay)*(px - ax);
+    return (c > 0) - (c < 0);
+}
+
+/*
+ *  Is p before q in sweep order.
+ */
+static int Before(
+    INT64       px,
+    INT64       py,
+    INT64       qx,
+    INT64       qy)
+{
+    return ((px < qx)||((px == qx)&&(py < qy)));
+}
+
+/*
+ *  Do two segs cross (touching is not crossing).
+ */
+static int Cross(
+    const Seg   *s,
+    const Seg   *t)
+{
+    return ((Side(t->lx, t->ly, s->lx, s->ly, s->rx, s->ry) *
+             Side(t->rx, t->ry, s->lx, s->ly, s->rx, s->ry) < 0)&&
+            (Side(s->lx, s->ly, t->lx, t->ly, t->rx, t->ry) *
+             Side(s->rx, s->ry, t->lx, t->ly, t->rx, t->ry) < 0));
+}
+
+/*
+ *  Event order.
+ */
+static int EventLess(
+    const Event *e,
+    const Event *f)
+{
+    if (e->x != f->x) return (e->x < f->x);
+    if (e->y != f->y) return (e->y < f->y);
+    if (e->type != f->type) return (e->type < f->type);
+    if (e->a != f->a) return (e->a < f->a);
+    return (e->b < f->b);
+}
+
+static void Push(
+    Sweep       *sw,
+    const Event *e)
+{
+    unsigned i;
+    if (sw->numEvents == sw->maxEvents) {
+        unsigned max = sw->maxEvents*2;
+        Event *heap = (Event *)realloc(sw->heap, max*sizeof(Event));
+        if (!heap) {
+            sw->failed = 1;
+            return;
+        }
+        sw->heap = heap;
+        sw->maxEvents = max;
+    }
+    i = sw->numEvents++;
+    while (i > 0) {
+        unsigned parent = (i-1)/2;
+        if (!EventLess(e, &sw->heap[parent])) break;
+        sw->heap[i] = sw->heap[parent];
+        i = parent;
+    }
+    sw->heap[i] = *e;
+}
+
+static void Pop(
+    Sweep       *sw,
+    Event       *e)
+{
+    Event    last;
+    unsigned i = 0;
+
+    *e = sw->heap[0];
+    last = sw->heap[--sw->numEvents];
+    for (;;) {
+        unsigned child = 2*i + 1;
+        if (child >= sw->numEvents) break;
+        if ((child+1 < sw->numEvents)&&
+            (EventLess(&sw->heap[child+1], &sw->heap[child])))
+            ++child;
+        if (!EventLess(&sw->heap[child], &last)) break;
+        sw->heap[i] = sw->heap[child];
+        i = child;
+    }
+    sw->heap[i] = last;
+}
+
+/*
+ *  Record a crossing.
+ */
+static void Found(
+    Sweep       *sw,
+    unsigned    a,
+    unsigned    b)
+{
+    if (sw->numPairs == sw->maxPairs) {
+        unsigned long max = sw->maxPairs*2;
+        unsigned *pairs = (unsigned *)realloc(sw->pairs,
+                                              max*2*sizeof(unsigned));
+        if (!pairs) {
+            sw->failed = 1;
+            return;
+        }
+        sw->pairs = pairs;
+        sw->maxPairs = max;
+    }
+    sw->pairs[2*sw->numPairs]   = a;
+    sw->pairs[2*sw->numPairs+1] = b;
+    ++sw->numPairs;
+    PAIR_SET(sw, a, b);
+    PAIR_SET(sw, b, a);
+}
+
+/*
+ *  Lower seg u and upper seg v are next to each other on the line.  If
+ *  they cross ahead of it, queue the crossing.  They cross ahead if they
+ *  have swapped over by the time the first of them ends.
+ */
+static void Test(
+    Sweep       *sw,
+    unsigned    u,
+    unsigned    v)
+{
+    const Seg *s = &sw->seg[u];
+    const Seg *t = &sw->seg[v];
+    Event     e;
+    double    d, r;
+
+    if ((PAIR_DONE(sw, u, v))||(!Cross(s, t))) return;
+    if (Before(s->rx, s->ry, t->rx, t->ry)) {
+        if (Side(s->rx, s->ry, t->lx, t->ly, t->rx, t->ry) <= 0) return;
+    } else {
+        if (Side(t->rx, t->ry, s->lx, s->ly, s->rx, s->ry) >= 0) return;
+    }
+    d = (double)(s->rx - s->lx)*(double)(t->ry - t->ly) -
+        (double)(s->ry - s->ly)*(double)(t->rx - t->lx);
+    r = ((double)(t->lx - s->lx)*(double)(t->ry - t->ly) -
+         (double)(t->ly - s->ly)*(double)(t->rx - t->lx))/d;
+    e.x = (double)s->lx + r*(double)(s->rx - s->lx);
+    e.y = (double)s->ly + r*(double)(s->ry - s->ly);
+    e.type = EV_CROSS;
+    e.a = u;
+    e.b = v;
+    Push(sw, &e);
+}
+
+/*
+ *  The height of a new skip list node, 1 to SKIP_LEVELS, each level
+ *  being half as likely as the one below.
+ */
+static int Height(
+    Sweep       *sw)
+{
+    unsigned long bits;
+    int           h = 1;
+
+    sw->rand = (sw->rand*1103515245UL + 12345UL) & 0xffffffffUL;
+    bits = sw->rand >> 8;
+    while ((h < SKIP_LEVELS)&&(bits & 1)) {
+        ++h;
+        bits >>= 1;
+    }
+    return h;
+}
+
+/*
+ *  Add seg s to the line.
+ */
+static void Start(
+    Sweep       *sw,
+    unsigned    s)
+{
+    const Seg *n = &sw->seg[s];
+    const int head = (int)sw->numSegs;
+    int       update[SKIP_LEVELS];
+    int       x = head;
+    int       node, h, l;
+
+    /*
+     *  Find the last seg the start of s is above, at each level.
+     */
+    for (l = sw->levels-1; l >= 0 ; --l) {
+        int nx;
+        while ((nx = NEXT(sw, x, l)) != NIL) {
+            const Seg *t = &sw->seg[sw->segOf[nx]];
+            int side = Side(n->lx, n->ly, t->lx, t->ly, t->rx, t->ry);
+            if (side == 0) {
+                sw->degenerate = 1;
+                return;
+            }
+            if (side < 0) break;
+            x = nx;
+        }
+        update[l] = x;
+    }
+    h = Height(sw);
+    for (l = sw->levels; l < h ; ++l)
+        update[l] = head;
+    if (h > sw->levels) sw->levels = h;
+
+    node = (int)sw->numNodes++;
+    sw->height[node] = (unsigned char)h;
+    sw->segOf[node] = s;
+    sw->pos[s] = node;
+    for (l = 0; l < h ; ++l) {
+        int nx = NEXT(sw, update[l], l);
+        NEXT(sw, node, l) = nx;
+        PREV(sw, node, l) = update[l];
+        NEXT(sw, update[l], l) = node;
+        if (nx != NIL) PREV(sw, nx, l) = node;
+    }
+    if (PREV(sw, node, 0) != head)
+        Test(sw, sw->segOf[PREV(sw, node, 0)], s);
+    if (NEXT(sw, node, 0) != NIL)
+        Test(sw, s, sw->segOf[NEXT(sw, node, 0)]);
+}
+
+/*
+ *  Remove seg s from the line.
+ */
+static void End(
+    Sweep       *sw,
+    unsigned    s)
+{
+    const int head = (int)sw->numSegs;
+    int       node = sw->pos[s];
+    int       below, above, l;
+
+    for (l = 0; l < sw->height[node] ; ++l) {
+        int p  = PREV(sw, node, l);
+        int nx = NEXT(sw, node, l);
+        NEXT(sw, p, l) = nx;
+        if (nx != NIL) PREV(sw, nx, l) = p;
+    }
+    sw->pos[s] = -1;
+    below = PREV(sw, node, 0);
+    above = NEXT(sw, node, 0);
+    if ((below != head)&&(above != NIL))
+        Test(sw, sw->segOf[below], sw->segOf[above]);
+}
+
+/*
+ *  Segs u (lower) and v cross here, swap them over.  If they have
+ *  already, this is a repeat of the event.  If they are not next to each
+ *  other, we are lost.
+ */
+static void Swap(
+    Sweep       *sw,
+    unsigned    u,
+    unsigned    v)
+{
+    int a = sw->pos[u];
+    int b = sw->pos[v];
+    if (PAIR_DONE(sw, u, v)) return;
+    if ((a < 0)||(b < 0)||(NEXT(sw, a, 0) != b)) {
+        sw->degenerate = 1;
+        return;
+    }
+    Found(sw, u, v);
+    sw->segOf[a] = v;
+    sw->segOf[b] = u;
+    sw->pos[v] = a;
+    sw->pos[u] = b;
+    if (PREV(sw, a, 0) != (int)sw->numSegs)
+        Test(sw, sw->segOf[PREV(sw, a, 0)], v);
+    if (NEXT(sw, b, 0) != NIL)
+        Test(sw, u, sw->segOf[NEXT(sw, b, 0)]);
+}
+
+/*
+ *  Test every pair, when the sweep can't be trusted.
+ */
+static void EveryPair(
+    Sweep       *sw)
+{
+    unsigned a, b;
+    memset(sw->done, 0, ((size_t)sw->numSegs*sw->numSegs + 7)/8);
+    sw->numPairs = 0;
+    for (a = 0; a < sw->numSegs ; ++a) {
+        for (b = a+1; b < sw->numSegs ; ++b) {
+            if (Cross(&sw->seg[a], &sw->seg[b]))
+                Found(sw, a, b);
+        }
+    }
+}
+
+
+/*+        T D F D E L T A S W E E P
+
+ *  Function name:
+      tdFdeltaSweep
+
+ *  Function:
+      Find all the fibre crossings of a field.
+
+ *  Description:
+      The fibres are those from each pivot to its virtual pivot point,
+      for the pivots flagged in use[] (all if use is null).  found() is
+      called once for each pair which cross, with the lower pivot index
+      first.  The pairs are given in the order the sweep came across them.
+
+ *  Language:
+      C
+
+ *  Call:
+      (long) = tdFdeltaSweep (numPivots, con, fvpX, fvpY, use, found,
+                              clientData, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) numPivots   (unsigned)        Number of pivots.
+      (>) con         (const tdFconstants *) Pivot positions.
+      (>) fvpX, fvpY  (const INT32 [])  Virtual pivot points.
+      (>) use         (const short [])  Fibres to include, or null for all.
+      (>) found       (tdFsweepFound)   Called for each crossing.
+      (>) clientData  (void *)          Passed to found().
+      (!) status      (StatusType *)    Modified status.
+
+ *  Returned value:
+      The number of crossings.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL long  tdFdeltaSweep (
+        unsigned            numPivots,
+        const tdFconstants  *con,
+        const INT32         fvpX[],
+        const INT32         fvpY[],
+        const short         use[],
+        tdFsweepFound       found,
+        void                *clientData,
+        StatusType          *status)
+{
+    Sweep         sw;
+    Event         e;
+    unsigned      i;
+    unsigned long p;
+
+    if (*status != STATUS__OK) return 0;
+
+    memset(&sw, 0, sizeof(sw));
+    sw.seg  = (Seg *)malloc((numPivots+1)*sizeof(Seg));
+    sw.next = (int *)malloc((numPivots+1)*SKIP_LEVELS*sizeof(int));
+    sw.prev = (int *)malloc((numPivots+1)*SKIP_LEVELS*sizeof(int));
+    sw.height = (unsigned char *)malloc(numPivots+1);
+    sw.segOf = (unsigned *)malloc((numPivots+1)*sizeof(unsigned));
+    sw.pos  = (int *)malloc((numPivots+1)*sizeof(int));
+    sw.done = (unsigned char *)calloc(((size_t)numPivots*numPivots + 7)/8 + 1,
+                                      1);
+    sw.maxEvents = 2*numPivots + 16;
+    sw.heap = (Event *)malloc(sw.maxEvents*sizeof(Event));
+    sw.maxPairs = numPivots + 16;
+    sw.pairs = (unsigned *)malloc(sw.maxPairs*2*sizeof(unsigned));
+    if ((!sw.seg)||(!sw.next)||(!sw.prev)||(!sw.height)||(!sw.segOf)||
+        (!sw.pos)||(!sw.done)||(!sw.heap)||(!sw.pairs)) {
+        sw.failed = 1;
+        goto CLEANUP;
+    }
+
+    /*
+     *  The fibres, and their start and end events.
+     */
+    for (i = 0; i < numPivots ; ++i) {
+        Seg *s = &sw.seg[sw.numSegs];
+        INT64 ax = con->xPiv[i], ay = con->yPiv[i];
+        INT64 bx = fvpX[i],      by = fvpY[i];
+        if ((use)&&(!use[i])) continue;
+        if ((ax == bx)&&(ay == by)) continue;
+        if (Before(ax, ay, bx, by)) {
+            s->lx = ax; s->ly = ay; s->rx = bx; s->ry = by;
+        } else {
+            s->lx = bx; s->ly = by; s->rx = ax; s->ry = ay;
+        }
+        s->piv = i;
+        sw.pos[sw.numSegs] = -1;
+        ++sw.numSegs;
+    }
+    for (i = 0; i < SKIP_LEVELS ; ++i)
+        NEXT(&sw, sw.numSegs, i) = NIL;
+    sw.levels = 1;
+    sw.rand = 1;
+    for (i = 0; i < sw.numSegs ; ++i) {
+        e.a = e.b = i;
+        e.type = EV_START;
+        e.x = (double)sw.seg[i].lx;
+        e.y = (double)sw.seg[i].ly;
+        Push(&sw, &e);
+        e.type = EV_END;
+        e.x = (double)sw.seg[i].rx;
+        e.y = (double)sw.seg[i].ry;
+        Push(&sw, &e);
+    }
+
+    /*
+     *  Sweep.
+     */
+    while ((sw.numEvents > 0)&&(!sw.failed)&&(!sw.degenerate)) {
+        Pop(&sw, &e);
+        switch (e.type) {
+          case EV_START: Start(&sw, e.a);      break;
+          case EV_CROSS: Swap(&sw, e.a, e.b);  break;
+          case EV_END:   End(&sw, e.a);        break;
+        }
+    }
+    if ((sw.degenerate)&&(!sw.failed))
+        EveryPair(&sw);
+
+ CLEANUP:
+    if (sw.failed) {
+        *status = TDFDELTA__MALLOCERR;
+        tdFdeltaErsRep(0, status, "Error allocating crossing sweep memory");
+    } else {
+        for (p = 0; p < sw.numPairs ; ++p) {
+            unsigned a = sw.seg[sw.pairs[2*p]].piv;
+            unsigned b = sw.seg[sw.pairs[2*p+1]].piv;
+            (*found)(clientData, (a < b ? a : b), (a < b ? b : a));
+        }
+    }
+    p = sw.numPairs;
+    free(sw.seg);
+    free(sw.next);
+    free(sw.prev);
+    free(sw.height);
+    free(sw.segOf);
+    free(sw.pos);
+    free(sw.done);
+    free(sw.heap);
+    free(sw.pairs);
+    return (*status == STATUS__OK ? (long)p : 0);
+}
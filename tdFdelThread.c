@@ -0,0 +1,1051 @@
+/*+                T D F D E L T A
+
+ *  Module name:
+      tdFdeltaThread
+
+ *  Function:
+      Runs the field check and sequencer in a worker thread.
+
+ *  Description:
+      When the THREAD flag is given to GENERATE, the field check and
+      sequencer are run in a dedicated worker thread rather then within
+      the action.  The DRAMA main loop thread then only polls the worker,
+      passing on its messages, publishing the DELTA_PROG parameter and,
+      when the worker completes, building the command file.  This keeps
+      the task fully responsive whilst a large field is being planned.
+
+      Neither DRAMA nor Sds may be used from the worker thread, so the
+      worker replaces the action's DRAMA output callbacks (see
+      tdFdelDrama.c) with its own, which save the output of the planning
+      core for the main thread to deal with.  The main thread then passes
+      it on to the DRAMA callbacks.
+
+      Progress is published with a single word release store by the worker
+      and an acquire load by the main thread (see TDFDELTA_LOAD()), no lock
+      is needed.  The cancel flag is set and polled in the same way.  Messages and the command
+      file are only picked up by the main thread under the worker's lock
+      or after the worker has been joined.
+
+      With the STREAM flag, the lines of the command file are passed on
+      at each poll, rather than when the worker completes, so they may
+      be sent as they come (see tdFdeltaDramaFlush()).
+
+      Up to TDFDELTA_MAX_WORKERS workers may run at a time, e.g. one for
+      each plate.  FPIL keeps the clearances in the instrument
+      description, so each worker's plan is given its own (see
+      tdFdeltaFpilNew()), which is freed with the worker.  The core keeps
+      the rest of each plan's state to itself (see tdFdeltaCore.h).
+
+      The PREPARE action starts a worker with no action to poll it (see
+      tdFdeltaThreadPrepare()).  Its result goes only to the result cache
+      and it runs at idle priority, where the system allows, so as not to
+      hold up the observation in progress.  Up to TDFDELTA_MAX_PREPARED
+      such workers may run at a time, in addition to the others.  They
+      are joined and released by tdFdeltaThreadReap() once complete.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Add tdFdeltaPutStats().
+      18-Oct-2026  AGT  Write any trace from the worker.
+      18-Oct-2026  AGT  Add tdFdeltaThreadRunHere().
+      18-Oct-2026  AGT  The worker output is captured by setting the plan's
+                        output callbacks rather then by tdFdeltaWorker()
+                        checks in the output functions.  tdFdeltaPutProgress(),
+                        tdFdeltaMsgOut(), tdFdeltaErsRep() and
+                        tdFdeltaPutStats() move to the planning core.
+      18-Oct-2026  AGT  Release the plan data in the main thread.
+      18-Oct-2026  AGT  Up to TDFDELTA_MAX_WORKERS workers, each with its
+                        own instrument description.
+      18-Oct-2026  AGT  Add tdFdeltaThreadPrepare() and
+                        tdFdeltaThreadHurry().
+      18-Oct-2026  AGT  Pass the lines on at each poll with the STREAM
+                        flag.
+      18-Oct-2026  AGT  Progress and the cancel flag are atomic.
+      19-Oct-2026  AGT  Add tdFdeltaThreadReap(), the PREPARE workers are
+                        also reaped by GENERATE and on exit.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelThread.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelThread.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE          /* For SCHED_IDLE              */
+#endif
+
+#include "DitsTypes.h"       /* Basic dits types            */
+#include "Dits_Err.h"        /* Dits error codes            */
+#include "DitsSys.h"         /* For PutActionHandlers       */
+#include "DitsFix.h"         /* For various Dits routines   */
+#include "DitsMsgOut.h"      /* For MsgOut                  */
+#include "DitsUtil.h"        /* For DitsErrorText           */
+#include "arg.h"             /* For ARG_ macros             */
+#include "sds.h"             /* For SDS_ macros             */
+#include "Sdp.h"             /* Sdp routines                */
+#include "Ers.h"
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdelta.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#define POLL_MS   100       /* Interval at which the main thread polls  */
+#define STREAM_POLL_MS 10   /* Interval when streaming the lines        */
+#define TDFDELTA_MAX_WORKERS 4 /* Worker threads which may run at once   */
+#define TDFDELTA_MAX_PREPARED 2 /* Plans which may be prepared at once   */
+
+/*
+ *  A message or error report queued by the worker.
+ */
+typedef struct tdFworkerMsg {
+    struct tdFworkerMsg *next;
+    int                 isErr;          /* From tdFdeltaErsRep()?      */
+    int                 flags;          /* ErsRep() flags              */
+    char                text[CMDLINE_LENGTH];
+} tdFworkerMsg;
+
+/*
+ *  A command file line generated by the worker.
+ */
+typedef struct tdFworkerLine {
+    struct tdFworkerLine *next;
+    char                 name[20];
+    char                 *text;
+} tdFworkerLine;
+
+/*
+ *  The worker details.  Items marked (W) are only used by the worker
+ *  until it completes, (M) only by the main thread, (L) under the lock.
+ */
+typedef struct tdFworker {
+    pthread_t             thread;
+    pthread_mutex_t       lock;
+    tdFdeltaType          *data;        /* (W) Freed by the worker       */
+    FpilType              inst;         /* The plan's instrument, if own */
+    int                   counted;      /* (M) Counted in numWorkers     */
+    int                   idle;         /* (M) Prepared, at idle priority*/
+    volatile int          cancel;       /* Set by kick, polled by worker */
+    volatile int          progress;     /* DELTA_PROG * 100              */
+    volatile long         eta;          /* DELTA_ETA                     */
+    float                 lastProgress; /* (M) Last value published      */
+    int                   done;         /* (L) Worker has completed      */
+    StatusType            status;       /* (L) Worker completion status  */
+    tdFworkerMsg          *msgs;        /* (L) Messages to output        */
+    tdFworkerMsg          **msgTail;    /* (L) */
+    tdFworkerMsg          *errs;        /* (M) Errors, kept till the end */
+    tdFworkerMsg          **errTail;    /* (M) */
+    tdFdeltaCallbacks     drama;        /* (M) The action's DRAMA output */
+    char                  name[FILENAME_LENGTH]; /* Command file name    */
+    short                 check;        /* Check flags                   */
+    /*
+     *  The command file (W), the lines and whether it is started are
+     *  also read by the main thread under the lock when streaming.
+     */
+    int                   planStarted;  /* (L) cfNew called              */
+    int                   planKeep;     /* cfDone called with keep set   */
+    tdFinterim            header;       /* Initial field details         */
+    tdFworkerLine         *lines;       /* (L) */
+    tdFworkerLine         **lineTail;   /* (L) */
+    unsigned long         numLines;     /* (L) */
+    long int              numMoves;
+    long int              numParks;
+    long int              springOutParks;
+    int                   haveSpringOut;
+    /*
+     *  Statistics (W).
+     */
+    int                   haveStats;    /* stats called                  */
+    tdFstats              stats;
+    /*
+     *  The command file as passed on to the DRAMA output (M).
+     */
+    int                   cfStarted;    /* cfNew passed on               */
+    unsigned long         linesSent;    /* Lines passed on               */
+    tdFworkerLine         **sendPos;    /* Next line to pass on          */
+    StatusType            sendStatus;   /* Error passing lines on        */
+} tdFworker;
+
+static int            numWorkers = 0;    /* Incremented before a worker
+                                           starts, decremented after it
+                                           is joined                       */
+static tdFworker      *prepared[TDFDELTA_MAX_PREPARED]; /* PREPARE workers */
+
+TDFDELTA_PRIVATE void  tdFdeltaThreadPoll(StatusType *status);
+TDFDELTA_PRIVATE void  tdFdeltaThreadKick(StatusType *status);
+
+/*
+ *  Queue a message from the worker.
+ */
+static void QueueMsg(
+    tdFworker   * const worker,
+    const int   isErr,
+    const int   flags,
+    const char  * const text)
+{
+    tdFworkerMsg *m;
+    if ((m = (tdFworkerMsg *)malloc(sizeof(tdFworkerMsg))) == NULL)
+        return;
+    m->next = 0;
+    m->isErr = isErr;
+    m->flags = flags;
+    strncpy(m->text, text, sizeof(m->text)-1);
+    m->text[sizeof(m->text)-1] = '\0';
+
+    pthread_mutex_lock(&worker->lock);
+    *worker->msgTail = m;
+    worker->msgTail = &m->next;
+    pthread_mutex_unlock(&worker->lock);
+}
+
+/*
+ *  The worker's output callbacks, see NewWorker().
+ */
+static void WorkerMsgOut(
+    void        *clientData,
+    const char  *text)
+{
+    QueueMsg((tdFworker *)clientData, 0, 0, text);
+}
+
+static void WorkerErsRep(
+    void        *clientData,
+    int         flags,
+    StatusType  *status,
+    const char  *text)
+{
+    QueueMsg((tdFworker *)clientData, 1, flags, text);
+}
+
+static void WorkerProgress(
+    void        *clientData,
+    float       progress,
+    long int    eta,
+    StatusType  *status)
+{
+    tdFworker *worker = (tdFworker *)clientData;
+    TDFDELTA_STORE(&worker->eta, eta);
+    TDFDELTA_STORE(&worker->progress, (int)(progress*100.0));
+}
+
+static void WorkerStats(
+    void            *clientData,
+    const tdFstats  *stats,
+    StatusType      *status)
+{
+    tdFworker *worker = (tdFworker *)clientData;
+    worker->stats = *stats;
+    worker->haveStats = 1;
+}
+
+static const char *WorkerErrorText(
+    void        *clientData,
+    StatusType  status)
+{
+    return DitsErrorText(status);
+}
+
+static void WorkerCFnew(
+    void              *clientData,
+    const char        *name,
+    const tdFinterim  *currDetails,
+    StatusType        *status)
+{
+    tdFworker *worker = (tdFworker *)clientData;
+    worker->header = *currDetails;
+    pthread_mutex_lock(&worker->lock);
+    worker->planStarted = 1;
+    pthread_mutex_unlock(&worker->lock);
+}
+
+static void WorkerCFline(
+    void        *clientData,
+    const char  *lineName,
+    const char  *cmdLine,
+    StatusType  *status)
+{
+    tdFworker *worker = (tdFworker *)clientData;
+    tdFworkerLine *line;
+
+    if (*status != STATUS__OK) return;
+
+    if (((line = (tdFworkerLine *)malloc(sizeof(tdFworkerLine))) == NULL)||
+        ((line->text = (char *)malloc(strlen(cmdLine)+1)) == NULL)) {
+        free(line);
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    line->next = 0;
+    strncpy(line->name, lineName, sizeof(line->name)-1);
+    line->name[sizeof(line->name)-1] = '\0';
+    strcpy(line->text, cmdLine);
+    pthread_mutex_lock(&worker->lock);
+    *worker->lineTail = line;
+    worker->lineTail = &line->next;
+    ++worker->numLines;
+    pthread_mutex_unlock(&worker->lock);
+}
+
+static void WorkerCFcount(
+    void        *clientData,
+    const char  *name,
+    long int    value,
+    StatusType  *status)
+{
+    tdFworker *worker = (tdFworker *)clientData;
+    if (strcmp(name, "numMoves") == 0)
+        worker->numMoves = value;
+    else if (strcmp(name, "numParks") == 0)
+        worker->numParks = value;
+    else if (strcmp(name, "springOutParks") == 0) {
+        worker->springOutParks = value;
+        worker->haveSpringOut = 1;
+    }
+}
+
+static void WorkerCFdone(
+    void        *clientData,
+    int         keep,
+    StatusType  *status)
+{
+    tdFworker *worker = (tdFworker *)clientData;
+    worker->planKeep = keep;
+}
+
+/*
+ *  Release the worker details, including the plan data, which is
+ *  released here in the main thread as tdFdeltaDataFree() keeps it for
+ *  reuse, and then the plan's instrument.  The worker must have been
+ *  joined.
+ */
+static void FreeWorker(
+    tdFworker   * const worker)
+{
+    while (worker->msgs) {
+        tdFworkerMsg *next = worker->msgs->next;
+        free(worker->msgs);
+        worker->msgs = next;
+    }
+    while (worker->errs) {
+        tdFworkerMsg *next = worker->errs->next;
+        free(worker->errs);
+        worker->errs = next;
+    }
+    while (worker->lines) {
+        tdFworkerLine *next = worker->lines->next;
+        free(worker->lines->text);
+        free(worker->lines);
+        worker->lines = next;
+    }
+    if (worker->data)
+        tdFdeltaDataFree(worker->data);
+    if (worker->inst)
+        FpilFree(worker->inst);
+    if (worker->drama.clientData)
+        tdFdeltaDramaOutFree(&worker->drama);
+    pthread_mutex_destroy(&worker->lock);
+    if (worker->counted)
+        --numWorkers;
+    free(worker);
+}
+
+/*
+ *  Create the worker details.  Ownership of the action data passes to the
+ *  worker, its output callbacks (and so the above item) stay with the
+ *  main thread.
+ */
+static tdFworker *NewWorker(
+    tdFdeltaType * const data,
+    StatusType   * const status)
+{
+    tdFworker *worker;
+
+    if ((worker = (tdFworker *)malloc(sizeof(tdFworker))) == NULL) {
+        *status = TDFDELTA__MALLOCERR;
+        tdFdeltaFreeActData(data);
+        return 0;
+    }
+    memset(worker, 0, sizeof(*worker));
+    pthread_mutex_init(&worker->lock, 0);
+    worker->data = data;
+    worker->msgTail = &worker->msgs;
+    worker->errTail = &worker->errs;
+    worker->lineTail = &worker->lines;
+    worker->sendPos = &worker->lines;
+    worker->lastProgress = -1.0;
+    worker->check = data->check;
+    strcpy(worker->name, data->name);
+    /*
+     *  The DRAMA output callbacks may only be used from the main thread.
+     */
+    worker->drama = data->out;
+    memset(&data->out, 0, sizeof(data->out));
+    data->out.clientData = worker;
+    data->out.msgOut     = WorkerMsgOut;
+    data->out.ersRep     = WorkerErsRep;
+    data->out.progress   = WorkerProgress;
+    data->out.stats      = WorkerStats;
+    data->out.errorText  = WorkerErrorText;
+    data->out.cfNew      = WorkerCFnew;
+    data->out.cfLine     = WorkerCFline;
+    data->out.cfCount    = WorkerCFcount;
+    data->out.cfDone     = WorkerCFdone;
+    return worker;
+}
+
+/*
+ *  Check and sequence the field, in the worker (or whatever thread has
+ *  made itself the worker).
+ */
+static void WorkerRun(
+    tdFworker   * const worker)
+{
+    tdFdeltaType *data = worker->data;
+    StatusType status = STATUS__OK;
+
+    tdFdeltaPlan(data, &worker->cancel, &status);
+    tdFdeltaTraceDone(data, &status);
+    tdFdeltaSnapDone(data, &status);
+    /*
+     *  A result not cached by now never will be.  Releasing the recording
+     *  here drops any pending cache entry (see tdFdeltaCachePrepare()) as
+     *  soon as the plan is done with it.
+     */
+    tdFdeltaCacheFree(data->cache);
+    data->cache = 0;
+
+    pthread_mutex_lock(&worker->lock);
+    worker->status = status;
+    worker->done = 1;
+    pthread_mutex_unlock(&worker->lock);
+}
+
+/*
+ *  Run a worker only when the machine is otherwise idle, or return it to
+ *  normal priority.  Where the system doesn't support this, workers just
+ *  run at normal priority.
+ */
+static void SetIdle(
+    tdFworker   * const worker,
+    const int   idle)
+{
+#ifdef SCHED_IDLE
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    pthread_setschedparam(worker->thread, idle ? SCHED_IDLE : SCHED_OTHER,
+                          &param);
+#endif
+    worker->idle = idle;
+}
+
+/*
+ *  Join and release the PREPARE workers which have completed.  If stop
+ *  is set, those still running are cancelled and waited for.
+ */
+static void ReapPrepared(
+    const int   stop)
+{
+    int i;
+    for (i = 0; i < TDFDELTA_MAX_PREPARED ; ++i) {
+        tdFworker *worker = prepared[i];
+        int done;
+        if (!worker) continue;
+        if (stop) {
+            TDFDELTA_STORE(&worker->cancel, 1);
+            if (worker->idle) SetIdle(worker, 0);
+        }
+        pthread_mutex_lock(&worker->lock);
+        done = worker->done;
+        pthread_mutex_unlock(&worker->lock);
+        if ((done)||(stop)) {
+            pthread_join(worker->thread, 0);
+            FreeWorker(worker);
+            prepared[i] = 0;
+        }
+    }
+}
+
+/*
+ *  The worker thread.
+ */
+static void *WorkerMain(void *arg)
+{
+    tdFworker * const worker = (tdFworker *)arg;
+
+    WorkerRun(worker);
+    return 0;
+}
+
+/*
+ *  Pass the first numLines lines saved by the worker to the action's
+ *  DRAMA output callbacks, starting the command file if need be.  Those
+ *  already passed on are skipped.  The lines must have been counted
+ *  under the lock, or the worker joined.
+ */
+static void PassLines(
+    tdFworker     * const worker,
+    unsigned long numLines,
+    StatusType    * const status)
+{
+    const tdFdeltaCallbacks * const out = &worker->drama;
+    tdFworkerLine *line;
+
+    if (*status != STATUS__OK) return;
+
+    if (!worker->cfStarted) {
+        (*out->cfNew)(out->clientData, worker->name, &worker->header, status);
+        worker->cfStarted = 1;
+    }
+    while ((worker->linesSent < numLines)&&(*status == STATUS__OK)) {
+        line = *worker->sendPos;
+        (*out->cfLine)(out->clientData, line->name, line->text, status);
+        worker->sendPos = &line->next;
+        ++worker->linesSent;
+    }
+}
+
+/*
+ *  Build the command file from the lines saved by the worker, by passing
+ *  them to the action's DRAMA output callbacks.
+ */
+static void BuildCmdFile(
+    tdFworker   * const worker,
+    StatusType  * const status)
+{
+    const tdFdeltaCallbacks * const out = &worker->drama;
+
+    if (*status != STATUS__OK) return;
+
+    PassLines(worker, worker->numLines, status);
+    (*out->cfCount)(out->clientData, "numMoves", worker->numMoves, status);
+    (*out->cfCount)(out->clientData, "numParks", worker->numParks, status);
+    if (worker->haveSpringOut)
+        (*out->cfCount)(out->clientData, "springOutParks",
+                        worker->springOutParks, status);
+    if (*status != STATUS__OK) {
+        StatusType ignore = STATUS__OK;
+        (*out->cfDone)(out->clientData, 0, &ignore);
+        ErsRep(0, status, "Error building command file - %s",
+               DitsErrorText(*status));
+        return;
+    }
+    (*out->cfDone)(out->clientData, 1, status);
+}
+
+
+/*+        T D F D E L T A T H R E A D
+
+ *  Function name:
+      tdFdeltaThreadStart
+
+ *  Function:
+      Start a worker thread to check and sequence a field.
+
+ *  Description:
+      Invoked from an action handler, in place of staging to
+      tdFdeltaFieldCheck().  Ownership of the action data passes to
+      the worker, which plans with its own instrument description.  The
+      action is rescheduled to poll the worker every POLL_MS milliseconds
+      until it completes.  The kick handler is replaced with one which
+      asks the worker to stop.  Fails if TDFDELTA_MAX_WORKERS workers
+      are running.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaThreadStart (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The action data.  Is freed by
+                                        this call on error.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Proir Requirements:
+      Must be called from an action handler.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Several workers, each with its own instrument.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaThreadStart (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFworker *worker;
+    DitsDeltaTimeType delay;
+
+    if (*status != STATUS__OK) return;
+
+    if (numWorkers >= TDFDELTA_MAX_WORKERS) {
+        *status = TDFDELTA__THREADERR;
+        ErsRep(0, status, "%d delta worker threads are already running",
+               numWorkers);
+        tdFdeltaFreeActData(data);
+        return;
+    }
+    if ((worker = NewWorker(data, status)) == 0)
+        return;
+    worker->counted = 1;
+    ++numWorkers;
+    if (!tdFdeltaFpilNew(&worker->inst)) {
+        *status = TDFDELTA__THREADERR;
+        ErsRep(0, status, "Failed to create the worker's instrument model");
+        FreeWorker(worker);
+        return;
+    }
+    data->inst = worker->inst;
+    if (pthread_create(&worker->thread, 0, WorkerMain, worker) != 0) {
+        *status = TDFDELTA__THREADERR;
+        ErsRep(0, status, "Failed to create delta worker thread");
+        tdFdeltaDataFree(data);
+        worker->data = 0;
+        FreeWorker(worker);
+        return;
+    }
+
+    if (data->check & SHOW)
+        MsgOut(status, "Running delta in a worker thread...");
+
+    DitsPutActData(worker, status);
+    DitsPutKickHandler(tdFdeltaThreadKick, status);
+    DitsPutHandler(tdFdeltaThreadPoll, status);
+    DitsDeltaTime(0, (worker->check & STREAM ? STREAM_POLL_MS : POLL_MS)
+                     *1000, &delay);
+    DitsPutDelay(&delay, status);
+    DitsPutRequest(DITS_REQ_WAIT, status);
+}
+
+/*
+ *  Internal Function, name:
+      tdFdeltaThreadPoll
+
+ *  Description:
+      Action handler invoked in the main thread to check on the worker.
+      Outputs messages, publishes progress and, once the worker is
+      complete, builds the command file or reports the errors.  With the
+      STREAM flag, the lines so far are passed on and sent at each poll.
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Pass the lines on at each poll when streaming.
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaThreadPoll (
+        StatusType  *status)
+{
+    tdFworker *worker = DitsGetActData();
+    tdFworkerMsg *msgs;
+    tdFworkerMsg *m;
+    float progress;
+    int done;
+    int started;
+    unsigned long numLines;
+    DitsDeltaTimeType delay;
+
+    if (*status != STATUS__OK) return;
+
+    pthread_mutex_lock(&worker->lock);
+    msgs = worker->msgs;
+    worker->msgs = 0;
+    worker->msgTail = &worker->msgs;
+    done = worker->done;
+    started = worker->planStarted;
+    numLines = worker->numLines;
+    pthread_mutex_unlock(&worker->lock);
+
+    /*
+     *  Output messages, keep errors till the end.
+     */
+    while (msgs) {
+        m = msgs;
+        msgs = msgs->next;
+        if (m->isErr) {
+            m->next = 0;
+            *worker->errTail = m;
+            worker->errTail = &m->next;
+        } else {
+            MsgOut(status, "%s", m->text);
+            free(m);
+        }
+    }
+
+    progress = (float)TDFDELTA_LOAD(&worker->progress)/100.0;
+    if (progress != worker->lastProgress) {
+        worker->lastProgress = progress;
+        SdpPutf("DELTA_PROG", progress, status);
+        SdpPuti("DELTA_ETA", TDFDELTA_LOAD(&worker->eta), status);
+    }
+
+    if (!done) {
+        /*
+         *  Pass on the lines so far.  On error the worker is stopped and
+         *  the error reported when it has.
+         */
+        if ((worker->check & STREAM)&&(started)&&
+            (!TDFDELTA_LOAD(&worker->cancel))) {
+            PassLines(worker, numLines, &worker->sendStatus);
+            tdFdeltaDramaFlush(&worker->drama, &worker->sendStatus);
+            if (worker->sendStatus != STATUS__OK)
+                TDFDELTA_STORE(&worker->cancel, 1);
+        }
+        DitsDeltaTime(0, (worker->check & STREAM ? STREAM_POLL_MS : POLL_MS)
+                         *1000, &delay);
+        DitsPutDelay(&delay, status);
+        DitsPutRequest(DITS_REQ_WAIT, status);
+        return;
+    }
+    pthread_join(worker->thread, 0);
+
+    if ((worker->haveStats)&&(worker->drama.stats))
+        (*worker->drama.stats)(worker->drama.clientData, &worker->stats,
+                               status);
+    if (worker->sendStatus != STATUS__OK) {
+        *status = worker->sendStatus;
+        ErsRep(0, status, "Error sending command file lines - %s",
+               DitsErrorText(*status));
+    } else if (TDFDELTA_LOAD(&worker->cancel)) {
+        MsgOut(status, "%s action terminated", tdFdeltaActionName());
+    } else if (worker->status != STATUS__OK) {
+        *status = worker->status;
+        for (m = worker->errs; m ; m = m->next)
+            ErsRep(m->flags, status, "%s", m->text);
+    } else {
+        for (m = worker->errs; m ; m = m->next)
+            MsgOut(status, "%s", m->text);
+        if (worker->planKeep)
+            BuildCmdFile(worker, status);
+    }
+    FreeWorker(worker);
+}
+
+/*
+ *  Internal Function, name:
+      tdFdeltaThreadKick
+
+ *  Description:
+      Kick handler whilst a worker is running.  Asks the worker to stop,
+      the poll handler ends the action once it has.
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaThreadKick (
+        StatusType  *status)
+{
+    tdFworker *worker = DitsGetActData();
+    TDFDELTA_STORE(&worker->cancel, 1);
+}
+
+
+/*+        T D F D E L T A T H R E A D
+
+ *  Function name:
+      tdFdeltaThreadBusy
+
+ *  Function:
+      Returns true if any worker thread is running.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaThreadBusy ()
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaThreadBusy (void)
+{
+    return (numWorkers != 0);
+}
+
+
+/*+        T D F D E L T A T H R E A D
+
+ *  Function name:
+      tdFdeltaThreadRunHere
+
+ *  Function:
+      Check and sequence a field in the calling thread, without DRAMA.
+
+ *  Description:
+      Runs the field check and sequencer exactly as the worker thread
+      would, but in the calling thread, which need not be a DRAMA task.
+      The output is captured by the worker callbacks rather than sent to
+      DRAMA.  Once complete, messages are written to
+      stdout and error reports to stderr.  The command file lines, if a
+      command file was generated, are written to cmdFile as
+      "<item> <line>" pairs, followed by the move and park counts.
+
+      Used by offline programs such as tdFreplay.  The plan uses its
+      own instrument description if it has one, otherwise the shared
+      one.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaThreadRunHere (data, cmdFile, stats, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The plan data, e.g. as returned
+                                        by tdFdeltaSnapLoad().  Is freed
+                                        by this call.
+      (>) cmdFile     (FILE *)          Where to write the command file.
+                                        May be null.
+      (<) stats       (tdFstats *)      The statistics.  May be null.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  May be run whilst workers are running.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaThreadRunHere (
+        tdFdeltaType  *data,
+        FILE          *cmdFile,
+        tdFstats      *stats,
+        StatusType    *status)
+{
+    tdFworker *worker;
+    tdFworkerMsg *m;
+    tdFworkerLine *line;
+
+    if (*status != STATUS__OK) return;
+
+    if ((worker = NewWorker(data, status)) == 0)
+        return;
+    WorkerRun(worker);
+
+    for (m = worker->msgs; m ; m = m->next)
+        fprintf(m->isErr ? stderr : stdout, "%s\n", m->text);
+    if (stats)
+        *stats = worker->stats;
+    if (worker->status != STATUS__OK)
+        *status = worker->status;
+    else if ((worker->planKeep)&&(cmdFile)) {
+        for (line = worker->lines; line ; line = line->next)
+            fprintf(cmdFile, "%s %s\n", line->name, line->text);
+        fprintf(cmdFile, "numMoves %ld\nnumParks %ld\n",
+                worker->numMoves, worker->numParks);
+        if (worker->haveSpringOut)
+            fprintf(cmdFile, "springOutParks %ld\n", worker->springOutParks);
+    }
+    FreeWorker(worker);
+}
+
+
+/*+        T D F D E L T A T H R E A D
+
+ *  Function name:
+      tdFdeltaThreadPrepare
+
+ *  Function:
+      Start a worker thread to prepare a plan in advance.
+
+ *  Description:
+      Used by the PREPARE action once tdFdeltaCachePrepare() has entered
+      the plan in the result cache.  The plan is checked and sequenced
+      by a worker, with its own instrument description, at idle priority
+      where the system allows.  Nothing waits for it - the plan has no
+      output callbacks and its result only goes to the cache, for the
+      GENERATE which needs it to find (see tdFdeltaThreadHurry()).
+
+      The workers of earlier prepared plans which have completed are
+      joined and released first.  Fails if TDFDELTA_MAX_PREPARED are
+      still running.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaThreadPrepare (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) data        (tdFdeltaType *)  The plan data, with no output
+                                        callbacks.  Is freed by this
+                                        call on error.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Proir Requirements:
+      Must be called from the main thread.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaThreadPrepare (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFworker *worker;
+    int slot = -1;
+    int i;
+
+    if (*status != STATUS__OK) {
+        tdFdeltaDataFree(data);
+        return;
+    }
+
+    ReapPrepared(NO);
+    for (i = 0; i < TDFDELTA_MAX_PREPARED ; ++i) {
+        if (!prepared[i]) slot = i;
+    }
+    if (slot < 0) {
+        *status = TDFDELTA__THREADERR;
+        ErsRep(0, status, "%d plans are already being prepared",
+               TDFDELTA_MAX_PREPARED);
+        tdFdeltaDataFree(data);
+        return;
+    }
+    if ((worker = NewWorker(data, status)) == 0)
+        return;
+    /*
+     *  Nobody to tell - drop the output NewWorker() would capture.
+     */
+    memset(&data->out, 0, sizeof(data->out));
+    if (!tdFdeltaFpilNew(&worker->inst)) {
+        *status = TDFDELTA__THREADERR;
+        ErsRep(0, status, "Failed to create the worker's instrument model");
+        FreeWorker(worker);
+        return;
+    }
+    data->inst = worker->inst;
+    if (pthread_create(&worker->thread, 0, WorkerMain, worker) != 0) {
+        *status = TDFDELTA__THREADERR;
+        ErsRep(0, status, "Failed to create delta worker thread");
+        FreeWorker(worker);
+        return;
+    }
+    SetIdle(worker, 1);
+    prepared[slot] = worker;
+}
+
+
+/*+        T D F D E L T A T H R E A D
+
+ *  Function name:
+      tdFdeltaThreadHurry
+
+ *  Function:
+      Return the workers of prepared plans to normal priority.
+
+ *  Description:
+      Called when a GENERATE finds its result is still being prepared
+      (see tdFdeltaCacheLookup()), as the plan is then on the critical
+      path.  All PREPARE workers still running are hurried, since we
+      don't know which one has the result.  If the system won't allow
+      it, they carry on at idle priority.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaThreadHurry ()
+
+ *  Proir Requirements:
+      Must be called from the main thread.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaThreadHurry (void)
+{
+    int i;
+    for (i = 0; i < TDFDELTA_MAX_PREPARED ; ++i) {
+        if ((prepared[i])&&(prepared[i]->idle))
+            SetIdle(prepared[i], 0);
+    }
+}
+
+
+/*+        T D F D E L T A T H R E A D
+
+ *  Function name:
+      tdFdeltaThreadReap
+
+ *  Function:
+      Join and release the workers of prepared plans.
+
+ *  Description:
+      The workers of prepared plans which have completed are joined and
+      their plan data and instrument descriptions released.  This is
+      done by tdFdeltaThreadPrepare() before starting another, by
+      GENERATE when it finds the prepared result in the cache, and on
+      exit.
+
+      If stop is set, as on exit, those still running are cancelled,
+      returned to normal priority and waited for too, so none is left
+      using the core when the data pool is flushed and the instrument
+      description freed.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaThreadReap (stop)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) stop        (int)             Cancel and wait for the workers
+                                        still running.
+
+ *  Proir Requirements:
+      Must be called from the main thread.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      19-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaThreadReap (
+        int         stop)
+{
+    ReapPrepared(stop);
+}
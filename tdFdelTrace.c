@@ -0,0 +1,507 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaTrace
+
+ *  Function:
+      Trace of sequencer decisions, written as a Chrome trace.
+
+ *  Description:
+      When the TRACE flag is given to GENERATE or REPLAN, the sequencer
+      records its decisions in a ring buffer of TDFDELTA_TRACE_EVENTS
+      events - each direct move verdict (and the blocking pivot if
+      the move is prevented), each park choice, each crossover list
+      change and each timed phase (see tdFdeltaStatsPhase()).  If the buffer
+      fills, the oldest events are overwritten.
+
+      When the action completes (successfully or not) the buffer is
+      written to the file "<name>.trace.json" in the task's working
+      directory, where <name> is the last component of the command file
+      name with any character other than a letter, digit, '.', '-' or
+      '_' replaced by '_', in the Chrome trace event format.  This can be
+      loaded into chrome://tracing or https://ui.perfetto.dev.
+
+      Recording is done with TDFDELTA_TRACE(), which only costs a test
+      of tdFdeltaTracing when not tracing.  Each traced plan has its own
+      buffer (data->trace).  tdFdeltaUse() calls tdFdeltaTraceUse() with
+      it, so events are recorded in the buffer of the plan the thread is
+      running, and not at all for plans which are not traced.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Moved to the planning core.
+      18-Oct-2026  AGT  A buffer for each traced plan, selected per thread.
+                        Add tdFdeltaTraceFree().
+      19-Oct-2026  AGT  The trace file is named from the last component
+                        of the command file name, sanitised, and the
+                        name is escaped in the JSON.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelTrace.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelTrace.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef struct tdFtraceEvent {
+    double ts;                  /* Start, seconds from trace start        */
+    double dur;                 /* Duration (spans only)                  */
+    short  type;                /* TDF_TRACE_ code                        */
+    short  piv;                 /* Pivot number                           */
+    short  other;               /* Other pivot number, or count           */
+    short  arg;                 /* Type specific                          */
+} tdFtraceEvent;
+
+struct tdFtrace {
+    tdFtraceEvent  *events;             /* The ring buffer               */
+    unsigned long  numEvents;           /* Events recorded, inc. lost    */
+    double         tOrigin;             /* tdFdeltaClock() at start      */
+    char           name[FILENAME_LENGTH];
+};
+
+/*
+ *  The trace of the plan this thread is running, see tdFdeltaTraceUse().
+ */
+static TDFDELTA_TLS tdFtrace *cur = 0;
+
+TDFDELTA_TLS int tdFdeltaTracing = NO;
+
+/*
+ *  Return the next slot in the ring buffer.
+ */
+static tdFtraceEvent *NextEvent(void)
+{
+    return &cur->events[(cur->numEvents++) % TDFDELTA_TRACE_EVENTS];
+}
+
+/*
+ *  The trace file name for a command file name, see the module
+ *  description.  Only the last component is used, so the trace can't be
+ *  written elsewhere.
+ */
+static void FileName(
+        const char  *name,
+        char        fileName[FILENAME_LENGTH+20])
+{
+    const char *base = strrchr(name, '/');
+    char *f = fileName;
+
+    base = (base ? base+1 : name);
+    if (*base == '\0') base = "delta";
+    for ( ; (*base)&&(f < fileName+FILENAME_LENGTH-1) ; ++base, ++f) {
+        *f = ((isalnum((unsigned char)*base))||(*base == '.')||
+              (*base == '-')||(*base == '_')) ? *base : '_';
+    }
+    strcpy(f, ".trace.json");
+}
+
+/*
+ *  Write a string as a JSON string, escaping as needed.
+ */
+static void WriteString(
+        FILE        *fp,
+        const char  *s)
+{
+    putc('"', fp);
+    for ( ; *s ; ++s) {
+        if ((*s == '"')||(*s == '\\'))
+            fprintf(fp, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(fp, "\\u%04x", (unsigned)(unsigned char)*s);
+        else
+            putc(*s, fp);
+    }
+    putc('"', fp);
+}
+
+/*
+ *  Write one event as JSON.
+ */
+static void WriteEvent(
+        FILE                 *fp,
+        const tdFtraceEvent  *e,
+        int                  first)
+{
+    const char *sep = (first ? "\n" : ",\n");
+    double ts = e->ts*1.0e6;    /* Chrome wants microseconds */
+
+    switch (e->type) {
+      case TDF_TRACE_MOVE:
+        fprintf(fp, "%s{\"name\":\"move\",\"cat\":\"verdict\",\"ph\":\"i\","
+                "\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+                "\"args\":{\"piv\":%d}}", sep, ts, e->piv);
+        break;
+      case TDF_TRACE_BLOCKED:
+        fprintf(fp, "%s{\"name\":\"blocked\",\"cat\":\"verdict\",\"ph\":\"i\","
+                "\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+                "\"args\":{\"piv\":%d,\"by\":%d,\"reason\":\"%s\"}}",
+                sep, ts, e->piv, e->other,
+                (e->arg ? "crossed" : "collision"));
+        break;
+      case TDF_TRACE_PARK:
+        fprintf(fp, "%s{\"name\":\"park\",\"cat\":\"park\",\"ph\":\"i\","
+                "\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+                "\"args\":{\"piv\":%d,\"prevented\":%d,\"timesParked\":%d}}",
+                sep, ts, e->piv, e->other, e->arg);
+        break;
+      case TDF_TRACE_CROSS_ADD:
+      case TDF_TRACE_CROSS_DEL:
+        fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"cross\",\"ph\":\"i\","
+                "\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+                "\"args\":{\"above\":%d,\"below\":%d}}", sep,
+                (e->type == TDF_TRACE_CROSS_ADD ? "crossAdd" : "crossDelete"),
+                ts, e->piv, e->other);
+        break;
+      default:
+        fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\","
+                "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}", sep,
+                tdFdeltaStatsPhaseName(e->type - TDF_TRACE_PHASE),
+                ts, e->dur*1.0e6);
+        break;
+    }
+}
+
+
+/*+        T D F D E L T A T R A C E
+
+ *  Function name:
+      tdFdeltaTraceStart
+
+ *  Function:
+      Start a trace.
+
+ *  Description:
+      Allocates the plan's ring buffer if needed, empties it and enables
+      tracing for the plan, which must be selected (see tdFdeltaUse()).
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaTraceStart (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.  The command file
+                                        name is used to name the trace
+                                        file.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  The buffer belongs to the plan.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaTraceStart (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFtrace *trace = data->trace;
+
+    if (*status != STATUS__OK) return;
+
+    if ((!trace) &&
+        ((trace = (tdFtrace *)calloc(1, sizeof(tdFtrace))) == NULL)) {
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    if ((!trace->events) &&
+        ((trace->events = (tdFtraceEvent *)malloc(
+             TDFDELTA_TRACE_EVENTS*sizeof(tdFtraceEvent))) == NULL)) {
+        free(trace);
+        *status = TDFDELTA__MALLOCERR;
+        return;
+    }
+    trace->numEvents = 0;
+    trace->tOrigin = tdFdeltaClock();
+    strncpy(trace->name, data->name, sizeof(trace->name)-1);
+    trace->name[sizeof(trace->name)-1] = '\0';
+    data->trace = trace;
+    tdFdeltaTraceUse(trace);
+}
+
+
+/*+        T D F D E L T A T R A C E
+
+ *  Function name:
+      tdFdeltaTraceUse
+
+ *  Function:
+      Select the trace events are recorded in.
+
+ *  Description:
+      Called by tdFdeltaUse() with the plan's trace, so events are only
+      recorded for traced plans, each in its own buffer.  Applies to the
+      calling thread.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaTraceUse (trace)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) trace       (tdFtrace *)      The plan's trace, null if the
+                                        plan is not being traced.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Given the plan's trace rather than a flag.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaTraceUse (
+        tdFtrace    *trace)
+{
+    cur = trace;
+    tdFdeltaTracing = (trace != 0);
+}
+
+
+/*+        T D F D E L T A T R A C E
+
+ *  Function name:
+      tdFdeltaTraceAdd
+
+ *  Function:
+      Record an event.
+
+ *  Description:
+      Normally invoked via the TDFDELTA_TRACE() macro.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaTraceAdd (type, piv, other, arg)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) type        (int)             The TDF_TRACE_ code.
+      (>) piv         (int)             The pivot number.
+      (>) other       (int)             TDF_TRACE_BLOCKED - the blocking
+                                          pivot.
+                                        TDF_TRACE_PARK - number of moves
+                                          the pivot has prevented.
+                                        TDF_TRACE_CROSS_ADD/DEL - the pivot
+                                          crossed below piv.
+      (>) arg         (int)             TDF_TRACE_BLOCKED - true if crossed
+                                          rather than a collision.
+                                        TDF_TRACE_PARK - times already
+                                          parked.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaTraceAdd (
+        int         type,
+        int         piv,
+        int         other,
+        int         arg)
+{
+    tdFtraceEvent *e;
+    if (!tdFdeltaTracing) return;
+    e = NextEvent();
+    e->ts    = tdFdeltaClock() - cur->tOrigin;
+    e->dur   = 0.0;
+    e->type  = (short)type;
+    e->piv   = (short)piv;
+    e->other = (short)other;
+    e->arg   = (short)arg;
+}
+
+
+/*+        T D F D E L T A T R A C E
+
+ *  Function name:
+      tdFdeltaTraceSpan
+
+ *  Function:
+      Record a timed span.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaTraceSpan (type, tStart, tEnd)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) type        (int)             TDF_TRACE_PHASE + the TDF_PHASE_ code.
+      (>) tStart      (double)          tdFdeltaClock() at the start.
+      (>) tEnd        (double)          tdFdeltaClock() at the end.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaTraceSpan (
+        int         type,
+        double      tStart,
+        double      tEnd)
+{
+    tdFtraceEvent *e;
+    if (!tdFdeltaTracing) return;
+    e = NextEvent();
+    e->ts    = tStart - cur->tOrigin;
+    e->dur   = tEnd - tStart;
+    e->type  = (short)type;
+    e->piv   = e->other = e->arg = 0;
+}
+
+
+/*+        T D F D E L T A T R A C E
+
+ *  Function name:
+      tdFdeltaTraceDone
+
+ *  Function:
+      Write the trace file and end the trace.
+
+ *  Description:
+      Does nothing unless the plan is being traced.  A failure to write
+      the file is reported as a warning, it does not fail the action.
+      The trace is then released.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaTraceDone (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (!) status      (StatusType *)    Modified status.  Only used to
+                                        output messages.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Given the plan data.
+      19-Oct-2026  AGT  Sanitise the file name, escape the JSON name.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaTraceDone (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    tdFtrace      *trace = data->trace;
+    StatusType    ignore = STATUS__OK;
+    char          fileName[FILENAME_LENGTH+20];
+    FILE          *fp;
+    unsigned long first, i;
+    unsigned long lost;
+
+    if (!trace) return;
+
+    FileName(trace->name, fileName);
+    if ((fp = fopen(fileName, "w")) == NULL) {
+        tdFdeltaMsgOut(&ignore, "WARNING:Failed to open trace file %s",
+                       fileName);
+        tdFdeltaTraceFree(data);
+        return;
+    }
+    lost  = (trace->numEvents > TDFDELTA_TRACE_EVENTS ?
+             trace->numEvents - TDFDELTA_TRACE_EVENTS : 0);
+    first = lost;
+
+    fprintf(fp, "{\"traceEvents\":[");
+    for (i = first; i < trace->numEvents ; ++i)
+        WriteEvent(fp, &trace->events[i % TDFDELTA_TRACE_EVENTS],
+                   i == first);
+    fprintf(fp, "\n],\n\"displayTimeUnit\":\"ms\",\n"
+            "\"otherData\":{\"name\":");
+    WriteString(fp, trace->name);
+    fprintf(fp, ",\"events\":%lu,\"lost\":%lu}}\n",
+            trace->numEvents, lost);
+
+    if (fclose(fp) != 0)
+        tdFdeltaMsgOut(&ignore, "WARNING:Error writing trace file %s",
+                       fileName);
+    else if (*status == STATUS__OK)
+        tdFdeltaMsgOut(status, "Trace written to %s (%lu events%s)",
+                       fileName, trace->numEvents - lost,
+                       (lost ? ", oldest lost" : ""));
+    tdFdeltaTraceFree(data);
+}
+
+
+/*+        T D F D E L T A T R A C E
+
+ *  Function name:
+      tdFdeltaTraceFree
+
+ *  Function:
+      Release a plan's trace without writing it.
+
+ *  Description:
+      Called by tdFdeltaTraceDone() and tdFdeltaDataFree().  If the trace
+      is selected in the calling thread, tracing stops.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaTraceFree (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaTraceFree (
+        tdFdeltaType  *data)
+{
+    if (!data->trace) return;
+    if (cur == data->trace)
+        tdFdeltaTraceUse(0);
+    free(data->trace->events);
+    free(data->trace);
+    data->trace = 0;
+}
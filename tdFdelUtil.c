@@ -17,6 +17,13 @@
 
  *  History:
       30-Jun-1994  JW   Original version
+      18-Oct-2026  AGT  Add tdFdeltaClock().  tdFdeltaKick() now defers to
+                        a time sliced sequencer.
+      18-Oct-2026  AGT  Add tdFdeltaProgInit() and tdFdeltaProgress(), a
+                        time based progress model.
+      18-Oct-2026  AGT  tdFdeltaClock(), tdFdeltaProgInit() and
+                        tdFdeltaProgress() moved to the planning core
+                        (tdFdelCore.c).
       {@change entry@}
 
  *  @(#) $Id: ACMM:2dFdelta/tdFdelUtil.c,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
@@ -163,6 +170,13 @@ TDFDELTA_INTERNAL void  tdFdeltaGetFlag (
  *  History:
       30-Jun-1994  JW   Original version
       01-Nov-2000  TJF  Support SPECIAL flag.
+      18-Oct-2026  AGT  Support THREAD flag.
+      18-Oct-2026  AGT  Support TRACE flag.
+      18-Oct-2026  AGT  Support SNAPSHOT flag.
+      18-Oct-2026  AGT  Support INT_GEOM flag.
+      18-Oct-2026  AGT  Support PACKED flag.
+      18-Oct-2026  AGT  Support STREAM flag.
+      19-Oct-2026  AGT  INT_GEOM flag removed.
       {@change entry@}
  */
 TDFDELTA_INTERNAL void  tdFdeltaFlagCheck (
@@ -267,6 +281,61 @@ TDFDELTA_INTERNAL void  tdFdeltaFlagCheck (
                 MsgOut(status,"SPECIAL flag set");
         }
     }
+    /*
+     *  Check for TRACE if requested.
+     */
+    if (checkFor & TRACE) {
+        tdFdeltaGetFlag(paramId,"TRACE",&flag,status);
+        if (flag == YES) {
+            *argFlags += TRACE;
+            if (*argFlags & _DEBUG)
+                MsgOut(status,"TRACE flag set");
+        }
+    }
+    /*
+     *  Check for SNAPSHOT if requested.
+     */
+    if (checkFor & SNAPSHOT) {
+        tdFdeltaGetFlag(paramId,"SNAPSHOT",&flag,status);
+        if (flag == YES) {
+            *argFlags += SNAPSHOT;
+            if (*argFlags & _DEBUG)
+                MsgOut(status,"SNAPSHOT flag set");
+        }
+    }
+    /*
+     *  Check for PACKED if requested.
+     */
+    if (checkFor & PACKED) {
+        tdFdeltaGetFlag(paramId,"PACKED",&flag,status);
+        if (flag == YES) {
+            *argFlags += PACKED;
+            if (*argFlags & _DEBUG)
+                MsgOut(status,"PACKED flag set");
+        }
+    }
+    /*
+     *  Check for STREAM if requested.
+     */
+    if (checkFor & STREAM) {
+        tdFdeltaGetFlag(paramId,"STREAM",&flag,status);
+        if (flag == YES) {
+            *argFlags += STREAM;
+            if (*argFlags & _DEBUG)
+                MsgOut(status,"STREAM flag set");
+        }
+    }
+    /*
+     *  Check for THREAD if requested.
+     */
+    if (checkFor & THREAD) {
+        tdFdeltaGetFlag(paramId,"THREAD",&flag,status);
+        if (flag == YES) {
+            *argFlags += THREAD;
+            if (*argFlags & _DEBUG)
+                MsgOut(status,"THREAD flag set");
+        }
+    }
 
 }
 
@@ -320,6 +389,12 @@ TDFDELTA_INTERNAL char  *tdFdeltaActionName ()
  *  Description:
       All kick actions will result in the aborting of the action.
 
+      If tdFdeltaSequencer() is running, it may be part way through
+      a time slice sequence and owns resources we can't see from here.  In
+      this case we just flag the cancellation and leave the action
+      rescheduled, the sequencer will clean up and end the action when it
+      next runs.
+
  *  Language:
       C
 
@@ -337,12 +412,19 @@ TDFDELTA_INTERNAL char  *tdFdeltaActionName ()
 
  *  History:
       30-Jun-1994  JW   Original version
+      18-Oct-2026  AGT  Defer to tdFdeltaSequencer() if it is running.
+      18-Oct-2026  AGT  Release the action data with tdFdeltaFreeActData().
       {@change entry@}
  */
 TDFDELTA_INTERNAL void  tdFdeltaKick (
         StatusType  *status)
 {
-    free((void *)DitsGetActData());
+    tdFdeltaType *data = DitsGetActData();
+    if (data && data->seq.started) {
+        data->seq.cancel = YES;
+        return;
+    }
+    tdFdeltaFreeActData(data);
     MsgOut(status,"%s action terminated",tdFdeltaActionName());
     DitsPutRequest(DITS_REQ_END,status);
 }
@@ -0,0 +1,678 @@
+/*+           T D F D E L T A
+
+ *  Module name:
+      tdFdeltaWarm
+
+ *  Function:
+      Warm start of the field check and sequencer from the last plan.
+
+ *  Description:
+      A tweak moves most fibres by a few hundred microns from where the
+      last configure left them, so nearly all pairs of fibres which were
+      well clear of each other still are.  This module keeps, from the
+      end of the last successful sequence, the final field (the
+      reference positions) and a matrix saying which pairs of pivots are
+      clear of each other there with a margin - the buttons, each button
+      and the other's fibre and the fibres (which may not cross) are all
+      at least 2*TDFDELTA_WARM_TOL further apart than the clearances
+      require.  Such a pair remains clear as long as neither pivot has
+      moved more than TDFDELTA_WARM_TOL from its reference position, so
+      the field check and the sequencer need not check it.
+
+      A position is within the tolerance of the reference (see Near())
+      if it is parked and the reference is parked, or if neither is
+      parked, the fibre end has moved by no more than the tolerance less
+      TDFDELTA_WARM_ARM times the change in theta (in radians, allowing
+      for the button rotating about the fibre end) and the fibre virtual
+      pivot point has moved by no more than the tolerance.
+
+      tdFdeltaWarmBegin() is called at the start of the field check and
+      of the sequencer.  It decides if the saved matrix applies (same
+      number of pivots, pivot positions and clearances) and which target
+      positions are within tolerance of the reference.  The pair loops
+      then call tdFdeltaWarmSkip() before their collision checks.  The
+      results are exactly as without it, just with fewer checks.
+
+      tdFdeltaWarmSave() is called when a sequence is complete.  Pivots
+      whose final position is within tolerance of their reference keep
+      their reference position, so the margin always holds.  The others
+      take their final position as their new reference and only the
+      pairs involving them are checked again.  If the matrix didn't
+      apply, it is built from scratch.  So the work needed to replan a
+      tweak depends on how many fibres moved beyond the tolerance, not
+      on the number of pivots.
+
+      There are TDFDELTA_WARM_REFS sets of reference positions and
+      matrices, so a task configuring both plates keeps one for each.  A
+      plan claims the set it uses (in tdFdeltaWarmBegin() or
+      tdFdeltaWarmSave()) until its save is done or the plan is released,
+      so plans running at the same time never share a set.  A plan
+      which finds no unclaimed set that applies just starts cold, and
+      its save replaces the least recently saved unclaimed set.  The
+      claims are made under tdFdeltaLock(), the sets are used without it.
+
+      The matrices are cleared when the instrument is changed (see
+      tdFdeltaFpilSet()).
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Collision checks through tdFdelGeom.c (INT_GEOM flag).
+      18-Oct-2026  AGT  Pivot count from tdFdeltaNumPivots(), constant in
+                        a single instrument build.
+      18-Oct-2026  AGT  Several reference sets, claimed by the plans using
+                        them, so plans may run at the same time.  Add
+                        tdFdeltaWarmUse() and tdFdeltaWarmRelease().
+      19-Oct-2026  AGT  Initialise all of noUse.
+      19-Oct-2026  AGT  Collision checks call FPIL directly again,
+                        tdFdelGeom.c removed.
+      {@change entry@}
+
+
+ *     @(#) $Id: ACMM:2dFdelta/tdFdelWarm.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
+ */
+
+/*
+ *  Include files.
+ */
+
+
+static char *rcsId="@(#) $Id: ACMM:2dFdelta/tdFdelWarm.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $";
+static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
+
+
+#include "status.h"          /* STATUS__OK definition       */
+
+#include "tdFdeltaCore.h"
+#include "tdFdelta_Err.h"
+
+#include <math.h>
+#include <string.h>
+
+#define ROW_BYTES   ((FPIL_MAXPIVOTS+7)/8)
+
+/*
+ *  A set of reference positions and pair matrix.  clear[i] has bit j set
+ *  if pivots i and j are clear of each other with margin.
+ */
+typedef struct {
+    int             valid;                  /* Has been built              */
+    double          saved;                  /* tdFdeltaClock() when saved  */
+    unsigned        numPivots;
+    long int        butClear;               /* Largest button clearance    */
+    long int        fibClear;               /* Largest fibre clearance     */
+    INT32           xPiv[FPIL_MAXPIVOTS];
+    INT32           yPiv[FPIL_MAXPIVOTS];
+    short           park[FPIL_MAXPIVOTS];
+    INT32           xf[FPIL_MAXPIVOTS];
+    INT32           yf[FPIL_MAXPIVOTS];
+    double          theta[FPIL_MAXPIVOTS];
+    INT32           fvpX[FPIL_MAXPIVOTS];
+    INT32           fvpY[FPIL_MAXPIVOTS];
+    double          fibreLength[FPIL_MAXPIVOTS];
+    unsigned char   clear[FPIL_MAXPIVOTS][ROW_BYTES];
+    } WarmRef;
+
+static WarmRef refs[TDFDELTA_WARM_REFS];
+static short   claimed[TDFDELTA_WARM_REFS];    /* Under tdFdeltaLock()  */
+
+/*
+ *  The warm start state of the plan this thread is running, see
+ *  tdFdeltaWarmUse().  noUse is never active.
+ */
+static tdFwarmUse noUse = { -1, NO, { 0 } };
+static TDFDELTA_TLS tdFwarmUse *curUse = &noUse;
+
+#define CLEAR_BIT(r,i,j)  ((r)->clear[i][(j)>>3] & (1 << ((j)&7)))
+
+/*
+ *  Is a position within tolerance of a pivot's reference position.
+ */
+static int Near(
+        const WarmRef  *r,
+        unsigned       piv,
+        short          park,
+        long           xf,
+        long           yf,
+        double         theta,
+        long           fvpX,
+        long           fvpY)
+{
+    double dxy, dfvp;
+    if ((park == YES) != (r->park[piv] == YES))
+        return NO;
+    if (park == YES)
+        return YES;
+    dxy  = sqrt(SQRD((double)(xf - r->xf[piv])) +
+                SQRD((double)(yf - r->yf[piv])));
+    dfvp = sqrt(SQRD((double)(fvpX - r->fvpX[piv])) +
+                SQRD((double)(fvpY - r->fvpY[piv])));
+    return ((dxy + TDFDELTA_WARM_ARM*fabs(theta - r->theta[piv]) <=
+             TDFDELTA_WARM_TOL)&&(dfvp <= TDFDELTA_WARM_TOL));
+}
+
+/*
+ *  Distance between a point and a line segment.
+ */
+static double PointSegDist(
+        double  px,
+        double  py,
+        double  x1,
+        double  y1,
+        double  x2,
+        double  y2)
+{
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    double len2 = dx*dx + dy*dy;
+    double t = 0;
+    if (len2 > 0) {
+        t = ((px - x1)*dx + (py - y1)*dy)/len2;
+        if (t < 0) t = 0;
+        else if (t > 1) t = 1;
+    }
+    return sqrt(SQRD(px - (x1 + t*dx)) + SQRD(py - (y1 + t*dy)));
+}
+
+/*
+ *  Distance between the fibres of two reference positions, assuming the
+ *  fibres do not cross.
+ */
+static double FibreDist(
+        const WarmRef  *r,
+        unsigned       a,
+        unsigned       b)
+{
+    double d, e;
+    d = PointSegDist(r->xPiv[a], r->yPiv[a], r->xPiv[b], r->yPiv[b],
+                     r->fvpX[b], r->fvpY[b]);
+    e = PointSegDist(r->fvpX[a], r->fvpY[a], r->xPiv[b], r->yPiv[b],
+                     r->fvpX[b], r->fvpY[b]);
+    if (e < d) d = e;
+    e = PointSegDist(r->xPiv[b], r->yPiv[b], r->xPiv[a], r->yPiv[a],
+                     r->fvpX[a], r->fvpY[a]);
+    if (e < d) d = e;
+    e = PointSegDist(r->fvpX[b], r->fvpY[b], r->xPiv[a], r->yPiv[a],
+                     r->fvpX[a], r->fvpY[a]);
+    if (e < d) d = e;
+    return d;
+}
+
+/*
+ *  Are two pivots clear of each other, with margin, at their reference
+ *  positions.
+ */
+static int PairClear(
+        const WarmRef  *r,
+        FpilType       inst,
+        unsigned       a,
+        unsigned       b)
+{
+    double margin = 2.0*TDFDELTA_WARM_TOL;
+    double reach;
+
+    if ((r->park[a] == YES)||(r->park[b] == YES))
+        return NO;
+
+    /*
+     *  Too far apart to touch.
+     */
+    reach = r->fibreLength[a] + r->fibreLength[b] + 2.0*TDFDELTA_WARM_ARM +
+            margin + (r->butClear > r->fibClear ? r->butClear :
+                                                  r->fibClear);
+    if (SQRD((double)(r->xPiv[a] - r->xPiv[b])) +
+        SQRD((double)(r->yPiv[a] - r->yPiv[b])) > SQRD(reach))
+        return YES;
+
+    TDFDELTA_STAT(colFibFib);
+    if (FpilColFibFib(inst,
+                      (double)r->xPiv[a], (double)r->yPiv[a],
+                      (double)r->fvpX[a], (double)r->fvpY[a],
+                      (double)r->xPiv[b], (double)r->yPiv[b],
+                      (double)r->fvpX[b], (double)r->fvpY[b]) > 0)
+        return NO;
+    if (FibreDist(r, a, b) <= margin)
+        return NO;
+
+    FpilSetButClear(inst, r->butClear + (long)margin);
+    TDFDELTA_STAT(colButBut);
+    if (FpilColButBut(inst,
+                      (double)r->xf[a], (double)r->yf[a], r->theta[a],
+                      (double)r->xf[b], (double)r->yf[b], r->theta[b]) > 0)
+        return NO;
+
+    FpilSetFibClear(inst, r->fibClear + (long)margin);
+    TDFDELTA_STAT(colButFib);
+    if (FpilColButFib(inst,
+                      (double)r->xf[a], (double)r->yf[a], r->theta[a],
+                      (double)r->fvpX[b], (double)r->fvpY[b],
+                      (double)r->xPiv[b], (double)r->yPiv[b]) > 0)
+        return NO;
+    TDFDELTA_STAT(colButFib);
+    if (FpilColButFib(inst,
+                      (double)r->xf[b], (double)r->yf[b], r->theta[b],
+                      (double)r->fvpX[a], (double)r->fvpY[a],
+                      (double)r->xPiv[a], (double)r->yPiv[a]) > 0)
+        return NO;
+    return YES;
+}
+
+/*
+ *  Does a reference set apply to a plan.
+ */
+static int Applies(
+        const WarmRef       *r,
+        const tdFdeltaType  *data)
+{
+    unsigned numPivots = tdFdeltaNumPivots(tdFdeltaFpilInst());
+    long int butClear = (data->butClearG > data->butClearO ?
+                         data->butClearG : data->butClearO);
+    long int fibClear = (data->fibClearG > data->fibClearO ?
+                         data->fibClearG : data->fibClearO);
+
+    return ((r->valid)&&(r->numPivots == numPivots)&&
+            (r->butClear == butClear)&&(r->fibClear == fibClear)&&
+            (memcmp(r->xPiv, data->constants.xPiv,
+                    numPivots*sizeof(INT32)) == 0)&&
+            (memcmp(r->yPiv, data->constants.yPiv,
+                    numPivots*sizeof(INT32)) == 0));
+}
+
+/*
+ *  Claim an unclaimed reference set which applies to a plan, keeping
+ *  the one the plan has if that still applies.  Returns NO if there is
+ *  none.  Called under tdFdeltaLock().
+ */
+static int Claim(
+        tdFdeltaType  *data)
+{
+    tdFwarmUse *use = &data->warm;
+    int i;
+
+    if ((use->ref >= 0)&&(Applies(&refs[use->ref], data)))
+        return YES;
+    if (use->ref >= 0)
+        claimed[use->ref] = NO;
+    use->ref = -1;
+    for (i = 0; i < TDFDELTA_WARM_REFS ; ++i) {
+        if ((!claimed[i])&&(Applies(&refs[i], data))) {
+            claimed[i] = YES;
+            use->ref = i;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+
+/*+        T D F D E L T A W A R M
+
+ *  Function name:
+      tdFdeltaWarmUse
+
+ *  Function:
+      Select the warm start state of the plan being run.
+
+ *  Description:
+      Called by tdFdeltaUse(), so tdFdeltaWarmSkip() uses the plan's
+      state.  Applies to the calling thread.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaWarmUse (use)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) use         (tdFwarmUse *)    The plan's state (data->warm).
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaWarmUse (
+        tdFwarmUse  *use)
+{
+    curUse = (use ? use : &noUse);
+}
+
+
+/*+        T D F D E L T A W A R M
+
+ *  Function name:
+      tdFdeltaWarmBegin
+
+ *  Function:
+      Prepare to use a saved pair matrix for a plan.
+
+ *  Description:
+      Claims a reference set which applies to the plan, if there is one,
+      and works out which of its target positions are within tolerance
+      of the reference positions.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaWarmBegin (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Claims a reference set.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaWarmBegin (
+        tdFdeltaType  *data)
+{
+    const tdFtarget *t = &data->target;
+    tdFwarmUse *use = &data->warm;
+    const WarmRef *r;
+    unsigned i;
+
+    tdFdeltaLock();
+    use->active = Claim(data);
+    tdFdeltaUnlock();
+    if (!use->active) return;
+    r = &refs[use->ref];
+    for (i = 0; i < r->numPivots ; ++i)
+        use->targetNear[i] = Near(r, i, t->park[i], t->xf[i], t->yf[i],
+                                  t->theta[i], t->fvpX[i], t->fvpY[i]);
+}
+
+
+/*+        T D F D E L T A W A R M
+
+ *  Function name:
+      tdFdeltaWarmSkip
+
+ *  Function:
+      Can the collision checks of a pair of pivots be skipped.
+
+ *  Description:
+      Returns true if pivot piv at its target position and pivot other
+      at the given position are known to be clear of each other, as per
+      the module description.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaWarmSkip (piv, other, park, xf, yf, theta,
+                                fvpX, fvpY)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (>) piv         (unsigned)        The pivot at its target position.
+      (>) other       (unsigned)        The other pivot.
+      (>) park        (short)           Other pivot parked flag,
+      (>) xf,yf       (long)            fibre end,
+      (>) theta       (double)          button orientation and
+      (>) fvpX,fvpY   (long)            fibre virtual pivot point.
+
+ *  Returned value:
+      True if the checks may be skipped.
+
+ *  Prior requirements:
+      tdFdeltaWarmBegin() must have been called for the plan.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaWarmSkip (
+        unsigned    piv,
+        unsigned    other,
+        short       park,
+        long        xf,
+        long        yf,
+        double      theta,
+        long        fvpX,
+        long        fvpY)
+{
+    const WarmRef *r;
+
+    if ((!curUse->active)||(!curUse->targetNear[piv]))
+        return NO;
+    r = &refs[curUse->ref];
+    if ((!CLEAR_BIT(r, piv, other))||
+        (!Near(r, other, park, xf, yf, theta, fvpX, fvpY)))
+        return NO;
+    TDFDELTA_STAT(warmSkips);
+    return YES;
+}
+
+
+/*+        T D F D E L T A W A R M
+
+ *  Function name:
+      tdFdeltaWarmSave
+
+ *  Function:
+      Update a pair matrix from the field a plan ends with.
+
+ *  Description:
+      Called when a sequence is complete, with the final field in
+      data->current.  Pivots which have moved beyond the tolerance take
+      their final position as their reference, and their pairs are
+      checked again.  If no reference set applied to the plan, the least
+      recently saved unclaimed set is replaced and all pairs are checked.
+      The set is then released.  The time taken is recorded as the warm
+      phase.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaWarmSave (data, status)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+      (!) status      (StatusType *)    Modified status.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Uses the plan's claimed set, or replaces the
+                        oldest.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaWarmSave (
+        tdFdeltaType  *data,
+        StatusType    *status)
+{
+    FpilType         inst = tdFdeltaFpilInst();
+    const tdFinterim *cur = &data->current;
+    tdFwarmUse       *use = &data->warm;
+    WarmRef          *r;
+    short            changed[FPIL_MAXPIVOTS];
+    double           tStart;
+    unsigned         numChanged = 0;
+    unsigned         i;
+    int              rebuild;
+
+    if (*status != STATUS__OK) return;
+    tStart = tdFdeltaClock();
+
+    /*
+     *  Find the set to update - the one which applies, else the oldest
+     *  unclaimed one.  If all are claimed by other plans we go without.
+     */
+    tdFdeltaLock();
+    rebuild = !Claim(data);
+    if (rebuild) {
+        int oldest = -1;
+        for (i = 0; i < TDFDELTA_WARM_REFS ; ++i) {
+            if (claimed[i]) continue;
+            if ((oldest < 0)||(!refs[i].valid)||
+                ((refs[oldest].valid)&&(refs[i].saved < refs[oldest].saved)))
+                oldest = i;
+            if (!refs[oldest].valid) break;
+        }
+        if (oldest >= 0) {
+            claimed[oldest] = YES;
+            use->ref = oldest;
+        }
+    }
+    tdFdeltaUnlock();
+    use->active = NO;
+    if (use->ref < 0) return;
+    r = &refs[use->ref];
+
+    if (rebuild) {
+        memset(r, 0, sizeof(*r));
+        r->numPivots = tdFdeltaNumPivots(inst);
+        r->butClear = (data->butClearG > data->butClearO ?
+                       data->butClearG : data->butClearO);
+        r->fibClear = (data->fibClearG > data->fibClearO ?
+                       data->fibClearG : data->fibClearO);
+        memcpy(r->xPiv, data->constants.xPiv, sizeof(r->xPiv));
+        memcpy(r->yPiv, data->constants.yPiv, sizeof(r->yPiv));
+    }
+
+    for (i = 0; i < r->numPivots ; ++i) {
+        changed[i] = (rebuild ||
+                      !Near(r, i, cur->park[i], cur->xf[i], cur->yf[i],
+                            cur->theta[i], cur->fvpX[i], cur->fvpY[i]));
+        if (!changed[i]) continue;
+        ++numChanged;
+        r->park[i]        = (cur->park[i] == YES ? YES : NO);
+        r->xf[i]          = cur->xf[i];
+        r->yf[i]          = cur->yf[i];
+        r->theta[i]       = cur->theta[i];
+        r->fvpX[i]        = cur->fvpX[i];
+        r->fvpY[i]        = cur->fvpY[i];
+        r->fibreLength[i] = cur->fibreLength[i];
+    }
+
+    /*
+     *  Only check each pair once.  Pairs of changed pivots are done
+     *  by the first of them.
+     */
+    for (i = 0; i < r->numPivots ; ++i) {
+        unsigned j;
+        if (!changed[i]) continue;
+        for (j = 0; j < r->numPivots ; ++j) {
+            if ((j == i)||((changed[j])&&(j < i))) continue;
+            if (PairClear(r, inst, i, j)) {
+                r->clear[i][j>>3] |= (1 << (j&7));
+                r->clear[j][i>>3] |= (1 << (i&7));
+            } else {
+                r->clear[i][j>>3] &= ~(1 << (j&7));
+                r->clear[j][i>>3] &= ~(1 << (i&7));
+            }
+        }
+    }
+    r->valid = YES;
+    r->saved = tdFdeltaClock();
+    tdFdeltaWarmRelease(data);
+    tdFdeltaStatsPhase(TDF_PHASE_WARM, tStart);
+    if (data->check & SHOW)
+        tdFdeltaMsgOut(status, "Warm start pairs updated for %u of %u pivots",
+                       numChanged, r->numPivots);
+}
+
+
+/*+        T D F D E L T A W A R M
+
+ *  Function name:
+      tdFdeltaWarmRelease
+
+ *  Function:
+      Release a plan's claim on a reference set.
+
+ *  Description:
+      Called by tdFdeltaWarmSave() and tdFdeltaDataFree(), so a plan
+      which does not complete does not keep its set from others.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaWarmRelease (data)
+
+ *  Parameters:  (">" input, "!" modified, "W" workspace, "<" output)
+      (!) data        (tdFdeltaType *)  The plan data.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL void  tdFdeltaWarmRelease (
+        tdFdeltaType  *data)
+{
+    tdFwarmUse *use = &data->warm;
+
+    use->active = NO;
+    if (use->ref < 0) return;
+    tdFdeltaLock();
+    claimed[use->ref] = NO;
+    tdFdeltaUnlock();
+    use->ref = -1;
+}
+
+
+/*+        T D F D E L T A W A R M
+
+ *  Function name:
+      tdFdeltaWarmClear
+
+ *  Function:
+      Discard the pair matrices.
+
+ *  Description:
+      Called when the instrument is changed, and by benchmarks to time
+      a cold start.
+
+ *  Language:
+      C
+
+ *  Call:
+      (void) = tdFdeltaWarmClear ()
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Clears all the reference sets.
+      {@change entry@}
+ */
+TDFDELTA_PUBLIC void  tdFdeltaWarmClear (void)
+{
+    int i;
+
+    tdFdeltaLock();
+    for (i = 0; i < TDFDELTA_WARM_REFS ; ++i)
+        refs[i].valid = NO;
+    tdFdeltaUnlock();
+    if (curUse != &noUse)
+        curUse->active = NO;
+}
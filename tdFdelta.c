@@ -24,6 +24,24 @@
       24-Feb-2000  TJF  Warn about version compilation combinations.
       01-Nov-2000  TJF  Remove ability to check FPIL against old
                         tdFcollision routines.
+      18-Oct-2026  AGT  Add REPLAN action and tdFdeltaNewActData().
+      18-Oct-2026  AGT  Add THREAD flag to GENERATE.
+      18-Oct-2026  AGT  Add DELTA_ETA parameter.
+      18-Oct-2026  AGT  Add DELTA_STATS parameter.
+      18-Oct-2026  AGT  Add TRACE flag to GENERATE and REPLAN.
+      18-Oct-2026  AGT  Add SNAPSHOT flag to GENERATE, add tdFdeltaFpilInit().
+      18-Oct-2026  AGT  The instrument description and tdFdeltaFpilInst()
+                        move to the planning core (tdFdelCore.c).
+      18-Oct-2026  AGT  GENERATE results are cached.
+      18-Oct-2026  AGT  Check the model against the single instrument build.
+      18-Oct-2026  AGT  Add tdFdeltaFpilNew().  GENERATE may run whilst
+                        worker threads are running.
+      18-Oct-2026  AGT  Add PREPARE action.
+      18-Oct-2026  AGT  Add BATCH action.
+      18-Oct-2026  AGT  Add MATRIX action.
+      18-Oct-2026  AGT  Add ESTIMATE action.
+      18-Oct-2026  AGT  Add PACKED flag to GENERATE and UNPACK action.
+      18-Oct-2026  AGT  Add STREAM flag to GENERATE.
       {@change entry@}
 
  *     @(#) $Id: ACMM:2dFdelta/tdFdelta.c,v 3.17 25-Aug-2014 14:38:02+10 tjf $
@@ -82,11 +100,6 @@ static void *use_rcsId = (0 ? (void *)(&use_rcsId) : (void *) &rcsId);
 extern const char * const tdFdeltaVersion;
 extern const char * const tdFdeltaDate;
 
-/*
- *  Instrumment description variable. 
- */
-static FpilType tdFdeltaInstrument;
-
 
 /*
  *  Function prototypes - ACTIONS
@@ -95,6 +108,13 @@ TDFDELTA_PRIVATE void  tdFdeltaInitialise(StatusType *status);
 TDFDELTA_PRIVATE void  tdFdeltaReset(StatusType *status);
 TDFDELTA_PRIVATE void  tdFdeltaExit(StatusType *status);
 TDFDELTA_PRIVATE void  tdFdeltaGenerate(StatusType *status);
+TDFDELTA_PRIVATE void  tdFdeltaGenerateWait(StatusType *status);
+TDFDELTA_PRIVATE void  tdFdeltaPrepare(StatusType *status);
+TDFDELTA_PRIVATE void  tdFdeltaEstimateAction(StatusType *status);
+TDFDELTA_PRIVATE void  tdFdeltaUnpack(StatusType *status);
+
+#define WAIT_MS   100       /* Interval at which GENERATE polls for a
+                               prepared plan                            */
 
 /*
  *  Action definitions
@@ -104,6 +124,12 @@ static DitsActionMapType tdFdeltaMap[] = {
     {tdFdeltaReset,      0,            0, "RESET"     },
     {tdFdeltaExit,       0,            0, "EXIT"      },
     {tdFdeltaGenerate,   tdFdeltaKick, 0, "GENERATE"  },
+    {tdFdeltaReplan,     tdFdeltaKick, 0, "REPLAN"    },
+    {tdFdeltaPrepare,    0,            0, "PREPARE"   },
+    {tdFdeltaQueue,      0,            0, "BATCH"     },
+    {tdFdeltaQueueMatrix,0,            0, "MATRIX"    },
+    {tdFdeltaEstimateAction, 0,        0, "ESTIMATE"  },
+    {tdFdeltaUnpack,     0,            0, "UNPACK"    },
     };
 int tdFdeltaMapSize = sizeof(tdFdeltaMap)/sizeof(DitsActionMapType);
 
@@ -111,6 +137,7 @@ int tdFdeltaMapSize = sizeof(tdFdeltaMap)/sizeof(DitsActionMapType);
  *  Parameter Initialisation variables.
  */
 float  deltaProg = 0.0;
+INT32  deltaEta  = 0;
 
 /*
  *  Parameter array
@@ -125,7 +152,11 @@ static SdpParDefType tdFdeltaParams[] = {
     /*
      *  Progress parameter.
      */
-    {"DELTA_PROG",    &deltaProg,                     SDS_FLOAT }
+    {"DELTA_PROG",    &deltaProg,                     SDS_FLOAT },
+    /*
+     *  Estimated milliseconds until the command file is complete.
+     */
+    {"DELTA_ETA",     &deltaEta,                      SDS_INT   }
     };
 static int tdFdeltaParamCnt = sizeof(tdFdeltaParams)/sizeof(SdpParDefType);
 
@@ -171,6 +202,9 @@ static int tdFdeltaParamCnt = sizeof(tdFdeltaParams)/sizeof(SdpParDefType);
       10-Jun-1998  TJF  Set the ENQ_VER_NUM and ENQ_VER_DATE parameters.
       28-Jan-2000  TJF  Convert to using FPIL module to allow support
                         of 6dF as well as 2dF, based on task name.
+      18-Oct-2026  AGT  Create the DELTA_STATS parameter.
+      18-Oct-2026  AGT  Use tdFdeltaFpilInit().
+      18-Oct-2026  AGT  Mention a model which does not match the build.
       {@change entry@}
  */
 TDFDELTA_PUBLIC void  tdFdeltaActivate (
@@ -178,10 +212,13 @@ TDFDELTA_PUBLIC void  tdFdeltaActivate (
         StatusType  *status)
 {
     char name[DITS_C_NAMELEN];
+    int  sixdf;
     MessPutFacility(&MessFac_TDFDELTA);
     DitsPutActionHandlers(tdFdeltaMapSize,tdFdeltaMap,status);
-    if (parsysid)
+    if (parsysid) {
         SdpCreate(parsysid,tdFdeltaParamCnt,tdFdeltaParams,status);
+        tdFdeltaStatsCreate(status);
+    }
 
    /*
     * Put the version number and date parameter values
@@ -194,34 +231,156 @@ TDFDELTA_PUBLIC void  tdFdeltaActivate (
      * we are the 6dF task
      */
     DitsGetTaskName(sizeof(name), name, status);
-    if (strncmp(name,SIXDF,sizeof(SIXDF)-1) == 0)
+    sixdf = (strncmp(name,SIXDF,sizeof(SIXDF)-1) == 0);
+    if (!tdFdeltaFpilInit(sixdf))
+    {
+        fprintf(stderr,"Delta task can't run with %s support as it was not compiled with %s support\n",
+                sixdf ? "6dF" : "2dF", sixdf ? "6dF" : "2dF");
+        fprintf(stderr,"(or the %s model does not match this single instrument build)\n",
+                sixdf ? "6dF" : "2dF");
+        exit(1);
+    }
+    printf("%s:Activating as %s delta task\n",name, sixdf ? "6dF" : "2dF");
+}
+
+
+/*
+ *  Create a model of the instrument, checking it suits this build.
+ *  instSixdf is the instrument given to tdFdeltaFpilInit().
+ */
+static int instSixdf = 0;
+
+static int FpilNew(
+        int         sixdf,
+        FpilType    *instP)
+{
+    FpilType  inst;
+    if (sixdf)
     {
 #       ifndef NO_SIX_DF
-        {
-            printf("%s:Activating as 6dF delta task\n",name);
-            sixdfFpilMinInit(&tdFdeltaInstrument);
-        }
+            sixdfFpilMinInit(&inst);
 #       else
-        {
-            fprintf(stderr,"Delta task can't run with 6dF support as it was not compiled with 6dF support\n");
-            exit(1);
-        }
+            return 0;
 #       endif
     } 
     else
     {
 #       ifndef NO_TWO_DF
-        {
-            printf("%s:Activating as 2dF delta task\n",name);
-            TdfFpilMinInit(&tdFdeltaInstrument);
-        }
+            TdfFpilMinInit(&inst);
 #       else
-        {
-            fprintf(stderr,"Delta task can't run with 2dF support as it was not compiled with 2dF support\n");
-            exit(1);
-        }
+            return 0;
 #       endif
     }       
+    /*
+     *  In a single instrument build, the model must agree with the
+     *  compile time ParkMayCollide constant.
+     */
+    if (!tdFdeltaFpilFixed(inst))
+    {
+        FpilFree(inst);
+        return 0;
+    }
+    *instP = inst;
+    return 1;
+}
+
+
+/*
+ *+           T D F D E L T A
+
+ *  Function name:
+      tdFdeltaFpilInit
+
+ *  Function:
+      Initialise the instrument model.
+
+ *  Description:
+      Initialises the instrument model returned by tdFdeltaFpilInst() for
+      either 2dF or 6dF.  Called by tdFdeltaActivate(), and by programs
+      which use the planner outside the task.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaFpilInit (sixdf)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) sixdf      (int)          True for 6dF, false for 2dF.
+
+ *  Returned value:
+      False if support for the instrument was not compiled in, or in a
+      single instrument build, if the model does not agree with the
+      compile time ParkMayCollide constant (see tdFdeltaFpilFixed()).
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, extracted from tdFdeltaActivate.
+      18-Oct-2026  AGT  Pass the model to the core with tdFdeltaFpilSet().
+      18-Oct-2026  AGT  Check the model with tdFdeltaFpilFixed().
+      18-Oct-2026  AGT  Model creation moved to FpilNew().
+      19-Oct-2026  AGT  Only ParkMayCollide need agree in a single
+                        instrument build.
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaFpilInit (
+        int         sixdf)
+{
+    FpilType  inst;
+    if (!FpilNew(sixdf, &inst))
+        return 0;
+    instSixdf = sixdf;
+    tdFdeltaFpilSet(inst);
+    return 1;
+}
+
+
+/*
+ *+           T D F D E L T A
+
+ *  Function name:
+      tdFdeltaFpilNew
+
+ *  Function:
+      Create another model of the instrument.
+
+ *  Description:
+      Creates a model of the instrument given to tdFdeltaFpilInit(), for
+      a plan which is to run at the same time as others (data->inst).
+      FPIL keeps the clearances in the model, so such plans may not
+      share one.  It should be released with FpilFree() once the plan
+      is released.
+
+ *  Language:
+      C
+
+ *  Call:
+      (int) = tdFdeltaFpilNew (inst)
+
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (<) inst       (FpilType *)   The new model.
+
+ *  Returned value:
+      False if the model could not be created.
+
+ *  Prior requirements:
+      tdFdeltaFpilInit() must have been called.
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_INTERNAL int  tdFdeltaFpilNew (
+        FpilType    *inst)
+{
+    return FpilNew(instSixdf, inst);
 }
 
 
@@ -291,6 +450,49 @@ TDFDELTA_PRIVATE void  tdFdeltaExit (
     DitsPutRequest(DITS_REQ_EXIT,status);
 }
 
+
+/*
+ *  Complete a GENERATE whose result was found in the cache.
+ */
+static void GenerateDone(
+    tdFdeltaType  * const data,
+    StatusType    * const status)
+{
+    tdFdeltaTraceDone(data,status);
+    tdFdeltaSnapDone(data,status);
+    tdFdeltaFreeActData(data);
+}
+
+/*
+ *  Reschedule the field validity checking, or hand it and the
+ *  sequencing to a worker thread.
+ */
+static void GeneratePlan(
+    tdFdeltaType  * const data,
+    StatusType    * const status)
+{
+    if (data->check & THREAD) {
+        tdFdeltaThreadStart(data,status);
+        return;
+    }
+    DitsPutActData(data,status);
+    DitsPutHandler(tdFdeltaFieldCheck,status);
+    DitsPutRequest(DITS_REQ_STAGE,status);
+}
+
+/*
+ *  Look up a GENERATE's result again after WAIT_MS milliseconds.
+ */
+static void GenerateWaitAgain(
+    StatusType    * const status)
+{
+    DitsDeltaTimeType delay;
+    DitsDeltaTime(0,WAIT_MS*1000,&delay);
+    DitsPutHandler(tdFdeltaGenerateWait,status);
+    DitsPutDelay(&delay,status);
+    DitsPutRequest(DITS_REQ_WAIT,status);
+}
+
 
 /*
  *  Internal Function, name:
@@ -329,11 +531,49 @@ TDFDELTA_PRIVATE void  tdFdeltaExit (
                                 - NO_FIELD_CHECK
                                 - CHECK_FULL_FIELD
                                 - SPECIAL (for 6dF)
+                                - THREAD
+                                - TRACE
+                                - SNAPSHOT
+                                - PACKED
+                                - STREAM
 
  *  Description:
       Check the target field validity and generate a command file containing the
       required sequence of moves to change from the current to target configurations.
 
+      If the THREAD flag is given, the field check and sequencing are run
+      in a worker thread (see tdFdelThread.c) whilst the action waits.  Up
+      to TDFDELTA_MAX_WORKERS such threads, e.g. one for each plate, may
+      run at a time, each with its own model of the instrument.
+
+      If the TRACE flag is given, the sequencer decisions are written to
+      "<name>.trace.json" on completion (see tdFdelTrace.c).
+
+      The converted inputs are written to "<name>.snap" if the action
+      fails, or straight away if the SNAPSHOT flag is given (see
+      tdFdelSnap.c).  These may be re-run with the tdFreplay program.
+
+      If the converted inputs are the same as those of a recent GENERATE
+      which produced a command file, that command file is returned
+      straight away (see tdFdelCache.c).  The cache is not used with the
+      TRACE flag, since there would be nothing to trace.  If the result
+      is still being prepared by a PREPARE action with the same inputs,
+      the action waits for it (see tdFdeltaGenerateWait()).
+
+      If the PACKED flag is given, the command file has arrays of the
+      commands in place of the `lineX' strings (see tdFdelDrama.c), for
+      readers using tdFdeltaCFread().  The UNPACK action adds the lines
+      for older readers.
+
+      If the STREAM flag is given, the lines of the command file are also
+      sent in chunks as trigger messages whilst the plan is made, so the
+      positioner may start moving before it is complete (see
+      tdFdelDrama.c).  The complete command file is still returned.  The
+      plan is only checked in full at the end, so if it fails after lines
+      were sent a CmdFileAbort trigger message follows.  The positioner
+      must then start no further lines, complete any move under way, and
+      make a new plan with GENERATE from the positions it reached.
+
  *  History:
       30-Jun-1994  JW   Original version
       28-Jul-1998  TJF  data->offsets renamed to data->offsets_
@@ -344,47 +584,46 @@ TDFDELTA_PRIVATE void  tdFdeltaExit (
                         still supplied as an argument, but if 0, then 
                         an extra item is supplied in the constants structure
                         to specify it on a fibre specific basis.
+      18-Oct-2026  AGT  Use tdFdeltaNewActData() to read the common arguments.
+      18-Oct-2026  AGT  Support THREAD flag.
+      18-Oct-2026  AGT  Support TRACE flag.
+      18-Oct-2026  AGT  Take an input snapshot, support SNAPSHOT flag.
+      18-Oct-2026  AGT  The above item is held by the DRAMA output
+                        callbacks, use tdFdeltaFreeActData().
+      18-Oct-2026  AGT  Look up the result cache.
+      18-Oct-2026  AGT  Support INT_GEOM flag.
+      18-Oct-2026  AGT  No longer rejected whilst a worker thread runs.
+                        The trace and snapshot are held with the plan.
+      18-Oct-2026  AGT  Wait for a result being prepared.
+      18-Oct-2026  AGT  Support PACKED flag.
+      18-Oct-2026  AGT  Support STREAM flag.
+      19-Oct-2026  AGT  Describe CmdFileAbort.
+      19-Oct-2026  AGT  INT_GEOM flag no longer accepted, there are no
+                        integer outlines for the 2dF and 6dF buttons.
       {@change entry@}
  */
 TDFDELTA_PRIVATE void  tdFdeltaGenerate (
         StatusType  *status)
 {
     tdFdeltaType  *data;                   /* Will contain all action parameters   */
-    SdsIdType     tarId,  curId,           /* SDS structure identifiers            */
-                  conId,  offId,
-                  fidId;
+    SdsIdType     curId;                   /* SDS structure identifier             */
     char          name[FILENAME_LENGTH];   /* Name of command file to be generated */
-    double        maxButAngG, maxPivAngG,
-                  maxButAngO, maxPivAngO;
-    long int      maxFibExt,
-                  butClearG,  fibClearG,
-                  butClearO,  fibClearO;
     long int      extSpringOut = 0;
     int           index;
     short         check;
 
+    if (*status != STATUS__OK) return;
+
     /*
      *  Get action arguments.
      */
     tdFdeltaFlagCheck(DitsGetArgument(),
                       _DEBUG | DISPLAY | CHECK_FULL_FIELD | NO_FIELD_CHECK |
-                      NO_ORDER_CHECK | NO_DELTA | SPECIAL,
+                      NO_ORDER_CHECK | NO_DELTA | SPECIAL | THREAD | TRACE |
+                      SNAPSHOT | PACKED | STREAM,
                       &check,
                       status);
 
-    GitArgGetI(DitsGetArgument(),"maxFibExt",1,0,0,GIT_M_ARG_KEEPERR,&maxFibExt,status);
-    GitArgGetD(DitsGetArgument(),"maxButAngG",2,0,0,GIT_M_ARG_KEEPERR,&maxButAngG,status);
-    GitArgGetD(DitsGetArgument(),"maxPivAngG",3,0,0,GIT_M_ARG_KEEPERR,&maxPivAngG,status);
-    GitArgGetD(DitsGetArgument(),"maxButAngO",4,0,0,GIT_M_ARG_KEEPERR,&maxButAngO,status);
-    GitArgGetD(DitsGetArgument(),"maxPivAngO",5,0,0,GIT_M_ARG_KEEPERR,&maxPivAngO,status);
-    GitArgGetI(DitsGetArgument(),"butClearG",6,0,0,GIT_M_ARG_KEEPERR,&butClearG,status);
-    GitArgGetI(DitsGetArgument(),"fibClearG",7,0,0,GIT_M_ARG_KEEPERR,&fibClearG,status);
-    GitArgGetI(DitsGetArgument(),"butClearO",8,0,0,GIT_M_ARG_KEEPERR,&butClearO,status);
-    GitArgGetI(DitsGetArgument(),"fibClearO",9,0,0,GIT_M_ARG_KEEPERR,&fibClearO,status);
-    GitArgNamePos(DitsGetArgument(),"tdFtarget",10,&tarId,status);
-    GitArgNamePos(DitsGetArgument(),"tdFconstants",11,&conId,status);
-    GitArgNamePos(DitsGetArgument(),"tdFoffsets",12,&offId,status);
-    GitArgNamePos(DitsGetArgument(),"tdFfiducials",13,&fidId,status);
     if (check & NO_DELTA)  /* Do not need current field details if NO_DELTA specified */
         sprintf(name,"blank");
     else {
@@ -405,90 +644,473 @@ TDFDELTA_PRIVATE void  tdFdeltaGenerate (
         return;
     }
 
+    /*
+     *  Create parameter structure containing the field details
+     *  common to all actions.
+     */
+    if ((data = tdFdeltaNewActData(check,status)) == NULL)
+        return;
+    tdFdeltaUse(data);
+
+    data->extSpringOut = extSpringOut;
+    if (ErsSPrintf(sizeof(data->name),data->name,"%s",name) == EOF) {
+        *status = TDFDELTA__SPRINTF;
+        tdFdeltaFreeActData(data);
+        return;
+    }
+    if (check & TRACE)
+        tdFdeltaTraceStart(data,status);
 
     /*
-     *  Create parameter structure to contain all action parameters.
+     *  Convert current field SDS structure to C structure.
      */
-    if ((data = (tdFdeltaType *)malloc(sizeof(tdFdeltaType))) == NULL) {
-        *status = TDFDELTA__MALLOCERR;
+    if (!(check & NO_DELTA)) {
+        double tStart = tdFdeltaClock();
+        tdFdeltaConvertCurToC(curId,&data->current,&data->crosses,
+                              tdFdeltaAbove(data), check,status);
+        tdFdeltaStatsPhase(TDF_PHASE_CONVERT, tStart);
+    }
+    if (*status != STATUS__OK) {
+        tdFdeltaTraceDone(data,status);
+        tdFdeltaFreeActData(data);
         return;
     }
-    else {
-        data->check = check;
-        data->maxButAngG = maxButAngG;
-        data->maxPivAngG = maxPivAngG;
-        data->maxButAngO = maxButAngO;
-        data->maxPivAngO = maxPivAngO;
-        data->butClearG = butClearG;
-        data->fibClearG = fibClearG;
-        data->butClearO = butClearO;
-        data->fibClearO = fibClearO;
-        data->extSpringOut = extSpringOut;
-        data->above     = 0;
-        if (ErsSPrintf(sizeof(data->name),data->name,"%s",name) == EOF) {
-            *status = TDFDELTA__SPRINTF;
-            free((void *)data);
-            return;
-        }
+    tdFdeltaSnapTake(data,status);
+    if (*status != STATUS__OK) {
+        tdFdeltaTraceDone(data,status);
+        tdFdeltaFreeActData(data);
+        return;
     }
 
     /*
-     *  Convert SDS structures to C structures.
+     *  If we have the result already, the action is complete.  If it is
+     *  being prepared, wait for it.
      */
-    tdFdeltaConvertConToC(conId,maxFibExt, &data->constants,check,status);
-    tdFdeltaConvertOffToC(offId,&data->offsets_,check,status);
-    tdFdeltaConvertTarToC(tarId,&data->target,check,status);
-    tdFdeltaConvertFidToC(fidId,&data->fids,check,status);
-    if (!(check & NO_DELTA))
-        tdFdeltaConvertCurToC(curId,&data->current,&data->crosses,
-                              &data->above, check,status);
+    if (!(check & (NO_DELTA | TRACE))) {
+        int found = tdFdeltaCacheLookup(data,status);
+        if (found == TDFDELTA_CACHE_PENDING) {
+            if (check & SHOW)
+                MsgOut(status,"Waiting for the prepared plan...");
+            tdFdeltaThreadHurry();
+            DitsPutActData(data,status);
+            GenerateWaitAgain(status);
+            return;
+        } else if (found) {
+            GenerateDone(data,status);
+            return;
+        }
+    }
+    GeneratePlan(data,status);
+}
+
+
+/*
+ *  Internal Function, name:
+      tdFdeltaGenerateWait
+
+ *  Description:
+      Action handler which waits for the result of a GENERATE to be
+      prepared, looking it up again every WAIT_MS milliseconds.  Once
+      prepared, the command file is returned.  If the prepared plan
+      failed, the GENERATE goes on to plan the field itself.  Either
+      way, the completed PREPARE workers are then reaped.  A kick ends
+      the action (see tdFdeltaKick()).
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      19-Oct-2026  AGT  Reap the completed PREPARE workers.
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaGenerateWait (
+        StatusType  *status)
+{
+    tdFdeltaType  *data = DitsGetActData();
+    int           found;
+
+    if (*status != STATUS__OK) return;
+    tdFdeltaUse(data);
+
+    found = tdFdeltaCacheLookup(data,status);
+    if (found == TDFDELTA_CACHE_PENDING) {
+        GenerateWaitAgain(status);
+        return;
+    }
+    tdFdeltaThreadReap(NO);
+    if (found) {
+        GenerateDone(data,status);
+    } else {
+        GeneratePlan(data,status);
+    }
+}
+
+
+/*
+ *  Internal Function, name:
+      tdFdeltaPrepare
+
+ *  Action:  PREPARE   maxFibExt maxButAngG maxPivAngG maxButAngO maxPivAngO
+                       butClearG fibClearG butClearO fibClearO
+                       tdFtarget tdFconstants tdFoffsets tdFfiducials
+                       tdFcurrent [name] [flag]
+
+ *  Parameters:
+      As per GENERATE.  The name argument is not used and the NO_DELTA
+      flag is not allowed.  The THREAD, TRACE, SNAPSHOT, PACKED and
+      STREAM flags are allowed, but ignored, so the same arguments may
+      be given to both.
+
+ *  Description:
+      Prepares the plan for a GENERATE which is expected later, e.g. for
+      the other plate whilst this one is observing, so that the GENERATE
+      need not wait for it.
+
+      The arguments are converted as GENERATE would and the plan is
+      entered in the result cache (see tdFdeltaCachePrepare()).  It is
+      then checked and sequenced in a worker thread at idle priority
+      (see tdFdeltaThreadPrepare()) and the action completes straight
+      away.  A GENERATE whose converted inputs give the same cache key
+      returns the prepared command file, waiting for it to be completed
+      if need be.  Any other GENERATE plans its field as usual.
+
+      If the result is already cached or being prepared, there is
+      nothing to do.
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Allow PACKED flag.
+      18-Oct-2026  AGT  Allow STREAM flag.
+      19-Oct-2026  AGT  INT_GEOM flag no longer allowed.
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaPrepare (
+        StatusType  *status)
+{
+    tdFdeltaType  *data;
+    SdsIdType     curId;
+    long int      extSpringOut = 0;
+    short         check;
+
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaFlagCheck(DitsGetArgument(),
+                      _DEBUG | DISPLAY | CHECK_FULL_FIELD | NO_FIELD_CHECK |
+                      NO_ORDER_CHECK | SPECIAL | THREAD | TRACE | SNAPSHOT |
+                      PACKED | STREAM,
+                      &check,
+                      status);
+    GitArgNamePos(DitsGetArgument(),"tdFcurrent",14,&curId,status);
+    if (check & SPECIAL) {
+        GitArgGetI(DitsGetArgument(),"extSpringOut",16,0,0,
+                   GIT_M_ARG_KEEPERR,&extSpringOut,status);
+    }
     if (*status != STATUS__OK) {
-        free((void *)data);
+        ErsRep(0,status,"Error getting %s argument(s) - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        return;
+    }
+
+    if ((data = tdFdeltaNewActData(check,status)) == NULL)
+        return;
+    tdFdeltaUse(data);
+    data->extSpringOut = extSpringOut;
+    tdFdeltaConvertCurToC(curId,&data->current,&data->crosses,
+                          tdFdeltaAbove(data),check,status);
+    if (!tdFdeltaCachePrepare(data,status)) {
+        if ((*status == STATUS__OK)&&(check & SHOW))
+            MsgOut(status,"The plan is already cached or being prepared");
+        tdFdeltaFreeActData(data);
         return;
     }
 
     /*
-     *  Reschedule the field validity checking.
+     *  The plan has no output, the above item is only used for the
+     *  command file.
      */
-    DitsPutActData(data,status);
-    DitsPutHandler(tdFdeltaFieldCheck,status);
-    DitsPutRequest(DITS_REQ_STAGE,status);
+    tdFdeltaDramaOutFree(&data->out);
+    tdFdeltaThreadPrepare(data,status);
+    if ((*status == STATUS__OK)&&(check & SHOW))
+        MsgOut(status,"Preparing the plan in a worker thread...");
+}
+
+
+/*
+ *  Internal Function, name:
+      tdFdeltaEstimateAction
+
+ *  Action:  ESTIMATE  maxFibExt maxButAngG maxPivAngG maxButAngO maxPivAngO
+                       butClearG fibClearG butClearO fibClearO
+                       tdFtarget tdFconstants tdFoffsets tdFfiducials
+                       tdFcurrent [name] [flag]
+
+ *  Parameters:
+      As per GENERATE.  The name argument is not used and the NO_DELTA
+      flag is not allowed.  The THREAD, TRACE, SNAPSHOT, PACKED and
+      STREAM flags are allowed, but ignored, so the same arguments may
+      be given to both.
+
+ *  Description:
+      Estimates the cost of the plan GENERATE would make, for scheduling
+      or allocation feedback, without planning it (see tdFdelEstimate.c).
+      There is no field check or sequencing and no command file.  The
+      fibres to move are ordered by their dependencies on each other,
+      with a broad phase bounding box test before each pair check, and
+      the robot time of that order is estimated (see tdFdelRobot.c).
+      With the SPECIAL flag the order is that of the 6dF sequencer -
+      every fibre on the plate parked, those with springs out (see
+      extSpringOut) first, then the target fibres moved on in order of
+      distance from the centre.
+
+      The result is a structure, EstimateResult, with the items -
+
+          numMoves   - Moves.
+          numParks   - Parks.
+          robotTime  - Robot time (seconds).
+          confident  - 1 if no fibre had to be parked out of the way,
+                       when the plan usually has the same numbers of
+                       moves and parks, otherwise 0 and the estimate is
+                       only a guide.  Always 1 with the SPECIAL flag.
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      18-Oct-2026  AGT  Allow PACKED flag.
+      18-Oct-2026  AGT  Allow STREAM flag.
+      19-Oct-2026  AGT  INT_GEOM flag no longer allowed.
+      19-Oct-2026  AGT  Estimate the special order with the SPECIAL flag.
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaEstimateAction (
+        StatusType  *status)
+{
+    tdFdeltaType  *data;
+    tdFestimate   est;
+    SdsIdType     curId;
+    SdsIdType     id = 0;
+    long int      extSpringOut = 0;
+    short         check;
+    double        tStart = tdFdeltaClock();
+
+    if (*status != STATUS__OK) return;
+
+    tdFdeltaFlagCheck(DitsGetArgument(),
+                      _DEBUG | DISPLAY | CHECK_FULL_FIELD | NO_FIELD_CHECK |
+                      NO_ORDER_CHECK | SPECIAL | THREAD | TRACE | SNAPSHOT |
+                      PACKED | STREAM,
+                      &check,
+                      status);
+    GitArgNamePos(DitsGetArgument(),"tdFcurrent",14,&curId,status);
+    if (check & SPECIAL) {
+        GitArgGetI(DitsGetArgument(),"extSpringOut",16,0,0,
+                   GIT_M_ARG_KEEPERR,&extSpringOut,status);
+    }
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error getting %s argument(s) - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        return;
+    }
+
+    if ((data = tdFdeltaNewActData(check,status)) == NULL)
+        return;
+    tdFdeltaUse(data);
+    data->extSpringOut = extSpringOut;
+    tdFdeltaConvertCurToC(curId,&data->current,&data->crosses,
+                          tdFdeltaAbove(data),check,status);
+    tdFdeltaEstimate(data,&data->target,0,&est,status);
+    tdFdeltaFreeActData(data);
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error estimating the plan - %s",
+               DitsErrorText(*status));
+        return;
+    }
+
+    SdsNew(0,"EstimateResult",0,NULL,SDS_STRUCT,0,NULL,&id,status);
+    ArgPuti(id,"numMoves",(long)est.numMoves,status);
+    ArgPuti(id,"numParks",(long)est.numParks,status);
+    ArgPutd(id,"robotTime",est.robotTime,status);
+    ArgPuti(id,"confident",(long)est.confident,status);
+    if (*status != STATUS__OK) {
+        StatusType ignore = STATUS__OK;
+        ErsRep(0,status,"Error creating the %s result - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        if (id) {
+            SdsDelete(id,&ignore);
+            SdsFreeId(id,&ignore);
+        }
+        return;
+    }
+    DitsPutArgument(id,DITS_ARG_DELETE,status);
+    if (check & SHOW)
+        MsgOut(status,"Estimated %u moves and %u parks, %.0f seconds%s, "
+               "in %.1f ms (%lu of %lu pair checks avoided)",
+               est.numMoves,est.numParks,est.robotTime,
+               (est.confident ? "" : " (a guide only)"),
+               (tdFdeltaClock()-tStart)*1000.0,est.pairsSkipped,
+               est.pairsSkipped+est.pairsChecked);
 }
 
 
+/*
+ *  Internal Function, name:
+      tdFdeltaUnpack
+
+ *  Action:  UNPACK  cmdFile
+
+ *  Parameters:
+      cmdFile      - SDS_STRUCT - A command file, as returned by GENERATE
+                                  or REPLAN.
+
+ *  Description:
+      Returns a copy of the command file with the `lineX' items, for
+      readers of command files generated with the PACKED flag which
+      only know the lines (see tdFdeltaCFlegacy()).  A command file
+      which is not packed is returned unchanged.
+
+ *  History:
+      18-Oct-2026  AGT  Original version
+      {@change entry@}
+ */
+TDFDELTA_PRIVATE void  tdFdeltaUnpack (
+        StatusType  *status)
+{
+    SdsIdType     cmdFileId = 0;
+    SdsIdType     id = 0;
+
+    if (*status != STATUS__OK) return;
+
+    GitArgNamePos(DitsGetArgument(),"cmdFile",1,&cmdFileId,status);
+    SdsCopy(cmdFileId,&id,status);
+    tdFdeltaCFlegacy(id,status);
+    if (*status != STATUS__OK) {
+        StatusType ignore = STATUS__OK;
+        ErsRep(0,status,"Error unpacking the command file - %s",
+               DitsErrorText(*status));
+        if (id) {
+            SdsDelete(id,&ignore);
+            SdsFreeId(id,&ignore);
+        }
+    } else {
+        DitsPutArgument(id,DITS_ARG_DELETE,status);
+    }
+    if (cmdFileId)
+        SdsFreeId(cmdFileId,status);
+}
+
 
 /*
  *+           T D F D E L T A
 
  *  Function name:
-      tdFdeltaFpilInst
+      tdFdeltaNewActData
 
  *  Function:
-      Returns the FPIL instrument variable
+      Create action data from the field arguments common to all actions.
 
  *  Description:
-      Returns the address of the variable initialised by tdFdeltaActivate
-	      using FpilInit()
+      Reads arguments 1 to 13 of the action (maxFibExt through to
+      tdFfiducials, as described for the GENERATE action), allocates
+      a tdFdeltaType structure and converts the target, constants,
+      offsets and fiducial SDS structures into it.
+
+      The current field details are not converted, since the way they
+      are obtained depends on the action.  The command file name is set
+      to "blank" and no pivots are flagged as failed.  The output goes
+      to DRAMA (see tdFdeltaDramaOut()), as a packed command file with
+      the PACKED flag and streamed with the STREAM flag.
+
+ *  Language:
+      C
 
-	 *  Language:
-	      C
+ *  Call:
+      (tdFdeltaType *) = tdFdeltaNewActData (check,status)
 
-	 *  Call:
-	      (FpilType *) = tdFdeltaFpilInst ()
+ *  Parameters:   (">" input, "!" modified, "W" workspace, "<" output)
+      (>) check      (short)        Check flags, as returned by
+                                    tdFdeltaFlagCheck().
+      (!) status     (StatusType *) Modified status.
 
+ *  Returned value:
+      The new structure, which should be released with
+      tdFdeltaFreeActData(), or NULL on error.
 
-	 *  Prior requirements:
-	      tdFdeltaActivate() must have been invoked.
+ *  Prior requirements:
+      Must be called from an action handler.
 
  *  Support: Tony Farrell, AAO
 
  *-
 
  *  History:
-      28-Jan-2000 TJF Original version
+      18-Oct-2026  AGT  Original version, extracted from tdFdeltaGenerate.
+      18-Oct-2026  AGT  Use tdFdeltaDataNew() and tdFdeltaDramaOut().
+      18-Oct-2026  AGT  Support PACKED flag.
+      18-Oct-2026  AGT  Support STREAM flag.
       {@change entry@}
  */
-TDFDELTA_INTERNAL FpilType tdFdeltaFpilInst()
+TDFDELTA_INTERNAL tdFdeltaType  *tdFdeltaNewActData (
+        short       check,
+        StatusType  *status)
 {
-    return tdFdeltaInstrument;
+    tdFdeltaType  *data;                   /* Will contain all action parameters   */
+    SdsIdType     tarId,  conId,           /* SDS structure identifiers            */
+                  offId,  fidId;
+    double        maxButAngG, maxPivAngG,
+                  maxButAngO, maxPivAngO;
+    long int      maxFibExt,
+                  butClearG,  fibClearG,
+                  butClearO,  fibClearO;
+    double        tStart;
+
+    if (*status != STATUS__OK) return NULL;
+
+    GitArgGetI(DitsGetArgument(),"maxFibExt",1,0,0,GIT_M_ARG_KEEPERR,&maxFibExt,status);
+    GitArgGetD(DitsGetArgument(),"maxButAngG",2,0,0,GIT_M_ARG_KEEPERR,&maxButAngG,status);
+    GitArgGetD(DitsGetArgument(),"maxPivAngG",3,0,0,GIT_M_ARG_KEEPERR,&maxPivAngG,status);
+    GitArgGetD(DitsGetArgument(),"maxButAngO",4,0,0,GIT_M_ARG_KEEPERR,&maxButAngO,status);
+    GitArgGetD(DitsGetArgument(),"maxPivAngO",5,0,0,GIT_M_ARG_KEEPERR,&maxPivAngO,status);
+    GitArgGetI(DitsGetArgument(),"butClearG",6,0,0,GIT_M_ARG_KEEPERR,&butClearG,status);
+    GitArgGetI(DitsGetArgument(),"fibClearG",7,0,0,GIT_M_ARG_KEEPERR,&fibClearG,status);
+    GitArgGetI(DitsGetArgument(),"butClearO",8,0,0,GIT_M_ARG_KEEPERR,&butClearO,status);
+    GitArgGetI(DitsGetArgument(),"fibClearO",9,0,0,GIT_M_ARG_KEEPERR,&fibClearO,status);
+    GitArgNamePos(DitsGetArgument(),"tdFtarget",10,&tarId,status);
+    GitArgNamePos(DitsGetArgument(),"tdFconstants",11,&conId,status);
+    GitArgNamePos(DitsGetArgument(),"tdFoffsets",12,&offId,status);
+    GitArgNamePos(DitsGetArgument(),"tdFfiducials",13,&fidId,status);
+    if (*status != STATUS__OK) {
+        ErsRep(0,status,"Error getting %s argument(s) - %s",
+               tdFdeltaActionName(),DitsErrorText(*status));
+        return NULL;
+    }
+
+    /*
+     *  Create parameter structure to contain all action parameters.
+     */
+    if ((data = tdFdeltaDataNew(check,status)) == NULL)
+        return NULL;
+    tdFdeltaDramaOut(&data->out,status);
+    if (check & PACKED)
+        tdFdeltaDramaPacked(&data->out);
+    if (check & STREAM)
+        tdFdeltaDramaStream(&data->out);
+    data->maxButAngG = maxButAngG;
+    data->maxPivAngG = maxPivAngG;
+    data->maxButAngO = maxButAngO;
+    data->maxPivAngO = maxPivAngO;
+    data->butClearG = butClearG;
+    data->fibClearG = fibClearG;
+    data->butClearO = butClearO;
+    data->fibClearO = fibClearO;
+
+    /*
+     *  Convert SDS structures to C structures.
+     */
+    tStart = tdFdeltaClock();
+    tdFdeltaConvertConToC(conId,maxFibExt, &data->constants,check,status);
+    tdFdeltaConvertOffToC(offId,&data->offsets_,check,status);
+    tdFdeltaConvertTarToC(tarId,&data->target,check,status);
+    tdFdeltaConvertFidToC(fidId,&data->fids,check,status);
+    tdFdeltaStatsPhase(TDF_PHASE_CONVERT, tStart);
+    if (*status != STATUS__OK) {
+        tdFdeltaFreeActData(data);
+        return NULL;
+    }
+    return data;
 }
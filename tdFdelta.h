@@ -36,7 +36,34 @@
                         fibre specific basis - to the constants structure.
       25-Mar-2001  TJF  Add extSpringOut item to tdFdeltaType structure.
       22-Sep-2002  TJF  Add tdFdeltaCFaddSpringOutParks() function.
-      
+      18-Oct-2026  AGT  Add REPLAN support - failed item in tdFdeltaType,
+                        tdFcmdLine type, tdFdeltaCFgetCmd(),
+                        tdFdeltaCrossesMoved(), tdFdeltaCrossesParked(),
+                        tdFdeltaConvertCrossesToSds() and tdFdeltaReplan().
+      18-Oct-2026  AGT  Add tdFseqState, TDFDELTA_SLICE_MS and
+                        tdFdeltaClock() for time sliced sequencing.
+      18-Oct-2026  AGT  Add THREAD flag and the tdFdeltaThread module.  Field
+                        check and sequencer entry points taking the action
+                        data directly.  tdFdeltaCFdone(), tdFdeltaCFdelete().
+      18-Oct-2026  AGT  Replace RESOLUTION with TDFDELTA_PROG_MS.  Add
+                        tdFprogress, tdFdeltaProgInit() and tdFdeltaProgress().
+      18-Oct-2026  AGT  Add tdFstats and the tdFdeltaStats module.
+      18-Oct-2026  AGT  Add TRACE flag and the tdFdeltaTrace module.
+      18-Oct-2026  AGT  Add SNAPSHOT flag and the tdFdeltaSnap module,
+                        tdFdeltaFpilInit() and tdFdeltaThreadRunHere().
+      18-Oct-2026  AGT  Types and planning functions moved to tdFdeltaCore.h.
+                        The above item moves out of tdFdeltaType, see
+                        tdFdeltaAbove().  Add the tdFdeltaDrama module.
+      18-Oct-2026  AGT  Add tdFdeltaFpilNew().
+      18-Oct-2026  AGT  Add tdFdeltaThreadPrepare(), tdFdeltaThreadHurry()
+                        and the PREPARE action.
+      18-Oct-2026  AGT  Add the tdFdeltaQueue module and the BATCH action.
+      18-Oct-2026  AGT  Add tdFdeltaQueueMatrix() and the MATRIX action.
+      18-Oct-2026  AGT  Add tdFcmdFile, tdFdeltaDramaPacked(),
+                        tdFdeltaCFread(), tdFdeltaCFfree() and
+                        tdFdeltaCFlegacy() for packed command files.
+      18-Oct-2026  AGT  Add tdFdeltaDramaStream() and tdFdeltaDramaFlush().
+      19-Oct-2026  AGT  Add tdFdeltaThreadReap().
       {@change entry@}
 
  *  @(#) $Id: ACMM:2dFdelta/tdFdelta.h,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
@@ -50,190 +77,45 @@
 #include "Git.h"
 #include "status.h"
 #include "fpil.h"
+#include <stdio.h>     /* For FILE */
+
+#include "tdFdeltaCore.h"
 
 #define SIXDF "SIXDF"
 #define SIXDF_TAKSNAME "SIXDFDELTA"
 #define TWODF_TASKNAME "TDFDELTA"
-/*
- *  Use to declare constant arguments.
- *  Under GNU may get some warnings when compiling TDFDELTA itself due to C
- *  routines not being declared correctly.
- */
-#define TDFDELTA_CONST_ARGVAL  const   /* Use for constant argument values     */
-#define TDFDELTA_CONST_ARGPNT  const   /* Use for constant argument pointers   */
-#define TDFDELTA_CONST_VAR     const   /* Use for constant variables           */
-
-/*
- *  Used to declare routines.
- */
-#define TDFDELTA_PUBLIC   extern       /* routines available to other packages */
-#define TDFDELTA_INTERNAL extern       /* routines available thoughout tdFpt   */
-#define TDFDELTA_PRIVATE  static       /* routines internal to one module      */
-
-/*
- *  2dF Delta Configuration Task definitions.
- */
-#define PI             3.1415926535
-
-#define NO                        0
-#define YES                       1
-#define IF_NEEDED                 2
-
-#define GUIDE                     0    /* Fibre types                          */
-#define OBJECT                    1
-
-#define FILENAME_LENGTH         200    /* Max "Command File" name length       */
-#define CMD_NAME_LENGTH          10    /* Command buffer length                */
-#define COMMENT_LENGTH          100    /* Comment buffer length                */
-#define CMDLINE_LENGTH          500    /* Command line maximum length          */
-
-#define RESOLUTION              3.0    /* Only update the DELTA_PROG param ... */
-                                       /* ... for % changes greater than this  */
-                                       /* Note - must be float value           */
 
 #define TDFDELTA_MSG_BUFFER  250000    /* Size of message buffer for TDFDELTA  */
 
 /*
- *  Used to set check word that is passed between most functions.
- */
-#define CHECK_ALL                 0    /* Reset check mask                     */
-#define _DEBUG               (1<<0)    /* Display debugging infomation         */
-#define DISPLAY              (1<<1)    /* Display useful infomation            */
-#define SHOW     (_DEBUG | DISPLAY)    /* Debug or display flag specified      */
-#define CHECK_FULL_FIELD     (1<<2)    /* Check validity of ALL fibres         */
-#define NO_DELTA             (1<<3)    /* Do not perform delta process         */
-#define NO_ORDER_CHECK       (1<<4)    /* Bypass delta checks                  */
-#define NO_FIELD_CHECK       (1<<5)    /* Do not perform field validity checks */
-
-#define SPECIAL              (1<<6)    /* Run the special mode delta for 6dF */
-
-/*
- *  Macro's
- */
-#define SQRD(x)           ((x)*(x))    /* Returns the square of the number     */
-#define MAXMIN(a,b,c,d) ((c=a)>(d=b)?(c):(c-=d,d+=c,c=d-c))  /* JOS macro to.. */
-                                       /* take a and b, and put max in c and.. */
-                                       /* min in d.                            */
-
-
-/*
- *  Interim details - these are the details that will be continually changing
- *  during the generation of command files. All units are either microns
- *  or radians.
- */
-typedef struct tdFinterim {
-      double    theta[FPIL_MAXPIVOTS]; /* Button handle orientation          */
-      double    fibreLength[FPIL_MAXPIVOTS];/* Pivot-button distance         */
-      INT32  fvpX[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - x ord. */
-      INT32  fvpY[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - y ord. */
-      INT32  xf[FPIL_MAXPIVOTS];    /* Fibre-end x coordinate             */
-      INT32  yf[FPIL_MAXPIVOTS];    /* Fibre-end y coordinate             */
-      INT32  xb[FPIL_MAXPIVOTS];    /* Button x coordinate                */
-      INT32  yb[FPIL_MAXPIVOTS];    /* Button y coordinate                */
-      short     park[FPIL_MAXPIVOTS];  /* Flag indicating button is parked   */
-      short     nAbove[FPIL_MAXPIVOTS];/* Number of fibres crossing above    */
-      short     nBelow[FPIL_MAXPIVOTS];/* Number of fibres crossing below    */
-      } tdFinterim;
-
-/*
- *  Positioning offsets.  This is the offset that occurs when a button
- *  is placed.  There are three offsets for each button, one for moves
- *  from the park position , one for moves to the park position and
- *  one for all other moves (plate to plate)
- */
-typedef struct tdFoffsets {
-      short  xOffPL[FPIL_MAXPIVOTS]; /* Positioning offset - x, plate to plate  */
-      short  yOffPL[FPIL_MAXPIVOTS]; /* Positioning offset - y, plate to plate  */
-      short  xOffFrPK[FPIL_MAXPIVOTS]; /* Positioning offset - x, park  to plate  */
-      short  yOffFrPK[FPIL_MAXPIVOTS]; /* Positioning offset - y, park  to plate  */
-      short  xOffToPK[FPIL_MAXPIVOTS]; /* Positioning offset - x, plate to park */
-      short  yOffToPK[FPIL_MAXPIVOTS]; /* Positioning offset - y, plate to park */
-      } tdFoffsets;
-
-/*
- *  Fidcuial locations.
- */
-typedef struct tdFfidcuials {
-      INT32  fidX[FPIL_MAXFIDS];   /* Fiducial mark X ordinate (mic)     */
-      INT32  fidY[FPIL_MAXFIDS];   /* Fiducial mark Y ordinate (mic)     */
-      short     inUse[FPIL_MAXFIDS];  /* Is the fiducial currently in use   */
-      } tdFfiducials;
-
-/*
- *  Target structure - details of target field.
- */
-typedef struct tdFtarget {
-      double    theta[FPIL_MAXPIVOTS]; /* Button handle orientation          */
-      double    fibreLength[FPIL_MAXPIVOTS]; /* Pivot-button distance        */
-      INT32  fvpX[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - x ord. */
-      INT32  fvpY[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - y ord. */
-      INT32  xf[FPIL_MAXPIVOTS];    /* Fibre-end x coordinate             */
-      INT32  yf[FPIL_MAXPIVOTS];    /* Fibre-end y coordinate             */
-      short     mustMove[FPIL_MAXPIVOTS];/* Flag indicating button must move */
-      short     park[FPIL_MAXPIVOTS];  /* Flag indicating button is parked   */
-      } tdFtarget;
-
-/*
- *  Field constants - should be constant during observations.
+ *  A single command file line, as read back by tdFdeltaCFgetCmd().
  */
-typedef struct tdFconstants {
-      double    tPark[FPIL_MAXPIVOTS]; /* Park position - theta coordinate   */
-      INT32  xPark[FPIL_MAXPIVOTS]; /*               - x coordinate       */
-      INT32  yPark[FPIL_MAXPIVOTS]; /*               - y coordinate       */
-      INT32  xPiv[FPIL_MAXPIVOTS];  /* Pivot location - x coordinate      */
-      INT32  yPiv[FPIL_MAXPIVOTS];  /*                - y coordinate      */
-      short     type[FPIL_MAXPIVOTS];  /* Type of pivot - GUIDE/OBJECT       */
-      short     inUse[FPIL_MAXPIVOTS]; /* Flag indicating if pivot is broken */
-      INT32  graspX[FPIL_MAXPIVOTS];/* Fibre-end location during...       */
-      INT32  graspY[FPIL_MAXPIVOTS];/*                   ...button grasp  */
-      unsigned long maxExt[FPIL_MAXPIVOTS]; /* Maximum fibre extension */
-      } tdFconstants;
+typedef struct tdFcmdLine {
+      char      cmd[CMD_NAME_LENGTH];  /* Command - MF, PF, ! or *          */
+      int       piv;                   /* Pivot number (MF and PF only)     */
+      INT32     xf;                    /* Target x (MF only)                */
+      INT32     yf;                    /* Target y (MF only)                */
+      double    theta;                 /* Target theta (MF only)            */
+      char      comment[CMDLINE_LENGTH];/* Comment text (! and * only)      */
+      } tdFcmdLine;
 
 /*
- *  Crossover details - details of the crossovers between the fibres.
- *  When a crossover is detected, the level number is used to determine
- *  which fibre crosses above the other. This information is then used to
- *  construct a linked list of the numbers of fibres crossing above, and the
- *  numbers of the fibres crossing below each fibre.
+ *  A command file read in bulk by tdFdeltaCFread(), element l-1 of each
+ *  array being line l.  The op is one of TDF_CF_...  For comments, xf is
+ *  the offset of the comment in text and yf its length.
  */
-typedef struct FibreCross {
-      short             piv;              /* Number of the fibre crossing    */
-      struct FibreCross *next;            /* Pointer to next pivot number    */
-} FibreCross;
-
-typedef struct tdFcrosses {
-      FibreCross   *above[FPIL_MAXPIVOTS];/* Numbers of fibres crossing above*/
-      FibreCross   *below[FPIL_MAXPIVOTS];/* Numbers of fibres crossing above*/
-} tdFcrosses;
-
-
-/*
- *  Action structs (used with DitsPutActData and DitsGetActData).
- */
-typedef struct tdFdeltaType {
-      tdFinterim      current;
-      tdFcrosses      crosses;
-      tdFconstants    constants;
-      tdFoffsets      offsets_;  /* Underscore was only to have compiler pick 
-                                    up occurances of this variable */
-      tdFfiducials    fids;
-      tdFtarget       target;
-      double          maxButAngG;
-      double          maxButAngO;
-      double          maxPivAngG;
-      double          maxPivAngO;
-      long int        butClearG;
-      long int        butClearO;
-      long int        fibClearG;
-      long int        fibClearO;
-      long int        extSpringOut;
-      short           check;
-      char            name[FILENAME_LENGTH];
-
-      SdsIdType       above;   /* Sds ID of a copy of the above item from
-                                  the intial current details structdure 
-                               */
-      }  tdFdeltaType;
+typedef struct tdFcmdFile {
+      unsigned long numLines;          /* Number of lines                   */
+      short     *op;                   /* Command                           */
+      short     *piv;                  /* Pivot number (MF and PF only)     */
+      INT32     *xf;                   /* Target x (MF only)                */
+      INT32     *yf;                   /* Target y (MF only)                */
+      double    *theta;                /* Target theta (MF only)            */
+      char      *text;                 /* Comments, each null terminated    */
+      unsigned long textLen;           /* Length of text                    */
+      unsigned long alloc;             /* Lines allocated                   */
+      unsigned long textAlloc;         /* Length of text allocated          */
+      } tdFcmdFile;
 
 
 /*
@@ -263,6 +145,16 @@ TDFDELTA_INTERNAL void  tdFdeltaFlagCheck (
         StatusType  *status);
 TDFDELTA_INTERNAL void  tdFdeltaKick (
         StatusType  *status);
+/*
+ *  MODULE = tdFdelta
+ */
+TDFDELTA_INTERNAL tdFdeltaType  *tdFdeltaNewActData (
+        short       check,
+        StatusType  *status);
+TDFDELTA_INTERNAL int  tdFdeltaFpilInit (
+        int         sixdf);
+TDFDELTA_INTERNAL int  tdFdeltaFpilNew (
+        FpilType    *inst);
 /*
  *  MODULE = tdFdeltaConvert
  */
@@ -294,65 +186,91 @@ TDFDELTA_INTERNAL void  tdFdeltaConvertTarToC (
         tdFtarget   *tar,
         short       check,
         StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaConvertCrossesToSds (
+        const tdFinterim  *cur,
+        const tdFcrosses  *crosses,
+        SdsIdType         *aboveID,
+        StatusType        *status);
 /*
- *  MODULE = tdFdeltaFieldCheck
+ *  MODULE = tdFdeltaReplan
  */
-TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
+TDFDELTA_INTERNAL void  tdFdeltaReplan (
         StatusType  *status);
 /*
- *  MODULE = tdFdeltaCrosses
+ *  MODULE = tdFdeltaQueue
  */
-TDFDELTA_INTERNAL void  tdFdeltaAddCross (
-        int         newCross,
-        FibreCross  **start,
-        StatusType  *status);
-TDFDELTA_INTERNAL void  tdFdeltaDeleteCross (
-        int         cross,
-        FibreCross  **start,
+TDFDELTA_INTERNAL void  tdFdeltaQueue (
         StatusType  *status);
-TDFDELTA_INTERNAL FibreCross  *tdFdeltaFindCross(
-        int         cross,
-        FibreCross  **start,
+TDFDELTA_INTERNAL void  tdFdeltaQueueMatrix (
         StatusType  *status);
 /*
- *  MODULE = tdFdeltaSequencer
+ *  MODULE = tdFdeltaThread
  */
-TDFDELTA_INTERNAL void  tdFdeltaSequencer (
-        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaThreadStart (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL int  tdFdeltaThreadBusy (
+        void);
+TDFDELTA_INTERNAL void  tdFdeltaThreadPrepare (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaThreadHurry (
+        void);
+TDFDELTA_INTERNAL void  tdFdeltaThreadReap (
+        int         stop);
+TDFDELTA_INTERNAL void  tdFdeltaThreadRunHere (
+        tdFdeltaType  *data,
+        FILE          *cmdFile,
+        tdFstats      *stats,
+        StatusType    *status);
 /*
- *  MODULE = tdFdeltaSeqSp
+ *  MODULE = tdFdeltaDrama
  */
+TDFDELTA_INTERNAL void  tdFdeltaDramaOut (
+        tdFdeltaCallbacks  *out,
+        StatusType         *status);
+TDFDELTA_INTERNAL void  tdFdeltaDramaOutFree (
+        tdFdeltaCallbacks  *out);
+TDFDELTA_INTERNAL void  tdFdeltaDramaPacked (
+        tdFdeltaCallbacks  *out);
+TDFDELTA_INTERNAL void  tdFdeltaDramaStream (
+        tdFdeltaCallbacks  *out);
+TDFDELTA_INTERNAL void  tdFdeltaDramaFlush (
+        const tdFdeltaCallbacks  *out,
+        StatusType               *status);
+TDFDELTA_INTERNAL SdsIdType  *tdFdeltaAbove (
+        tdFdeltaType  *data);
+TDFDELTA_INTERNAL void  tdFdeltaFreeActData (
+        tdFdeltaType  *data);
+TDFDELTA_INTERNAL void  tdFdeltaFieldCheck (
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaSequencer (
+        StatusType  *status);
 TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecial (
-        StatusType  *status);/*
- *  MODULE = tdFdeltaCmdFile
- */
-TDFDELTA_INTERNAL SdsIdType  tdFdeltaCFnew (
-        char        *name,
-        tdFinterim  *currDetails,
-        SdsIdType   *above,
         StatusType  *status);
-TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
+TDFDELTA_INTERNAL void  tdFdeltaStatsCreate (
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaStatsPublish (
+        const tdFstats  *stats,
+        StatusType      *status);
+TDFDELTA_INTERNAL SdsIdType  tdFdeltaCFcreate (
+        const char        *name,
+        const tdFinterim  *currDetails,
+        SdsIdType         *above,
+        StatusType        *status);
+TDFDELTA_INTERNAL int  tdFdeltaCFgetCmd (
         SdsIdType   cmdFileId,
-        long int    numMoves,
-        long int    numParks,
+        int         lineNo,
+        tdFcmdLine  *line,
         StatusType  *status);
-TDFDELTA_INTERNAL void  tdFdeltaCFaddSpringOutParks (
+TDFDELTA_INTERNAL void  tdFdeltaCFread (
+        SdsIdType   cmdFileId,
+        tdFcmdFile  *file,
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaCFfree (
+        tdFcmdFile  *file);
+TDFDELTA_INTERNAL void  tdFdeltaCFlegacy (
         SdsIdType   cmdFileId,
-        long int    numSpringOutParks,
         StatusType  *status);
 
-#ifdef DSTDARG_OK
-    TDFDELTA_INTERNAL void  tdFdeltaCFaddCmd (
-            StatusType  *status,
-            SdsIdType   cmdFileId,
-            int         lineNo,
-            char        *cmd,
-            ...);
-#else
-    TDFDELTA_INTERNAL void  tdFdeltaCFaddCmd ();
-#endif
-
-
-
-TDFDELTA_INTERNAL FpilType tdFdeltaFpilInst();
 #endif
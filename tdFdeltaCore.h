@@ -0,0 +1,1100 @@
+/*+            T D F D E L T A
+
+ *  Module name:
+      tdFdeltaCore.h
+
+ *  Function:
+      2dF Delta planning core include file.
+    
+ *  Description:
+      Types and functions of the planning core - the field check, both
+      sequencers, the crossover lists and command file generation.  The
+      core does not use DRAMA.  It is given its inputs in a tdFdeltaType
+      and reports messages, progress, statistics and the command file
+      through the callbacks in tdFdeltaCallbacks.  It is built as the
+      tdFdeltaCore library, which may be linked into other programs to
+      run the planner in-process, e.g.
+
+          data = tdFdeltaDataNew(check, &status);
+          ... fill in current, crosses, constants, offsets_, fids,
+              target and the clearances, set data->out ...
+          tdFdeltaPlan(data, 0, &status);
+          tdFdeltaDataFree(data);
+
+      The instrument must first be given with tdFdeltaFpilSet().  Plans
+      may be run at the same time in different threads, each selecting
+      its own plan with tdFdeltaUse() (see TDFDELTA_TLS below).  Plans run
+      at the same time must each have their own instrument description
+      (data->inst), since FPIL keeps the clearances in it.
+
+      The DRAMA task (tdFdelta.h) is a thin layer over the core.  Only
+      types (StatusType, INT32) are taken from the DRAMA include files.
+
+ *  Language:
+      C
+
+ *  Support: Tony Farrell, AAO
+
+ *-
+
+ *  History:
+      18-Oct-2026  AGT  Original version, split from tdFdelta.h.
+      18-Oct-2026  AGT  Add tdFsimGeom and the stand-in instrument model.
+      18-Oct-2026  AGT  Add tdFgenParams and the field generator.
+      18-Oct-2026  AGT  Button outlines, pivot keep out and screw holes
+                        in tdFsimGeom.
+      18-Oct-2026  AGT  Add the GENERATE result cache.
+      18-Oct-2026  AGT  Add warm start of tweaks, the warm phase and
+                        tdFgenParams tweak.
+      18-Oct-2026  AGT  Add the tdFdeltaRobot module.
+      18-Oct-2026  AGT  Hot items first in tdFdeltaType.  Add
+                        tdFdeltaDataPoolFlush().
+      18-Oct-2026  AGT  Add INT_GEOM flag and the tdFdeltaGeom module.
+      18-Oct-2026  AGT  Compile time instrument constants for single
+                        instrument builds.  Add tdFdeltaFpilFixed().
+      18-Oct-2026  AGT  Add the tdFdeltaSweep module, tdFdeltaCrossesCheck()
+                        and the crossover check phase.
+      18-Oct-2026  AGT  Plans may run concurrently.  Add TDFDELTA_TLS, the
+                        per plan instrument, trace, snapshot and warm start
+                        state and tdFdeltaLock().
+      18-Oct-2026  AGT  Add tdFdeltaCachePrepare().
+      18-Oct-2026  AGT  Add the tdFdeltaBatch module.
+      18-Oct-2026  AGT  Add the tdFdeltaEstimate and tdFdeltaMatrix modules.
+      18-Oct-2026  AGT  Add tdFdeltaGeomRadius() and tdFestimate pairsChecked
+                        and pairsSkipped.
+      18-Oct-2026  AGT  Add PACKED flag, tdFcfCmd, the cfCmd callback,
+                        tdFdeltaCFformat(), tdFdeltaCFparse() and
+                        tdFdeltaCacheRecording().
+      18-Oct-2026  AGT  Add STREAM flag.
+      18-Oct-2026  AGT  Add TDFDELTA_LOAD(), TDFDELTA_STORE() and
+                        TDFDELTA_CANCELLED().  tdFdeltaFieldCheckRun() and
+                        tdFdeltaSequencerSpecialRun() take a cancel flag.
+      19-Oct-2026  AGT  tdFdeltaColButBut() etc. are macros, the integer
+                        checks are tdFdeltaGeomButBut() etc.
+      19-Oct-2026  AGT  Add TDFDELTA_STATS_CUR and tdFdeltaStatsSpare.
+      19-Oct-2026  AGT  Add tdFdeltaSequencerSpecialOrder() and the
+                        tdFneighbours button radius.
+      19-Oct-2026  AGT  Remove INT_GEOM flag, the tdFdeltaGeom module and
+                        the tdFdeltaCol*() macros.
+      19-Oct-2026  AGT  Add tdFdeltaFieldCheckFailed().
+      19-Oct-2026  AGT  Single instrument builds take the number of
+                        pivots from the instrument description, set by
+                        tdFdeltaFpilSet().  Only ParkMayCollide is a
+                        compile time constant.
+      {@change entry@}
+
+ *  @(#) $Id: ACMM:2dFdelta/tdFdeltaCore.h,v 3.17 25-Aug-2014 14:38:03+10 tjf $ (mm/dd/yy)
+ */
+
+#ifndef __TDFDELTACORE_H__
+#define __TDFDELTACORE_H__
+
+#include "status.h"    /* For StatusType */
+#include "sds.h"       /* For INT32      */
+#include "fpil.h"
+
+/*
+ *  Use to declare constant arguments.
+ *  Under GNU may get some warnings when compiling TDFDELTA itself due to C
+ *  routines not being declared correctly.
+ */
+#define TDFDELTA_CONST_ARGVAL  const   /* Use for constant argument values     */
+#define TDFDELTA_CONST_ARGPNT  const   /* Use for constant argument pointers   */
+#define TDFDELTA_CONST_VAR     const   /* Use for constant variables           */
+
+/*
+ *  Used to declare routines.
+ */
+#define TDFDELTA_PUBLIC   extern       /* routines available to other packages */
+#define TDFDELTA_INTERNAL extern       /* routines available thoughout tdFpt   */
+#define TDFDELTA_PRIVATE  static       /* routines internal to one module      */
+
+/*
+ *  2dF Delta Configuration Task definitions.
+ */
+#define PI             3.1415926535
+
+#define NO                        0
+#define YES                       1
+#define IF_NEEDED                 2
+
+#define GUIDE                     0    /* Fibre types                          */
+#define OBJECT                    1
+
+#define FILENAME_LENGTH         200    /* Max "Command File" name length       */
+#define CMD_NAME_LENGTH          10    /* Command buffer length                */
+#define COMMENT_LENGTH          100    /* Comment buffer length                */
+#define CMDLINE_LENGTH          500    /* Command line maximum length          */
+
+#define TDFDELTA_PROG_MS        250    /* Only update the DELTA_PROG and ...   */
+                                       /* ... DELTA_ETA params this often (ms) */
+
+#define TDFDELTA_TRACE_EVENTS 100000   /* Size of the TRACE ring buffer        */
+
+#define TDFDELTA_SLICE_MS        20    /* The sequencer reschedules itself ... */
+                                       /* ... after running for this many ms   */
+
+#define TDFDELTA_CACHE_ENTRIES    8    /* Max GENERATE results cached ...      */
+#define TDFDELTA_CACHE_BYTES (4*1024*1024) /* ... and memory they may use      */
+#define TDFDELTA_CACHE_PENDING    2    /* Looked up result is being prepared   */
+
+#define TDFDELTA_WARM_TOL       500    /* Warm start position tolerance and .. */
+#define TDFDELTA_WARM_ARM     10000    /* .. button radius for theta (microns) */
+#define TDFDELTA_WARM_REFS        2    /* Warm start references, one per plate */
+
+#define TDFDELTA_ROBOT_SPEED  50000    /* Robot speed on each axis (microns/s) */
+#define TDFDELTA_ROBOT_GRASP    2.5    /* Time to pick up or put down (s)      */
+#define TDFDELTA_BATCH_THREADS    4    /* Max threads planning a batch         */
+
+/*
+ *  Used to set check word that is passed between most functions.
+ */
+#define CHECK_ALL                 0    /* Reset check mask                     */
+#define _DEBUG               (1<<0)    /* Display debugging infomation         */
+#define DISPLAY              (1<<1)    /* Display useful infomation            */
+#define SHOW     (_DEBUG | DISPLAY)    /* Debug or display flag specified      */
+#define CHECK_FULL_FIELD     (1<<2)    /* Check validity of ALL fibres         */
+#define NO_DELTA             (1<<3)    /* Do not perform delta process         */
+#define NO_ORDER_CHECK       (1<<4)    /* Bypass delta checks                  */
+#define NO_FIELD_CHECK       (1<<5)    /* Do not perform field validity checks */
+
+#define SPECIAL              (1<<6)    /* Run the special mode delta for 6dF */
+#define THREAD               (1<<7)    /* Run delta in a worker thread         */
+#define TRACE                (1<<8)    /* Write a Chrome trace of decisions    */
+#define SNAPSHOT             (1<<9)    /* Write a snapshot of the inputs       */
+#define PACKED               (1<<11)   /* Packed (columnar) command file       */
+#define STREAM               (1<<12)   /* Send command file lines as they come */
+
+/*
+ *  Macro's
+ */
+#define SQRD(x)           ((x)*(x))    /* Returns the square of the number     */
+#define MAXMIN(a,b,c,d) ((c=a)>(d=b)?(c):(c-=d,d+=c,c=d-c))  /* JOS macro to.. */
+                                       /* take a and b, and put max in c and.. */
+                                       /* min in d.                            */
+
+/*
+ *  Instrument specialisation.  When built for only one instrument (dmkmf
+ *  -v 2df_only or -v 6df_only, giving NO_SIX_DF or NO_TWO_DF), whether
+ *  parked buttons may collide is a compile time constant - they may in
+ *  6dF but not in 2dF (see the 26-Apr-2000 entry of tdFdelFieldCh.c).
+ *  The instrument given to tdFdeltaFpilSet() must agree with it (see
+ *  tdFdeltaFpilFixed()).  The number of pivots is got from the FPIL
+ *  instrument description once, by tdFdeltaFpilSet(), rather than for
+ *  each use, and a plan's own instrument (data->inst) must have the same
+ *  number.  Otherwise both are got from the FPIL instrument description.
+ */
+#if defined(NO_SIX_DF) && !defined(NO_TWO_DF)
+#   define TDFDELTA_INST_NAME       "2dF"
+#   define TDFDELTA_PARK_MAY_COLLIDE  NO
+#elif defined(NO_TWO_DF) && !defined(NO_SIX_DF)
+#   define TDFDELTA_INST_NAME       "6dF"
+#   define TDFDELTA_PARK_MAY_COLLIDE YES
+#endif
+
+#ifdef TDFDELTA_PARK_MAY_COLLIDE
+    extern unsigned tdFdeltaPivots;
+#   define tdFdeltaNumPivots(inst)       tdFdeltaPivots
+#   define tdFdeltaParkMayCollide(inst)  TDFDELTA_PARK_MAY_COLLIDE
+#else
+#   define tdFdeltaNumPivots(inst)       FpilGetNumPivots(inst)
+#   define tdFdeltaParkMayCollide(inst)  FpilParkMayCollide(inst)
+#endif
+
+/*
+ *  Thread local storage.  The core keeps the plan selected by
+ *  tdFdeltaUse() (its callbacks, statistics, instrument and so on) in
+ *  thread local variables, so each thread may run its own plan.  What
+ *  is shared between plans - the plan data pool, the result cache, the
+ *  warm start references and the integer button outlines - is only used
+ *  under tdFdeltaLock().
+ *  Where the compiler has no thread local storage, or TDFDELTA_NO_THREADS
+ *  is defined, these are ordinary variables and only one thread may
+ *  plan at a time, although plans may still be interleaved in one
+ *  thread (as the task's time sliced actions are).
+ */
+#if defined(__GNUC__) && !defined(TDFDELTA_NO_THREADS)
+#   define TDFDELTA_TLS  __thread
+#   define TDFDELTA_REENTRANT
+#else
+#   define TDFDELTA_TLS
+#endif
+
+/*
+ *  Flags and counters set in one thread and polled in another, such as
+ *  a plan's cancel flag and a worker's progress, are read with acquire
+ *  and written with release ordering.  Without the GCC atomic builtins
+ *  they are plain volatile accesses.  TDFDELTA_CANCELLED() takes a
+ *  cancel flag pointer which may be null.
+ */
+#if defined(__GNUC__)
+#   define TDFDELTA_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#   define TDFDELTA_STORE(p,v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#   define TDFDELTA_LOAD(p)     (*(p))
+#   define TDFDELTA_STORE(p,v)  (*(p) = (v))
+#endif
+#define TDFDELTA_CANCELLED(c)   (((c) != 0) && TDFDELTA_LOAD(c))
+
+
+/*
+ *  Interim details - these are the details that will be continually changing
+ *  during the generation of command files. All units are either microns
+ *  or radians.
+ */
+typedef struct tdFinterim {
+      double    theta[FPIL_MAXPIVOTS]; /* Button handle orientation          */
+      double    fibreLength[FPIL_MAXPIVOTS];/* Pivot-button distance         */
+      INT32  fvpX[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - x ord. */
+      INT32  fvpY[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - y ord. */
+      INT32  xf[FPIL_MAXPIVOTS];    /* Fibre-end x coordinate             */
+      INT32  yf[FPIL_MAXPIVOTS];    /* Fibre-end y coordinate             */
+      INT32  xb[FPIL_MAXPIVOTS];    /* Button x coordinate                */
+      INT32  yb[FPIL_MAXPIVOTS];    /* Button y coordinate                */
+      short     park[FPIL_MAXPIVOTS];  /* Flag indicating button is parked   */
+      short     nAbove[FPIL_MAXPIVOTS];/* Number of fibres crossing above    */
+      short     nBelow[FPIL_MAXPIVOTS];/* Number of fibres crossing below    */
+      } tdFinterim;
+
+/*
+ *  Positioning offsets.  This is the offset that occurs when a button
+ *  is placed.  There are three offsets for each button, one for moves
+ *  from the park position , one for moves to the park position and
+ *  one for all other moves (plate to plate)
+ */
+typedef struct tdFoffsets {
+      short  xOffPL[FPIL_MAXPIVOTS]; /* Positioning offset - x, plate to plate  */
+      short  yOffPL[FPIL_MAXPIVOTS]; /* Positioning offset - y, plate to plate  */
+      short  xOffFrPK[FPIL_MAXPIVOTS]; /* Positioning offset - x, park  to plate  */
+      short  yOffFrPK[FPIL_MAXPIVOTS]; /* Positioning offset - y, park  to plate  */
+      short  xOffToPK[FPIL_MAXPIVOTS]; /* Positioning offset - x, plate to park */
+      short  yOffToPK[FPIL_MAXPIVOTS]; /* Positioning offset - y, plate to park */
+      } tdFoffsets;
+
+/*
+ *  Fidcuial locations.
+ */
+typedef struct tdFfidcuials {
+      INT32  fidX[FPIL_MAXFIDS];   /* Fiducial mark X ordinate (mic)     */
+      INT32  fidY[FPIL_MAXFIDS];   /* Fiducial mark Y ordinate (mic)     */
+      short     inUse[FPIL_MAXFIDS];  /* Is the fiducial currently in use   */
+      } tdFfiducials;
+
+/*
+ *  Target structure - details of target field.
+ */
+typedef struct tdFtarget {
+      double    theta[FPIL_MAXPIVOTS]; /* Button handle orientation          */
+      double    fibreLength[FPIL_MAXPIVOTS]; /* Pivot-button distance        */
+      INT32  fvpX[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - x ord. */
+      INT32  fvpY[FPIL_MAXPIVOTS];  /* Fibre virtual pivot point - y ord. */
+      INT32  xf[FPIL_MAXPIVOTS];    /* Fibre-end x coordinate             */
+      INT32  yf[FPIL_MAXPIVOTS];    /* Fibre-end y coordinate             */
+      short     mustMove[FPIL_MAXPIVOTS];/* Flag indicating button must move */
+      short     park[FPIL_MAXPIVOTS];  /* Flag indicating button is parked   */
+      } tdFtarget;
+
+/*
+ *  Field constants - should be constant during observations.
+ */
+typedef struct tdFconstants {
+      double    tPark[FPIL_MAXPIVOTS]; /* Park position - theta coordinate   */
+      INT32  xPark[FPIL_MAXPIVOTS]; /*               - x coordinate       */
+      INT32  yPark[FPIL_MAXPIVOTS]; /*               - y coordinate       */
+      INT32  xPiv[FPIL_MAXPIVOTS];  /* Pivot location - x coordinate      */
+      INT32  yPiv[FPIL_MAXPIVOTS];  /*                - y coordinate      */
+      short     type[FPIL_MAXPIVOTS];  /* Type of pivot - GUIDE/OBJECT       */
+      short     inUse[FPIL_MAXPIVOTS]; /* Flag indicating if pivot is broken */
+      INT32  graspX[FPIL_MAXPIVOTS];/* Fibre-end location during...       */
+      INT32  graspY[FPIL_MAXPIVOTS];/*                   ...button grasp  */
+      unsigned long maxExt[FPIL_MAXPIVOTS]; /* Maximum fibre extension */
+      } tdFconstants;
+
+/*
+ *  Crossover details - details of the crossovers between the fibres.
+ *  When a crossover is detected, the level number is used to determine
+ *  which fibre crosses above the other. This information is then used to
+ *  construct a linked list of the numbers of fibres crossing above, and the
+ *  numbers of the fibres crossing below each fibre.
+ */
+typedef struct FibreCross {
+      short             piv;              /* Number of the fibre crossing    */
+      struct FibreCross *next;            /* Pointer to next pivot number    */
+} FibreCross;
+
+typedef struct tdFcrosses {
+      FibreCross   *above[FPIL_MAXPIVOTS];/* Numbers of fibres crossing above*/
+      FibreCross   *below[FPIL_MAXPIVOTS];/* Numbers of fibres crossing above*/
+} tdFcrosses;
+
+/*
+ *  Called by tdFdeltaSweep() for each pair of fibres which cross (pivot
+ *  indices, lower first).
+ */
+typedef void (*tdFsweepFound)(void *clientData, unsigned a, unsigned b);
+
+
+/*
+ *  Progress model, see tdFdeltaProgress().
+ */
+typedef struct tdFprogress {
+      double        tStart;               /* tdFdeltaClock() at start         */
+      double        tLast;                /* When pivotsLeft last dropped     */
+      double        tPut;                 /* When last published              */
+      double        cost;                 /* Smoothed seconds per pivot       */
+      unsigned      leftLast;             /* pivotsLeft at tLast              */
+      } tdFprogress;
+
+/*
+ *  Sequencer state.  tdFdeltaSequencer() runs in time slices, rescheduling
+ *  itself between them, so everything it needs to carry on from where it
+ *  left off is kept here rather than in local variables.
+ */
+typedef struct tdFseqState {
+      short         started;              /* Set once initialised             */
+      short         cancel;               /* Set by tdFdeltaKick()            */
+      double        tStart;               /* tdFdeltaClock() at start         */
+      tdFprogress   progress;             /* DELTA_PROG/DELTA_ETA model       */
+      unsigned      numPivots;            /* Number of pivots                 */
+      int           pivotsLeft;           /* Number of pivots left to move    */
+      int           pivotsMoved;          /* Pivots moved to target position  */
+      int           didMove;              /* A fibre was moved this pass      */
+      unsigned      searchIndex;          /* Next pivot for SearchForMove()   */
+      unsigned      lineNumber;           /* Next command file line           */
+      unsigned      numMoves;             /* Number of moves so far           */
+      unsigned      numParks;             /* Number of parks so far           */
+      short         extraParks;
+      short         numUnParkedNotMovedLeft; /* Un-parked pivots not moved   */
+      short         numMovesPrevented[FPIL_MAXPIVOTS]; /* Moves each pivot ..
+                                                 has prevented this pass    */
+      short         alreadyMoved[FPIL_MAXPIVOTS];
+      short         alreadyParked[FPIL_MAXPIVOTS];
+      } tdFseqState;
+
+/*
+ *  Planner statistics, published as the DELTA_STATS parameter.  Phase
+ *  timers record the number of times a phase was entered and the total
+ *  time spent in it.  The counters are incremented with TDFDELTA_STAT().
+ */
+#define TDF_PHASE_CONVERT        0     /* SDS to C conversion                  */
+#define TDF_PHASE_CHECK_BUTBUT   1     /* Field check passes                   */
+#define TDF_PHASE_CHECK_BUTFIB   2
+#define TDF_PHASE_CHECK_EXT      3
+#define TDF_PHASE_CHECK_BEND     4
+#define TDF_PHASE_CHECK_POS      5
+#define TDF_PHASE_CHECK_FIDS     6
+#define TDF_PHASE_SEARCH         7     /* SearchForMove() passes, positioning  */
+#define TDF_PHASE_PARK           8     /* Park choices                         */
+#define TDF_PHASE_CMDFILE        9     /* Command file line emission           */
+#define TDF_PHASE_WARM          10     /* Warm start pair matrix update        */
+#define TDF_PHASE_CHECK_CROSS   11     /* Crossover list checks                */
+#define TDF_NUM_PHASES          12
+
+typedef struct tdFphaseStat {
+      unsigned long count;                /* Times phase entered              */
+      double        ns;                   /* Total time in phase (ns)         */
+      } tdFphaseStat;
+
+typedef struct tdFstats {
+      tdFphaseStat  phase[TDF_NUM_PHASES];
+      unsigned long colButBut;            /* FpilColButBut() calls            */
+      unsigned long colButFib;            /* FpilColButFib() calls            */
+      unsigned long colFibFib;            /* FpilColFibFib() calls            */
+      unsigned long crossAdds;            /* Crossover list items added       */
+      unsigned long crossDeletes;         /* Crossover list items deleted     */
+      unsigned long cacheHits;            /* Result cache hits so far         */
+      unsigned long cacheMisses;          /* Result cache misses so far       */
+      unsigned long cacheEntries;         /* Results in the cache             */
+      unsigned long cacheBytes;           /* Memory used by the cache         */
+      unsigned long warmSkips;            /* Pair checks skipped, warm start  */
+      } tdFstats;
+
+#define TDFDELTA_STATS_CUR   (tdFdeltaStatsCur ? tdFdeltaStatsCur : \
+                                               &tdFdeltaStatsSpare)
+#define TDFDELTA_STAT(item)  (++TDFDELTA_STATS_CUR->item)
+
+/*
+ *  Trace event types, see tdFdeltaTraceAdd().  Phases (TDF_PHASE_ codes)
+ *  are also traced, as spans.
+ */
+#define TDF_TRACE_MOVE          0      /* Pivot can move directly to target    */
+#define TDF_TRACE_BLOCKED       1      /* Pivot move prevented by another      */
+#define TDF_TRACE_PARK          2      /* Pivot chosen to be parked            */
+#define TDF_TRACE_CROSS_ADD     3      /* Crossover added                      */
+#define TDF_TRACE_CROSS_DEL     4      /* Crossover removed                    */
+#define TDF_TRACE_PHASE       100      /* + TDF_PHASE_ code                    */
+
+#define TDFDELTA_TRACE(type,piv,other,arg) \
+    ((tdFdeltaTracing) ? tdFdeltaTraceAdd(type,piv,other,arg) : (void)0)
+
+/*
+ *  A command file command, as passed to the cfCmd callback.  The op is
+ *  one of TDF_CF_... below.  For MF, piv, xf, yf and theta are set, for
+ *  PF just piv, for the comments (! and *) just comment.
+ */
+#define TDF_CF_MF       1               /* Move fibre                        */
+#define TDF_CF_PF       2               /* Park fibre                        */
+#define TDF_CF_NOTE     3               /* Comment, no echo (!)              */
+#define TDF_CF_ECHO     4               /* Comment, echoed (*)               */
+
+typedef struct tdFcfCmd {
+      short         op;
+      int           piv;                  /* Pivot number, from 1             */
+      INT32         xf;
+      INT32         yf;
+      double        theta;
+      const char    *comment;
+      } tdFcfCmd;
+
+/*
+ *  Output callbacks.  The core calls these, with clientData as the first
+ *  argument, for all of its output.  Any may be null, in which case that
+ *  output is discarded.
+ *
+ *  msgOut    - An informational message.
+ *  ersRep    - An error report, flags as per ErsRep().
+ *  progress  - Percentage complete and estimated milliseconds remaining.
+ *  stats     - The planner statistics, on completion.
+ *  errorText - Returns the text for a status code.
+ *  cfNew     - A command file is being started.  name is as per the
+ *              tdFdeltaType, cur is the field it starts from.
+ *  cfLine    - A command file line, name is "line<n>".
+ *  cfCmd     - A command file line, lineNo being <n>, as its command and
+ *              parameters rather than text.  If set, it is called in
+ *              place of cfLine for new lines, so the text is not
+ *              formatted.  Lines replayed from the result cache or a
+ *              worker thread are still passed to cfLine.
+ *  cfCount   - A command file count - numMoves, numParks or
+ *              springOutParks.
+ *  cfDone    - The command file is complete (keep true) or should be
+ *              discarded (keep false).
+ */
+typedef struct tdFdeltaCallbacks {
+      void          *clientData;
+      void          (*msgOut)(void *clientData, const char *text);
+      void          (*ersRep)(void *clientData, int flags,
+                              StatusType *status, const char *text);
+      void          (*progress)(void *clientData, float progress,
+                                long int eta, StatusType *status);
+      void          (*stats)(void *clientData, const tdFstats *stats,
+                             StatusType *status);
+      const char    *(*errorText)(void *clientData, StatusType status);
+      void          (*cfNew)(void *clientData, const char *name,
+                             const tdFinterim *cur, StatusType *status);
+      void          (*cfLine)(void *clientData, const char *name,
+                              const char *line, StatusType *status);
+      void          (*cfCount)(void *clientData, const char *name,
+                               long int value, StatusType *status);
+      void          (*cfDone)(void *clientData, int keep,
+                              StatusType *status);
+      void          (*cfCmd)(void *clientData, int lineNo,
+                             const tdFcfCmd *cmd, StatusType *status);
+      } tdFdeltaCallbacks;
+
+/*
+ *  A result cache recording, see tdFdelCache.c, a trace, see
+ *  tdFdelTrace.c, and an input snapshot, see tdFdelSnap.c.
+ */
+typedef struct tdFcacheRec tdFcacheRec;
+typedef struct tdFtrace    tdFtrace;
+typedef struct tdFsnap     tdFsnap;
+
+/*
+ *  A plan's use of the warm start references, see tdFdelWarm.c.
+ */
+typedef struct tdFwarmUse {
+      short         ref;                  /* Reference claimed, -1 if none    */
+      short         active;               /* The reference applies            */
+      short         targetNear[FPIL_MAXPIVOTS]; /* Target within tolerance  */
+      } tdFwarmUse;
+
+/*
+ *  The planner inputs and state.  Used as the action data (with
+ *  DitsPutActData and DitsGetActData) by the task.  Created by
+ *  tdFdeltaDataNew() from a pool of cache line aligned structures.
+ *
+ *  The items used in the pair loops of the field check and sequencer come
+ *  first, those only used in conversion, positioning offsets, fiducial
+ *  checks and reporting after, so the hot items share as few cache lines
+ *  and pages as possible with the cold.
+ */
+typedef struct tdFdeltaType {
+      tdFinterim      current;
+      tdFtarget       target;
+      tdFconstants    constants;
+      tdFcrosses      crosses;
+      long int        butClearG;
+      long int        butClearO;
+      long int        fibClearG;
+      long int        fibClearO;
+      short           check;
+      tdFseqState     seq;     /* tdFdeltaSequencer() state */
+      tdFstats        stats;   /* DELTA_STATS for this action */
+      tdFwarmUse      warm;    /* Warm start, see tdFdelWarm.c */
+
+      /*
+       *  Cold items.
+       */
+      double          maxButAngG;
+      double          maxButAngO;
+      double          maxPivAngG;
+      double          maxPivAngO;
+      long int        extSpringOut;
+      tdFoffsets      offsets_;  /* Underscore was only to have compiler pick 
+                                    up occurances of this variable */
+      tdFfiducials    fids;
+      char            name[FILENAME_LENGTH];
+      short           failed[FPIL_MAXPIVOTS]; /* Pivots reported as failed
+                                                 to a REPLAN action       */
+      tdFdeltaCallbacks out;   /* Where output goes, see tdFdeltaUse() */
+      tdFcacheRec     *cache;  /* Result being recorded for the cache */
+      tdFtrace        *trace;  /* Trace, if the TRACE flag was given */
+      tdFsnap         *snap;   /* Input snapshot, see tdFdelSnap.c */
+      FpilType        inst;    /* The plan's own instrument description,
+                                  null for that given to tdFdeltaFpilSet() */
+      }  tdFdeltaType;
+
+
+/*
+ *  Stand-in instrument geometry, see tdFdeltaFpilSimInit().  Lengths
+ *  are in microns, angles in radians.  The button outline is a convex
+ *  polygon relative to the fibre end, the first ordinate along the
+ *  button axis toward the pivot, the second at right angles to it.
+ */
+#define TDF_SIM_OUTLINE          8     /* Max button outline vertices          */
+#define TDF_SIM_SCREWS           4     /* Max screw holes                      */
+
+typedef struct tdFsimGeom {
+      const char    *name;                /* Instrument name                  */
+      const char    *telescope;           /* Telescope name                   */
+      unsigned      numPivots;            /* Nominal number of pivots         */
+      unsigned      numGuide;             /* Number of guide pivots           */
+      unsigned      numFids;              /* Number of fiducials              */
+      int           parkMayCollide;       /* Parked buttons may collide       */
+      int           fibAngVar;            /* Button/fibre angle may vary      */
+      long int      fieldRadius;          /* Usable field radius              */
+      long int      pivotRadius;          /* Radius of pivot circle           */
+      long int      pivotKeepOut;         /* Buttons keep this far inside it  */
+      long int      parkRadius;           /* Radius of park positions         */
+      long int      fidRadius;            /* Radius of fiducial circle        */
+      unsigned      numOutline;           /* Button outline vertices          */
+      long int      outline[TDF_SIM_OUTLINE][2]; /* Button outline        */
+      unsigned      numScrews;            /* Number of screw holes            */
+      long int      screw[TDF_SIM_SCREWS][2];    /* Screw hole centres    */
+      long int      screwRadius;          /* Screw hole radius                */
+      long int      virPivLen;            /* Fibre end to virtual pivot       */
+      long int      maxExt;               /* Maximum fibre extension          */
+      double        maxPivAng;            /* Maximum pivot/fibre angle        */
+      double        maxButAng;            /* Maximum button/fibre angle       */
+      long int      butClear;             /* Default button clearance         */
+      long int      fibClear;             /* Default fibre clearance          */
+      long int      butRadius;            /* Outline bounding radius, set by
+                                             tdFdeltaFpilSimInit()          */
+      } tdFsimGeom;
+
+/*
+ *  Random field parameters, see tdFdeltaGenField().
+ */
+typedef struct tdFgenParams {
+      double        density;              /* Fraction of pivots placed        */
+      double        crossing;             /* Crossing rate, 0 to 1            */
+      double        mustMove;             /* Fraction of pivots to move       */
+      long          tweak;                /* If > 0, target is a tweak of the
+                                             current field by up to this
+                                             (microns)                        */
+      } tdFgenParams;
+
+/*
+ *  Robot time estimate, see tdFdelRobot.c.
+ */
+typedef struct tdFrobot {
+      double        time;                 /* Estimated time so far (s)        */
+      INT32         x, y;                 /* Gripper position                 */
+      const tdFconstants *con;            /* For the park positions           */
+      INT32         xf[FPIL_MAXPIVOTS];   /* Fibre end positions              */
+      INT32         yf[FPIL_MAXPIVOTS];
+      } tdFrobot;
+
+/*
+ *  A batch of plans, see tdFdeltaBatch().  Each segment is an ordered
+ *  list of fields configured one after the other on one plate, starting
+ *  from the start field.  The segments are independent (different plates
+ *  or different nights) and are planned concurrently.
+ */
+typedef struct tdFbatchField {
+      unsigned      numMoves;             /* Moves in the plan                */
+      unsigned      numParks;             /* Parks in the plan                */
+      double        robotTime;            /* Estimated robot time (s)         */
+      StatusType    status;               /* STATUS__OK if planned            */
+      char          error[CMDLINE_LENGTH];/* First error reported, if not     */
+      } tdFbatchField;
+
+typedef struct tdFbatchSeg {
+      tdFdeltaType  *start;               /* Start field, constants, offsets,
+                                             fiducials, clearances and flags.
+                                             Its target is not used and it
+                                             is not changed.                  */
+      const tdFtarget *targets;           /* The fields, in order             */
+      unsigned      numFields;            /* Number of targets                */
+      tdFbatchField *fields;              /* Output, numFields of them        */
+      unsigned long numMoves;             /* Output totals of the planned     */
+      unsigned long numParks;             /* fields                           */
+      double        robotTime;
+      unsigned      numPlanned;           /* Output number of fields planned  */
+      } tdFbatchSeg;
+
+typedef struct tdFbatch {
+      tdFbatchSeg   *segs;                /* The segments                     */
+      unsigned      numSegs;
+      FpilType      *insts;               /* Instruments, one per thread, see
+                                             tdFdeltaFpilNew(), or null to
+                                             use just the calling thread      */
+      unsigned      numInsts;
+      volatile int  cancel;               /* Set to stop planning             */
+      unsigned      nextSeg;              /* Next segment to plan (locked)    */
+      unsigned      fieldsDone;           /* Fields finished so far (locked)  */
+      } tdFbatch;
+
+/*
+ *  Pivot neighbour lists, see tdFdeltaNeighboursNew().  For pivot i, the
+ *  other pivots ordered by distance are piv[i*numPivots ...], with their
+ *  distances in dist.  The button radius is for the estimate's broad phase.
+ */
+typedef struct tdFneighbours {
+      unsigned      numPivots;
+      short         *piv;
+      float         *dist;
+      long          radius;               /* Button radius, or -1             */
+      } tdFneighbours;
+
+/*
+ *  Estimated cost of a plan, see tdFdeltaEstimate().
+ */
+typedef struct tdFestimate {
+      unsigned      numMoves;             /* Moves                            */
+      unsigned      numParks;             /* Parks                            */
+      double        robotTime;            /* Robot time (s)                   */
+      unsigned      lifted;               /* Fibres parked and put back       */
+      unsigned      parkedOut;            /* Fibres parked out of the way     */
+      short         confident;            /* Expected to match the plan       */
+      short         exact;                /* From the plan itself             */
+      unsigned long pairsChecked;         /* Pair collision checks made       */
+      unsigned long pairsSkipped;         /* Pairs clear by the broad phase   */
+      StatusType    status;               /* STATUS__OK if estimated          */
+      } tdFestimate;
+
+/*
+ *  Costs between each pair of candidate fields, see tdFdeltaMatrix().
+ */
+typedef struct tdFmatrix {
+      tdFdeltaType  *start;               /* Constants, offsets, fiducials,
+                                             clearances and flags.  Its
+                                             current and target are not used
+                                             and it is not changed.           */
+      const tdFtarget *targets;           /* The candidate fields             */
+      unsigned      numFields;            /* Number of targets                */
+      unsigned      refine;               /* Number per row to plan in full   */
+      tdFestimate   *cost;                /* Output, [from*numFields + to]    */
+      FpilType      *insts;               /* Instruments, one per thread, see
+                                             tdFdeltaFpilNew(), or null to
+                                             use just the calling thread      */
+      unsigned      numInsts;
+      volatile int  cancel;               /* Set to stop                      */
+      unsigned      nextRow;              /* Next row to estimate (locked)    */
+      unsigned      rowsDone;             /* Rows finished so far (locked)    */
+      } tdFmatrix;
+
+
+/*
+ *  Function prototypes.
+ */
+
+/*
+ *  MODULE = tdFdeltaCore
+ */
+TDFDELTA_PUBLIC tdFdeltaType  *tdFdeltaDataNew (
+        short       check,
+        StatusType  *status);
+TDFDELTA_PUBLIC void  tdFdeltaDataFree (
+        tdFdeltaType  *data);
+TDFDELTA_PUBLIC void  tdFdeltaDataPoolFlush (
+        void);
+TDFDELTA_PUBLIC void  tdFdeltaPlan (
+        tdFdeltaType  *data,
+        volatile int  *cancel,
+        StatusType    *status);
+TDFDELTA_PUBLIC void  tdFdeltaFpilSet (
+        FpilType    inst);
+TDFDELTA_PUBLIC FpilType  tdFdeltaFpilInst (
+        void);
+TDFDELTA_PUBLIC int  tdFdeltaFpilFixed (
+        FpilType    inst);
+TDFDELTA_INTERNAL void  tdFdeltaUse (
+        tdFdeltaType  *data);
+TDFDELTA_INTERNAL const tdFdeltaCallbacks  *tdFdeltaOut (
+        void);
+TDFDELTA_INTERNAL void  tdFdeltaLock (
+        void);
+TDFDELTA_INTERNAL void  tdFdeltaUnlock (
+        void);
+TDFDELTA_INTERNAL double  tdFdeltaClock (
+        void);
+TDFDELTA_INTERNAL void  tdFdeltaProgInit (
+        tdFprogress  *prog,
+        unsigned     pivotsLeft);
+TDFDELTA_INTERNAL void  tdFdeltaProgress (
+        tdFprogress  *prog,
+        unsigned     pivotsLeft,
+        StatusType   *status);
+TDFDELTA_INTERNAL void  tdFdeltaPutProgress (
+        float       progress,
+        long int    eta,
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaPutStats (
+        const tdFstats  *stats,
+        StatusType      *status);
+TDFDELTA_INTERNAL const char  *tdFdeltaErrorText (
+        StatusType  status);
+#ifdef DSTDARG_OK
+    TDFDELTA_INTERNAL void  tdFdeltaMsgOut (
+            StatusType  *status,
+            const char  *fmt,
+            ...);
+    TDFDELTA_INTERNAL void  tdFdeltaErsRep (
+            int         flags,
+            StatusType  *status,
+            const char  *fmt,
+            ...);
+#else
+    TDFDELTA_INTERNAL void  tdFdeltaMsgOut ();
+    TDFDELTA_INTERNAL void  tdFdeltaErsRep ();
+#endif
+/*
+ *  MODULE = tdFdeltaFieldCheck
+ */
+TDFDELTA_INTERNAL int  tdFdeltaFieldCheckRun (
+        tdFdeltaType  *data,
+        volatile int  *cancel,
+        StatusType    *status);
+TDFDELTA_INTERNAL unsigned  tdFdeltaFieldCheckFailed (
+        tdFdeltaType  *data,
+        short         *blocked,
+        StatusType    *status);
+/*
+ *  MODULE = tdFdeltaCrosses
+ */
+TDFDELTA_INTERNAL void  tdFdeltaAddCross (
+        int         newCross,
+        FibreCross  **start,
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaDeleteCross (
+        int         cross,
+        FibreCross  **start,
+        StatusType  *status);
+TDFDELTA_INTERNAL FibreCross  *tdFdeltaFindCross(
+        int         cross,
+        FibreCross  **start,
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaCrossesMoved (
+        unsigned            piv,
+        int                 parkMayCollide,
+        const tdFconstants  *con,
+        tdFinterim          *cur,
+        tdFcrosses          *crosses,
+        StatusType          *status);
+TDFDELTA_INTERNAL void  tdFdeltaCrossesParked (
+        unsigned            piv,
+        tdFinterim          *cur,
+        tdFcrosses          *crosses,
+        StatusType          *status);
+TDFDELTA_INTERNAL unsigned  tdFdeltaCrossesCheck (
+        const char          *what,
+        int                 parkMayCollide,
+        const tdFconstants  *con,
+        const tdFinterim    *cur,
+        const tdFcrosses    *crosses,
+        StatusType          *status);
+/*
+ *  MODULE = tdFdeltaSweep
+ */
+TDFDELTA_INTERNAL long  tdFdeltaSweep (
+        unsigned            numPivots,
+        const tdFconstants  *con,
+        const INT32         fvpX[],
+        const INT32         fvpY[],
+        const short         use[],
+        tdFsweepFound       found,
+        void                *clientData,
+        StatusType          *status);
+/*
+ *  MODULE = tdFdeltaSequencer
+ */
+TDFDELTA_INTERNAL int  tdFdeltaSequencerStart (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL int  tdFdeltaSequencerSlice (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaSequencerCancel (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaSequencerRun (
+        tdFdeltaType      *data,
+        volatile int      *cancel,
+        StatusType        *status);
+TDFDELTA_INTERNAL int  tdFdeltaTargetBlocked (
+        const tdFinterim    *cur,
+        const tdFtarget     *target,
+        const tdFconstants  *con,
+        long                butClearG,
+        long                butClearO,
+        long                fibClearG,
+        long                fibClearO,
+        unsigned            piv,
+        unsigned            otherPiv);
+/*
+ *  MODULE = tdFdeltaSeqSp
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecialRun (
+        tdFdeltaType  *data,
+        volatile int  *cancel,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaSequencerSpecialOrder (
+        const tdFdeltaType  *from,
+        const tdFtarget     *target,
+        const short         *mustMove,
+        short               *parkOrder,
+        unsigned            *numParks,
+        short               *moveOrder,
+        unsigned            *numMoves,
+        StatusType          *status);
+/*
+ *  MODULE = tdFdeltaCmdFile
+ */
+TDFDELTA_INTERNAL void  tdFdeltaCFnew (
+        const char        *name,
+        const tdFinterim  *currDetails,
+        StatusType        *status);
+TDFDELTA_INTERNAL void  tdFdeltaCFaddMoves (
+        long int    numMoves,
+        long int    numParks,
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaCFaddSpringOutParks (
+        long int    numSpringOutParks,
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaCFdone (
+        StatusType  *status);
+TDFDELTA_INTERNAL void  tdFdeltaCFdelete (
+        void);
+TDFDELTA_INTERNAL void  tdFdeltaCFformat (
+        const tdFcfCmd  *cmd,
+        char            line[CMDLINE_LENGTH],
+        StatusType      *status);
+TDFDELTA_INTERNAL int  tdFdeltaCFparse (
+        const char  *line,
+        tdFcfCmd    *cmd);
+
+#ifdef DSTDARG_OK
+    TDFDELTA_INTERNAL void  tdFdeltaCFaddCmd (
+            StatusType  *status,
+            int         lineNo,
+            char        *cmd,
+            ...);
+#else
+    TDFDELTA_INTERNAL void  tdFdeltaCFaddCmd ();
+#endif
+/*
+ *  MODULE = tdFdeltaStats
+ */
+extern TDFDELTA_TLS tdFstats  *tdFdeltaStatsCur;
+extern TDFDELTA_TLS tdFstats   tdFdeltaStatsSpare;
+TDFDELTA_INTERNAL void  tdFdeltaStatsInit (
+        tdFstats    *stats);
+TDFDELTA_INTERNAL void  tdFdeltaStatsUse (
+        tdFstats    *stats);
+TDFDELTA_INTERNAL void  tdFdeltaStatsPhase (
+        int         phase,
+        double      tStart);
+TDFDELTA_INTERNAL const char  *tdFdeltaStatsPhaseName (
+        int         phase);
+/*
+ *  MODULE = tdFdeltaTrace
+ */
+extern TDFDELTA_TLS int  tdFdeltaTracing;
+TDFDELTA_INTERNAL void  tdFdeltaTraceStart (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaTraceUse (
+        tdFtrace    *trace);
+TDFDELTA_INTERNAL void  tdFdeltaTraceAdd (
+        int         type,
+        int         piv,
+        int         other,
+        int         arg);
+TDFDELTA_INTERNAL void  tdFdeltaTraceSpan (
+        int         type,
+        double      tStart,
+        double      tEnd);
+TDFDELTA_INTERNAL void  tdFdeltaTraceDone (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaTraceFree (
+        tdFdeltaType  *data);
+/*
+ *  MODULE = tdFdeltaSnap
+ */
+TDFDELTA_INTERNAL void  tdFdeltaSnapTake (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaSnapDone (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaSnapFree (
+        tdFdeltaType  *data);
+TDFDELTA_INTERNAL tdFdeltaType  *tdFdeltaSnapLoad (
+        const char  *file,
+        int         instLen,
+        char        *instName,
+        int         *numPivots,
+        StatusType  *status);
+/*
+ *  MODULE = tdFdeltaCache
+ */
+TDFDELTA_INTERNAL int  tdFdeltaCacheLookup (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL int  tdFdeltaCachePrepare (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaCacheUse (
+        tdFcacheRec  *rec);
+TDFDELTA_INTERNAL void  tdFdeltaCacheLine (
+        const char  *name,
+        const char  *line,
+        long int    value);
+TDFDELTA_INTERNAL int  tdFdeltaCacheRecording (
+        void);
+TDFDELTA_INTERNAL void  tdFdeltaCacheDone (
+        int         keep);
+TDFDELTA_INTERNAL void  tdFdeltaCacheStats (
+        tdFstats    *stats);
+TDFDELTA_INTERNAL void  tdFdeltaCacheFree (
+        tdFcacheRec  *rec);
+TDFDELTA_INTERNAL void  tdFdeltaCacheClear (
+        void);
+/*
+ *  MODULE = tdFdeltaWarm
+ */
+TDFDELTA_INTERNAL void  tdFdeltaWarmUse (
+        tdFwarmUse  *use);
+TDFDELTA_INTERNAL void  tdFdeltaWarmBegin (
+        tdFdeltaType  *data);
+TDFDELTA_INTERNAL int  tdFdeltaWarmSkip (
+        unsigned    piv,
+        unsigned    other,
+        short       park,
+        long        xf,
+        long        yf,
+        double      theta,
+        long        fvpX,
+        long        fvpY);
+TDFDELTA_INTERNAL void  tdFdeltaWarmSave (
+        tdFdeltaType  *data,
+        StatusType    *status);
+TDFDELTA_INTERNAL void  tdFdeltaWarmRelease (
+        tdFdeltaType  *data);
+TDFDELTA_PUBLIC void  tdFdeltaWarmClear (
+        void);
+/*
+ *  MODULE = tdFdeltaRobot
+ */
+TDFDELTA_INTERNAL void  tdFdeltaRobotStart (
+        tdFrobot            *robot,
+        const tdFinterim    *cur,
+        const tdFconstants  *con);
+TDFDELTA_INTERNAL void  tdFdeltaRobotMove (
+        tdFrobot  *robot,
+        unsigned  piv,
+        INT32     x,
+        INT32     y);
+TDFDELTA_INTERNAL void  tdFdeltaRobotPark (
+        tdFrobot  *robot,
+        unsigned  piv);
+TDFDELTA_INTERNAL int  tdFdeltaRobotLine (
+        tdFrobot    *robot,
+        const char  *line);
+/*
+ *  MODULE = tdFdeltaBatch
+ */
+TDFDELTA_PUBLIC void  tdFdeltaBatch (
+        tdFbatch    *batch,
+        StatusType  *status);
+TDFDELTA_INTERNAL tdFdeltaType  *tdFdeltaBatchChain (
+        const tdFdeltaType  *prev,
+        const tdFtarget     *target,
+        int                 derive,
+        unsigned            index,
+        StatusType          *status);
+TDFDELTA_INTERNAL void  tdFdeltaBatchField (
+        tdFdeltaType   *data,
+        FpilType       inst,
+        volatile int   *cancel,
+        tdFbatchField  *field);
+/*
+ *  MODULE = tdFdeltaEstimate
+ */
+TDFDELTA_INTERNAL tdFneighbours  *tdFdeltaNeighboursNew (
+        unsigned            numPivots,
+        const tdFconstants  *con,
+        StatusType          *status);
+TDFDELTA_INTERNAL void  tdFdeltaNeighboursFree (
+        tdFneighbours  *nb);
+TDFDELTA_INTERNAL void  tdFdeltaEstimate (
+        const tdFdeltaType   *from,
+        const tdFtarget      *target,
+        const tdFneighbours  *nb,
+        tdFestimate          *est,
+        StatusType           *status);
+/*
+ *  MODULE = tdFdeltaMatrix
+ */
+TDFDELTA_PUBLIC void  tdFdeltaMatrix (
+        tdFmatrix   *matrix,
+        StatusType  *status);
+/*
+ *  MODULE = tdFdeltaFpilSim
+ *
+ *  Not part of the tdFdeltaCore library.  Provides the FPIL entry
+ *  points itself, so replaces the FPIL library when linked.
+ */
+TDFDELTA_PUBLIC const tdFsimGeom  *tdFdeltaFpilSimGeom (
+        int  sixdf);
+TDFDELTA_PUBLIC const tdFsimGeom  *tdFdeltaFpilSimCurrent (
+        void);
+TDFDELTA_PUBLIC void  tdFdeltaFpilSimInit (
+        const tdFsimGeom  *geom,
+        unsigned          numPivots,
+        FpilType          *inst,
+        StatusType        *status);
+TDFDELTA_PUBLIC void  tdFdeltaFpilSimConstants (
+        tdFdeltaType  *data);
+TDFDELTA_PUBLIC void  tdFdeltaFpilSimFibre (
+        long    xPiv,
+        long    yPiv,
+        long    xf,
+        long    yf,
+        double  *theta,
+        INT32   *fvpX,
+        INT32   *fvpY,
+        double  *fibreLength);
+/*
+ *  MODULE = tdFdeltaGen
+ *
+ *  Not part of the tdFdeltaCore library.  Uses the stand-in instrument.
+ */
+TDFDELTA_PUBLIC tdFdeltaType  *tdFdeltaGenField (
+        const tdFgenParams  *params,
+        unsigned long       seed,
+        StatusType          *status);
+
+#endif